@@ -50,6 +50,8 @@
 #include "p_saveg.h"
 #include "r_main.h"
 #include "r_local.h"
+#include "r_patchrotation.h"
+#include "r_pvs.h"
 #include "s_sound.h"
 #include "st_stuff.h"
 #include "v_video.h"
@@ -71,6 +73,7 @@
 #include "g_input.h" // tutorial mode control scheming
 #include "m_perfstats.h"
 #include "m_random.h"
+#include "m_trace.h"
 #include "command.h"
 
 #ifdef CMAKECONFIG
@@ -483,6 +486,9 @@ static void D_Display(void)
 		// see if the border needs to be initially drawn
 		if (gamestate == GS_LEVEL || (gamestate == GS_TITLESCREEN && titlemapinaction && curbghide && (!hidetitlemap)))
 		{
+			// Pick up whatever's left of the level's precaching.
+			R_FinishPrecacheLevel();
+
 			// draw the view directly
 
 			if (!automapactive && !dedicated && cv_renderview.value)
@@ -491,7 +497,7 @@ static void D_Display(void)
 				PS_START_TIMING(ps_rendercalltime);
 				if (players[displayplayer].mo || players[displayplayer].playerstate == PST_DEAD)
 				{
-					topleft = screens[0] + viewwindowy*vid.width + viewwindowx;
+					topleft = viewscreen + viewwindowy*columnpitch + viewwindowx*spanpitch;
 					objectsdrawn = 0;
 	#ifdef HWRENDER
 					if (rendermode != render_soft)
@@ -515,7 +521,7 @@ static void D_Display(void)
 						viewwindowy = vid.height / 2;
 						M_Memcpy(ylookup, ylookup2, viewheight*sizeof (ylookup[0]));
 
-						topleft = screens[0] + viewwindowy*vid.width + viewwindowx;
+						topleft = viewscreen + viewwindowy*columnpitch + viewwindowx*spanpitch;
 
 						R_RenderPlayerView(&players[secondarydisplayplayer]);
 
@@ -645,10 +651,7 @@ static void D_Display(void)
 
 		// reset counters so timedemo doesn't count the wipe duration
 		if (timingdemo)
-		{
-			framecount = 0;
-			demostarttime = I_GetTime();
-		}
+			G_ResetDemoTiming();
 
 		wipetypepost = -1;
 	}
@@ -718,6 +721,9 @@ void D_SRB2Loop(void)
 
 	// Pushing of + parameters is now done back in D_SRB2Main, not here.
 
+	// Startup is over
+	M_StopTrace();
+
 #ifdef _WINDOWS
 	CONS_Printf("I_StartupMouse()...\n");
 	I_DoStartupMouse();
@@ -899,8 +905,16 @@ void D_SRB2Loop(void)
 
 		LUA_Step();
 
+		// Nothing is holding cached lumps or sprite rotations now, so they can be evicted.
+		W_TrimLumpCache();
+#ifdef ROTSPRITE
+		RotatedPatch_UpdateCache();
+#endif
+
 		// Fully completed frame made.
 		finishprecise = I_GetPreciseTime();
+		if (timingdemo)
+			G_TimeDemoFrame(finishprecise - enterprecise);
 		if (!singletics)
 		{
 			INT64 elapsed = (INT64)(finishprecise - enterprecise);
@@ -1239,6 +1253,11 @@ void D_SRB2Main(void)
 	/* break the version string into version numbers, for netplay */
 	D_ConvertVersionNumbers();
 
+	// Time everything up to the main loop, if asked to
+	if (M_CheckParm("-tracestartup") && M_IsNextParm())
+		M_StartTrace(M_GetNextParm());
+	M_TraceBegin("D_SRB2Main", NULL);
+
 	if (!strcmp(compbranch, ""))
 	{
 		compbranch = "detached HEAD";
@@ -1372,7 +1391,10 @@ void D_SRB2Main(void)
 	M_InitPlayerSetupColors();
 
 	CONS_Printf("Z_Init(): Init zone memory allocation daemon. \n");
+	M_TraceBegin("Z_Init", NULL);
 	Z_Init();
+	P_InitMobjPools();
+	M_TraceEnd();
 
 	clientGamedata = M_NewGameDataStruct();
 	serverGamedata = M_NewGameDataStruct();
@@ -1439,8 +1461,10 @@ void D_SRB2Main(void)
 
 	// load wad, including the main wad file
 	CONS_Printf("W_InitMultipleFiles(): Adding IWAD and main PWADs.\n");
+	M_TraceBegin("W_InitMultipleFiles", "main files");
 	W_InitMultipleFiles(&startupwadfiles);
 	D_CleanFile(&startupwadfiles);
+	M_TraceEnd();
 
 #ifndef DEVELOP // md5s last updated 22/02/20 (ddmmyy)
 
@@ -1461,7 +1485,9 @@ void D_SRB2Main(void)
 	// we need to check for dedicated before initialization of some subsystems
 
 	CONS_Printf("I_StartupGraphics()...\n");
+	M_TraceBegin("I_StartupGraphics", NULL);
 	I_StartupGraphics();
+	M_TraceEnd();
 
 #ifdef HWRENDER
 	// Lactozilla: Add every hardware mode CVAR and CCMD.
@@ -1472,35 +1498,49 @@ void D_SRB2Main(void)
 
 	//--------------------------------------------------------- CONSOLE
 	// setup loading screen
+	M_TraceBegin("SCR_Startup", NULL);
 	SCR_Startup();
+	M_TraceEnd();
 
+	M_TraceBegin("HU_Init", NULL);
 	HU_Init();
+	M_TraceEnd();
 
+	M_TraceBegin("CON_Init", NULL);
 	CON_Init();
+	M_TraceEnd();
 
+	M_TraceBegin("Register commands", NULL);
 	D_RegisterServerCommands();
 	D_RegisterClientCommands(); // be sure that this is called before D_CheckNetGame
 	R_RegisterEngineStuff();
 	S_RegisterSoundStuff();
 
 	I_RegisterSysCommands();
+	M_TraceEnd();
 
 	CON_StopRefresh(); // Temporarily stop refreshing the screen for wad loading
 
 	if (startuppwads.numfiles)
 	{
 		CONS_Printf("W_InitMultipleFiles(): Adding extra PWADs.\n");
+		M_TraceBegin("W_InitMultipleFiles", "extra files");
 		W_InitMultipleFiles(&startuppwads);
 		D_CleanFile(&startuppwads);
+		M_TraceEnd();
 	}
 
 	CON_StartRefresh(); // Restart the refresh!
 
 	CONS_Printf("HU_LoadGraphics()...\n");
+	M_TraceBegin("HU_LoadGraphics", NULL);
 	HU_LoadGraphics();
+	M_TraceEnd();
 
 	//--------------------------------------------------------- CONFIG.CFG
+	M_TraceBegin("M_FirstLoadConfig", NULL);
 	M_FirstLoadConfig(); // WARNING : this do a "COM_BufExecute()"
+	M_TraceEnd();
 
 	if (M_CheckParm("-gamedata") && M_IsNextParm())
 	{
@@ -1509,8 +1549,10 @@ void D_SRB2Main(void)
 		strlcpy(gamedatafilename, M_GetNextParm(), sizeof gamedatafilename);
 	}
 
+	M_TraceBegin("G_LoadGameData", NULL);
 	G_LoadGameData(clientGamedata);
 	M_CopyGameData(serverGamedata, clientGamedata);
+	M_TraceEnd();
 
 #if defined (__unix__) || defined (UNIXCOMMON) || defined (HAVE_SDL)
 	VID_PrepareModeList(); // Regenerate Modelist according to cv_fullscreen
@@ -1542,14 +1584,49 @@ void D_SRB2Main(void)
 		}
 	}
 
+	// Benchmarks the Software renderer on a map, then quits
+	if (M_CheckParm("-renderbench") && M_IsNextParm())
+	{
+		const char *word = M_GetNextParm();
+		pstartmap = G_FindMapByNameOrCode(word, 0);
+		if (! pstartmap)
+			I_Error("Cannot find a map remotely named '%s'\n", word);
+		else
+		{
+			PS_StartRenderBench(pstartmap, M_IsNextParm() ? atoi(M_GetNextParm()) : 0, true);
+			G_SetUsedCheats(true);
+			autostart = true;
+		}
+	}
+
+	// Builds and saves the PVS of every map listed, then quits
+	if (M_CheckParm("-buildpvs") && M_IsNextParm())
+	{
+		while (M_IsNextParm())
+		{
+			const char *word = M_GetNextParm();
+			INT16 map = G_FindMapByNameOrCode(word, 0);
+			if (! map)
+				I_Error("Cannot find a map remotely named '%s'\n", word);
+			R_QueuePVSBuild(map);
+		}
+		pstartmap = R_FirstPVSBuild();
+		G_SetUsedCheats(true);
+		autostart = true;
+	}
+
 	if (M_CheckParm("-noupload"))
 		COM_BufAddText("downloading 0\n");
 
 	CONS_Printf("M_Init(): Init miscellaneous info.\n");
+	M_TraceBegin("M_Init", NULL);
 	M_Init();
+	M_TraceEnd();
 
 	CONS_Printf("R_Init(): Init SRB2 refresh daemon.\n");
+	M_TraceBegin("R_Init", NULL);
 	R_Init();
+	M_TraceEnd();
 
 	// setting up sound
 	if (dedicated)
@@ -1587,15 +1664,21 @@ void D_SRB2Main(void)
 	 ))
 	{
 		CONS_Printf("S_InitSfxChannels(): Setting up sound channels.\n");
+		M_TraceBegin("S_InitSfxChannels", NULL);
 		I_StartupSound();
 		I_InitMusic();
 		S_InitSfxChannels(cv_soundvolume.value);
+		M_TraceEnd();
 	}
 
+	M_TraceBegin("S_InitMusicDefs", NULL);
 	S_InitMusicDefs();
+	M_TraceEnd();
 
 	CONS_Printf("ST_Init(): Init status bar.\n");
+	M_TraceBegin("ST_Init", NULL);
 	ST_Init();
+	M_TraceEnd();
 
 	if (M_CheckParm("-room"))
 	{
@@ -1610,8 +1693,10 @@ void D_SRB2Main(void)
 
 	// init all NETWORK
 	CONS_Printf("D_CheckNetGame(): Checking network game status.\n");
+	M_TraceBegin("D_CheckNetGame", NULL);
 	if (D_CheckNetGame())
 		autostart = true;
+	M_TraceEnd();
 
 	// check for a driver that wants intermission stats
 	// start the apropriate game based on parms
@@ -1627,10 +1712,12 @@ void D_SRB2Main(void)
 	}
 
 	// user settings come before "+" parameters.
+	M_TraceBegin("Execute autoexec", NULL);
 	if (dedicated)
 		COM_ImmedExecute(va("exec \"%s"PATHSEP"adedserv.cfg\"\n", srb2home));
 	else
 		COM_ImmedExecute(va("exec \"%s"PATHSEP"autoexec.cfg\" -noerror\n", srb2home));
+	M_TraceEnd();
 
 	if (!autostart)
 		M_PushSpecialParameters(); // push all "+" parameters at the command buffer
@@ -1664,7 +1751,18 @@ void D_SRB2Main(void)
 			G_DeferedPlayDemo(tmp);
 		}
 		else
+		{
+			// -timedemocsv [<trialid>] adds the results to timedemo.csv,
+			// like the timedemo command's -csv
+			timedemo_csv = (M_CheckParm("-timedemocsv") != 0);
+			if (timedemo_csv && M_IsNextParm())
+				strlcpy(timedemo_csv_id, M_GetNextParm(), sizeof timedemo_csv_id);
+			else
+				timedemo_csv_id[0] = 0;
+			strlcpy(timedemo_name, tmp, sizeof timedemo_name);
+
 			G_TimeDemo(tmp);
+		}
 
 		G_SetGamestate(GS_NULL);
 		wipegamestate = GS_NULL;
@@ -1684,7 +1782,9 @@ void D_SRB2Main(void)
 	}
 
 	// rei/miru: bootmap (Idea: starts the game on a predefined map)
-	if (bootmap && !(M_CheckParm("-warp") && M_IsNextParm()))
+	if (bootmap && !(M_CheckParm("-warp") && M_IsNextParm())
+		&& !(M_CheckParm("-renderbench") && M_IsNextParm())
+		&& !(M_CheckParm("-buildpvs") && M_IsNextParm()))
 	{
 		pstartmap = bootmap;
 
@@ -24,6 +24,7 @@
 #include "m_menu.h"
 #include "r_local.h"
 #include "r_skins.h"
+#include "r_patchrotation.h"
 #include "p_local.h"
 #include "p_setup.h"
 #include "s_sound.h"
@@ -376,7 +377,7 @@ consvar_t cv_mute = CVAR_INIT ("mute", "Off", CV_NETVAR|CV_CALL|CV_ALLOWLUA, CV_
 consvar_t cv_sleep = CVAR_INIT ("cpusleep", "1", CV_SAVE, sleeping_cons_t, NULL);
 
 static CV_PossibleValue_t perfstats_cons_t[] = {
-	{0, "Off"}, {1, "Rendering"}, {2, "Logic"}, {3, "ThinkFrame"}, {0, NULL}};
+	{0, "Off"}, {1, "Rendering"}, {2, "Logic"}, {3, "ThinkFrame"}, {4, "Drawers"}, {0, NULL}};
 consvar_t cv_perfstats = CVAR_INIT ("perfstats", "Off", CV_CALL, perfstats_cons_t, PS_PerfStats_OnChange);
 static CV_PossibleValue_t ps_samplesize_cons_t[] = {
 	{1, "MIN"}, {1000, "MAX"}, {0, NULL}};
@@ -490,6 +491,19 @@ void D_RegisterServerCommands(void)
 	COM_AddCommand("addfolder", Command_Addfolder, COM_LUA);
 	COM_AddCommand("addfile", Command_Addfile, COM_LUA);
 	COM_AddCommand("listwad", Command_ListWADS_f, COM_LUA);
+	COM_AddCommand("lumpbench", Command_Lumpbench_f, 0);
+	COM_AddCommand("lumpcachestats", Command_LumpCacheStats_f, 0);
+#ifdef ROTSPRITE
+	COM_AddCommand("rotspritecachestats", Command_RotSpriteCacheStats_f, 0);
+#endif
+	COM_AddCommand("drawerbench", Command_Drawerbench_f, 0);
+	COM_AddCommand("slopebench", Command_Slopebench_f, 0);
+	COM_AddCommand("spritesortbench", Command_Spritesortbench_f, 0);
+	COM_AddCommand("renderbench", Command_Renderbench_f, 0);
+	CV_RegisterVar(&cv_lumpcachesize);
+#ifdef ROTSPRITE
+	CV_RegisterVar(&cv_rotspritecachesize);
+#endif
 
 	COM_AddCommand("runsoc", Command_RunSOC, COM_LUA);
 	COM_AddCommand("pause", Command_Pause, COM_LUA);
@@ -1698,7 +1712,7 @@ static void Command_Timedemo_f(void)
 
 	if (COM_Argc() < 2)
 	{
-		CONS_Printf(M_GetText("timedemo <demoname> [-csv [<trialid>]] [-quit]: time a demo\n"));
+		CONS_Printf(M_GetText("timedemo <demoname> [-csv [<trialid>]] [-nodraw] [-quit]: time a demo\n"));
 		return;
 	}
 
@@ -1721,7 +1735,7 @@ static void Command_Timedemo_f(void)
 	// print timedemo results as CSV?
 	i = COM_CheckParm("-csv");
 	timedemo_csv = (i > 0);
-	if (COM_CheckParm("-quit") != i + 1)
+	if (timedemo_csv && COM_Argv(i + 1)[0] != '-')
 		strcpy(timedemo_csv_id, COM_Argv(i + 1)); // user-defined string to identify row
 	else
 		timedemo_csv_id[0] = 0;
@@ -1732,6 +1746,10 @@ static void Command_Timedemo_f(void)
 	CONS_Printf(M_GetText("Timing demo '%s'.\n"), timedemo_name);
 
 	G_TimeDemo(timedemo_name);
+
+	// time the game logic alone?
+	if (COM_CheckParm("-nodraw"))
+		nodrawers = true;
 }
 
 // stop current demo
@@ -3480,11 +3498,9 @@ static void Command_Addfile(void)
 
 			if ((fhandle = W_OpenWadFile(&fn, true)) != NULL)
 			{
-				tic_t t = I_GetTime();
-				CONS_Debug(DBG_SETUP, "Making MD5 for %s\n",fn);
-				md5_stream(fhandle, md5sum);
-				CONS_Debug(DBG_SETUP, "MD5 calc for %s took %f second\n", fn, (float)(I_GetTime() - t)/TICRATE);
 				fclose(fhandle);
+				if (W_MakeFileMD5(fn, md5sum) != 0)
+					continue;
 			}
 			else // file not found
 				continue;
@@ -1585,17 +1585,13 @@ filestatus_t checkfilemd5(char *filename, const UINT8 *wantedmd5sum)
 	(void)wantedmd5sum;
 	(void)filename;
 #else
-	FILE *fhandle;
 	UINT8 md5sum[16];
 
 	if (!wantedmd5sum)
 		return FS_FOUND;
 
-	fhandle = fopen(filename, "rb");
-	if (fhandle)
+	if (W_MakeFileMD5(filename, md5sum) == 0)
 	{
-		md5_stream(fhandle,md5sum);
-		fclose(fhandle);
 		if (!memcmp(wantedmd5sum, md5sum, 16))
 			return FS_FOUND;
 		return FS_MD5SUMBAD;
@@ -14,6 +14,7 @@
 #include "m_cond.h"
 #include "deh_soc.h"
 #include "deh_tables.h"
+#include "m_trace.h"
 
 boolean deh_loaded = false;
 
@@ -619,7 +620,9 @@ void DEH_LoadDehackedLumpPwad(UINT16 wad, UINT16 lump, boolean mainfile)
 	W_ReadLumpPwad(wad, lump, f.data);
 	f.curpos = f.data;
 	f.data[f.size] = 0;
+	M_TraceBegin("DEH_LoadDehackedLump", wadfiles[wad]->lumpinfo[lump].fullname);
 	DEH_LoadDehackedFile(&f, mainfile);
+	M_TraceEnd();
 	Z_Free(f.data);
 }
 
@@ -257,9 +257,11 @@ enum {false = 0, true = 1};
 	#endif
 
 	#define ATTRUNUSED __attribute__((unused))
+	#define ATTRTHREADLOCAL __thread
 #elif defined (_MSC_VER)
 	#define ATTRNORETURN __declspec(noreturn)
 	#define ATTRINLINE __forceinline
+	#define ATTRTHREADLOCAL __declspec(thread)
 	#if _MSC_VER > 1200 // >= MSVC 6.0
 		#define ATTRNOINLINE __declspec(noinline)
 	#endif
@@ -310,6 +312,7 @@ enum {false = 0, true = 1};
 #ifndef ATTRNOINLINE
 #define ATTRNOINLINE
 #endif
+// ATTRTHREADLOCAL is left undefined where there's no way to ask for it
 
 /* Miscellaneous types that don't fit anywhere else (Can this be changed?) */
 
@@ -29,6 +29,11 @@ UINT64 I_GetPrecisePrecision(void)
 	return 1000000;
 }
 
+INT32 I_GetCPUCount(void)
+{
+	return 1;
+}
+
 void I_GetEvent(void){}
 
 void I_OsPolling(void){}
@@ -2642,6 +2642,25 @@ void G_FreeGhosts(void)
 //
 static INT32 restorecv_vidwait;
 
+// Frame times for timedemo, counted in TIMEDEMOBUCKET microsecond
+// buckets, the last of which takes every frame longer than that
+#define TIMEDEMOBUCKET 50
+#define NUMTIMEDEMOBUCKETS 4000 // up to 200 ms
+#define NUMTIMEDEMOWORST 5
+
+static struct
+{
+	UINT32 buckets[NUMTIMEDEMOBUCKETS];
+	UINT32 frames;
+	precise_t total;
+	boolean skipframe; // the timing was reset partway through this frame
+	struct
+	{
+		precise_t time;
+		tic_t tic;
+	} worst[NUMTIMEDEMOWORST]; // longest first
+} demotiming;
+
 void G_TimeDemo(const char *name)
 {
 	nodrawers = M_CheckParm("-nodraw");
@@ -2651,9 +2670,71 @@ void G_TimeDemo(const char *name)
 		CV_Set(&cv_vidwait, "0");
 	timingdemo = true;
 	singletics = true;
+	G_ResetDemoTiming();
+	G_DeferedPlayDemo(name);
+}
+
+/** Starts timing the demo afresh, leaving out whatever came before,
+  * such as loading the level or the wipe into it.
+  */
+void G_ResetDemoTiming(void)
+{
 	framecount = 0;
 	demostarttime = I_GetTime();
-	G_DeferedPlayDemo(name);
+	memset(&demotiming, 0, sizeof (demotiming));
+	demotiming.skipframe = true;
+}
+
+/** Adds a frame to the timedemo's frame times. With -nodraw, every
+  * frame is a single tic of game logic.
+  *
+  * \param time How long the frame took, in I_GetPreciseTime units.
+  */
+void G_TimeDemoFrame(precise_t time)
+{
+	const precise_t us = time / (I_GetPrecisePrecision() / 1000000);
+	INT32 i;
+
+	if (demotiming.skipframe)
+	{
+		demotiming.skipframe = false;
+		return;
+	}
+
+	if (gamestate != GS_LEVEL)
+		return;
+
+	demotiming.buckets[min(us / TIMEDEMOBUCKET, NUMTIMEDEMOBUCKETS - 1)]++;
+	demotiming.frames++;
+	demotiming.total += time;
+
+	for (i = 0; i < NUMTIMEDEMOWORST; i++)
+		if (time > demotiming.worst[i].time)
+			break;
+
+	if (i < NUMTIMEDEMOWORST)
+	{
+		memmove(&demotiming.worst[i + 1], &demotiming.worst[i], (NUMTIMEDEMOWORST - 1 - i) * sizeof (demotiming.worst[0]));
+		demotiming.worst[i].time = time;
+		demotiming.worst[i].tic = leveltime;
+	}
+}
+
+// The frame time in ms that pct percent of the frames came in under
+static double G_DemoTimingPercentile(UINT32 pct)
+{
+	const UINT64 target = ((UINT64)demotiming.frames * pct + 99) / 100;
+	UINT64 count = 0;
+	INT32 b;
+
+	for (b = 0; b < NUMTIMEDEMOBUCKETS - 1; b++)
+	{
+		count += demotiming.buckets[b];
+		if (count >= target)
+			break;
+	}
+
+	return (b + 1) * TIMEDEMOBUCKET / 1000.0;
 }
 
 void G_DoPlayMetal(void)
@@ -2728,8 +2809,7 @@ void G_DoPlayMetal(void)
 void G_DoneLevelLoad(void)
 {
 	CONS_Printf(M_GetText("Loaded level in %f sec\n"), (double)(I_GetTime() - demostarttime) / TICRATE);
-	framecount = 0;
-	demostarttime = I_GetTime();
+	G_ResetDemoTiming();
 }
 
 /*
@@ -2806,11 +2886,34 @@ ATTRNORETURN void FUNCNORETURN G_StopMetalRecording(boolean kill)
 	I_Error("Failed to save demo!");
 }
 
+// Adds the frame time histogram to timedemo_frames.csv, a row per
+// bucket with any frames in it
+static void G_WriteDemoTimingHistogram(void)
+{
+	const char *csvpath = va("%s"PATHSEP"%s", srb2home, "timedemo_frames.csv");
+	boolean headerrow = !FIL_FileExists(csvpath);
+	FILE *f = fopen(csvpath, "a+");
+	INT32 b;
+
+	if (!f)
+		return;
+
+	if (headerrow)
+		fputs("id,demoname,framems,frames\n", f);
+	for (b = 0; b < NUMTIMEDEMOBUCKETS; b++)
+		if (demotiming.buckets[b])
+			fprintf(f, "\"%s\",\"%s\",%.2f,%u\n", timedemo_csv_id, timedemo_name,
+				(b + 1) * TIMEDEMOBUCKET / 1000.0, demotiming.buckets[b]);
+	fclose(f);
+}
+
 // Stops timing a demo.
 static void G_StopTimingDemo(void)
 {
-	INT32 demotime;
+	INT32 demotime, i;
 	double f1, f2;
+	double p50 = 0.0, p95 = 0.0, p99 = 0.0;
+	const double mspertick = 1000.0 / I_GetPrecisePrecision();
 	demotime = I_GetTime() - demostarttime;
 	if (!demotime)
 		return;
@@ -2822,13 +2925,30 @@ static void G_StopTimingDemo(void)
 	CONS_Printf(M_GetText("timed %u gametics in %d realtics - %u frames\n%f seconds, %f avg fps\n"),
 		leveltime,demotime,(UINT32)framecount,f1/TICRATE,f2/f1);
 
+	if (demotiming.frames)
+	{
+		p50 = G_DemoTimingPercentile(50);
+		p95 = G_DemoTimingPercentile(95);
+		p99 = G_DemoTimingPercentile(99);
+
+		// Nothing is drawn, so every frame is a tic of game logic
+		if (nodrawers)
+			CONS_Printf(M_GetText("%f tics per second of game logic\n"),
+				demotiming.frames / (demotiming.total * mspertick / 1000.0));
+
+		CONS_Printf(M_GetText("frame times: %.2f ms p50, %.2f ms p95, %.2f ms p99\n"), p50, p95, p99);
+		for (i = 0; i < NUMTIMEDEMOWORST && demotiming.worst[i].time; i++)
+			CONS_Printf(M_GetText("  %.2f ms at tic %u\n"), demotiming.worst[i].time * mspertick, demotiming.worst[i].tic);
+	}
+
 	// CSV-readable timedemo results, for external parsing
 	if (timedemo_csv)
 	{
 		FILE *f;
 		const char *csvpath = va("%s"PATHSEP"%s", srb2home, "timedemo.csv");
-		const char *header = "id,demoname,seconds,avgfps,leveltime,demotime,framecount,ticrate,rendermode,vidmode,vidwidth,vidheight,procbits\n";
-		const char *rowformat = "\"%s\",\"%s\",%f,%f,%u,%d,%u,%u,%u,%u,%u,%u,%u\n";
+		const char *header = "id,demoname,seconds,avgfps,leveltime,demotime,framecount,ticrate,rendermode,vidmode,vidwidth,vidheight,procbits,"
+			"p50ms,p95ms,p99ms,worstms,worsttic,nodraw\n";
+		const char *rowformat = "\"%s\",\"%s\",%f,%f,%u,%d,%u,%u,%u,%u,%u,%u,%u,%.2f,%.2f,%.2f,%.2f,%u,%u\n";
 		boolean headerrow = !FIL_FileExists(csvpath);
 		UINT8 procbits = 0;
 
@@ -2845,8 +2965,10 @@ static void G_StopTimingDemo(void)
 			if (headerrow)
 				fputs(header, f);
 			fprintf(f, rowformat,
-				timedemo_csv_id,timedemo_name,f1/TICRATE,f2/f1,leveltime,demotime,(UINT32)framecount,TICRATE,rendermode,vid.modenum,vid.width,vid.height,procbits);
+				timedemo_csv_id,timedemo_name,f1/TICRATE,f2/f1,leveltime,demotime,(UINT32)framecount,TICRATE,rendermode,vid.modenum,vid.width,vid.height,procbits,
+				p50,p95,p99,demotiming.worst[0].time * mspertick,demotiming.worst[0].tic,nodrawers);
 			fclose(f);
+			G_WriteDemoTimingHistogram();
 			CONS_Printf("Timedemo results saved to '%s'\n", csvpath);
 		}
 		else
@@ -2854,10 +2976,14 @@ static void G_StopTimingDemo(void)
 			// Just print the CSV output to console
 			CON_LogMessage(header);
 			CONS_Printf(rowformat,
-				timedemo_csv_id,timedemo_name,f1/TICRATE,f2/f1,leveltime,demotime,(UINT32)framecount,TICRATE,rendermode,vid.modenum,vid.width,vid.height,procbits);
+				timedemo_csv_id,timedemo_name,f1/TICRATE,f2/f1,leveltime,demotime,(UINT32)framecount,TICRATE,rendermode,vid.modenum,vid.width,vid.height,procbits,
+				p50,p95,p99,demotiming.worst[0].time * mspertick,demotiming.worst[0].tic,nodrawers);
 		}
 	}
 
+	// Back to drawing the title screen
+	nodrawers = false;
+
 	if (restorecv_vidwait != cv_vidwait.value)
 		CV_SetValue(&cv_vidwait, restorecv_vidwait);
 	D_AdvanceDemo();
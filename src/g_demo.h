@@ -96,6 +96,8 @@ void G_LoadMetal(UINT8 **buffer);
 void G_DeferedPlayDemo(const char *demo);
 void G_DoPlayDemo(char *defdemoname);
 void G_TimeDemo(const char *name);
+void G_ResetDemoTiming(void);
+void G_TimeDemoFrame(precise_t time);
 void G_AddGhost(char *defdemoname);
 void G_FreeGhosts(void);
 void G_DoPlayMetal(void);
@@ -48,6 +48,8 @@
 #include "m_cond.h" // condition sets
 #include "lua_script.h"
 #include "r_fps.h" // frame interpolation/uncapped
+#include "m_perfstats.h" // renderbench
+#include "r_pvs.h" // -buildpvs
 
 #include "lua_hud.h"
 
@@ -2289,6 +2291,11 @@ void G_Ticker(boolean run)
 		marathontime++;
 
 	P_MapStart();
+
+	// Waits for its map to be loaded.
+	PS_RenderBenchTicker();
+	R_BuildPVSTicker();
+
 	// do player reborns if needed
 	if (gamestate == GS_LEVEL)
 	{
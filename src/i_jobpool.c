@@ -0,0 +1,336 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  i_jobpool.c
+/// \brief Worker threads that take jobs off a queue.
+///
+///        A pool spawns its threads the first time it is used and keeps
+///        them until the game quits. Jobs are queued from the main thread,
+///        which can then help run them while it waits. Without threads,
+///        or once they have been stopped, the queue is simply run by
+///        whoever waits on it, so callers need no fallback of their own.
+///
+///        The zone is not thread-safe, so jobs must not touch it.
+
+#include "doomdef.h"
+#include "i_jobpool.h"
+#include "i_system.h" // I_AddExitFunc, I_GetCPUCount
+
+static jobpool_t *jobpools = NULL; // started pools, for I_StopJobPools
+
+// Once I_stop_threads has run, the threads and mutexes are gone, and the
+// main thread has the pools to itself. Returns whether it took the lock.
+static boolean I_LockJobPool(jobpool_t *pool)
+{
+#ifdef HAVE_THREADS
+	if (!I_thread_is_stopped())
+	{
+		I_lock_mutex(&pool->mutex);
+		return true;
+	}
+#else
+	(void)pool;
+#endif
+	return false;
+}
+
+static void I_UnlockJobPool(jobpool_t *pool, boolean locked)
+{
+#ifdef HAVE_THREADS
+	if (locked)
+		I_unlock_mutex(pool->mutex);
+#else
+	(void)pool;
+	(void)locked;
+#endif
+}
+
+// Takes the oldest queued job, if any. Call with the lock held.
+static job_t *I_TakeJob(jobpool_t *pool)
+{
+	job_t *job = pool->head;
+
+	if (job)
+	{
+		pool->head = job->next;
+		if (!pool->head)
+			pool->tail = NULL;
+		job->state = JOB_RUNNING;
+	}
+
+	return job;
+}
+
+// Takes a job out of the queue. Call with the lock held.
+static void I_UnqueueJob(jobpool_t *pool, job_t *job)
+{
+	job_t **link, *prev = NULL;
+
+	for (link = &pool->head; *link != job; link = &(*link)->next)
+		prev = *link;
+
+	*link = job->next;
+	if (pool->tail == job)
+		pool->tail = prev;
+	job->state = JOB_IDLE;
+}
+
+#ifdef HAVE_THREADS
+static void I_JobPoolThread(void *userdata)
+{
+	jobpool_t *pool = userdata;
+	INT32 worker;
+	job_t *job;
+
+	I_lock_mutex(&pool->mutex);
+	worker = ++pool->numstarted;
+	for (;;)
+	{
+		while (!pool->head && !pool->quit)
+			I_hold_cond(&pool->cond, pool->mutex);
+
+		if (pool->quit)
+			break;
+
+		job = I_TakeJob(pool);
+		pool->numrunning++;
+
+		I_unlock_mutex(pool->mutex);
+		job->func(job, worker);
+		I_lock_mutex(&pool->mutex);
+
+		job->state = JOB_IDLE;
+		pool->numrunning--;
+		I_wake_all_cond(&pool->donecond);
+	}
+	I_unlock_mutex(pool->mutex);
+}
+
+// The threads spend their lives waiting for jobs, so they have to be
+// told to leave before I_stop_threads waits for them. Whatever is still
+// queued is left to whoever waits on it.
+static void I_StopJobPools(void)
+{
+	jobpool_t *pool;
+
+	for (pool = jobpools; pool; pool = pool->next)
+	{
+		I_lock_mutex(&pool->mutex);
+		{
+			pool->quit = true;
+			I_wake_all_cond(&pool->cond);
+		}
+		I_unlock_mutex(pool->mutex);
+	}
+}
+#endif
+
+/** Spawns a pool's threads, if it doesn't have them yet.
+  * I_queue_job does this by itself; call it first to pick how many
+  * threads there are, or to find out whether there are any.
+  *
+  * \param pool The pool.
+  * \param count How many threads it should have, up to its maximum.
+  *              0 for one per core.
+  * \return How many threads the pool has, which is 0 if the game is
+  *         quitting or was built without threads.
+  */
+INT32 I_start_job_pool(jobpool_t *pool, INT32 count)
+{
+#ifdef HAVE_THREADS
+	if (pool->quit || I_thread_is_stopped())
+		return 0;
+
+	if (count <= 0)
+		count = I_GetCPUCount();
+	count = min(count, pool->maxthreads);
+
+	if (!pool->numthreads && count > 0)
+	{
+		if (!jobpools)
+			I_AddExitFunc(I_StopJobPools);
+		pool->next = jobpools;
+		jobpools = pool;
+	}
+
+	for (; pool->numthreads < count; pool->numthreads++)
+		I_spawn_thread(pool->name, I_JobPoolThread, pool);
+
+	return pool->numthreads;
+#else
+	(void)pool;
+	(void)count;
+	return 0;
+#endif
+}
+
+/** Queues a job for a pool's threads, spawning them if need be.
+  * If there aren't any, the job waits for I_finish_jobs or I_wait_job
+  * to run it instead.
+  *
+  * \param pool The pool.
+  * \param job The job, which must not be queued already.
+  * \param func What to run it with.
+  */
+void I_queue_job(jobpool_t *pool, job_t *job, I_job_fn func)
+{
+	boolean locked;
+
+	if (!pool->numthreads)
+		I_start_job_pool(pool, 0);
+
+	locked = I_LockJobPool(pool);
+	{
+		job->func = func;
+		job->next = NULL;
+		job->state = JOB_QUEUED;
+
+		if (pool->tail)
+			pool->tail->next = job;
+		else
+			pool->head = job;
+		pool->tail = job;
+
+#ifdef HAVE_THREADS
+		if (locked)
+			I_wake_one_cond(&pool->cond);
+#endif
+	}
+	I_UnlockJobPool(pool, locked);
+}
+
+/** Runs queued jobs until there are none left,
+  * then waits for the ones the threads are still running.
+  *
+  * \param pool The pool.
+  * \sa I_wait_jobs
+  */
+void I_finish_jobs(jobpool_t *pool)
+{
+	boolean locked = I_LockJobPool(pool);
+	job_t *job;
+
+	while ((job = I_TakeJob(pool)) != NULL)
+	{
+		I_UnlockJobPool(pool, locked);
+		job->func(job, 0);
+		locked = I_LockJobPool(pool);
+
+		job->state = JOB_IDLE;
+	}
+
+#ifdef HAVE_THREADS
+	if (locked)
+	{
+		while (pool->numrunning)
+			I_hold_cond(&pool->donecond, pool->mutex);
+	}
+#endif
+	I_UnlockJobPool(pool, locked);
+}
+
+/** Waits for every queued job to be run by the pool's threads, without
+  * running any on the calling thread. Only if there are no threads to
+  * run them does it run them itself.
+  *
+  * \param pool The pool.
+  * \sa I_finish_jobs
+  */
+void I_wait_jobs(jobpool_t *pool)
+{
+#ifdef HAVE_THREADS
+	if (pool->numthreads && !pool->quit && !I_thread_is_stopped())
+	{
+		I_lock_mutex(&pool->mutex);
+		{
+			while (pool->head || pool->numrunning)
+				I_hold_cond(&pool->donecond, pool->mutex);
+		}
+		I_unlock_mutex(pool->mutex);
+		return;
+	}
+#endif
+	I_finish_jobs(pool);
+}
+
+/** Waits for one job to be done.
+  * If no thread has taken it yet, it is run on the calling thread.
+  *
+  * \param pool The pool it was queued in.
+  * \param job The job.
+  */
+void I_wait_job(jobpool_t *pool, job_t *job)
+{
+	boolean locked = I_LockJobPool(pool);
+
+	if (job->state == JOB_QUEUED)
+	{
+		I_UnqueueJob(pool, job);
+		job->state = JOB_RUNNING;
+
+		I_UnlockJobPool(pool, locked);
+		job->func(job, 0);
+		locked = I_LockJobPool(pool);
+
+		job->state = JOB_IDLE;
+	}
+
+#ifdef HAVE_THREADS
+	if (locked)
+	{
+		while (job->state == JOB_RUNNING)
+			I_hold_cond(&pool->donecond, pool->mutex);
+	}
+#endif
+	I_UnlockJobPool(pool, locked);
+}
+
+/** Takes a job back out of the queue, or waits for it to be done
+  * if a thread has taken it already.
+  *
+  * \param pool The pool it was queued in.
+  * \param job The job.
+  * \return true if the job was taken out before it ran.
+  */
+boolean I_cancel_job(jobpool_t *pool, job_t *job)
+{
+	boolean locked = I_LockJobPool(pool);
+	boolean cancelled = false;
+
+	if (job->state == JOB_QUEUED)
+	{
+		I_UnqueueJob(pool, job);
+		cancelled = true;
+	}
+
+#ifdef HAVE_THREADS
+	if (locked)
+	{
+		while (job->state == JOB_RUNNING)
+			I_hold_cond(&pool->donecond, pool->mutex);
+	}
+#endif
+	I_UnlockJobPool(pool, locked);
+
+	return cancelled;
+}
+
+/** Checks whether a job is out of the pool's hands,
+  * either because it was run or because it was never queued.
+  *
+  * \param pool The pool it was queued in.
+  * \param job The job.
+  * \return true if the job is neither queued nor running.
+  */
+boolean I_job_is_done(jobpool_t *pool, job_t *job)
+{
+	boolean locked = I_LockJobPool(pool);
+	boolean done = (job->state == JOB_IDLE);
+	I_UnlockJobPool(pool, locked);
+	return done;
+}
@@ -0,0 +1,80 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  i_jobpool.h
+/// \brief Worker threads that take jobs off a queue
+
+#ifndef __I_JOBPOOL__
+#define __I_JOBPOOL__
+
+#include "doomtype.h"
+
+#ifdef HAVE_THREADS
+#include "i_threads.h"
+#endif
+
+typedef enum
+{
+	JOB_IDLE, // never queued, or finished
+	JOB_QUEUED,
+	JOB_RUNNING,
+} jobstate_t;
+
+typedef struct job_s job_t;
+
+// worker is which of the pool's threads runs the job, 1 and up,
+// or 0 for the thread that queued it
+typedef void (*I_job_fn)(job_t *job, INT32 worker);
+
+// Put one of these at the start of whatever the job works on.
+// The pool only ever touches it under its lock.
+struct job_s
+{
+	I_job_fn func;
+	job_t *next; // in the queue
+	jobstate_t state;
+};
+
+typedef struct jobpool_s
+{
+	const char *name; // given to its threads
+	INT32 maxthreads; // however many cores there are
+
+	INT32 numthreads; // spawned so far
+	INT32 numstarted; // running their loop, for numbering them
+	job_t *head, *tail; // queued jobs, oldest first
+	INT32 numrunning;
+	boolean quit;
+
+	struct jobpool_s *next; // in the list of started pools
+
+#ifdef HAVE_THREADS
+	I_mutex mutex;
+	I_cond cond; // a job was queued, or the threads should quit
+	I_cond donecond; // a job was finished
+#endif
+} jobpool_t;
+
+#ifdef HAVE_THREADS
+#define JOBPOOL_INIT(name, maxthreads) {name, maxthreads, 0, 0, NULL, NULL, 0, false, NULL, NULL, NULL, NULL}
+#else
+#define JOBPOOL_INIT(name, maxthreads) {name, maxthreads, 0, 0, NULL, NULL, 0, false, NULL}
+#endif
+
+INT32   I_start_job_pool (jobpool_t *pool, INT32 count);
+
+void    I_queue_job      (jobpool_t *pool, job_t *job, I_job_fn func);
+
+void    I_finish_jobs    (jobpool_t *pool);
+void    I_wait_jobs      (jobpool_t *pool);
+
+void    I_wait_job       (jobpool_t *pool, job_t *job);
+boolean I_cancel_job     (jobpool_t *pool, job_t *job);
+boolean I_job_is_done    (jobpool_t *pool, job_t *job);
+
+#endif/*__I_JOBPOOL__*/
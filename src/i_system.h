@@ -58,6 +58,12 @@ size_t I_GetRandomBytes(char *destination, size_t count);
   */
 UINT64 I_GetPrecisePrecision(void);
 
+/**	\brief	Get the number of logical CPU cores, for sizing worker thread pools.
+
+	\return	the number of logical CPU cores, at least 1
+*/
+INT32 I_GetCPUCount(void);
+
 /** \brief  Get the current time in rendering tics, including fractions.
 */
 double I_GetFrameTime(void);
@@ -283,6 +289,7 @@ typedef struct {
 	int PPCMM64    : 1; ///< PowerPC Movemem 64bit ok?
 	int ALPHAbyte  : 1; ///< ?
 	int PAE        : 1; ///< Physical Address Extension
+	int AVX2       : 1; ///< AVX2 features
 	int CPUs       : 8;
 } CPUInfoFlags;
 
@@ -30,6 +30,7 @@
 #ifdef LUA_ALLOW_BYTECODE
 #include "d_netfil.h" // for LUA_DumpFile
 #endif
+#include "m_trace.h"
 
 #include "lua_script.h"
 #include "lua_libs.h"
@@ -656,7 +657,9 @@ void LUA_LoadLump(UINT16 wad, UINT16 lump, boolean noresults)
 		name[len] = '\0';
 	}
 
+	M_TraceBegin("LUA_LoadLump", name);
 	LUA_LoadFile(&f, name, noresults); // actually load file!
+	M_TraceEnd();
 
 	free(name);
 	Z_Free(f.data);
@@ -822,6 +825,9 @@ lpushed_t LUA_RawPushUserdata(lua_State *L, void *data)
 
 		// stack is left with the userdata on top, as if getting it had originally succeeded.
 
+		// Zone memory has to tell us when it goes
+		Z_MarkUserdata(data);
+
 		status = LPUSHED_NEW;
 	}
 	else
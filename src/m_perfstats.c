@@ -18,6 +18,13 @@
 #include "z_zone.h"
 #include "p_local.h"
 #include "r_fps.h"
+#include "r_bsp.h" // drawsegs
+#include "r_draw.h" // topleft
+#include "p_setup.h" // numcoopstarts
+#include "g_game.h"
+#include "m_misc.h" // FIL_FileExists
+#include "d_main.h" // srb2home
+#include "console.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -64,6 +71,8 @@ static ps_metric_t ps_precipcount = {0};
 static ps_metric_t ps_removecount = {0};
 
 ps_metric_t ps_checkposition_calls = {0};
+ps_metric_t ps_checksight_calls = {0};
+ps_metric_t ps_checksight_rejects = {0};
 
 ps_metric_t ps_lua_thinkframe_time = {0};
 ps_metric_t ps_lua_mobjhooks = {0};
@@ -103,6 +112,7 @@ perfstatrow_t rendertime_rows[] = {
 	{" portals", " Portals+Skybox:", &ps_sw_portaltime, PS_TIME|PS_LEVEL|PS_SW},
 	{" planes ", " R_DrawPlanes:  ", &ps_sw_planetime, PS_TIME|PS_LEVEL|PS_SW},
 	{" masked ", " R_DrawMasked:  ", &ps_sw_maskedtime, PS_TIME|PS_LEVEL|PS_SW},
+	{" transp ", " Transpose:     ", &ps_sw_transposetime, PS_TIME|PS_LEVEL|PS_SW},
 	{" other  ", " Other:         ", &ps_otherrendertime, PS_TIME|PS_LEVEL|PS_SW},
 
 	{"ui     ", "UI render:     ", &ps_uitime, PS_TIME},
@@ -117,9 +127,14 @@ perfstatrow_t gamelogicbrief_row[] = {
 
 perfstatrow_t commoncounter_rows[] = {
 	{"bspcall", "BSP calls:   ", &ps_numbspcalls, 0},
+	{" pvscul", " PVS culled: ", &ps_numpvsculled, PS_SW},
 	{"sprites", "Sprites:     ", &ps_numsprites, 0},
 	{"drwnode", "Drawnodes:   ", &ps_numdrawnodes, 0},
 	{"plyobjs", "Polyobjects: ", &ps_numpolyobjects, 0},
+	{"visplns", "Visplanes:   ", &ps_numvisplanes, PS_SW},
+	{" splits", " Splits:     ", &ps_visplanesplits, PS_SW},
+	{" reused", " Reused:     ", &ps_visplanereuse, PS_SW},
+	{" pool  ", " Pool size:  ", &ps_visplanepool, PS_SW},
 	{0}
 };
 
@@ -146,6 +161,53 @@ perfstatrow_t batchcalls_rows[] = {
 };
 #endif
 
+// Drawer stats columns
+
+perfstatrow_t colpixel_rows[] = {
+	{"base   ", "Base:          ", &ps_sw_colpixels[COLDRAWFUNC_BASE], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"fuzzy  ", "Fuzzy:         ", &ps_sw_colpixels[COLDRAWFUNC_FUZZY], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"trans  ", "Translucent:   ", &ps_sw_colpixels[COLDRAWFUNC_TRANS], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"shade  ", "Shade:         ", &ps_sw_colpixels[COLDRAWFUNC_SHADE], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"trtrans", "Transl+trans:  ", &ps_sw_colpixels[COLDRAWFUNC_TRANSTRANS], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"2smpat ", "Multipatch:    ", &ps_sw_colpixels[COLDRAWFUNC_TWOSMULTIPATCH], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"2smptrn", "Multipatch tr: ", &ps_sw_colpixels[COLDRAWFUNC_TWOSMULTIPATCHTRANS], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"fog    ", "Fog:           ", &ps_sw_colpixels[COLDRAWFUNC_FOG], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"other  ", "Other:         ", &ps_sw_colpixels[COLDRAWFUNC_MAX], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{0}
+};
+
+perfstatrow_t spanpixel_rows[] = {
+	{"base   ", "Base:          ", &ps_sw_spanpixels[SPANDRAWFUNC_BASE], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"trans  ", "Translucent:   ", &ps_sw_spanpixels[SPANDRAWFUNC_TRANS], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"tilt   ", "Tilted:        ", &ps_sw_spanpixels[SPANDRAWFUNC_TILTED], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"tlttrns", "Tilted trans:  ", &ps_sw_spanpixels[SPANDRAWFUNC_TILTEDTRANS], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"splat  ", "Splat:         ", &ps_sw_spanpixels[SPANDRAWFUNC_SPLAT], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"trsplat", "Trans splat:   ", &ps_sw_spanpixels[SPANDRAWFUNC_TRANSSPLAT], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"tltsplt", "Tilted splat:  ", &ps_sw_spanpixels[SPANDRAWFUNC_TILTEDSPLAT], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"sprite ", "Sprite:        ", &ps_sw_spanpixels[SPANDRAWFUNC_SPRITE], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"trsprit", "Trans sprite:  ", &ps_sw_spanpixels[SPANDRAWFUNC_TRANSSPRITE], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"tltsprt", "Tilted sprite: ", &ps_sw_spanpixels[SPANDRAWFUNC_TILTEDSPRITE], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"tltrspr", "Tilt tr sprite:", &ps_sw_spanpixels[SPANDRAWFUNC_TILTEDTRANSSPRITE], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"water  ", "Water:         ", &ps_sw_spanpixels[SPANDRAWFUNC_WATER], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"tltwatr", "Tilted water:  ", &ps_sw_spanpixels[SPANDRAWFUNC_TILTEDWATER], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"solid  ", "Solid:         ", &ps_sw_spanpixels[SPANDRAWFUNC_SOLID], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"trsolid", "Trans solid:   ", &ps_sw_spanpixels[SPANDRAWFUNC_TRANSSOLID], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"tltsold", "Tilted solid:  ", &ps_sw_spanpixels[SPANDRAWFUNC_TILTEDSOLID], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"tltrsld", "Tilt tr solid: ", &ps_sw_spanpixels[SPANDRAWFUNC_TILTEDTRANSSOLID], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"wtrsold", "Water solid:   ", &ps_sw_spanpixels[SPANDRAWFUNC_WATERSOLID], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"tlwtrsd", "Tilt wtr solid:", &ps_sw_spanpixels[SPANDRAWFUNC_TILTEDWATERSOLID], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"fog    ", "Fog:           ", &ps_sw_spanpixels[SPANDRAWFUNC_FOG], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"tltfog ", "Tilted fog:    ", &ps_sw_spanpixels[SPANDRAWFUNC_TILTEDFOG], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{"other  ", "Other:         ", &ps_sw_spanpixels[SPANDRAWFUNC_MAX], PS_LEVEL|PS_SW|PS_HIDE_ZERO},
+	{0}
+};
+
+perfstatrow_t pixeltotal_rows[] = {
+	{"pixels ", "Pixels drawn:  ", &ps_sw_pixelsdrawn, PS_LEVEL|PS_SW},
+	{"ovrdrw%", "Overdraw %:    ", &ps_sw_overdraw, PS_LEVEL|PS_SW},
+	{0}
+};
+
 // Game logic stats columns
 
 perfstatrow_t gamelogic_rows[] = {
@@ -179,6 +241,8 @@ perfstatrow_t thinkercount_rows[] = {
 perfstatrow_t misc_calls_rows[] = {
 	{"lmhook", "Lua mobj hooks: ", &ps_lua_mobjhooks, PS_LEVEL},
 	{"chkpos", "P_CheckPosition:", &ps_checkposition_calls, PS_LEVEL},
+	{"chksgt", "P_CheckSight:   ", &ps_checksight_calls, PS_LEVEL},
+	{" rejct", " Rejected:      ", &ps_checksight_rejects, PS_LEVEL},
 	{0}
 };
 
@@ -470,7 +534,8 @@ static void PS_UpdateFrameStats(void)
 				ps_sw_spritecliptime.value.p +
 				ps_sw_portaltime.value.p +
 				ps_sw_planetime.value.p +
-				ps_sw_maskedtime.value.p;
+				ps_sw_maskedtime.value.p +
+				ps_sw_transposetime.value.p;
 		}
 	}
 
@@ -478,7 +543,15 @@ static void PS_UpdateFrameStats(void)
 	{
 		PS_UpdateRowHistories(rendertime_rows, true);
 		if (PS_IsLevelActive())
+		{
 			PS_UpdateRowHistories(commoncounter_rows, true);
+			if (cv_perfstats.value == 4)
+			{
+				PS_UpdateRowHistories(colpixel_rows, true);
+				PS_UpdateRowHistories(spanpixel_rows, true);
+				PS_UpdateRowHistories(pixeltotal_rows, true);
+			}
+		}
 
 		if (R_UsingFrameInterpolation())
 			PS_UpdateRowHistories(interpolation_rows, true);
@@ -697,6 +770,43 @@ static void PS_DrawGameLogicStats(void)
 	PS_DrawPerfRows(x, y, V_PURPLEMAP, misc_calls_rows);
 }
 
+static void PS_DrawDrawerStats(void)
+{
+	const boolean hires = PS_HighResolution();
+	const INT32 flags = V_MONOSPACE | V_ALLOWLOWERCASE | V_GRAYMAP;
+	int x, y;
+
+	PS_DrawDescriptorHeader();
+
+	if (!PS_IsLevelActive())
+		return;
+
+	if (rendermode != render_soft)
+	{
+		V_DrawThinString(20, 10, flags, "Only the Software renderer counts its drawers.");
+		return;
+	}
+
+	// Pixels written by each drawer
+	x = hires ? 115 : 90;
+	if (hires)
+	{
+		V_DrawSmallString(20, 10, flags, "Column pixels:");
+		V_DrawSmallString(x, 10, flags, "Span pixels:");
+		y = 15;
+	}
+	else
+	{
+		V_DrawThinString(20, 10, flags, "Columns:");
+		V_DrawThinString(x, 10, flags, "Spans:");
+		y = 18;
+	}
+
+	PS_DrawPerfRows(x, y, V_BLUEMAP, spanpixel_rows);
+	y = PS_DrawPerfRows(20, y, V_YELLOWMAP, colpixel_rows);
+	PS_DrawPerfRows(20, y + (hires ? 5 : 4), V_PURPLEMAP, pixeltotal_rows);
+}
+
 static void PS_DrawThinkFrameStats(void)
 {
 	char s[100];
@@ -810,6 +920,11 @@ void M_DrawPerfStats(void)
 			PS_DrawThinkFrameStats();
 		}
 	}
+	else if (cv_perfstats.value == 4) // drawers
+	{
+		PS_UpdateFrameStats();
+		PS_DrawDrawerStats();
+	}
 }
 
 // remove and unallocate history from all metrics
@@ -840,3 +955,302 @@ void PS_SampleSize_OnChange(void)
 	if (cv_ps_samplesize.value > 1)
 		PS_ClearHistory();
 }
+
+// ==========================================================================
+//                   RENDER BENCHMARK
+// ==========================================================================
+
+// renderbench loads a map, then renders it in the Software renderer from
+// the same views every time: each player start, and the centers of the
+// subsectors under a grid laid over the map, each looking out at
+// RENDERBENCHANGLES angles. The results are added to renderbench.csv.
+
+#define RENDERBENCHSAMPLES 64 // grid points, unless told otherwise
+#define MAXRENDERBENCHSAMPLES 16384 // a 128x128 grid
+#define RENDERBENCHANGLES 8 // ANGLE_45 apart
+
+typedef struct
+{
+	fixed_t x, y;
+} renderbenchpoint_t;
+
+static struct
+{
+	INT16 map; // 0 when there's no benchmark waiting for its map
+	INT32 samples;
+	boolean quit; // started by -renderbench
+} renderbench;
+
+// The stages of R_RenderPlayerView that the benchmark times
+static ps_metric_t *const renderbenchstages[] = {
+	&ps_bsptime, &ps_sw_spritecliptime, &ps_sw_portaltime,
+	&ps_sw_planetime, &ps_sw_maskedtime, &ps_sw_transposetime
+};
+
+#define NUMRENDERBENCHSTAGES (sizeof (renderbenchstages) / sizeof (renderbenchstages[0]))
+
+static int PS_CompareRenderBenchTimes(const void *a, const void *b)
+{
+	const precise_t ta = *(const precise_t *)a, tb = *(const precise_t *)b;
+	return (ta > tb) - (ta < tb);
+}
+
+static void PS_AddRenderBenchPoint(renderbenchpoint_t *points, size_t *numpoints, fixed_t x, fixed_t y)
+{
+	points[*numpoints].x = x;
+	points[*numpoints].y = y;
+	(*numpoints)++;
+}
+
+// Adds the center of the subsector under each point of an n by n grid
+// over the map, skipping closed sectors and subsectors already added.
+static void PS_AddRenderBenchGrid(renderbenchpoint_t *points, size_t *numpoints, INT32 n)
+{
+	fixed_t minx = INT32_MAX, miny = INT32_MAX, maxx = INT32_MIN, maxy = INT32_MIN;
+	INT32 gx, gy;
+	size_t i;
+
+	for (i = 0; i < numvertexes; i++)
+	{
+		minx = min(minx, vertexes[i].x);
+		maxx = max(maxx, vertexes[i].x);
+		miny = min(miny, vertexes[i].y);
+		maxy = max(maxy, vertexes[i].y);
+	}
+
+	validcount++;
+
+	for (gy = 0; gy < n; gy++)
+		for (gx = 0; gx < n; gx++)
+		{
+			const fixed_t x = minx + (fixed_t)(((INT64)maxx - minx) * (2*gx + 1) / (2*n));
+			const fixed_t y = miny + (fixed_t)(((INT64)maxy - miny) * (2*gy + 1) / (2*n));
+			subsector_t *sub = R_PointInSubsector(x, y);
+			INT64 cx = 0, cy = 0;
+			INT32 l;
+
+			if (sub->validcount == validcount || !sub->numlines
+				|| sub->sector->ceilingheight <= sub->sector->floorheight)
+				continue;
+			sub->validcount = validcount;
+
+			for (l = 0; l < sub->numlines; l++)
+			{
+				cx += segs[sub->firstline + l].v1->x;
+				cy += segs[sub->firstline + l].v1->y;
+			}
+
+			PS_AddRenderBenchPoint(points, numpoints, (fixed_t)(cx / sub->numlines), (fixed_t)(cy / sub->numlines));
+		}
+}
+
+// Writes a row of results to renderbench.csv, or to the console if it
+// can't be opened.
+static void PS_WriteRenderBenchResults(size_t numviews, precise_t *frametimes, precise_t *stagetimes,
+	INT64 totaldrawsegs, INT32 maxdrawsegs, INT64 totalvisplanes, INT32 maxvisplanes)
+{
+	const double mspertick = 1000.0 / I_GetPrecisePrecision();
+	const char *csvpath = va("%s"PATHSEP"%s", srb2home, "renderbench.csv");
+	const char *header = "map,views,meanms,p95ms,maxms,bspms,spriteclipms,portalms,planems,maskedms,transposems,"
+		"meandrawsegs,maxdrawsegs,meanvisplanes,maxvisplanes,vidwidth,vidheight,renderthreads\n";
+	char row[512];
+	boolean headerrow = !FIL_FileExists(csvpath);
+	precise_t total = 0;
+	size_t i, p95;
+	FILE *f;
+
+	for (i = 0; i < numviews; i++)
+		total += frametimes[i];
+
+	qsort(frametimes, numviews, sizeof (precise_t), PS_CompareRenderBenchTimes);
+	p95 = (numviews * 95 + 99) / 100 - 1;
+
+	snprintf(row, sizeof row, "\"%s\",%s,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f,%d,%.1f,%d,%d,%d,%d\n",
+		G_BuildMapName(renderbench.map), sizeu1(numviews),
+		total * mspertick / numviews, frametimes[p95] * mspertick, frametimes[numviews - 1] * mspertick,
+		stagetimes[0] * mspertick / numviews, stagetimes[1] * mspertick / numviews,
+		stagetimes[2] * mspertick / numviews, stagetimes[3] * mspertick / numviews,
+		stagetimes[4] * mspertick / numviews, stagetimes[5] * mspertick / numviews,
+		(double)totaldrawsegs / numviews, maxdrawsegs, (double)totalvisplanes / numviews, maxvisplanes,
+		vid.width, vid.height, cv_renderthreads.value);
+
+	CONS_Printf(M_GetText("%s: %s views, %.2f ms mean, %.2f ms p95, %.2f ms max\n"),
+		G_BuildMapName(renderbench.map), sizeu1(numviews),
+		total * mspertick / numviews, frametimes[p95] * mspertick, frametimes[numviews - 1] * mspertick);
+
+	f = fopen(csvpath, "a+");
+
+	if (f)
+	{
+		if (headerrow)
+			fputs(header, f);
+		fputs(row, f);
+		fclose(f);
+		CONS_Printf("Renderbench results saved to '%s'\n", csvpath);
+	}
+	else
+	{
+		// Just print the CSV output to console
+		CON_LogMessage(header);
+		CON_LogMessage(row);
+	}
+}
+
+static void PS_RunRenderBench(void)
+{
+	player_t *player = &players[consoleplayer];
+	const fixed_t oldtimefrac = rendertimefrac;
+	const INT32 oldawayviewtics = player->awayviewtics;
+	const angle_t oldawayviewaiming = player->awayviewaiming;
+	mobj_t *oldawayviewmobj = player->awayviewmobj;
+	mobj_t *viewmobj;
+	renderbenchpoint_t *points;
+	size_t numpoints = 0, numviews, v;
+	precise_t *frametimes, stagetimes[NUMRENDERBENCHSTAGES] = {0};
+	INT64 totaldrawsegs = 0, totalvisplanes = 0;
+	INT32 maxdrawsegs = 0, maxvisplanes = 0, n;
+	INT32 i;
+	double gridsize;
+
+	// Whatever's left of the level's precaching would be timed otherwise.
+	R_FinishPrecacheLevel();
+
+	gridsize = ceil(sqrt((double)renderbench.samples));
+	n = (INT32)gridsize;
+	points = Z_Malloc((MAXPLAYERS + MAX_DM_STARTS + n*n) * sizeof (*points), PU_STATIC, NULL);
+
+	for (i = 0; i < numcoopstarts; i++)
+		PS_AddRenderBenchPoint(points, &numpoints, playerstarts[i]->x << FRACBITS, playerstarts[i]->y << FRACBITS);
+	for (i = 0; i < numdmstarts; i++)
+		PS_AddRenderBenchPoint(points, &numpoints, deathmatchstarts[i]->x << FRACBITS, deathmatchstarts[i]->y << FRACBITS);
+	PS_AddRenderBenchGrid(points, &numpoints, n);
+
+	if (!numpoints)
+	{
+		CONS_Alert(CONS_WARNING, M_GetText("%s has nowhere to put the view.\n"), G_BuildMapName(renderbench.map));
+		Z_Free(points);
+		return;
+	}
+
+	numviews = numpoints * RENDERBENCHANGLES;
+	frametimes = Z_Malloc(numviews * sizeof (*frametimes), PU_STATIC, NULL);
+
+	// The views are cut-away views from a camera of our own.
+	viewmobj = P_SpawnMobj(points[0].x, points[0].y, 0, MT_ALTVIEWMAN);
+	P_SetTarget(&player->awayviewmobj, viewmobj);
+	player->awayviewaiming = 0;
+	rendertimefrac = FRACUNIT;
+
+	for (v = 0; v < numviews; v++)
+	{
+		const renderbenchpoint_t *point = &points[v / RENDERBENCHANGLES];
+		precise_t time;
+		size_t s;
+
+		// Cut-away views are 20 units above the camera,
+		// which puts this at a player's eye height of 41.
+		P_SetOrigin(viewmobj, point->x, point->y, 0);
+		viewmobj->z = min(viewmobj->floorz + 21*FRACUNIT, viewmobj->ceilingz - 20*FRACUNIT);
+		viewmobj->angle = (angle_t)(v % RENDERBENCHANGLES) * ANGLE_45;
+		player->awayviewtics = 1;
+
+		topleft = viewscreen + viewwindowy*columnpitch + viewwindowx*spanpitch;
+
+		// The first time around loads the textures for the view.
+		R_RenderPlayerView(player);
+
+		time = I_GetPreciseTime();
+		R_RenderPlayerView(player);
+		frametimes[v] = I_GetPreciseTime() - time;
+
+		for (s = 0; s < NUMRENDERBENCHSTAGES; s++)
+			stagetimes[s] += renderbenchstages[s]->value.p;
+
+		totaldrawsegs += ds_p - drawsegs;
+		maxdrawsegs = max(maxdrawsegs, (INT32)(ds_p - drawsegs));
+		totalvisplanes += ps_numvisplanes.value.i;
+		maxvisplanes = max(maxvisplanes, ps_numvisplanes.value.i);
+	}
+
+	player->awayviewtics = oldawayviewtics;
+	player->awayviewaiming = oldawayviewaiming;
+	P_SetTarget(&player->awayviewmobj, oldawayviewmobj);
+	P_RemoveMobj(viewmobj);
+	rendertimefrac = oldtimefrac;
+
+	PS_WriteRenderBenchResults(numviews, frametimes, stagetimes, totaldrawsegs, maxdrawsegs, totalvisplanes, maxvisplanes);
+
+	Z_Free(frametimes);
+	Z_Free(points);
+}
+
+/** Queues a render benchmark for when its map has loaded.
+  *
+  * \param map Map to benchmark.
+  * \param samples Number of grid points to take views from, or 0 for
+  *                the default. Capped at MAXRENDERBENCHSAMPLES.
+  * \param quit Quit the game once it's done, for -renderbench.
+  */
+void PS_StartRenderBench(INT16 map, INT32 samples, boolean quit)
+{
+	renderbench.map = map;
+	renderbench.samples = (samples > 0) ? min(samples, MAXRENDERBENCHSAMPLES) : RENDERBENCHSAMPLES;
+	renderbench.quit = quit;
+}
+
+/** Runs the render benchmark, if its map is the one that's loaded.
+  * Called every tic.
+  */
+void PS_RenderBenchTicker(void)
+{
+	if (!renderbench.map || gamestate != GS_LEVEL || gamemap != renderbench.map)
+		return;
+
+	if (rendermode == render_soft)
+		PS_RunRenderBench();
+	else
+		CONS_Alert(CONS_WARNING, M_GetText("renderbench only works in the Software renderer.\n"));
+
+	renderbench.map = 0;
+
+	if (renderbench.quit)
+		I_Quit();
+}
+
+/** The function called by the "renderbench" console command.
+  */
+void Command_Renderbench_f(void)
+{
+	INT32 map;
+
+	if (COM_Argc() < 2 || COM_Argc() > 3)
+	{
+		CONS_Printf(M_GetText("renderbench <map> [samples]: time the Software renderer from views across a map\n"));
+		return;
+	}
+
+	if (rendermode != render_soft)
+	{
+		CONS_Printf(M_GetText("You must be using the software renderer.\n"));
+		return;
+	}
+
+	if (netgame || multiplayer)
+	{
+		CONS_Printf(M_GetText("You can't use this in multiplayer.\n"));
+		return;
+	}
+
+	map = G_FindMapByNameOrCode(COM_Argv(1), NULL);
+	if (!map)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Could not find any map described as '%s'.\n"), COM_Argv(1));
+		return;
+	}
+
+	// Moving the view around the map is as good as warping.
+	G_SetUsedCheats(false);
+
+	PS_StartRenderBench((INT16)map, (COM_Argc() == 3) ? atoi(COM_Argv(2)) : 0, false);
+	D_MapChange(map, gametype, false, true, 0, false, false);
+}
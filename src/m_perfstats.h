@@ -42,6 +42,8 @@ extern ps_metric_t ps_thinkertime;
 extern ps_metric_t ps_thlist_times[];
 
 extern ps_metric_t ps_checkposition_calls;
+extern ps_metric_t ps_checksight_calls;
+extern ps_metric_t ps_checksight_rejects;
 
 extern ps_metric_t ps_lua_thinkframe_time;
 extern ps_metric_t ps_lua_mobjhooks;
@@ -57,4 +59,8 @@ void M_DrawPerfStats(void);
 void PS_PerfStats_OnChange(void);
 void PS_SampleSize_OnChange(void);
 
+void PS_StartRenderBench(INT16 map, INT32 samples, boolean quit);
+void PS_RenderBenchTicker(void);
+void Command_Renderbench_f(void);
+
 #endif
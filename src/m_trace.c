@@ -0,0 +1,180 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file m_trace.c
+/// \brief Nested phase timing, written out as Chrome trace JSON.
+///
+///        The file can be opened with chrome://tracing or ui.perfetto.dev.
+///        Only the main thread records phases. Nothing is recorded, and
+///        M_TraceBegin/M_TraceEnd return straight away, unless a trace
+///        was started.
+
+#include "doomdef.h"
+#include "m_trace.h"
+#include "i_system.h"
+
+#define MAXTRACEDEPTH 32
+
+typedef struct
+{
+	const char *name;
+	char *detail;
+	precise_t start, duration;
+} traceevent_t;
+
+static char *tracefilename = NULL;
+static precise_t tracestart;
+
+static traceevent_t *traceevents = NULL;
+static size_t numtraceevents = 0, maxtraceevents = 0;
+
+static size_t tracestack[MAXTRACEDEPTH];
+static INT32 tracedepth = 0;
+
+/** Starts recording phases. The trace is written when M_StopTrace is called.
+  *
+  * \param filename Where to write the trace.
+  * \sa M_StopTrace
+  */
+void M_StartTrace(const char *filename)
+{
+	if (tracefilename)
+		return;
+
+	tracefilename = strdup(filename);
+	tracestart = I_GetPreciseTime();
+	tracedepth = 0;
+}
+
+/** Begins timing a phase. Every call must be matched by a call to M_TraceEnd.
+  *
+  * \param name Name of the phase. Not copied, so it should be a literal.
+  * \param detail What the phase is working on, such as a file or lump name,
+  *               or NULL.
+  * \sa M_TraceEnd
+  */
+void M_TraceBegin(const char *name, const char *detail)
+{
+	traceevent_t *event;
+
+	if (!tracefilename)
+		return;
+
+	// Too deep to record, but M_TraceEnd still has to balance it
+	if (tracedepth >= MAXTRACEDEPTH)
+	{
+		tracedepth++;
+		return;
+	}
+
+	if (numtraceevents == maxtraceevents)
+	{
+		maxtraceevents = maxtraceevents ? maxtraceevents * 2 : 256;
+		traceevents = realloc(traceevents, maxtraceevents * sizeof (*traceevents));
+		if (!traceevents)
+			I_Error("M_TraceBegin: out of memory");
+	}
+
+	event = &traceevents[numtraceevents];
+	event->name = name;
+	event->detail = detail ? strdup(detail) : NULL;
+	event->duration = 0;
+
+	tracestack[tracedepth++] = numtraceevents++;
+	event->start = I_GetPreciseTime();
+}
+
+/** Ends the most recently begun phase.
+  *
+  * \sa M_TraceBegin
+  */
+void M_TraceEnd(void)
+{
+	precise_t now;
+
+	if (!tracefilename || !tracedepth)
+		return;
+
+	now = I_GetPreciseTime();
+	if (--tracedepth < MAXTRACEDEPTH)
+	{
+		traceevent_t *event = &traceevents[tracestack[tracedepth]];
+		event->duration = now - event->start;
+	}
+}
+
+// Writes a JSON string, quotes included
+static void M_WriteTraceString(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++)
+	{
+		if (*s == '"' || *s == '\\')
+			fprintf(f, "\\%c", *s);
+		else if ((UINT8)*s < 0x20)
+			fprintf(f, "\\u%04x", (UINT8)*s);
+		else
+			fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+/** Stops recording phases, and writes the trace to the file given to
+  * M_StartTrace. Phases that are still open are closed first.
+  *
+  * \sa M_StartTrace
+  */
+void M_StopTrace(void)
+{
+	double scale = 1000000.0 / I_GetPrecisePrecision(); // ticks to microseconds
+	FILE *f;
+	size_t i;
+
+	if (!tracefilename)
+		return;
+
+	while (tracedepth)
+		M_TraceEnd();
+
+	f = fopen(tracefilename, "w");
+	if (!f)
+		CONS_Alert(CONS_ERROR, M_GetText("Couldn't write trace to %s\n"), tracefilename);
+	else
+	{
+		fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		for (i = 0; i < numtraceevents; i++)
+		{
+			traceevent_t *event = &traceevents[i];
+
+			fprintf(f, "{\"name\":");
+			M_WriteTraceString(f, event->name);
+			fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f",
+				(event->start - tracestart) * scale, event->duration * scale);
+			if (event->detail)
+			{
+				fprintf(f, ",\"args\":{\"detail\":");
+				M_WriteTraceString(f, event->detail);
+				fputc('}', f);
+			}
+			fprintf(f, "}%s\n", (i + 1 < numtraceevents) ? "," : "");
+		}
+		fprintf(f, "]}\n");
+		fclose(f);
+
+		CONS_Printf(M_GetText("Wrote %s phases to %s\n"), sizeu1(numtraceevents), tracefilename);
+	}
+
+	for (i = 0; i < numtraceevents; i++)
+		free(traceevents[i].detail);
+	free(traceevents);
+	traceevents = NULL;
+	numtraceevents = maxtraceevents = 0;
+
+	free(tracefilename);
+	tracefilename = NULL;
+}
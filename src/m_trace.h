@@ -0,0 +1,26 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file m_trace.h
+/// \brief Nested phase timing, written out as Chrome trace JSON.
+
+#ifndef __M_TRACE_H__
+#define __M_TRACE_H__
+
+#include "doomtype.h"
+
+// Start recording phases, to be written to filename by M_StopTrace
+void M_StartTrace(const char *filename);
+void M_StopTrace(void);
+
+// Time a phase. Phases begun while another is open are nested inside it.
+// name must stay valid until the trace is written; detail is copied.
+void M_TraceBegin(const char *name, const char *detail);
+void M_TraceEnd(void);
+
+#endif
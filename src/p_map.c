@@ -4505,10 +4505,19 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 static msecnode_t *headsecnode = NULL;
 static mprecipsecnode_t *headprecipsecnode = NULL;
 
+static mempool_t *secnodepool = NULL;
+static mempool_t *precipsecnodepool = NULL;
+
 void P_Initsecnode(void)
 {
 	headsecnode = NULL;
 	headprecipsecnode = NULL;
+
+	if (!secnodepool)
+	{
+		secnodepool = Z_CreatePool("msecnode_t", sizeof (msecnode_t));
+		precipsecnodepool = Z_CreatePool("mprecipsecnode_t", sizeof (mprecipsecnode_t));
+	}
 }
 
 // P_GetSecnode() retrieves a node from the freelist. The calling routine
@@ -4524,7 +4533,7 @@ static msecnode_t *P_GetSecnode(void)
 		headsecnode = headsecnode->m_thinglist_next;
 	}
 	else
-		node = Z_Calloc(sizeof (*node), PU_LEVEL, NULL);
+		node = Z_PoolCalloc(secnodepool, PU_LEVEL, NULL);
 	return node;
 }
 
@@ -4538,7 +4547,7 @@ static mprecipsecnode_t *P_GetPrecipSecnode(void)
 		headprecipsecnode = headprecipsecnode->m_thinglist_next;
 	}
 	else
-		node = Z_Calloc(sizeof (*node), PU_LEVEL, NULL);
+		node = Z_PoolCalloc(precipsecnodepool, PU_LEVEL, NULL);
 	return node;
 }
 
@@ -42,8 +42,17 @@ consvar_t cv_movebob = CVAR_INIT ("movebob", "1.0", CV_FLOAT|CV_SAVE, CV_BobSpee
 
 actioncache_t actioncachehead;
 
+mempool_t *mobjpool = NULL;
+mempool_t *precipmobjpool = NULL;
+
 static mobj_t *overlaycap = NULL;
 
+void P_InitMobjPools(void)
+{
+	mobjpool = Z_CreatePool("mobj_t", sizeof (mobj_t));
+	precipmobjpool = Z_CreatePool("precipmobj_t", sizeof (precipmobj_t));
+}
+
 void P_InitCachedActions(void)
 {
 	actioncachehead.prev = actioncachehead.next = &actioncachehead;
@@ -10656,7 +10665,7 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 		type = MT_RAY;
 	}
 
-	mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+	mobj = Z_PoolCalloc(mobjpool, PU_LEVEL, NULL);
 
 	// this is officially a mobj, declared as soon as possible.
 	mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
@@ -11047,7 +11056,7 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 static precipmobj_t *P_SpawnPrecipMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 {
 	state_t *st;
-	precipmobj_t *mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+	precipmobj_t *mobj = Z_PoolCalloc(precipmobjpool, PU_LEVEL, NULL);
 	fixed_t starting_floorz;
 
 	mobj->x = x;
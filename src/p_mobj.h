@@ -28,6 +28,9 @@
 // Needs precompiled tables/data structures.
 #include "info.h"
 
+// Mobjs come from their own memory pools.
+#include "z_zone.h"
+
 //
 // NOTES: mobj_t
 //
@@ -478,6 +481,11 @@ typedef struct actioncache_s
 
 extern actioncache_t actioncachehead;
 
+extern mempool_t *mobjpool;
+extern mempool_t *precipmobjpool;
+
+void P_InitMobjPools(void);
+
 void P_InitCachedActions(void);
 void P_RunCachedActions(void);
 void P_AddCachedAction(mobj_t *mobj, INT32 statenum);
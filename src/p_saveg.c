@@ -2833,13 +2833,13 @@ static thinker_t* LoadMobjThinker(actionf_p1 thinker)
 			return NULL;
 		}
 
-		mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+		mobj = Z_PoolCalloc(mobjpool, PU_LEVEL, NULL);
 
 		mobj->spawnpoint = &mapthings[spawnpointnum];
 		mapthings[spawnpointnum].mobj = mobj;
 	}
 	else
-		mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+		mobj = Z_PoolCalloc(mobjpool, PU_LEVEL, NULL);
 
 	// declare this as a valid mobj as soon as possible.
 	mobj->thinker.function.acp1 = thinker;
@@ -35,6 +35,7 @@
 #include "r_sky.h"
 #include "r_draw.h"
 #include "r_fps.h" // R_ResetViewInterpolation in level load
+#include "r_pvs.h"
 
 #include "s_sound.h"
 #include "st_stuff.h"
@@ -143,6 +144,7 @@ mobj_t **blocklinks;
 // Without special effect, this could be used as a PVS lookup as well.
 //
 UINT8 *rejectmatrix;
+static size_t rejectsize;
 
 // Maintain single and multi player starting spots.
 INT32 numdmstarts, numcoopstarts, numredctfstarts, numbluectfstarts;
@@ -3937,11 +3939,13 @@ static void P_LoadReject(UINT8 *data, size_t count)
 	if (!count) // zero length, someone probably used ZDBSP
 	{
 		rejectmatrix = NULL;
+		rejectsize = 0;
 		CONS_Debug(DBG_SETUP, "P_LoadReject: REJECT lump has size 0, will not be loaded\n");
 	}
 	else
 	{
 		rejectmatrix = Z_Malloc(count, PU_LEVEL, NULL); // allocate memory for the reject matrix
+		rejectsize = count;
 		M_Memcpy(rejectmatrix, data, count); // copy the data into it
 	}
 }
@@ -3955,12 +3959,137 @@ static void P_LoadMapLUT(const virtres_t *virt)
 	if (virtreject)
 		P_LoadReject(virtreject->data, virtreject->size);
 	else
+	{
 		rejectmatrix = NULL;
+		rejectsize = 0;
+	}
 
 	if (!(virtblockmap && P_LoadBlockMap(virtblockmap->data, virtblockmap->size)))
 		P_CreateBlockMap();
 }
 
+// The generated reject matrix takes numsectors^2 bits, so give up past this.
+#define MAXREJECTSECTORS 8192
+
+static size_t P_RejectGroup(size_t *groups, size_t i)
+{
+	while (groups[i] != i)
+		i = groups[i] = groups[groups[i]];
+	return i;
+}
+
+static void P_RejectLink(size_t *groups, const sector_t *a, const sector_t *b)
+{
+	size_t ga, gb;
+
+	if (!a || !b || a == b)
+		return;
+
+	ga = P_RejectGroup(groups, a - sectors);
+	gb = P_RejectGroup(groups, b - sectors);
+	if (ga < gb)
+		groups[gb] = ga;
+	else
+		groups[ga] = gb;
+}
+
+/** Works out which sectors can never see each other, and marks them in
+  * the reject matrix so P_CheckSight can skip tracing between them.
+  *
+  * Sight can only pass between sectors through two-sided lines, so any
+  * two sectors that aren't joined by a chain of them are rejected.
+  * Heights, FOFs and polyobjects are left out, since they can move and
+  * only ever block sight. Sectors are also joined through segs and
+  * shared vertices, so traces that slip through the corners and unclosed
+  * edges of a map aren't rejected either. Bits from the map's own REJECT
+  * lump are kept.
+  */
+static void P_GenerateReject(void)
+{
+	size_t *groups;
+	UINT8 *matrix;
+	size_t i, j, numgroups = 0, size;
+	const sector_t **vertexsectors;
+
+	if (!numsectors || numsectors > MAXREJECTSECTORS)
+		return;
+
+	groups = Z_Malloc(numsectors * sizeof (*groups), PU_STATIC, NULL);
+	for (i = 0; i < numsectors; i++)
+		groups[i] = i;
+
+	for (i = 0; i < numlines; i++)
+		P_RejectLink(groups, lines[i].frontsector, lines[i].backsector);
+
+	for (i = 0; i < numsubsectors; i++)
+	{
+		const seg_t *seg = &segs[subsectors[i].firstline];
+		INT16 count;
+		for (count = 0; count < subsectors[i].numlines; count++, seg++)
+		{
+			P_RejectLink(groups, subsectors[i].sector, seg->frontsector);
+			P_RejectLink(groups, subsectors[i].sector, seg->backsector);
+		}
+	}
+
+	vertexsectors = Z_Calloc(numvertexes * sizeof (*vertexsectors), PU_STATIC, NULL);
+	for (i = 0; i < numlines; i++)
+	{
+		const vertex_t *v[2] = {lines[i].v1, lines[i].v2};
+		for (j = 0; j < 2; j++)
+		{
+			const size_t vnum = v[j] - vertexes;
+			if (vnum >= numvertexes)
+				continue;
+			if (vertexsectors[vnum])
+				P_RejectLink(groups, vertexsectors[vnum], lines[i].frontsector);
+			else
+				vertexsectors[vnum] = lines[i].frontsector;
+		}
+	}
+	Z_Free(vertexsectors);
+
+	for (i = 0; i < numsectors; i++)
+	{
+		groups[i] = P_RejectGroup(groups, i);
+		if (groups[i] == i)
+			numgroups++;
+	}
+
+	// Everything's connected, so there's nothing to add.
+	if (numgroups < 2)
+	{
+		Z_Free(groups);
+		return;
+	}
+
+	size = (numsectors * numsectors + 7) / 8;
+	matrix = Z_Calloc(size, PU_LEVEL, NULL);
+
+	for (i = 0; i < numsectors; i++)
+	{
+		const size_t row = i * numsectors;
+		for (j = 0; j < numsectors; j++)
+		{
+			if (groups[i] != groups[j])
+				matrix[(row + j) >> 3] |= 1 << ((row + j) & 7);
+		}
+	}
+
+	if (rejectmatrix)
+	{
+		for (i = 0; i < size && i < rejectsize; i++)
+			matrix[i] |= rejectmatrix[i];
+		Z_Free(rejectmatrix);
+	}
+
+	rejectmatrix = matrix;
+	rejectsize = size;
+	Z_Free(groups);
+
+	CONS_Debug(DBG_SETUP, "P_GenerateReject: %s sectors in %s separate groups\n", sizeu1(numsectors), sizeu2(numgroups));
+}
+
 //
 // P_LinkMapData
 // Builds sector line lists and subsector sector numbers.
@@ -6948,6 +7077,7 @@ static boolean P_LoadMapFromFile(void)
 	P_LoadMapLUT(virt);
 
 	P_LinkMapData();
+	P_GenerateReject();
 
 	if (!udmf)
 		P_AddBinaryMapTags();
@@ -7826,6 +7956,9 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 	if (lastloadedmaplumpnum == LUMPERROR)
 		I_Error("Map %s not found.\n", maplumpname);
 
+	// Decompress the map on worker threads while the rest is set up.
+	vres_PrefetchMap(lastloadedmaplumpnum);
+
 	R_ReInitColormaps(mapheaderinfo[gamemap-1]->palette);
 	CON_SetupBackColormap();
 
@@ -7862,6 +7995,9 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 	if (!fromnetsave) //  ugly hack for P_NetUnArchiveMisc (and P_LoadNetGame)
 		P_SpawnPrecipitation();
 
+	// Load or build the potentially visible sets, if they're wanted.
+	R_LoadLevelPVS();
+
 #ifdef HWRENDER // not win32 only 19990829 by Kin
 	gl_maploaded = false;
 
@@ -7895,6 +8031,8 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 	if (rendermode != render_none && !(titlemapinaction || reloadinggamestate))
 		F_WipeColorFill(levelfadecol);
 
+	// Start precaching the level's graphics in the background,
+	// to be finished up before the level is first drawn.
 	if (precache || dedicated)
 		R_PrecacheLevel();
 
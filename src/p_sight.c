@@ -13,6 +13,7 @@
 
 #include "doomdef.h"
 #include "doomstat.h"
+#include "m_perfstats.h" // ps_checksight_calls
 #include "p_local.h"
 #include "p_slopes.h"
 #include "r_main.h"
@@ -387,6 +388,8 @@ boolean P_CheckSight(mobj_t *t1, mobj_t *t2)
 	if (!t1 || !t2)
 		return false;
 
+	ps_checksight_calls.value.i++;
+
 	I_Assert(!P_MobjWasRemoved(t1));
 	I_Assert(!P_MobjWasRemoved(t2));
 
@@ -402,7 +405,10 @@ boolean P_CheckSight(mobj_t *t1, mobj_t *t2)
 	{
 		// Check in REJECT table.
 		if (rejectmatrix[pnum>>3] & (1 << (pnum&7))) // can't possibly be connected
+		{
+			ps_checksight_rejects.value.i++;
 			return false;
+		}
 	}
 
 	// killough 11/98: shortcut for melee situations
@@ -234,6 +234,37 @@ void P_InitPicAnims(void)
 	animdefs = NULL;
 }
 
+/** Marks every frame of the animated textures that have a frame in use,
+  * so that precaching also covers the frames that aren't showing yet.
+  *
+  * \param texturepresent One flag for each texture, set if it's in use.
+  * \sa R_PrecacheLevel
+  */
+void P_MarkAnimatedTextures(char *texturepresent)
+{
+	anim_t *anim;
+	INT32 i;
+
+	if (!anims)
+		return;
+
+	for (anim = anims; anim < lastanim; anim++)
+	{
+		if (!anim->istexture)
+			continue;
+
+		for (i = 0; i < anim->numpics; i++)
+			if (texturepresent[anim->basepic + i])
+				break;
+
+		if (i == anim->numpics)
+			continue;
+
+		for (i = 0; i < anim->numpics; i++)
+			texturepresent[anim->basepic + i] = 1;
+	}
+}
+
 void P_ParseANIMDEFSLump(INT32 wadNum, UINT16 lumpnum)
 {
 	char *animdefsLump;
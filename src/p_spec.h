@@ -483,6 +483,7 @@ typedef enum
 
 // at game start
 void P_InitPicAnims(void);
+void P_MarkAnimatedTextures(char *texturepresent);
 
 // at map load (sectors)
 void P_SetupLevelFlatAnims(void);
@@ -755,6 +755,7 @@ void P_Ticker(boolean run)
 
 		ps_lua_mobjhooks.value.i = 0;
 		ps_checkposition_calls.value.i = 0;
+		ps_checksight_calls.value.i = ps_checksight_rejects.value.i = 0;
 
 		LUA_HOOK(PreThinkFrame);
 
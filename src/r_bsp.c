@@ -16,6 +16,7 @@
 #include "r_local.h"
 #include "r_state.h"
 #include "r_portal.h" // Add seg portals
+#include "r_pvs.h"
 
 #include "r_splats.h"
 #include "p_local.h" // camera
@@ -1263,6 +1264,13 @@ void R_RenderBSPNode(INT32 bspnum)
 
 	while (!(bspnum & NF_SUBSECTOR))  // Found a subsector?
 	{
+		// Nothing under this node can be seen from the view's subsector.
+		if (!R_NodeInPVS(bspnum))
+		{
+			ps_numpvsculled.value.i++;
+			return;
+		}
+
 		bsp = &nodes[bspnum];
 
 		// Decide which side the view point is on.
@@ -1278,6 +1286,12 @@ void R_RenderBSPNode(INT32 bspnum)
 		bspnum = bsp->children[side^1];
 	}
 
+	if (bspnum != -1 && !R_SubsectorInPVS(bspnum & ~NF_SUBSECTOR))
+	{
+		ps_numpvsculled.value.i++;
+		return;
+	}
+
 	// PORTAL CULLING
 	if (portalcullsector) {
 		sector_t *sect = subsectors[bspnum & ~NF_SUBSECTOR].sector;
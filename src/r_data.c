@@ -29,6 +29,7 @@
 #include "f_finale.h" // wipes
 #include "byteptr.h"
 #include "dehacked.h"
+#include "m_trace.h"
 
 //
 // Graphics.
@@ -425,6 +426,9 @@ void R_ClearColormaps(void)
 {
 	// Purged by PU_LEVEL, just overwrite the pointer
 	extra_colormaps = R_CreateDefaultColormap(true);
+
+	// The light tables may have been reloaded, or are about to be purged.
+	R_FlushFusedColormapCache();
 }
 
 //
@@ -1209,51 +1213,80 @@ void R_InitData(void)
 	}
 
 	CONS_Printf("R_LoadTextures()...\n");
+	M_TraceBegin("R_LoadTextures", NULL);
 	R_LoadTextures();
+	M_TraceEnd();
 
 	CONS_Printf("P_InitPicAnims()...\n");
+	M_TraceBegin("P_InitPicAnims", NULL);
 	P_InitPicAnims();
+	M_TraceEnd();
 
 	CONS_Printf("R_InitSprites()...\n");
+	M_TraceBegin("R_InitSprites", NULL);
 	R_InitSpriteLumps();
 	R_InitSprites();
+	M_TraceEnd();
 
 	CONS_Printf("R_InitColormaps()...\n");
+	M_TraceBegin("R_InitColormaps", NULL);
 	R_InitColormaps();
+	M_TraceEnd();
+}
+
+// Sprite lumps to be cached by R_FinishPrecacheLevel
+static lumpnum_t *precachesprites = NULL;
+static size_t numprecachesprites = 0, maxprecachesprites = 0;
+static boolean precachepending = false;
+
+static void R_AddPrecacheLump(lumpnum_t **list, size_t *count, size_t *maxcount, lumpnum_t lump)
+{
+	if (*count >= *maxcount)
+	{
+		*maxcount = *maxcount ? *maxcount * 2 : 256;
+		*list = Z_Realloc(*list, *maxcount * sizeof (**list), PU_STATIC, NULL);
+	}
+	(*list)[(*count)++] = lump;
 }
 
 //
 // R_PrecacheLevel
 //
 // Preloads all relevant graphics for the level.
+// Software textures are composited and lumps are decompressed by worker
+// threads while the rest of the level loads, and R_FinishPrecacheLevel
+// picks up what's left once the level is about to be drawn.
 //
 void R_PrecacheLevel(void)
 {
 	char *texturepresent, *spritepresent;
+	INT32 *texnums;
+	lumpnum_t *lumps = NULL;
+	size_t numlumps = 0, maxlumps = 0, numtexnums = 0;
 	size_t i, j, k;
-	lumpnum_t lump;
+	INT32 p;
+	texture_t *texture;
 
 	thinker_t *th;
 	spriteframe_t *sf;
 
+	// One level at a time.
+	R_FinishPrecacheLevel();
+
 	if (demoplayback)
 		return;
 
-	// do not flush the memory, Z_Malloc twice with same user will cause error in Z_CheckHeap()
-	if (rendermode != render_soft)
+	if (rendermode == render_none)
 		return;
 
-	// Precache flats.
-	flatmemory = P_PrecacheLevelFlats();
-
 	//
 	// Precache textures.
 	//
-	// no need to precache all software textures in 3D mode
-	// (note they are still used with the reference software view)
 	texturepresent = calloc(numtextures, sizeof (*texturepresent));
 	if (texturepresent == NULL) I_Error("%s: Out of memory looking up textures", "R_PrecacheLevel");
 
+	// FOF and polyobject walls are covered here too,
+	// since they're drawn with the textures of their control lines.
 	for (j = 0; j < numsides; j++)
 	{
 		// huh, a potential bug here????
@@ -1265,24 +1298,67 @@ void R_PrecacheLevel(void)
 			texturepresent[sides[j].bottomtexture] = 1;
 	}
 
+	// Textures used as flats.
+	for (j = 0; j < numlevelflats; j++)
+	{
+		if (levelflats[j].type == LEVELFLAT_TEXTURE
+			&& levelflats[j].u.texture.num >= 0 && levelflats[j].u.texture.num < numtextures)
+			texturepresent[levelflats[j].u.texture.num] = 1;
+	}
+
 	// Sky texture is always present.
 	// Note that F_SKY1 is the name used to indicate a sky floor/ceiling as a flat,
 	// while the sky texture is stored like a wall texture, with a skynum dependent name.
 	texturepresent[skytexture] = 1;
 
-	texturememory = 0;
+	// So are the frames of any animation that's in use.
+	P_MarkAnimatedTextures(texturepresent);
+
+	texnums = Z_Malloc(numtextures * sizeof (*texnums), PU_STATIC, NULL);
 	for (j = 0; j < (unsigned)numtextures; j++)
 	{
-		if (!texturepresent[j])
+		if (!texturepresent[j] || texturecache[j])
 			continue;
 
-		if (!texturecache[j])
-			R_GenerateTexture(j);
-		// pre-caching individual patches that compose textures became obsolete,
-		// since we cache entire composite textures
+		texnums[numtexnums++] = (INT32)j;
+
+		texture = textures[j];
+		for (p = 0; p < texture->patchcount; p++)
+			R_AddPrecacheLump(&lumps, &numlumps, &maxlumps, ((lumpnum_t)texture->patches[p].wad << 16) + texture->patches[p].lump);
 	}
 	free(texturepresent);
 
+	texturememory = 0;
+	if (rendermode == render_soft)
+	{
+		// Decompress all of the patches at once, then have them composited.
+		W_PrefetchLumps(lumps, numlumps);
+		R_PrecacheTextures(texnums, numtexnums);
+		numlumps = 0;
+	}
+	// OpenGL builds its textures as it uploads them, on the main thread,
+	// so only their patches can be gotten ready ahead of time.
+	Z_Free(texnums);
+
+	//
+	// Precache flats.
+	//
+	for (j = 0; j < numlevelflats; j++)
+	{
+		levelflat_t *levelflat = &levelflats[j];
+
+		if (levelflat->type != LEVELFLAT_FLAT && levelflat->type != LEVELFLAT_PNG)
+			continue;
+
+		if (levelflat->speed && levelflat->u.flat.baselumpnum != LUMPERROR)
+		{
+			for (p = 0; p < levelflat->numpics; p++)
+				R_AddPrecacheLump(&lumps, &numlumps, &maxlumps, levelflat->u.flat.baselumpnum + p);
+		}
+		else if (levelflat->u.flat.lumpnum != LUMPERROR)
+			R_AddPrecacheLump(&lumps, &numlumps, &maxlumps, levelflat->u.flat.lumpnum);
+	}
+
 	//
 	// Precache sprites.
 	//
@@ -1293,7 +1369,6 @@ void R_PrecacheLevel(void)
 		if (th->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
 			spritepresent[((mobj_t *)th)->sprite] = 1;
 
-	spritememory = 0;
 	for (i = 0; i < numsprites; i++)
 	{
 		if (!spritepresent[i])
@@ -1303,10 +1378,8 @@ void R_PrecacheLevel(void)
 		{
 			sf = &sprites[i].spriteframes[j];
 #define cacheang(a) {\
-		lump = sf->lumppat[a];\
-		if (devparm)\
-			spritememory += W_LumpLength(lump);\
-		W_CachePatchNum(lump, PU_SPRITE);\
+		R_AddPrecacheLump(&lumps, &numlumps, &maxlumps, sf->lumppat[a]);\
+		R_AddPrecacheLump(&precachesprites, &numprecachesprites, &maxprecachesprites, sf->lumppat[a]);\
 	}
 			// see R_InitSprites for more about lumppat,lumpid
 			switch (sf->rotate)
@@ -1329,6 +1402,52 @@ void R_PrecacheLevel(void)
 	}
 	free(spritepresent);
 
+	// Flats and sprites are put in the lump cache here, but still
+	// have to be read and made into patches on the main thread.
+	W_PrefetchLumps(lumps, numlumps);
+	if (lumps)
+		Z_Free(lumps);
+
+	precachepending = true;
+}
+
+//
+// R_FinishPrecacheLevel
+//
+// Waits for the level's textures to be composited, and caches its flats
+// and sprites from the lumps that have been decompressed in the meantime.
+// Called before the level is first drawn.
+//
+void R_FinishPrecacheLevel(void)
+{
+	size_t i;
+
+	R_FinishTexturePrecache();
+
+	if (!precachepending)
+		return;
+	precachepending = false;
+
+	// do not flush the memory, Z_Malloc twice with same user will cause error in Z_CheckHeap()
+	// OpenGL only gets the lumps decompressed ahead of time.
+	flatmemory = spritememory = 0;
+	if (rendermode == render_soft)
+	{
+		flatmemory = P_PrecacheLevelFlats();
+
+		for (i = 0; i < numprecachesprites; i++)
+		{
+			if (devparm)
+				spritememory += W_LumpLength(precachesprites[i]);
+			W_CachePatchNum(precachesprites[i], PU_SPRITE);
+		}
+	}
+
+	if (precachesprites)
+		Z_Free(precachesprites);
+	precachesprites = NULL;
+	numprecachesprites = maxprecachesprites = 0;
+
 	// FIXME: this is no longer correct with OpenGL render mode
 	CONS_Debug(DBG_SETUP, "Precache level done:\n"
 			"flatmemory:    %s k\n"
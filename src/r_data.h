@@ -44,6 +44,7 @@ extern CV_PossibleValue_t Color_cons_t[];
 // I/O, setting up the stuff.
 void R_InitData(void);
 void R_PrecacheLevel(void);
+void R_FinishPrecacheLevel(void);
 
 extern size_t flatmemory, spritememory, texturememory;
 
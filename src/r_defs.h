@@ -787,6 +787,7 @@ typedef struct
 {
 	INT32 angles;
 	void **patches;
+	struct rotspritecachenode_s *cachenodes; // Sprite rotation cache order, NULL if not a sprite
 } rotsprite_t;
 #endif
 
@@ -26,6 +26,11 @@
 #include "z_zone.h"
 #include "console.h" // Until buffering gets finished
 #include "libdivide.h" // used by NPO2 tilted span functions
+#include "i_system.h" // I_GetPreciseTime
+
+#ifdef RENDERTHREADS
+#include "i_jobpool.h"
+#endif
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -58,17 +63,30 @@ INT32 columnofs[MAXVIDWIDTH*4];
 
 UINT8 *topleft;
 
+/**	\brief the buffer the view is drawn into: screens[0], or with
+	r_columnmajor, a column-major one that R_TransposeViewBuffer copies
+	back into screens[0]
+*/
+UINT8 *viewscreen;
+
+/**	\brief byte distance between vertically and horizontally neighbouring
+	pixels of viewscreen, which the column and span drawers step by
+*/
+INT32 columnpitch, spanpitch;
+
+static UINT8 *columnmajorscreen;
+
 // =========================================================================
 //                      COLUMN DRAWING CODE STUFF
 // =========================================================================
 
-lighttable_t *dc_colormap;
-INT32 dc_x = 0, dc_yl = 0, dc_yh = 0;
+DRAWERSTATE lighttable_t *dc_colormap;
+DRAWERSTATE INT32 dc_x = 0, dc_yl = 0, dc_yh = 0;
 
-fixed_t dc_iscale, dc_texturemid;
-UINT8 dc_hires; // under MSVC boolean is a byte, while on other systems, it a bit,
+DRAWERSTATE fixed_t dc_iscale, dc_texturemid;
+DRAWERSTATE UINT8 dc_hires; // under MSVC boolean is a byte, while on other systems, it a bit,
                // soo lets make it a byte on all system for the ASM code
-UINT8 *dc_source;
+DRAWERSTATE UINT8 *dc_source;
 
 // -----------------------
 // translucency stuff here
@@ -80,7 +98,7 @@ UINT8 *blendtables[NUMBLENDMAPS];
 
 /**	\brief R_DrawTransColumn uses this
 */
-UINT8 *dc_transmap; // one of the translucency tables
+DRAWERSTATE UINT8 *dc_transmap; // one of the translucency tables
 
 // ----------------------
 // translation stuff here
@@ -89,37 +107,39 @@ UINT8 *dc_transmap; // one of the translucency tables
 
 /**	\brief R_DrawTranslatedColumn uses this
 */
-UINT8 *dc_translation;
+DRAWERSTATE UINT8 *dc_translation;
 
 struct r_lightlist_s *dc_lightlist = NULL;
-INT32 dc_numlights = 0, dc_maxlights, dc_texheight;
+INT32 dc_numlights = 0, dc_maxlights;
+DRAWERSTATE INT32 dc_texheight;
 
 // =========================================================================
 //                      SPAN DRAWING CODE STUFF
 // =========================================================================
 
-INT32 ds_y, ds_x1, ds_x2;
-lighttable_t *ds_colormap;
-lighttable_t *ds_translation; // Lactozilla: Sprite splat drawer
+DRAWERSTATE INT32 ds_y, ds_x1, ds_x2;
+DRAWERSTATE lighttable_t *ds_colormap;
+DRAWERSTATE lighttable_t *ds_translation; // Lactozilla: Sprite splat drawer
 
-fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
-INT32 ds_waterofs, ds_bgofs;
+DRAWERSTATE fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
+DRAWERSTATE INT32 ds_waterofs, ds_bgofs;
 
-UINT16 ds_flatwidth, ds_flatheight;
-boolean ds_powersoftwo, ds_solidcolor;
+DRAWERSTATE UINT16 ds_flatwidth, ds_flatheight;
+DRAWERSTATE boolean ds_powersoftwo, ds_solidcolor;
 
-UINT8 *ds_source; // points to the start of a flat
-UINT8 *ds_transmap; // one of the translucency tables
+DRAWERSTATE UINT8 *ds_source; // points to the start of a flat
+DRAWERSTATE UINT8 *ds_transmap; // one of the translucency tables
 
 // Vectors for Software's tilted slope drawers
 floatv3_t *ds_su, *ds_sv, *ds_sz;
-floatv3_t *ds_sup, *ds_svp, *ds_szp;
-float focallengthf, zeroheight;
+DRAWERSTATE floatv3_t *ds_sup, *ds_svp, *ds_szp;
+float focallengthf;
+DRAWERSTATE float zeroheight;
 
 /**	\brief Variable flat sizes
 */
 
-UINT32 nflatxshift, nflatyshift, nflatshiftup, nflatmask;
+DRAWERSTATE UINT32 nflatxshift, nflatyshift, nflatshiftup, nflatmask;
 
 // =========================================================================
 //                   TRANSLATION COLORMAP CODE
@@ -604,6 +624,7 @@ UINT8* R_GetTranslationColormap(INT32 skinnum, skincolornum_t color, UINT8 flags
 				if (translationtablecache[i] && translationtablecache[i][color])
 					R_GenerateTranslationColormap(translationtablecache[i][color], CacheIndexToSkin(i), color);
 
+			R_FlushFusedColormapCache();
 			skincolor_modified[color] = false;
 		}
 	}
@@ -638,6 +659,8 @@ void R_FlushTranslationColormapCache(void)
 	for (i = 0; i < (INT32)(sizeof(translationtablecache) / sizeof(translationtablecache[0])); i++)
 		if (translationtablecache[i])
 			memset(translationtablecache[i], 0, MAXSKINCOLORS * sizeof(UINT8**));
+
+	R_FlushFusedColormapCache();
 }
 
 UINT16 R_GetColorByName(const char *name)
@@ -665,6 +688,145 @@ UINT16 R_GetSuperColorByName(const char *name)
 	return color;
 }
 
+// ==========================================================================
+//               FUSED COLORMAP AND TRANSLATION TABLES
+// ==========================================================================
+
+// Translated sprites look every pixel up twice, in the translation and then
+// in the colormap, but both are the same for the whole sprite. So they're
+// fused into a single table, and the sprite is drawn with the plain column
+// drawers. Tables are shared by all sprites with the same translation and
+// light, and the least recently used one is reused once they're all taken.
+
+#define NUMFUSEDCOLORMAPS 512
+#define FUSEDCOLORMAPHASHSIZE 1024 // must be a power of two
+
+typedef struct fusedcolormap_s
+{
+	UINT8 table[NUM_PALETTE_ENTRIES];
+	const UINT8 *colormap, *translation; // NULL when not in use
+	size_t lastframe; // framecount of the view it was last drawn with
+	struct fusedcolormap_s *hashnext;
+	struct fusedcolormap_s *prev, *next; // LRU order, most recent first
+} fusedcolormap_t;
+
+static fusedcolormap_t *fusedcolormaps = NULL;
+static fusedcolormap_t *fusedcolormaphash[FUSEDCOLORMAPHASHSIZE];
+static fusedcolormap_t fusedcolormaplru;
+
+static inline size_t R_FusedColormapHash(const UINT8 *colormap, const UINT8 *translation)
+{
+	// Light levels are 256 bytes apart, translations at least 8.
+	return ((((uintptr_t)colormap >> 8) * 31) + ((uintptr_t)translation >> 3)) & (FUSEDCOLORMAPHASHSIZE - 1);
+}
+
+static void R_InitFusedColormaps(void)
+{
+	INT32 i;
+
+	fusedcolormaps = Z_Calloc(NUMFUSEDCOLORMAPS * sizeof (*fusedcolormaps), PU_STATIC, NULL);
+	fusedcolormaplru.next = fusedcolormaplru.prev = &fusedcolormaplru;
+
+	for (i = 0; i < NUMFUSEDCOLORMAPS; i++)
+	{
+		fusedcolormap_t *fused = &fusedcolormaps[i];
+
+		fused->lastframe = (size_t)-1;
+		fused->prev = fusedcolormaplru.prev;
+		fused->next = &fusedcolormaplru;
+		fusedcolormaplru.prev->next = fused;
+		fusedcolormaplru.prev = fused;
+	}
+}
+
+static void R_UnhashFusedColormap(fusedcolormap_t *fused)
+{
+	fusedcolormap_t **link = &fusedcolormaphash[R_FusedColormapHash(fused->colormap, fused->translation)];
+
+	while (*link != fused)
+		link = &(*link)->hashnext;
+	*link = fused->hashnext;
+}
+
+/**	\brief	Retrieves a colormap fused with a translation.
+
+	The table is only good for the current view, since it can be
+	reused for another one as soon as the next view starts.
+
+	\param	colormap	colormap, at the sprite's light level
+	\param	translation	translation colormap
+
+	\return	colormap[translation[i]] for every color, or NULL if every
+		table has already been taken by the current view.
+*/
+UINT8 *R_GetFusedColormap(const UINT8 *colormap, const UINT8 *translation)
+{
+	fusedcolormap_t *fused;
+	size_t hash;
+	INT32 i;
+
+	if (!fusedcolormaps)
+		R_InitFusedColormaps();
+
+	hash = R_FusedColormapHash(colormap, translation);
+	for (fused = fusedcolormaphash[hash]; fused; fused = fused->hashnext)
+		if (fused->colormap == colormap && fused->translation == translation)
+			break;
+
+	if (!fused)
+	{
+		// Queued drawers may still be reading a table taken
+		// by this view, so those can't be reused.
+		fused = fusedcolormaplru.prev;
+		if (fused->lastframe == framecount)
+			return NULL;
+
+		if (fused->colormap)
+			R_UnhashFusedColormap(fused);
+
+		for (i = 0; i < NUM_PALETTE_ENTRIES; i++)
+			fused->table[i] = colormap[translation[i]];
+
+		fused->colormap = colormap;
+		fused->translation = translation;
+		fused->hashnext = fusedcolormaphash[hash];
+		fusedcolormaphash[hash] = fused;
+	}
+
+	fused->lastframe = framecount;
+
+	// Move it to the front.
+	fused->prev->next = fused->next;
+	fused->next->prev = fused->prev;
+	fused->prev = &fusedcolormaplru;
+	fused->next = fusedcolormaplru.next;
+	fusedcolormaplru.next->prev = fused;
+	fusedcolormaplru.next = fused;
+
+	return fused->table;
+}
+
+/**	\brief	Forgets every fused colormap.
+
+	Called whenever a colormap or translation may have been freed or
+	changed in place. The tables themselves are left alone, since the
+	current view may still be drawing with them.
+
+	\return	void
+*/
+void R_FlushFusedColormapCache(void)
+{
+	INT32 i;
+
+	if (!fusedcolormaps)
+		return;
+
+	for (i = 0; i < NUMFUSEDCOLORMAPS; i++)
+		fusedcolormaps[i].colormap = fusedcolormaps[i].translation = NULL;
+
+	memset(fusedcolormaphash, 0, sizeof (fusedcolormaphash));
+}
+
 // ==========================================================================
 //               COMMON DRAWER FOR 8 AND 16 BIT COLOR MODES
 // ==========================================================================
@@ -699,12 +861,33 @@ void R_InitViewBuffer(INT32 width, INT32 height)
 	if (bytesperpixel < 1 || bytesperpixel > 4)
 		I_Error("R_InitViewBuffer: wrong bytesperpixel value %d\n", bytesperpixel);
 
+	// Drawing down the columns of a column-major buffer stays within a
+	// few cache lines, instead of touching a new one every pixel.
+	if (columnmajorscreen)
+	{
+		Z_Free(columnmajorscreen);
+		columnmajorscreen = NULL;
+	}
+	if (cv_columnmajor.value && bytesperpixel == 1 && rendermode == render_soft)
+	{
+		columnmajorscreen = Z_Malloc(vid.width * vid.height, PU_STATIC, NULL);
+		viewscreen = columnmajorscreen;
+		columnpitch = 1;
+		spanpitch = vid.height;
+	}
+	else
+	{
+		viewscreen = screens[0];
+		columnpitch = vid.width*bytesperpixel;
+		spanpitch = bytesperpixel;
+	}
+
 	// Handle resize, e.g. smaller view windows with border and/or status bar.
 	viewwindowx = (vid.width - width) >> 1;
 
 	// Column offset for those columns of the view window, but relative to the entire screen
 	for (i = 0; i < width; i++)
-		columnofs[i] = (viewwindowx + i) * bytesperpixel;
+		columnofs[i] = (viewwindowx + i) * spanpitch;
 
 	// Same with base row offset.
 	if (width == vid.width)
@@ -715,8 +898,8 @@ void R_InitViewBuffer(INT32 width, INT32 height)
 	// Precalculate all row offsets.
 	for (i = 0; i < height; i++)
 	{
-		ylookup[i] = ylookup1[i] = screens[0] + (i+viewwindowy)*vid.width*bytesperpixel;
-		ylookup2[i] = screens[0] + (i+(vid.height>>1))*vid.width*bytesperpixel; // for splitscreen
+		ylookup[i] = ylookup1[i] = viewscreen + (i+viewwindowy)*columnpitch;
+		ylookup2[i] = viewscreen + (i+(vid.height>>1))*columnpitch; // for splitscreen
 	}
 }
 
@@ -886,7 +1069,7 @@ void R_DrawViewBorder(void)
 
 // R_CalcTiltedLighting
 // Exactly what it says on the tin. I wish I wasn't too lazy to explain things properly.
-static INT32 tiltlighting[MAXVIDWIDTH];
+static DRAWERSTATE INT32 tiltlighting[MAXVIDWIDTH];
 
 static void R_CalcTiltedLighting(fixed_t start, fixed_t end)
 {
@@ -908,6 +1091,46 @@ static void R_CalcTiltedLighting(fixed_t start, fixed_t end)
 	}
 }
 
+/** Works out how many pixels of a tilted span can go between perspective
+  * divides. The texture coordinates are interpolated linearly in between,
+  * which is furthest off half way between two divides, and worst where the
+  * plane is nearest to the view. This picks the longest stretch, up to
+  * r_slopesubdivision pixels, that stays within a texel of the exact drawer.
+  *
+  * \param iz The span's ds_szp value at its first pixel.
+  * \param uz The span's ds_sup value at its first pixel.
+  * \param vz The span's ds_svp value at its first pixel.
+  * \param width The span's width, minus one.
+  * \param texel The size of a texel, in the units the drawer steps u and v in.
+  * \return How many pixels to draw between divides.
+  */
+static INT32 R_TiltedSpanSize(double iz, double uz, double vz, INT32 width, double texel)
+{
+	INT32 spansize = cv_slopesubdivision.value;
+	double endz = iz + ds_szp->x*width;
+	double nearz, ku, kv, maxerror;
+
+	if (spansize <= 1 || (iz <= 0.0) != (endz <= 0.0))
+		return 1;
+
+	nearz = min(fabs(iz), fabs(endz));
+
+	// u = uz/iz, and uz*dz - du*iz is the same all along the span.
+	// Interpolating across n pixels is off by at most |dz*k|*n*n/(4*z*z*z).
+	ku = fabs(uz*ds_szp->x - ds_sup->x*iz);
+	kv = fabs(vz*ds_szp->x - ds_svp->x*iz);
+	maxerror = fabs(ds_szp->x) * max(ku, kv) / (4.0 * nearz*nearz*nearz);
+
+	while (spansize > 1 && maxerror*spansize*spansize > texel)
+		spansize >>= 1;
+
+	return spansize;
+}
+
+// Texel sizes for R_TiltedSpanSize, see R_CalculateSlopeVectors
+#define TILTEDTEXEL (65536.0 * (1 << nflatshiftup))
+#define TILTEDTEXEL_NPO2 65536.0
+
 // Lighting is simple. It's just linear interpolation from start to end
 #define CALC_SLOPE_LIGHT { \
 	float planelightfloat = PLANELIGHTFLOAT; \
@@ -923,6 +1146,7 @@ static void R_CalcTiltedLighting(fixed_t start, fixed_t end)
 
 #include "r_draw8.c"
 #include "r_draw8_npo2.c"
+#include "r_draw8_simd.c"
 
 // ==========================================================================
 //                   INCLUDE 16bpp DRAWING CODE HERE
@@ -931,3 +1155,795 @@ static void R_CalcTiltedLighting(fixed_t start, fixed_t end)
 #ifdef HIGHCOLOR
 #include "r_draw16.c"
 #endif
+
+// ==========================================================================
+//                   COLUMN-MAJOR VIEW
+// ==========================================================================
+
+// The view is copied over in TRANSPOSEBLOCK squares, so that the columns
+// being read and the rows being written all stay in cache.
+#define TRANSPOSEBLOCK 64
+
+// Copies a w by h rectangle of the column-major viewscreen, with its
+// top left corner at x, y, into screens[0]
+static void R_TransposeRect(INT32 x, INT32 y, INT32 w, INT32 h)
+{
+	INT32 i, j;
+
+	for (j = 0; j < h; j++)
+	{
+		const UINT8 *src = viewscreen + x*vid.height + y + j;
+		UINT8 *dest = screens[0] + (y + j)*vid.width + x;
+
+		for (i = 0; i < w; i++, src += vid.height)
+			dest[i] = *src;
+	}
+}
+
+/**	\brief	The R_TransposeViewBuffer function
+	Copies the view just drawn into a column-major viewscreen over to
+	screens[0], before the HUD goes on top of it.
+
+	\return	void
+*/
+void R_TransposeViewBuffer(void)
+{
+	const INT32 x2 = viewwindowx + scaledviewwidth, y2 = viewwindowy + viewheight;
+	INT32 bx, by, xend, yend;
+
+	if (viewscreen == screens[0])
+		return;
+
+	for (by = viewwindowy; by < y2; by += TRANSPOSEBLOCK)
+	{
+		yend = min(by + TRANSPOSEBLOCK, y2);
+		for (bx = viewwindowx; bx < x2; bx += TRANSPOSEBLOCK)
+		{
+			xend = min(bx + TRANSPOSEBLOCK, x2);
+#ifdef SIMDDRAWERS_X86
+			if (R_SSE2)
+			{
+				const INT32 w = (xend - bx) & ~15, h = (yend - by) & ~15;
+				INT32 x, y;
+
+				for (x = bx; x < bx + w; x += 16)
+					for (y = by; y < by + h; y += 16)
+						R_Transpose16_SSE2(viewscreen + x*vid.height + y, vid.height, screens[0] + y*vid.width + x, vid.width);
+
+				// The edges of the view that aren't a multiple of 16
+				R_TransposeRect(bx, by + h, w, yend - by - h);
+				R_TransposeRect(bx + w, by, xend - bx - w, yend - by);
+				continue;
+			}
+#endif
+			R_TransposeRect(bx, by, xend - bx, yend - by);
+		}
+	}
+}
+
+// ==========================================================================
+//                   MULTITHREADED DRAWING
+// ==========================================================================
+
+// While the draw queue is active, the renderer doesn't run the drawers
+// itself. Each call is recorded along with the dc_ or ds_ state it would
+// have drawn with, and when the queue is flushed, every render thread
+// replays the whole of it, clipped to its own band of rows. Spans are
+// single rows, so they go to exactly one thread. Columns are cut at the
+// band edges; the column drawers work out their texture position from
+// dc_yl, so the pieces come out the same as the column drawn in one go.
+//
+// The BSP traversal, clipping and visplane building all still happen on
+// the main thread, which only records the queue and waits for the flush.
+
+#ifdef RENDERTHREADS
+
+// Everything a span drawer draws with
+typedef struct
+{
+	lighttable_t *colormap, *translation, **zlight;
+	UINT8 *source, *transmap;
+	INT32 y, x1, x2, waterofs, bgofs;
+	fixed_t xfrac, yfrac, xstep, ystep;
+	UINT16 flatwidth, flatheight;
+	boolean powersoftwo, solidcolor, tilted;
+	UINT32 xshift, yshift, shiftup, mask;
+	floatv3_t su, sv, sz; // ds_sup etc. point into arrays reused by the next plane
+	float zeroheight;
+} spanstate_t;
+
+typedef enum
+{
+	DRAWCMD_COLUMN,
+	DRAWCMD_SPAN,
+	DRAWCMD_PLANE, // a whole visplane, spans and all
+} drawcmdtype_t;
+
+typedef struct
+{
+	void (*drawer)(void);
+	drawcmdtype_t type;
+	union
+	{
+		struct
+		{
+			lighttable_t *colormap;
+			UINT8 *source, *transmap, *translation;
+			INT32 x, yl, yh, texheight;
+			fixed_t iscale, texturemid;
+			UINT8 hires;
+		} col;
+		spanstate_t span;
+		size_t plane; // index into drawqueue.planes
+	} u;
+} drawcmd_t;
+
+// Kept apart from the other commands, being a lot bigger than them
+typedef struct
+{
+	spanstate_t state;
+	planespans_t spans;
+} planecmd_t;
+
+// The rows one render thread draws in a flush
+typedef struct
+{
+	job_t job;
+	INT32 top, bottom;
+} renderband_t;
+
+DRAWERSTATE boolean drawqueueactive = false;
+
+static struct
+{
+	drawcmd_t *cmds;
+	size_t numcmds, maxcmds;
+	planecmd_t *planes;
+	size_t numplanes, maxplanes;
+
+	renderband_t bands[MAXRENDERTHREADS];
+	INT32 numbands; // this frame
+} drawqueue;
+
+static jobpool_t renderpool = JOBPOOL_INIT("render-thread", MAXRENDERTHREADS);
+
+static void R_SaveSpanState(spanstate_t *state)
+{
+	state->colormap = ds_colormap;
+	state->translation = ds_translation;
+	state->zlight = planezlight;
+	state->source = ds_source;
+	state->transmap = ds_transmap;
+	state->y = ds_y;
+	state->x1 = ds_x1;
+	state->x2 = ds_x2;
+	state->waterofs = ds_waterofs;
+	state->bgofs = ds_bgofs;
+	state->xfrac = ds_xfrac;
+	state->yfrac = ds_yfrac;
+	state->xstep = ds_xstep;
+	state->ystep = ds_ystep;
+	state->flatwidth = ds_flatwidth;
+	state->flatheight = ds_flatheight;
+	state->powersoftwo = ds_powersoftwo;
+	state->solidcolor = ds_solidcolor;
+	state->xshift = nflatxshift;
+	state->yshift = nflatyshift;
+	state->shiftup = nflatshiftup;
+	state->mask = nflatmask;
+	state->zeroheight = zeroheight;
+
+	state->tilted = (ds_sup != NULL);
+	if (state->tilted)
+	{
+		state->su = *ds_sup;
+		state->sv = *ds_svp;
+		state->sz = *ds_szp;
+	}
+}
+
+// The tilted vectors are pointed at the saved ones, so state has to
+// outlive the drawing. The drawers only ever read them.
+static void R_LoadSpanState(spanstate_t *state)
+{
+	ds_colormap = state->colormap;
+	ds_translation = state->translation;
+	planezlight = state->zlight;
+	ds_source = state->source;
+	ds_transmap = state->transmap;
+	ds_y = state->y;
+	ds_x1 = state->x1;
+	ds_x2 = state->x2;
+	ds_waterofs = state->waterofs;
+	ds_bgofs = state->bgofs;
+	ds_xfrac = state->xfrac;
+	ds_yfrac = state->yfrac;
+	ds_xstep = state->xstep;
+	ds_ystep = state->ystep;
+	ds_flatwidth = state->flatwidth;
+	ds_flatheight = state->flatheight;
+	ds_powersoftwo = state->powersoftwo;
+	ds_solidcolor = state->solidcolor;
+	nflatxshift = state->xshift;
+	nflatyshift = state->yshift;
+	nflatshiftup = state->shiftup;
+	nflatmask = state->mask;
+	zeroheight = state->zeroheight;
+
+	if (state->tilted)
+	{
+		ds_sup = &state->su;
+		ds_svp = &state->sv;
+		ds_szp = &state->sz;
+	}
+	else
+		ds_sup = ds_svp = ds_szp = NULL;
+}
+
+// Replays the queue, drawing only rows top to bottom.
+static void R_RunDrawQueue(INT32 top, INT32 bottom)
+{
+	size_t i;
+
+	for (i = 0; i < drawqueue.numcmds; i++)
+	{
+		drawcmd_t *cmd = &drawqueue.cmds[i];
+
+		switch (cmd->type)
+		{
+			case DRAWCMD_COLUMN:
+				dc_yl = max(cmd->u.col.yl, top);
+				dc_yh = min(cmd->u.col.yh, bottom);
+				if (dc_yl > dc_yh)
+					continue;
+
+				dc_colormap = cmd->u.col.colormap;
+				dc_source = cmd->u.col.source;
+				dc_transmap = cmd->u.col.transmap;
+				dc_translation = cmd->u.col.translation;
+				dc_x = cmd->u.col.x;
+				dc_texheight = cmd->u.col.texheight;
+				dc_iscale = cmd->u.col.iscale;
+				dc_texturemid = cmd->u.col.texturemid;
+				dc_hires = cmd->u.col.hires;
+
+				cmd->drawer();
+				break;
+			case DRAWCMD_SPAN:
+				if (cmd->u.span.y < top || cmd->u.span.y > bottom)
+					continue;
+
+				R_LoadSpanState(&cmd->u.span);
+				cmd->drawer();
+				break;
+			case DRAWCMD_PLANE:
+				R_LoadSpanState(&drawqueue.planes[cmd->u.plane].state);
+				R_DrawPlaneSpans(&drawqueue.planes[cmd->u.plane].spans, top, bottom);
+				break;
+		}
+	}
+}
+
+static void R_RenderBandJob(job_t *job, INT32 worker)
+{
+	renderband_t *band = (renderband_t *)job;
+
+	(void)worker;
+
+	R_RunDrawQueue(band->top, band->bottom);
+}
+
+static drawcmd_t *R_NewDrawCommand(void (*drawer)(void), drawcmdtype_t type)
+{
+	drawcmd_t *cmd;
+
+	if (drawqueue.numcmds == drawqueue.maxcmds)
+	{
+		drawqueue.maxcmds = drawqueue.maxcmds ? drawqueue.maxcmds * 2 : 4096;
+		drawqueue.cmds = Z_Realloc(drawqueue.cmds, drawqueue.maxcmds * sizeof (*drawqueue.cmds), PU_STATIC, NULL);
+	}
+
+	cmd = &drawqueue.cmds[drawqueue.numcmds++];
+	cmd->drawer = drawer;
+	cmd->type = type;
+	return cmd;
+}
+
+/** Queues a column drawer with the current dc_ state.
+  * Use R_RunColumnDrawer rather than calling this directly.
+  *
+  * \param drawer Column drawer to run.
+  */
+void R_QueueColumnDrawer(void (*drawer)(void))
+{
+	drawcmd_t *cmd;
+
+	// The shadowed drawer only cuts the column up by the light list,
+	// which is gone by the time the queue is flushed, so run it now.
+	// It queues its pieces in turn.
+	if (drawer == colfuncs[COLDRAWFUNC_SHADOWED])
+	{
+		drawer();
+		return;
+	}
+
+	if (dc_yl > dc_yh)
+		return;
+
+	cmd = R_NewDrawCommand(drawer, DRAWCMD_COLUMN);
+	cmd->u.col.colormap = dc_colormap;
+	cmd->u.col.source = dc_source;
+	cmd->u.col.transmap = dc_transmap;
+	cmd->u.col.translation = dc_translation;
+	cmd->u.col.x = dc_x;
+	cmd->u.col.yl = dc_yl;
+	cmd->u.col.yh = dc_yh;
+	cmd->u.col.texheight = dc_texheight;
+	cmd->u.col.iscale = dc_iscale;
+	cmd->u.col.texturemid = dc_texturemid;
+	cmd->u.col.hires = dc_hires;
+}
+
+/** Queues a span drawer with the current ds_ state.
+  * Use R_RunSpanDrawer rather than calling this directly.
+  *
+  * \param drawer Span drawer to run.
+  */
+void R_QueueSpanDrawer(void (*drawer)(void))
+{
+	R_SaveSpanState(&R_NewDrawCommand(drawer, DRAWCMD_SPAN)->u.span);
+}
+
+/** Queues a whole visplane, so that the render threads make its spans
+  * as well as draw them, each for its own rows.
+  * The current ds_ state is what the plane's spans start out with.
+  *
+  * \param spans What R_DrawPlaneSpans needs to know about the plane.
+  */
+void R_QueuePlaneSpans(const planespans_t *spans)
+{
+	planecmd_t *plane;
+
+	if (drawqueue.numplanes == drawqueue.maxplanes)
+	{
+		drawqueue.maxplanes = drawqueue.maxplanes ? drawqueue.maxplanes * 2 : 256;
+		drawqueue.planes = Z_Realloc(drawqueue.planes, drawqueue.maxplanes * sizeof (*drawqueue.planes), PU_STATIC, NULL);
+	}
+
+	R_NewDrawCommand(NULL, DRAWCMD_PLANE)->u.plane = drawqueue.numplanes;
+
+	plane = &drawqueue.planes[drawqueue.numplanes++];
+	R_SaveSpanState(&plane->state);
+	plane->spans = *spans;
+
+	// The threads' plane caches aren't in step with the main thread's,
+	// so they start every flush afresh.
+	if (drawqueue.numplanes == 1)
+		plane->spans.resetcache = true;
+}
+
+#endif // RENDERTHREADS
+
+/** Starts queueing the drawers for the render threads, if r_threads
+  * asks for more than one. Called at the start of each view.
+  *
+  * \sa R_FlushDrawQueue, R_EndDrawQueue
+  */
+void R_BeginDrawQueue(void)
+{
+#ifdef RENDERTHREADS
+	INT32 i, count = cv_renderthreads.value;
+
+	if (count > MAXRENDERTHREADS)
+		count = MAXRENDERTHREADS;
+
+	// The drawers are only counted when they're run straight away.
+	// Once the game starts quitting, there are no threads to draw with.
+	if (count <= 1 || drawercounting || !I_start_job_pool(&renderpool, count))
+	{
+		drawqueueactive = false;
+		return;
+	}
+
+	// Cut the view into bands of rows. The outer bands are left open so
+	// that nothing drawn outside of the view gets lost.
+	drawqueue.numbands = count;
+	for (i = 0; i < count; i++)
+	{
+		drawqueue.bands[i].top = (i == 0) ? INT32_MIN : viewheight * i / count;
+		drawqueue.bands[i].bottom = (i == count - 1) ? INT32_MAX : viewheight * (i + 1) / count - 1;
+	}
+
+	drawqueue.numcmds = drawqueue.numplanes = 0;
+	drawqueueactive = true;
+#endif
+}
+
+/** Draws everything queued so far, and waits for it to be done.
+  * Anything that reads or writes the screen directly in the middle of
+  * a view has to call this first.
+  *
+  * \sa R_BeginDrawQueue
+  */
+void R_FlushDrawQueue(void)
+{
+#ifdef RENDERTHREADS
+	INT32 i;
+
+	if (!drawqueueactive || !drawqueue.numcmds)
+		return;
+
+	for (i = 0; i < drawqueue.numbands; i++)
+		I_queue_job(&renderpool, &drawqueue.bands[i].job, R_RenderBandJob);
+
+	// The main thread doesn't help, as its own drawer state is still in use.
+	I_wait_jobs(&renderpool);
+
+	drawqueue.numcmds = drawqueue.numplanes = 0;
+#endif
+}
+
+/** Flushes the draw queue and goes back to drawing straight away.
+  * Called at the end of each view.
+  *
+  * \sa R_BeginDrawQueue
+  */
+void R_EndDrawQueue(void)
+{
+#ifdef RENDERTHREADS
+	R_FlushDrawQueue();
+	drawqueueactive = false;
+#endif
+}
+
+// ==========================================================================
+//                   DRAWER STATISTICS
+// ==========================================================================
+
+// For the drawer page of perfstats, and r_overdraw, R_RunColumnDrawer and
+// R_RunSpanDrawer go through R_CountColumnDrawer and R_CountSpanDrawer,
+// which add up the pixels each drawer writes into ps_sw_colpixels and
+// ps_sw_spanpixels, and with r_overdraw, how many times each pixel of the
+// view is written. The draw queue stays off while they count, so that
+// it's all done on the main thread.
+
+boolean drawercounting = false;
+
+static UINT8 *overdrawbuffer;
+static size_t overdrawsize;
+static UINT8 *overdrawcount; // overdrawbuffer while r_overdraw counts, else NULL
+
+// Heatmap colours, from not drawn at all up to drawn this many times or more
+#define NUMOVERDRAWCOLORS 8
+
+static const UINT8 overdrawrgb[NUMOVERDRAWCOLORS][3] = {
+	{  0,   0,   0},
+	{  0,   0, 160},
+	{  0, 160, 255},
+	{  0, 200,   0},
+	{255, 255,   0},
+	{255, 128,   0},
+	{255,   0,   0},
+	{255, 255, 255}
+};
+
+static void R_CountOverdraw(INT32 x1, INT32 x2, INT32 y1, INT32 y2)
+{
+	INT32 x, y;
+
+	x1 = max(x1, 0);
+	x2 = min(x2, viewwidth - 1);
+	y1 = max(y1, 0);
+	y2 = min(y2, viewheight - 1);
+
+	for (y = y1; y <= y2; y++)
+	{
+		UINT8 *count = &overdrawcount[y*viewwidth];
+		for (x = x1; x <= x2; x++)
+			if (count[x] < UINT8_MAX)
+				count[x]++;
+	}
+}
+
+/** Counts a column drawer's pixels, then runs it.
+  * Use R_RunColumnDrawer rather than calling this directly.
+  *
+  * \param drawer Column drawer to run.
+  */
+void R_CountColumnDrawer(void (*drawer)(void))
+{
+	INT32 i;
+
+	// The shadowed drawer runs each of its pieces through
+	// R_RunColumnDrawer, so they get counted instead.
+	if (drawer != colfuncs[COLDRAWFUNC_SHADOWED] && dc_yl <= dc_yh)
+	{
+		for (i = 0; i < COLDRAWFUNC_MAX; i++)
+			if (drawer == colfuncs[i])
+				break;
+
+		ps_sw_colpixels[i].value.i += dc_yh - dc_yl + 1;
+
+		if (overdrawcount)
+			R_CountOverdraw(dc_x, dc_x, dc_yl, dc_yh);
+	}
+
+	drawer();
+}
+
+/** Counts a span drawer's pixels, then runs it.
+  * Use R_RunSpanDrawer rather than calling this directly.
+  *
+  * \param drawer Span drawer to run.
+  */
+void R_CountSpanDrawer(void (*drawer)(void))
+{
+	INT32 i;
+
+	if (ds_x1 <= ds_x2)
+	{
+		for (i = 0; i < SPANDRAWFUNC_MAX; i++)
+			if (drawer == spanfuncs[i] || drawer == spanfuncs_npo2[i])
+				break;
+
+		ps_sw_spanpixels[i].value.i += ds_x2 - ds_x1 + 1;
+
+		if (overdrawcount)
+			R_CountOverdraw(ds_x1, ds_x2, ds_y, ds_y);
+	}
+
+	drawer();
+}
+
+/** Starts counting the drawers for this view. Called before
+  * R_BeginDrawQueue, which then leaves the queue off.
+  *
+  * \param overdraw Also count the writes to each pixel, for r_overdraw.
+  * \sa R_EndDrawerCounting
+  */
+void R_BeginDrawerCounting(boolean overdraw)
+{
+	const size_t size = viewwidth * viewheight;
+	INT32 i;
+
+	for (i = 0; i <= COLDRAWFUNC_MAX; i++)
+		ps_sw_colpixels[i].value.i = 0;
+	for (i = 0; i <= SPANDRAWFUNC_MAX; i++)
+		ps_sw_spanpixels[i].value.i = 0;
+
+	overdrawcount = NULL;
+	if (overdraw)
+	{
+		if (size > overdrawsize)
+		{
+			overdrawbuffer = Z_Realloc(overdrawbuffer, size, PU_STATIC, NULL);
+			overdrawsize = size;
+		}
+
+		overdrawcount = overdrawbuffer;
+		memset(overdrawcount, 0, size);
+	}
+
+	drawercounting = true;
+}
+
+/** Stops counting the drawers, and with r_overdraw, draws the heatmap
+  * over the view. Called once the view is drawn.
+  *
+  * \sa R_BeginDrawerCounting
+  */
+void R_EndDrawerCounting(void)
+{
+	UINT8 colors[NUMOVERDRAWCOLORS];
+	INT32 x, y;
+
+	drawercounting = false;
+
+	if (!overdrawcount)
+		return;
+
+	// Looked up every time, since the palette could have changed.
+	for (x = 0; x < NUMOVERDRAWCOLORS; x++)
+		colors[x] = NearestColor(overdrawrgb[x][0], overdrawrgb[x][1], overdrawrgb[x][2]);
+
+	for (y = 0; y < viewheight; y++)
+	{
+		const UINT8 *count = &overdrawcount[y*viewwidth];
+		UINT8 *dest = ylookup[y];
+
+		for (x = 0; x < viewwidth; x++)
+			dest[columnofs[x]] = colors[min(count[x], NUMOVERDRAWCOLORS - 1)];
+	}
+
+	overdrawcount = NULL;
+}
+
+// ==========================================================================
+//                   DRAWER BENCHMARK
+// ==========================================================================
+
+typedef enum
+{
+	DRAWERBENCH_SPAN,
+	DRAWERBENCH_TILTEDSPAN,
+	DRAWERBENCH_COLUMN
+} drawerbenchkind_t;
+
+// Each plain C drawer, against whatever SCR_SetDrawFuncs picked in its place
+static const struct
+{
+	const char *name;
+	drawerbenchkind_t kind;
+	void (*plain)(void);
+	void (**current)(void);
+} drawerbenches[] = {
+	{"Span",            DRAWERBENCH_SPAN,       R_DrawSpan_8,              &spanfuncs[BASEDRAWFUNC]},
+	{"Trans. span",     DRAWERBENCH_SPAN,       R_DrawTranslucentSpan_8,   &spanfuncs[SPANDRAWFUNC_TRANS]},
+	{"Tilted span",     DRAWERBENCH_TILTEDSPAN, R_DrawTiltedSpan_8,        &spanfuncs[SPANDRAWFUNC_TILTED]},
+	{"Trans. column",   DRAWERBENCH_COLUMN,     R_DrawTranslucentColumn_8, &colfuncs[COLDRAWFUNC_FUZZY]},
+	{"Transl. column",  DRAWERBENCH_COLUMN,     R_DrawTranslatedColumn_8,  &colfuncs[COLDRAWFUNC_TRANS]},
+};
+
+#define DRAWERBENCH_FLAT 0
+#define DRAWERBENCH_TRANSMAP (DRAWERBENCH_FLAT + 256*256)
+#define DRAWERBENCH_TRANSLATION (DRAWERBENCH_TRANSMAP + 256*256)
+#define DRAWERBENCH_COLUMNSOURCE (DRAWERBENCH_TRANSLATION + 256)
+#define DRAWERBENCH_DATASIZE (DRAWERBENCH_COLUMNSOURCE + 8*MAXVIDHEIGHT)
+
+static UINT32 drawerbenchseed;
+
+static UINT32 R_DrawerBenchRandom(UINT32 range)
+{
+	drawerbenchseed = drawerbenchseed*1103515245u + 12345u;
+	return (drawerbenchseed >> 8) % range;
+}
+
+/** Sets up the drawer state for one randomly placed span or column.
+  * The same seed always gives the same span or column.
+  *
+  * \param kind What sort of drawer is about to be run.
+  * \param data Made up flat, transmap, translation and column, see DRAWERBENCH_DATASIZE.
+  * \return The number of pixels the drawer will write.
+  */
+static INT32 R_SetupDrawerBench(drawerbenchkind_t kind, UINT8 *data)
+{
+	static floatv3_t sup, svp, szp;
+
+	if (kind == DRAWERBENCH_COLUMN)
+	{
+		dc_x = R_DrawerBenchRandom(viewwidth);
+		dc_yl = R_DrawerBenchRandom(viewheight);
+		dc_yh = dc_yl + R_DrawerBenchRandom(viewheight - dc_yl);
+		dc_iscale = FRACUNIT/4 + R_DrawerBenchRandom(3*FRACUNIT/4);
+		dc_texturemid = (fixed_t)R_DrawerBenchRandom(128*FRACUNIT) - 64*FRACUNIT;
+		dc_texheight = 128;
+		dc_hires = 0;
+
+		// Texels can be a couple of screen heights either side of the middle
+		dc_source = data + DRAWERBENCH_COLUMNSOURCE + 4*MAXVIDHEIGHT;
+		dc_colormap = colormaps + 256*R_DrawerBenchRandom(32);
+		dc_transmap = data + DRAWERBENCH_TRANSMAP;
+		dc_translation = data + DRAWERBENCH_TRANSLATION;
+
+		return dc_yh - dc_yl + 1;
+	}
+
+	R_SetFlatVars(256*256);
+	ds_y = R_DrawerBenchRandom(viewheight);
+	ds_x1 = R_DrawerBenchRandom(viewwidth);
+	ds_x2 = ds_x1 + R_DrawerBenchRandom(viewwidth - ds_x1);
+	ds_xfrac = R_DrawerBenchRandom(256*FRACUNIT);
+	ds_yfrac = R_DrawerBenchRandom(256*FRACUNIT);
+	ds_xstep = (fixed_t)R_DrawerBenchRandom(2*FRACUNIT) - FRACUNIT;
+	ds_ystep = (fixed_t)R_DrawerBenchRandom(2*FRACUNIT) - FRACUNIT;
+	ds_source = data + DRAWERBENCH_FLAT;
+	ds_colormap = colormaps;
+	ds_transmap = data + DRAWERBENCH_TRANSMAP;
+
+	if (kind == DRAWERBENCH_TILTEDSPAN)
+	{
+		// Something like a gentle slope seen from above
+		sup.x = R_DrawerBenchRandom(2000)/100.0f - 10.0f;
+		sup.y = R_DrawerBenchRandom(2000)/100.0f - 10.0f;
+		sup.z = R_DrawerBenchRandom(200000) - 100000.0f;
+		svp.x = R_DrawerBenchRandom(2000)/100.0f - 10.0f;
+		svp.y = R_DrawerBenchRandom(2000)/100.0f - 10.0f;
+		svp.z = R_DrawerBenchRandom(200000) - 100000.0f;
+		szp.x = R_DrawerBenchRandom(2000)/1000000.0f + 0.0001f;
+		szp.y = R_DrawerBenchRandom(2000)/1000000.0f + 0.0001f;
+		szp.z = R_DrawerBenchRandom(2000)/10.0f + 100.0f;
+		ds_sup = &sup;
+		ds_svp = &svp;
+		ds_szp = &szp;
+		zeroheight = 1 + R_DrawerBenchRandom(1000);
+		planezlight = scalelight[LIGHTLEVELS-1];
+	}
+
+	return ds_x2 - ds_x1 + 1;
+}
+
+/** Times the drawers SCR_SetDrawFuncs picked against the plain C ones,
+  * and checks that they draw exactly the same thing.
+  */
+void Command_Drawerbench_f(void)
+{
+	INT32 count = 4096, i;
+	size_t b, screensize;
+	UINT8 *data, *saved, *plainresult;
+	UINT32 mismatches = 0;
+	double nspertick = 1000000000.0 / I_GetPrecisePrecision();
+
+	if (COM_Argc() > 2)
+	{
+		CONS_Printf(M_GetText("drawerbench [count]: time the software drawers\n"));
+		return;
+	}
+
+	if (rendermode != render_soft || !viewscreen || !colormaps || viewwidth <= 0 || viewheight <= 0)
+	{
+		CONS_Printf(M_GetText("The drawers can only be timed in the software renderer.\n"));
+		return;
+	}
+
+	if (COM_Argc() == 2)
+		count = max(atoi(COM_Argv(1)), 1);
+
+	screensize = vid.rowbytes * vid.height;
+	data = Z_Malloc(DRAWERBENCH_DATASIZE, PU_STATIC, NULL);
+	saved = Z_Malloc(screensize, PU_STATIC, NULL);
+	plainresult = Z_Malloc(screensize, PU_STATIC, NULL);
+
+	drawerbenchseed = (UINT32)I_GetPreciseTime();
+	for (i = 0; i < DRAWERBENCH_DATASIZE; i++)
+		data[i] = R_DrawerBenchRandom(256);
+
+	M_Memcpy(saved, viewscreen, screensize);
+
+	CONS_Printf("\x82%s", M_GetText("Drawers:\n"));
+	for (b = 0; b < sizeof (drawerbenches) / sizeof (drawerbenches[0]); b++)
+	{
+		void (*current)(void) = *drawerbenches[b].current;
+		UINT32 seed = drawerbenchseed;
+		precise_t plaintime = 0, currenttime = 0, start;
+		UINT64 pixels = 0;
+
+		for (i = 0; i < count; i++)
+		{
+			pixels += R_SetupDrawerBench(drawerbenches[b].kind, data);
+			start = I_GetPreciseTime();
+			drawerbenches[b].plain();
+			plaintime += I_GetPreciseTime() - start;
+		}
+		M_Memcpy(plainresult, viewscreen, screensize);
+		M_Memcpy(viewscreen, saved, screensize);
+
+		drawerbenchseed = seed;
+		for (i = 0; i < count; i++)
+		{
+			R_SetupDrawerBench(drawerbenches[b].kind, data);
+			start = I_GetPreciseTime();
+			current();
+			currenttime += I_GetPreciseTime() - start;
+		}
+		if (memcmp(plainresult, viewscreen, screensize))
+		{
+			CONS_Alert(CONS_WARNING, M_GetText("%s drawer doesn't match the plain C one\n"), drawerbenches[b].name);
+			mismatches++;
+		}
+		M_Memcpy(viewscreen, saved, screensize);
+
+		if (!pixels)
+			continue;
+		CONS_Printf(M_GetText("%-15s %6.2f ns/pixel plain, %6.2f ns/pixel in use%s\n"), drawerbenches[b].name,
+			plaintime * nspertick / pixels, currenttime * nspertick / pixels,
+			(current == drawerbenches[b].plain) ? M_GetText(" (same drawer)") : "");
+	}
+
+	Z_Free(data);
+	Z_Free(saved);
+	Z_Free(plainresult);
+
+	if (!mismatches)
+		CONS_Printf(M_GetText("All drawers matched.\n"));
+}
+
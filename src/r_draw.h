@@ -16,6 +16,15 @@
 
 #include "r_defs.h"
 
+// The render threads each have their own copy of the drawer state, so that
+// they can all run drawers at once. See R_RunColumnDrawer.
+#if defined (HAVE_THREADS) && defined (ATTRTHREADLOCAL)
+#define RENDERTHREADS
+#define DRAWERSTATE ATTRTHREADLOCAL
+#else
+#define DRAWERSTATE
+#endif
+
 // -------------------------------
 // COMMON STUFF FOR 8bpp AND 16bpp
 // -------------------------------
@@ -24,47 +33,49 @@ extern UINT8 *ylookup1[MAXVIDHEIGHT*4];
 extern UINT8 *ylookup2[MAXVIDHEIGHT*4];
 extern INT32 columnofs[MAXVIDWIDTH*4];
 extern UINT8 *topleft;
+extern UINT8 *viewscreen;
+extern INT32 columnpitch, spanpitch;
 
 // -------------------------
 // COLUMN DRAWING CODE STUFF
 // -------------------------
 
-extern lighttable_t *dc_colormap;
-extern INT32 dc_x, dc_yl, dc_yh;
-extern fixed_t dc_iscale, dc_texturemid;
-extern UINT8 dc_hires;
+extern DRAWERSTATE lighttable_t *dc_colormap;
+extern DRAWERSTATE INT32 dc_x, dc_yl, dc_yh;
+extern DRAWERSTATE fixed_t dc_iscale, dc_texturemid;
+extern DRAWERSTATE UINT8 dc_hires;
 
-extern UINT8 *dc_source; // first pixel in a column
+extern DRAWERSTATE UINT8 *dc_source; // first pixel in a column
 
 // translucency stuff here
-extern UINT8 *dc_transmap;
+extern DRAWERSTATE UINT8 *dc_transmap;
 
 // translation stuff here
 
-extern UINT8 *dc_translation;
+extern DRAWERSTATE UINT8 *dc_translation;
 
 extern struct r_lightlist_s *dc_lightlist;
 extern INT32 dc_numlights, dc_maxlights;
 
 //Fix TUTIFRUTI
-extern INT32 dc_texheight;
+extern DRAWERSTATE INT32 dc_texheight;
 
 // -----------------------
 // SPAN DRAWING CODE STUFF
 // -----------------------
 
-extern INT32 ds_y, ds_x1, ds_x2;
-extern lighttable_t *ds_colormap;
-extern lighttable_t *ds_translation;
+extern DRAWERSTATE INT32 ds_y, ds_x1, ds_x2;
+extern DRAWERSTATE lighttable_t *ds_colormap;
+extern DRAWERSTATE lighttable_t *ds_translation;
 
-extern fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
-extern INT32 ds_waterofs, ds_bgofs;
+extern DRAWERSTATE fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
+extern DRAWERSTATE INT32 ds_waterofs, ds_bgofs;
 
-extern UINT16 ds_flatwidth, ds_flatheight;
-extern boolean ds_powersoftwo, ds_solidcolor;
+extern DRAWERSTATE UINT16 ds_flatwidth, ds_flatheight;
+extern DRAWERSTATE boolean ds_powersoftwo, ds_solidcolor;
 
-extern UINT8 *ds_source;
-extern UINT8 *ds_transmap;
+extern DRAWERSTATE UINT8 *ds_source;
+extern DRAWERSTATE UINT8 *ds_transmap;
 
 typedef struct {
 	float x, y, z;
@@ -72,14 +83,54 @@ typedef struct {
 
 // Vectors for Software's tilted slope drawers
 extern floatv3_t *ds_su, *ds_sv, *ds_sz;
-extern floatv3_t *ds_sup, *ds_svp, *ds_szp;
-extern float focallengthf, zeroheight;
+extern DRAWERSTATE floatv3_t *ds_sup, *ds_svp, *ds_szp;
+extern float focallengthf;
+extern DRAWERSTATE float zeroheight;
 
 // Variable flat sizes
-extern UINT32 nflatxshift;
-extern UINT32 nflatyshift;
-extern UINT32 nflatshiftup;
-extern UINT32 nflatmask;
+extern DRAWERSTATE UINT32 nflatxshift;
+extern DRAWERSTATE UINT32 nflatyshift;
+extern DRAWERSTATE UINT32 nflatshiftup;
+extern DRAWERSTATE UINT32 nflatmask;
+
+// --------------------------
+// MULTITHREADED DRAWING
+// --------------------------
+
+// Upper limit on r_threads
+#define MAXRENDERTHREADS 16
+
+// Calls a drawer, or queues it for the render threads along with
+// a copy of the dc_ or ds_ state it draws with.
+// While the drawers are being counted, they go through
+// R_CountColumnDrawer and R_CountSpanDrawer instead.
+#ifdef RENDERTHREADS
+extern DRAWERSTATE boolean drawqueueactive;
+void R_QueueColumnDrawer(void (*drawer)(void));
+void R_QueueSpanDrawer(void (*drawer)(void));
+#define R_RunColumnDrawer(drawer) (drawqueueactive ? R_QueueColumnDrawer(drawer) : drawercounting ? R_CountColumnDrawer(drawer) : (drawer)())
+#define R_RunSpanDrawer(drawer) (drawqueueactive ? R_QueueSpanDrawer(drawer) : drawercounting ? R_CountSpanDrawer(drawer) : (drawer)())
+#else
+#define R_RunColumnDrawer(drawer) (drawercounting ? R_CountColumnDrawer(drawer) : (drawer)())
+#define R_RunSpanDrawer(drawer) (drawercounting ? R_CountSpanDrawer(drawer) : (drawer)())
+#endif
+
+void R_BeginDrawQueue(void);
+void R_FlushDrawQueue(void);
+void R_EndDrawQueue(void);
+
+// --------------------------
+// DRAWER STATISTICS
+// --------------------------
+
+// Between R_BeginDrawerCounting and R_EndDrawerCounting
+extern boolean drawercounting;
+
+void R_CountColumnDrawer(void (*drawer)(void));
+void R_CountSpanDrawer(void (*drawer)(void));
+
+void R_BeginDrawerCounting(boolean overdraw);
+void R_EndDrawerCounting(void);
 
 /// \brief Top border
 #define BRDR_T 0
@@ -122,6 +173,8 @@ enum
 // Initialize color translation tables, for player rendering etc.
 UINT8* R_GetTranslationColormap(INT32 skinnum, skincolornum_t color, UINT8 flags);
 void R_FlushTranslationColormapCache(void);
+UINT8 *R_GetFusedColormap(const UINT8 *colormap, const UINT8 *translation);
+void R_FlushFusedColormapCache(void);
 UINT16 R_GetColorByName(const char *name);
 UINT16 R_GetSuperColorByName(const char *name);
 
@@ -150,6 +203,7 @@ boolean R_BlendLevelVisible(INT32 blendmode, INT32 alphalevel);
 extern UINT8 skincolor_modified[];
 
 void R_InitViewBuffer(INT32 width, INT32 height);
+void R_TransposeViewBuffer(void);
 void R_InitViewBorder(void);
 void R_VideoErase(size_t ofs, INT32 count);
 
@@ -218,6 +272,36 @@ void R_DrawTiltedTranslucentFloorSprite_NPO2_8(void);
 void R_DrawWaterSpan_NPO2_8(void);
 void R_DrawTiltedWaterSpan_NPO2_8(void);
 
+// SIMD versions of the busiest drawers, see r_draw8_simd.c
+#if (defined (__x86_64__) || defined (_M_X64) || defined (__i386__) || defined (_M_IX86)) \
+	&& (defined (__clang__) || defined (_MSC_VER) || (defined (__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SIMDDRAWERS_X86
+#elif (defined (__aarch64__) || defined (_M_ARM64)) && (defined (__GNUC__) || defined (_MSC_VER))
+#define SIMDDRAWERS_NEON
+#endif
+
+#ifdef SIMDDRAWERS_X86
+void R_DrawSpan_8_SSE2(void);
+void R_DrawTranslucentSpan_8_SSE2(void);
+void R_DrawTiltedSpan_8_SSE2(void);
+void R_DrawTranslucentColumn_8_SSE2(void);
+void R_DrawTranslatedColumn_8_SSE2(void);
+
+void R_DrawSpan_8_AVX2(void);
+void R_DrawTranslucentSpan_8_AVX2(void);
+void R_DrawTiltedSpan_8_AVX2(void);
+void R_DrawTranslucentColumn_8_AVX2(void);
+void R_DrawTranslatedColumn_8_AVX2(void);
+#endif
+
+#ifdef SIMDDRAWERS_NEON
+void R_DrawSpan_8_NEON(void);
+void R_DrawTranslucentSpan_8_NEON(void);
+void R_DrawTiltedSpan_8_NEON(void);
+void R_DrawTranslucentColumn_8_NEON(void);
+void R_DrawTranslatedColumn_8_NEON(void);
+#endif
+
 void R_DrawSolidColorSpan_8(void);
 void R_DrawTransSolidColorSpan_8(void);
 void R_DrawTiltedSolidColorSpan_8(void);
@@ -225,6 +309,8 @@ void R_DrawTiltedTransSolidColorSpan_8(void);
 void R_DrawWaterSolidColorSpan_8(void);
 void R_DrawTiltedWaterSolidColorSpan_8(void);
 
+void Command_Drawerbench_f(void);
+
 // ------------------
 // 16bpp DRAWING CODE
 // ------------------
@@ -44,7 +44,7 @@ void R_DrawColumn_8(void)
 	// Use columnofs LUT for subwindows?
 
 	//dest = ylookup[dc_yl] + columnofs[dc_x];
-	dest = &topleft[dc_yl*vid.width + dc_x];
+	dest = &topleft[dc_yl*columnpitch + dc_x*spanpitch];
 
 	count++;
 
@@ -76,7 +76,7 @@ void R_DrawColumn_8(void)
 				//  using a lighting/special effects LUT.
 				// heightmask is the Tutti-Frutti fix
 				*dest = colormap[source[frac>>FRACBITS]];
-				dest += vid.width;
+				dest += columnpitch;
 
 				// Avoid overflow.
 				if (fracstep > 0x7FFFFFFF - frac)
@@ -93,10 +93,10 @@ void R_DrawColumn_8(void)
 			while ((count -= 2) >= 0) // texture height is a power of 2
 			{
 				*dest = colormap[source[(frac>>FRACBITS) & heightmask]];
-				dest += vid.width;
+				dest += columnpitch;
 				frac += fracstep;
 				*dest = colormap[source[(frac>>FRACBITS) & heightmask]];
-				dest += vid.width;
+				dest += columnpitch;
 				frac += fracstep;
 			}
 			if (count & 1)
@@ -127,7 +127,7 @@ void R_Draw2sMultiPatchColumn_8(void)
 	// Use columnofs LUT for subwindows?
 
 	//dest = ylookup[dc_yl] + columnofs[dc_x];
-	dest = &topleft[dc_yl*vid.width + dc_x];
+	dest = &topleft[dc_yl*columnpitch + dc_x*spanpitch];
 
 	count++;
 
@@ -164,7 +164,7 @@ void R_Draw2sMultiPatchColumn_8(void)
 				if (val != TRANSPARENTPIXEL)
 					*dest = colormap[val];
 
-				dest += vid.width;
+				dest += columnpitch;
 
 				// Avoid overflow.
 				if (fracstep > 0x7FFFFFFF - frac)
@@ -183,12 +183,12 @@ void R_Draw2sMultiPatchColumn_8(void)
 				val = source[(frac>>FRACBITS) & heightmask];
 				if (val != TRANSPARENTPIXEL)
 					*dest = colormap[val];
-				dest += vid.width;
+				dest += columnpitch;
 				frac += fracstep;
 				val = source[(frac>>FRACBITS) & heightmask];
 				if (val != TRANSPARENTPIXEL)
 					*dest = colormap[val];
-				dest += vid.width;
+				dest += columnpitch;
 				frac += fracstep;
 			}
 			if (count & 1)
@@ -223,7 +223,7 @@ void R_Draw2sMultiPatchTranslucentColumn_8(void)
 	// Use columnofs LUT for subwindows?
 
 	//dest = ylookup[dc_yl] + columnofs[dc_x];
-	dest = &topleft[dc_yl*vid.width + dc_x];
+	dest = &topleft[dc_yl*columnpitch + dc_x*spanpitch];
 
 	count++;
 
@@ -261,7 +261,7 @@ void R_Draw2sMultiPatchTranslucentColumn_8(void)
 				if (val != TRANSPARENTPIXEL)
 					*dest = *(transmap + (colormap[val]<<8) + (*dest));
 
-				dest += vid.width;
+				dest += columnpitch;
 
 				// Avoid overflow.
 				if (fracstep > 0x7FFFFFFF - frac)
@@ -280,12 +280,12 @@ void R_Draw2sMultiPatchTranslucentColumn_8(void)
 				val = source[(frac>>FRACBITS) & heightmask];
 				if (val != TRANSPARENTPIXEL)
 					*dest = *(transmap + (colormap[val]<<8) + (*dest));
-				dest += vid.width;
+				dest += columnpitch;
 				frac += fracstep;
 				val = source[(frac>>FRACBITS) & heightmask];
 				if (val != TRANSPARENTPIXEL)
 					*dest = *(transmap + (colormap[val]<<8) + (*dest));
-				dest += vid.width;
+				dest += columnpitch;
 				frac += fracstep;
 			}
 			if (count & 1)
@@ -322,7 +322,7 @@ void R_DrawShadeColumn_8(void)
 
 	// FIXME. As above.
 	//dest = ylookup[dc_yl] + columnofs[dc_x];
-	dest = &topleft[dc_yl*vid.width + dc_x];
+	dest = &topleft[dc_yl*columnpitch + dc_x*spanpitch];
 
 	// Looks familiar.
 	fracstep = dc_iscale;
@@ -333,7 +333,7 @@ void R_DrawShadeColumn_8(void)
 	do
 	{
 		*dest = colormaps[(dc_source[frac>>FRACBITS] <<8) + (*dest)];
-		dest += vid.width;
+		dest += columnpitch;
 		frac += fracstep;
 	} while (count--);
 }
@@ -361,7 +361,7 @@ void R_DrawTranslucentColumn_8(void)
 
 	// FIXME. As above.
 	//dest = ylookup[dc_yl] + columnofs[dc_x];
-	dest = &topleft[dc_yl*vid.width + dc_x];
+	dest = &topleft[dc_yl*columnpitch + dc_x*spanpitch];
 
 	// Looks familiar.
 	fracstep = dc_iscale;
@@ -393,7 +393,7 @@ void R_DrawTranslucentColumn_8(void)
 				// using a lighting/special effects LUT.
 				// heightmask is the Tutti-Frutti fix
 				*dest = *(transmap + (colormap[source[frac>>FRACBITS]]<<8) + (*dest));
-				dest += vid.width;
+				dest += columnpitch;
 				if ((frac += fracstep) >= heightmask)
 					frac -= heightmask;
 			}
@@ -404,10 +404,10 @@ void R_DrawTranslucentColumn_8(void)
 			while ((count -= 2) >= 0) // texture height is a power of 2
 			{
 				*dest = *(transmap + (colormap[source[(frac>>FRACBITS)&heightmask]]<<8) + (*dest));
-				dest += vid.width;
+				dest += columnpitch;
 				frac += fracstep;
 				*dest = *(transmap + (colormap[source[(frac>>FRACBITS)&heightmask]]<<8) + (*dest));
-				dest += vid.width;
+				dest += columnpitch;
 				frac += fracstep;
 			}
 			if (count & 1)
@@ -431,7 +431,7 @@ void R_DrawDropShadowColumn_8(void)
 	if (count <= 0) // Zero length, column does not exceed a pixel.
 		return;
 
-	dest = &topleft[dc_yl*vid.width + dc_x];
+	dest = &topleft[dc_yl*columnpitch + dc_x*spanpitch];
 
 	{
 #define DSCOLOR 31 // palette index for the color of the shadow
@@ -440,9 +440,9 @@ void R_DrawDropShadowColumn_8(void)
 		while ((count -= 2) >= 0)
 		{
 			*dest = *(transmap_offset + (*dest));
-			dest += vid.width;
+			dest += columnpitch;
 			*dest = *(transmap_offset + (*dest));
-			dest += vid.width;
+			dest += columnpitch;
 		}
 		if (count & 1)
 			*dest = *(transmap_offset + (*dest));
@@ -466,7 +466,7 @@ void R_DrawTranslatedTranslucentColumn_8(void)
 
 	// FIXME. As above.
 	//dest = ylookup[dc_yl] + columnofs[dc_x];
-	dest = &topleft[dc_yl*vid.width + dc_x];
+	dest = &topleft[dc_yl*columnpitch + dc_x*spanpitch];
 
 	// Looks familiar.
 	fracstep = dc_iscale;
@@ -497,7 +497,7 @@ void R_DrawTranslatedTranslucentColumn_8(void)
 
 				*dest = *(dc_transmap + (dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]]<<8) + (*dest));
 
-				dest += vid.width;
+				dest += columnpitch;
 				if ((frac += fracstep) >= heightmask)
 					frac -= heightmask;
 			}
@@ -508,10 +508,10 @@ void R_DrawTranslatedTranslucentColumn_8(void)
 			while ((count -= 2) >= 0) // texture height is a power of 2
 			{
 				*dest = *(dc_transmap + (dc_colormap[dc_translation[dc_source[(frac>>FRACBITS)&heightmask]]]<<8) + (*dest));
-				dest += vid.width;
+				dest += columnpitch;
 				frac += fracstep;
 				*dest = *(dc_transmap + (dc_colormap[dc_translation[dc_source[(frac>>FRACBITS)&heightmask]]]<<8) + (*dest));
-				dest += vid.width;
+				dest += columnpitch;
 				frac += fracstep;
 			}
 			if (count & 1)
@@ -542,7 +542,7 @@ void R_DrawTranslatedColumn_8(void)
 
 	// FIXME. As above.
 	//dest = ylookup[dc_yl] + columnofs[dc_x];
-	dest = &topleft[dc_yl*vid.width + dc_x];
+	dest = &topleft[dc_yl*columnpitch + dc_x*spanpitch];
 
 	// Looks familiar.
 	fracstep = dc_iscale;
@@ -559,7 +559,7 @@ void R_DrawTranslatedColumn_8(void)
 		//  is mapped to gray, red, black/indigo.
 		*dest = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
 
-		dest += vid.width;
+		dest += columnpitch;
 
 		frac += fracstep;
 	} while (count--);
@@ -569,9 +569,6 @@ void R_DrawTranslatedColumn_8(void)
 // SPANS
 // ==========================================================================
 
-#define SPANSIZE 16
-#define INVSPAN 0.0625f
-
 /**	\brief The R_DrawSpan_8 function
 	Draws the actual span.
 */
@@ -584,7 +581,7 @@ void R_DrawSpan_8 (void)
 	UINT8 *source;
 	UINT8 *colormap;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 
@@ -617,40 +614,41 @@ void R_DrawSpan_8 (void)
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[1] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
+		dest[spanpitch] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[2] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
+		dest[2*spanpitch] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[3] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
+		dest[3*spanpitch] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[4] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
+		dest[4*spanpitch] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[5] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
+		dest[5*spanpitch] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[6] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
+		dest[6*spanpitch] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[7] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
+		dest[7*spanpitch] = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest += 8;
+		dest += 8*spanpitch;
 		count -= 8;
 	}
 	while (count-- && dest <= deststop)
 	{
-		*dest++ = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
+		*dest = colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]];
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -675,6 +673,8 @@ void R_DrawTiltedSpan_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	iz = ds_szp->z + ds_szp->y*(centery-ds_y) + ds_szp->x*(ds_x1-centerx);
 
@@ -699,7 +699,7 @@ void R_DrawTiltedSpan_8(void)
 		colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 
 		*dest = colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]];
-		dest++;
+		dest += spanpitch;
 		iz += ds_szp->x;
 		uz += ds_sup->x;
 		vz += ds_svp->x;
@@ -709,13 +709,16 @@ void R_DrawTiltedSpan_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -724,22 +727,22 @@ void R_DrawTiltedSpan_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 			*dest = colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]];
-			dest++;
+			dest += spanpitch;
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -770,7 +773,7 @@ void R_DrawTiltedSpan_8(void)
 			{
 				colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 				*dest = colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]];
-				dest++;
+				dest += spanpitch;
 				u += stepu;
 				v += stepv;
 			}
@@ -798,6 +801,8 @@ void R_DrawTiltedTranslucentSpan_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	iz = ds_szp->z + ds_szp->y*(centery-ds_y) + ds_szp->x*(ds_x1-centerx);
 
@@ -821,7 +826,7 @@ void R_DrawTiltedTranslucentSpan_8(void)
 
 		colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 		*dest = *(ds_transmap + (colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]] << 8) + *dest);
-		dest++;
+		dest += spanpitch;
 		iz += ds_szp->x;
 		uz += ds_sup->x;
 		vz += ds_svp->x;
@@ -831,13 +836,16 @@ void R_DrawTiltedTranslucentSpan_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -846,22 +854,22 @@ void R_DrawTiltedTranslucentSpan_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 			*dest = *(ds_transmap + (colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]] << 8) + *dest);
-			dest++;
+			dest += spanpitch;
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -892,7 +900,7 @@ void R_DrawTiltedTranslucentSpan_8(void)
 			{
 				colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 				*dest = *(ds_transmap + (colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]] << 8) + *dest);
-				dest++;
+				dest += spanpitch;
 				u += stepu;
 				v += stepv;
 			}
@@ -921,6 +929,8 @@ void R_DrawTiltedWaterSpan_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	iz = ds_szp->z + ds_szp->y*(centery-ds_y) + ds_szp->x*(ds_x1-centerx);
 
@@ -930,7 +940,7 @@ void R_DrawTiltedWaterSpan_8(void)
 	vz = ds_svp->z + ds_svp->y*(centery-ds_y) + ds_svp->x*(ds_x1-centerx);
 
 	dest = ylookup[ds_y] + columnofs[ds_x1];
-	dsrc = screens[1] + (ds_y+ds_bgofs)*vid.width + ds_x1;
+	dsrc = screens[1] + (ds_y+ds_bgofs)*columnpitch + ds_x1*spanpitch;
 	source = ds_source;
 	//colormap = ds_colormap;
 
@@ -944,8 +954,9 @@ void R_DrawTiltedWaterSpan_8(void)
 		v = (INT64)(vz*z);
 
 		colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
-		*dest = *(ds_transmap + (colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]] << 8) + *dsrc++);
-		dest++;
+		*dest = *(ds_transmap + (colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]] << 8) + *dsrc);
+		dest += spanpitch;
+		dsrc += spanpitch;
 		iz += ds_szp->x;
 		uz += ds_sup->x;
 		vz += ds_svp->x;
@@ -955,13 +966,16 @@ void R_DrawTiltedWaterSpan_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -970,22 +984,23 @@ void R_DrawTiltedWaterSpan_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
-			*dest = *(ds_transmap + (colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]] << 8) + *dsrc++);
-			dest++;
+			*dest = *(ds_transmap + (colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]] << 8) + *dsrc);
+			dest += spanpitch;
+			dsrc += spanpitch;
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -994,7 +1009,7 @@ void R_DrawTiltedWaterSpan_8(void)
 			u = (INT64)(startu);
 			v = (INT64)(startv);
 			colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
-			*dest = *(ds_transmap + (colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]] << 8) + *dsrc++);
+			*dest = *(ds_transmap + (colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]] << 8) + *dsrc);
 		}
 		else
 		{
@@ -1015,8 +1030,9 @@ void R_DrawTiltedWaterSpan_8(void)
 			for (; width != 0; width--)
 			{
 				colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
-				*dest = *(ds_transmap + (colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]] << 8) + *dsrc++);
-				dest++;
+				*dest = *(ds_transmap + (colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]] << 8) + *dsrc);
+				dest += spanpitch;
+				dsrc += spanpitch;
 				u += stepu;
 				v += stepv;
 			}
@@ -1043,6 +1059,8 @@ void R_DrawTiltedSplat_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	iz = ds_szp->z + ds_szp->y*(centery-ds_y) + ds_szp->x*(ds_x1-centerx);
 
@@ -1070,7 +1088,7 @@ void R_DrawTiltedSplat_8(void)
 		if (val != TRANSPARENTPIXEL)
 			*dest = colormap[val];
 
-		dest++;
+		dest += spanpitch;
 		iz += ds_szp->x;
 		uz += ds_sup->x;
 		vz += ds_svp->x;
@@ -1080,13 +1098,16 @@ void R_DrawTiltedSplat_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -1095,24 +1116,24 @@ void R_DrawTiltedSplat_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 			val = source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)];
 			if (val != TRANSPARENTPIXEL)
 				*dest = colormap[val];
-			dest++;
+			dest += spanpitch;
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -1147,7 +1168,7 @@ void R_DrawTiltedSplat_8(void)
 				val = source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)];
 				if (val != TRANSPARENTPIXEL)
 					*dest = colormap[val];
-				dest++;
+				dest += spanpitch;
 				u += stepu;
 				v += stepv;
 			}
@@ -1168,7 +1189,7 @@ void R_DrawSplat_8 (void)
 	UINT8 *source;
 	UINT8 *colormap;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 	UINT32 val;
@@ -1210,7 +1231,7 @@ void R_DrawSplat_8 (void)
 		val &= 0x3FFFFF;
 		val = source[val];
 		if (val != TRANSPARENTPIXEL)
-			dest[1] = colormap[val];
+			dest[spanpitch] = colormap[val];
 		xposition += xstep;
 		yposition += ystep;
 
@@ -1218,7 +1239,7 @@ void R_DrawSplat_8 (void)
 		val &= 0x3FFFFF;
 		val = source[val];
 		if (val != TRANSPARENTPIXEL)
-			dest[2] = colormap[val];
+			dest[2*spanpitch] = colormap[val];
 		xposition += xstep;
 		yposition += ystep;
 
@@ -1226,7 +1247,7 @@ void R_DrawSplat_8 (void)
 		val &= 0x3FFFFF;
 		val = source[val];
 		if (val != TRANSPARENTPIXEL)
-			dest[3] = colormap[val];
+			dest[3*spanpitch] = colormap[val];
 		xposition += xstep;
 		yposition += ystep;
 
@@ -1234,7 +1255,7 @@ void R_DrawSplat_8 (void)
 		val &= 0x3FFFFF;
 		val = source[val];
 		if (val != TRANSPARENTPIXEL)
-			dest[4] = colormap[val];
+			dest[4*spanpitch] = colormap[val];
 		xposition += xstep;
 		yposition += ystep;
 
@@ -1242,7 +1263,7 @@ void R_DrawSplat_8 (void)
 		val &= 0x3FFFFF;
 		val = source[val];
 		if (val != TRANSPARENTPIXEL)
-			dest[5] = colormap[val];
+			dest[5*spanpitch] = colormap[val];
 		xposition += xstep;
 		yposition += ystep;
 
@@ -1250,7 +1271,7 @@ void R_DrawSplat_8 (void)
 		val &= 0x3FFFFF;
 		val = source[val];
 		if (val != TRANSPARENTPIXEL)
-			dest[6] = colormap[val];
+			dest[6*spanpitch] = colormap[val];
 		xposition += xstep;
 		yposition += ystep;
 
@@ -1258,11 +1279,11 @@ void R_DrawSplat_8 (void)
 		val &= 0x3FFFFF;
 		val = source[val];
 		if (val != TRANSPARENTPIXEL)
-			dest[7] = colormap[val];
+			dest[7*spanpitch] = colormap[val];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest += 8;
+		dest += 8*spanpitch;
 		count -= 8;
 	}
 	while (count-- && dest <= deststop)
@@ -1270,7 +1291,7 @@ void R_DrawSplat_8 (void)
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val != TRANSPARENTPIXEL)
 			*dest = colormap[val];
-		dest++;
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -1288,7 +1309,7 @@ void R_DrawTranslucentSplat_8 (void)
 	UINT8 *source;
 	UINT8 *colormap;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 	UINT32 val;
@@ -1323,47 +1344,47 @@ void R_DrawTranslucentSplat_8 (void)
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val != TRANSPARENTPIXEL)
-			dest[1] = *(ds_transmap + (colormap[val] << 8) + dest[1]);
+			dest[spanpitch] = *(ds_transmap + (colormap[val] << 8) + dest[spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val != TRANSPARENTPIXEL)
-			dest[2] = *(ds_transmap + (colormap[val] << 8) + dest[2]);
+			dest[2*spanpitch] = *(ds_transmap + (colormap[val] << 8) + dest[2*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val != TRANSPARENTPIXEL)
-			dest[3] = *(ds_transmap + (colormap[val] << 8) + dest[3]);
+			dest[3*spanpitch] = *(ds_transmap + (colormap[val] << 8) + dest[3*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val != TRANSPARENTPIXEL)
-			dest[4] = *(ds_transmap + (colormap[val] << 8) + dest[4]);
+			dest[4*spanpitch] = *(ds_transmap + (colormap[val] << 8) + dest[4*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val != TRANSPARENTPIXEL)
-			dest[5] = *(ds_transmap + (colormap[val] << 8) + dest[5]);
+			dest[5*spanpitch] = *(ds_transmap + (colormap[val] << 8) + dest[5*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val != TRANSPARENTPIXEL)
-			dest[6] = *(ds_transmap + (colormap[val] << 8) + dest[6]);
+			dest[6*spanpitch] = *(ds_transmap + (colormap[val] << 8) + dest[6*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val != TRANSPARENTPIXEL)
-			dest[7] = *(ds_transmap + (colormap[val] << 8) + dest[7]);
+			dest[7*spanpitch] = *(ds_transmap + (colormap[val] << 8) + dest[7*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
-		dest += 8;
+		dest += 8*spanpitch;
 		count -= 8;
 	}
 	while (count-- && dest <= deststop)
@@ -1371,7 +1392,7 @@ void R_DrawTranslucentSplat_8 (void)
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val != TRANSPARENTPIXEL)
 			*dest = *(ds_transmap + (colormap[val] << 8) + *dest);
-		dest++;
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -1390,7 +1411,7 @@ void R_DrawFloorSprite_8 (void)
 	UINT8 *colormap;
 	UINT8 *translation;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 	UINT32 val;
@@ -1428,53 +1449,53 @@ void R_DrawFloorSprite_8 (void)
 		val = (((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift);
 		val = source[val];
 		if (val & 0xFF00)
-			dest[1] = colormap[translation[val & 0xFF]];
+			dest[spanpitch] = colormap[translation[val & 0xFF]];
 		xposition += xstep;
 		yposition += ystep;
 
 		val = (((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift);
 		val = source[val];
 		if (val & 0xFF00)
-			dest[2] = colormap[translation[val & 0xFF]];
+			dest[2*spanpitch] = colormap[translation[val & 0xFF]];
 		xposition += xstep;
 		yposition += ystep;
 
 		val = (((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift);
 		val = source[val];
 		if (val & 0xFF00)
-			dest[3] = colormap[translation[val & 0xFF]];
+			dest[3*spanpitch] = colormap[translation[val & 0xFF]];
 		xposition += xstep;
 		yposition += ystep;
 
 		val = (((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift);
 		val = source[val];
 		if (val & 0xFF00)
-			dest[4] = colormap[translation[val & 0xFF]];
+			dest[4*spanpitch] = colormap[translation[val & 0xFF]];
 		xposition += xstep;
 		yposition += ystep;
 
 		val = (((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift);
 		val = source[val];
 		if (val & 0xFF00)
-			dest[5] = colormap[translation[val & 0xFF]];
+			dest[5*spanpitch] = colormap[translation[val & 0xFF]];
 		xposition += xstep;
 		yposition += ystep;
 
 		val = (((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift);
 		val = source[val];
 		if (val & 0xFF00)
-			dest[6] = colormap[translation[val & 0xFF]];
+			dest[6*spanpitch] = colormap[translation[val & 0xFF]];
 		xposition += xstep;
 		yposition += ystep;
 
 		val = (((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift);
 		val = source[val];
 		if (val & 0xFF00)
-			dest[7] = colormap[translation[val & 0xFF]];
+			dest[7*spanpitch] = colormap[translation[val & 0xFF]];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest += 8;
+		dest += 8*spanpitch;
 		count -= 8;
 	}
 	while (count-- && dest <= deststop)
@@ -1482,7 +1503,7 @@ void R_DrawFloorSprite_8 (void)
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val & 0xFF00)
 			*dest = colormap[translation[val & 0xFF]];
-		dest++;
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -1501,7 +1522,7 @@ void R_DrawTranslucentFloorSprite_8 (void)
 	UINT8 *colormap;
 	UINT8 *translation;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 	UINT32 val;
@@ -1537,47 +1558,47 @@ void R_DrawTranslucentFloorSprite_8 (void)
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val & 0xFF00)
-			dest[1] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[1]);
+			dest[spanpitch] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val & 0xFF00)
-			dest[2] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[2]);
+			dest[2*spanpitch] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[2*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val & 0xFF00)
-			dest[3] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[3]);
+			dest[3*spanpitch] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[3*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val & 0xFF00)
-			dest[4] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[4]);
+			dest[4*spanpitch] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[4*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val & 0xFF00)
-			dest[5] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[5]);
+			dest[5*spanpitch] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[5*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val & 0xFF00)
-			dest[6] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[6]);
+			dest[6*spanpitch] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[6*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val & 0xFF00)
-			dest[7] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[7]);
+			dest[7*spanpitch] = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + dest[7*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
-		dest += 8;
+		dest += 8*spanpitch;
 		count -= 8;
 	}
 	while (count-- && dest <= deststop)
@@ -1585,7 +1606,7 @@ void R_DrawTranslucentFloorSprite_8 (void)
 		val = source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)];
 		if (val & 0xFF00)
 			*dest = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + *dest);
-		dest++;
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -1612,6 +1633,8 @@ void R_DrawTiltedFloorSprite_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	iz = ds_szp->z + ds_szp->y*(centery-ds_y) + ds_szp->x*(ds_x1-centerx);
 	uz = ds_sup->z + ds_sup->y*(centery-ds_y) + ds_sup->x*(ds_x1-centerx);
@@ -1626,13 +1649,16 @@ void R_DrawTiltedFloorSprite_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -1641,24 +1667,24 @@ void R_DrawTiltedFloorSprite_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			val = source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)];
 			if (val & 0xFF00)
 				*dest = colormap[translation[val & 0xFF]];
-			dest++;
+			dest += spanpitch;
 
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -1691,7 +1717,7 @@ void R_DrawTiltedFloorSprite_8(void)
 				val = source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)];
 				if (val & 0xFF00)
 					*dest = colormap[translation[val & 0xFF]];
-				dest++;
+				dest += spanpitch;
 
 				u += stepu;
 				v += stepv;
@@ -1721,6 +1747,8 @@ void R_DrawTiltedTranslucentFloorSprite_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	iz = ds_szp->z + ds_szp->y*(centery-ds_y) + ds_szp->x*(ds_x1-centerx);
 	uz = ds_sup->z + ds_sup->y*(centery-ds_y) + ds_sup->x*(ds_x1-centerx);
@@ -1735,13 +1763,16 @@ void R_DrawTiltedTranslucentFloorSprite_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -1750,24 +1781,24 @@ void R_DrawTiltedTranslucentFloorSprite_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			val = source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)];
 			if (val & 0xFF00)
 				*dest = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + *dest);
-			dest++;
+			dest += spanpitch;
 
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -1800,7 +1831,7 @@ void R_DrawTiltedTranslucentFloorSprite_8(void)
 				val = source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)];
 				if (val & 0xFF00)
 					*dest = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + *dest);
-				dest++;
+				dest += spanpitch;
 
 				u += stepu;
 				v += stepv;
@@ -1821,7 +1852,7 @@ void R_DrawTranslucentSpan_8 (void)
 	UINT8 *source;
 	UINT8 *colormap;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 	UINT32 val;
@@ -1852,42 +1883,42 @@ void R_DrawTranslucentSpan_8 (void)
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[1] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[1]);
+		dest[spanpitch] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[2] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[2]);
+		dest[2*spanpitch] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[2*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[3] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[3]);
+		dest[3*spanpitch] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[3*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[4] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[4]);
+		dest[4*spanpitch] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[4*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[5] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[5]);
+		dest[5*spanpitch] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[5*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[6] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[6]);
+		dest[6*spanpitch] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[6*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[7] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[7]);
+		dest[7*spanpitch] = *(ds_transmap + (colormap[source[(((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift)]] << 8) + dest[7*spanpitch]);
 		xposition += xstep;
 		yposition += ystep;
 
-		dest += 8;
+		dest += 8*spanpitch;
 		count -= 8;
 	}
 	while (count-- && dest <= deststop)
 	{
 		val = (((UINT32)yposition >> nflatyshift) & nflatmask) | ((UINT32)xposition >> nflatxshift);
 		*dest = *(ds_transmap + (colormap[source[val]] << 8) + *dest);
-		dest++;
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -1919,7 +1950,7 @@ void R_DrawWaterSpan_8(void)
 	source = ds_source;
 	colormap = ds_colormap;
 	dest = ylookup[ds_y] + columnofs[ds_x1];
-	dsrc = screens[1] + (ds_y+ds_bgofs)*vid.width + ds_x1;
+	dsrc = screens[1] + (ds_y+ds_bgofs)*columnpitch + ds_x1*spanpitch;
 	count = ds_x2 - ds_x1 + 1;
 
 	while (count >= 8)
@@ -1927,44 +1958,47 @@ void R_DrawWaterSpan_8(void)
 		// SoM: Why didn't I see this earlier? the spot variable is a waste now because we don't
 		// have the uber complicated math to calculate it now, so that was a memory write we didn't
 		// need!
-		dest[0] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + *dsrc++)];
+		dest[0] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + dsrc[0])];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[1] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + *dsrc++)];
+		dest[spanpitch] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + dsrc[spanpitch])];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[2] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + *dsrc++)];
+		dest[2*spanpitch] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + dsrc[2*spanpitch])];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[3] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + *dsrc++)];
+		dest[3*spanpitch] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + dsrc[3*spanpitch])];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[4] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + *dsrc++)];
+		dest[4*spanpitch] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + dsrc[4*spanpitch])];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[5] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + *dsrc++)];
+		dest[5*spanpitch] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + dsrc[5*spanpitch])];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[6] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + *dsrc++)];
+		dest[6*spanpitch] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + dsrc[6*spanpitch])];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest[7] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + *dsrc++)];
+		dest[7*spanpitch] = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + dsrc[7*spanpitch])];
 		xposition += xstep;
 		yposition += ystep;
 
-		dest += 8;
+		dest += 8*spanpitch;
+		dsrc += 8*spanpitch;
 		count -= 8;
 	}
 	while (count--)
 	{
-		*dest++ = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + *dsrc++)];
+		*dest = colormap[*(ds_transmap + (source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)] << 8) + *dsrc)];
+		dest += spanpitch;
+		dsrc += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -1982,25 +2016,25 @@ void R_DrawFogSpan_8(void)
 
 	colormap = ds_colormap;
 	//dest = ylookup[ds_y] + columnofs[ds_x1];
-	dest = &topleft[ds_y *vid.width + ds_x1];
+	dest = &topleft[ds_y*columnpitch + ds_x1*spanpitch];
 
 	count = ds_x2 - ds_x1 + 1;
 
 	while (count >= 4)
 	{
 		dest[0] = colormap[dest[0]];
-		dest[1] = colormap[dest[1]];
-		dest[2] = colormap[dest[2]];
-		dest[3] = colormap[dest[3]];
+		dest[spanpitch] = colormap[dest[spanpitch]];
+		dest[2*spanpitch] = colormap[dest[2*spanpitch]];
+		dest[3*spanpitch] = colormap[dest[3*spanpitch]];
 
-		dest += 4;
+		dest += 4*spanpitch;
 		count -= 4;
 	}
 
 	while (count--)
 	{
 		*dest = colormap[*dest];
-		dest++;
+		dest += spanpitch;
 	}
 }
 
@@ -2021,7 +2055,7 @@ void R_DrawTiltedFogSpan_8(void)
 	{
 		UINT8 *colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 		*dest = colormap[*dest];
-		dest++;
+		dest += spanpitch;
 	} while (--width >= 0);
 }
 
@@ -2035,7 +2069,16 @@ void R_DrawSolidColorSpan_8(void)
 	UINT8 source = ds_colormap[ds_source[0]];
 	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
 
-	memset(dest, source, count);
+	if (spanpitch == 1)
+		memset(dest, source, count);
+	else
+	{
+		while (count--)
+		{
+			*dest = source;
+			dest += spanpitch;
+		}
+	}
 }
 
 /**	\brief The R_DrawTransSolidColorSpan_8 function
@@ -2048,12 +2091,12 @@ void R_DrawTransSolidColorSpan_8(void)
 	UINT8 source = ds_colormap[ds_source[0]];
 	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
 
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	while (count-- && dest <= deststop)
 	{
 		*dest = *(ds_transmap + (source << 8) + *dest);
-		dest++;
+		dest += spanpitch;
 	}
 }
 
@@ -2074,7 +2117,8 @@ void R_DrawTiltedSolidColorSpan_8(void)
 	do
 	{
 		UINT8 *colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
-		*dest++ = colormap[source];
+		*dest = colormap[source];
+		dest += spanpitch;
 	} while (--width >= 0);
 }
 
@@ -2096,7 +2140,7 @@ void R_DrawTiltedTransSolidColorSpan_8(void)
 	{
 		UINT8 *colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 		*dest = *(ds_transmap + (colormap[source] << 8) + *dest);
-		dest++;
+		dest += spanpitch;
 	} while (--width >= 0);
 }
 
@@ -2108,15 +2152,16 @@ void R_DrawWaterSolidColorSpan_8(void)
 	UINT8 source = ds_source[0];
 	UINT8 *colormap = ds_colormap;
 	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
-	UINT8 *dsrc = screens[1] + (ds_y+ds_bgofs)*vid.width + ds_x1;
+	UINT8 *dsrc = screens[1] + (ds_y+ds_bgofs)*columnpitch + ds_x1*spanpitch;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	while (count-- && dest <= deststop)
 	{
-		*dest = colormap[*(ds_transmap + (source << 8) + *dsrc++)];
-		dest++;
+		*dest = colormap[*(ds_transmap + (source << 8) + *dsrc)];
+		dest += spanpitch;
+		dsrc += spanpitch;
 	}
 }
 
@@ -2129,7 +2174,7 @@ void R_DrawTiltedWaterSolidColorSpan_8(void)
 
 	UINT8 source = ds_source[0];
 	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
-	UINT8 *dsrc = screens[1] + (ds_y+ds_bgofs)*vid.width + ds_x1;
+	UINT8 *dsrc = screens[1] + (ds_y+ds_bgofs)*columnpitch + ds_x1*spanpitch;
 
 	double iz = ds_szp->z + ds_szp->y*(centery-ds_y) + ds_szp->x*(ds_x1-centerx);
 
@@ -2138,7 +2183,9 @@ void R_DrawTiltedWaterSolidColorSpan_8(void)
 	do
 	{
 		UINT8 *colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
-		*dest++ = *(ds_transmap + (colormap[source] << 8) + *dsrc++);
+		*dest = *(ds_transmap + (colormap[source] << 8) + *dsrc);
+		dest += spanpitch;
+		dsrc += spanpitch;
 	} while (--width >= 0);
 }
 
@@ -2165,14 +2212,14 @@ void R_DrawFogColumn_8(void)
 	// Use ylookup LUT to avoid multiply with ScreenWidth.
 	// Use columnofs LUT for subwindows?
 	//dest = ylookup[dc_yl] + columnofs[dc_x];
-	dest = &topleft[dc_yl*vid.width + dc_x];
+	dest = &topleft[dc_yl*columnpitch + dc_x*spanpitch];
 
 	// Determine scaling, which is the only mapping to be done.
 	do
 	{
 		// Simple. Apply the colormap to what's already on the screen.
 		*dest = dc_colormap[*dest];
-		dest += vid.width;
+		dest += columnpitch;
 	} while (count--);
 }
 
@@ -2232,7 +2279,7 @@ void R_DrawColumnShadowed_8(void)
 
 		if (dc_yh > realyh)
 			dc_yh = realyh;
-		(colfuncs[BASEDRAWFUNC])();		// R_DrawColumn_8 for the appropriate architecture
+		R_RunColumnDrawer(colfuncs[BASEDRAWFUNC]);		// R_DrawColumn_8 for the appropriate architecture
 		if (solid)
 			dc_yl = bheight;
 		else
@@ -2242,5 +2289,5 @@ void R_DrawColumnShadowed_8(void)
 	}
 	dc_yh = realyh;
 	if (dc_yl <= realyh)
-		(colfuncs[BASEDRAWFUNC])();		// R_DrawWallColumn_8 for the appropriate architecture
+		R_RunColumnDrawer(colfuncs[BASEDRAWFUNC]);		// R_DrawWallColumn_8 for the appropriate architecture
 }
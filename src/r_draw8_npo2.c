@@ -15,9 +15,6 @@
 // SPANS
 // ==========================================================================
 
-#define SPANSIZE 16
-#define INVSPAN 0.0625f
-
 #if defined(__GNUC__) || defined(__clang__) // Suppress intentional libdivide compiler warnings - Also added to libdivide.h
     #pragma GCC diagnostic push
     #pragma GCC diagnostic ignored "-Waggregate-return"
@@ -37,7 +34,7 @@ void R_DrawSpan_NPO2_8 (void)
 	UINT8 *source;
 	UINT8 *colormap;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 
@@ -85,7 +82,8 @@ void R_DrawSpan_NPO2_8 (void)
 		x = (xposition >> FRACBITS);
 		y = (yposition >> FRACBITS);
 
-		*dest++ = colormap[source[((y * ds_flatwidth) + x)]];
+		*dest = colormap[source[((y * ds_flatwidth) + x)]];
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -110,6 +108,8 @@ void R_DrawTiltedSpan_NPO2_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	struct libdivide_u32_t x_divider = libdivide_u32_gen(ds_flatwidth);
 	struct libdivide_u32_t y_divider = libdivide_u32_gen(ds_flatheight);
@@ -153,7 +153,7 @@ void R_DrawTiltedSpan_NPO2_8(void)
 
 			*dest = colormap[source[((y * ds_flatwidth) + x)]];
 		}
-		dest++;
+		dest += spanpitch;
 		iz += ds_szp->x;
 		uz += ds_sup->x;
 		vz += ds_svp->x;
@@ -163,13 +163,16 @@ void R_DrawTiltedSpan_NPO2_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL_NPO2);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -178,12 +181,12 @@ void R_DrawTiltedSpan_NPO2_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 			// Lactozilla: Non-powers-of-two
@@ -203,13 +206,13 @@ void R_DrawTiltedSpan_NPO2_8(void)
 
 				*dest = colormap[source[((y * ds_flatwidth) + x)]];
 			}
-			dest++;
+			dest += spanpitch;
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -272,7 +275,7 @@ void R_DrawTiltedSpan_NPO2_8(void)
 
 					*dest = colormap[source[((y * ds_flatwidth) + x)]];
 				}
-				dest++;
+				dest += spanpitch;
 				u += stepu;
 				v += stepv;
 			}
@@ -300,6 +303,8 @@ void R_DrawTiltedTranslucentSpan_NPO2_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	struct libdivide_u32_t x_divider = libdivide_u32_gen(ds_flatwidth);
 	struct libdivide_u32_t y_divider = libdivide_u32_gen(ds_flatheight);
@@ -342,7 +347,7 @@ void R_DrawTiltedTranslucentSpan_NPO2_8(void)
 
 			*dest = *(ds_transmap + (colormap[source[((y * ds_flatwidth) + x)]] << 8) + *dest);
 		}
-		dest++;
+		dest += spanpitch;
 		iz += ds_szp->x;
 		uz += ds_sup->x;
 		vz += ds_svp->x;
@@ -352,13 +357,16 @@ void R_DrawTiltedTranslucentSpan_NPO2_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL_NPO2);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -367,12 +375,12 @@ void R_DrawTiltedTranslucentSpan_NPO2_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 			// Lactozilla: Non-powers-of-two
@@ -392,13 +400,13 @@ void R_DrawTiltedTranslucentSpan_NPO2_8(void)
 
 				*dest = *(ds_transmap + (colormap[source[((y * ds_flatwidth) + x)]] << 8) + *dest);
 			}
-			dest++;
+			dest += spanpitch;
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -461,7 +469,7 @@ void R_DrawTiltedTranslucentSpan_NPO2_8(void)
 
 					*dest = *(ds_transmap + (colormap[source[((y * ds_flatwidth) + x)]] << 8) + *dest);
 				}
-				dest++;
+				dest += spanpitch;
 				u += stepu;
 				v += stepv;
 			}
@@ -488,6 +496,8 @@ void R_DrawTiltedSplat_NPO2_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	struct libdivide_u32_t x_divider = libdivide_u32_gen(ds_flatwidth);
 	struct libdivide_u32_t y_divider = libdivide_u32_gen(ds_flatheight);
@@ -535,7 +545,7 @@ void R_DrawTiltedSplat_NPO2_8(void)
 		if (val != TRANSPARENTPIXEL)
 			*dest = colormap[val];
 
-		dest++;
+		dest += spanpitch;
 		iz += ds_szp->x;
 		uz += ds_sup->x;
 		vz += ds_svp->x;
@@ -545,13 +555,16 @@ void R_DrawTiltedSplat_NPO2_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL_NPO2);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -560,12 +573,12 @@ void R_DrawTiltedSplat_NPO2_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 			// Lactozilla: Non-powers-of-two
@@ -587,13 +600,13 @@ void R_DrawTiltedSplat_NPO2_8(void)
 			}
 			if (val != TRANSPARENTPIXEL)
 				*dest = colormap[val];
-			dest++;
+			dest += spanpitch;
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -660,7 +673,7 @@ void R_DrawTiltedSplat_NPO2_8(void)
 				}
 				if (val != TRANSPARENTPIXEL)
 					*dest = colormap[val];
-				dest++;
+				dest += spanpitch;
 				u += stepu;
 				v += stepv;
 			}
@@ -683,7 +696,7 @@ void R_DrawSplat_NPO2_8 (void)
 	UINT8 *source;
 	UINT8 *colormap;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 	UINT32 val;
@@ -731,7 +744,7 @@ void R_DrawSplat_NPO2_8 (void)
 		val = source[((y * ds_flatwidth) + x)];
 		if (val != TRANSPARENTPIXEL)
 			*dest = colormap[val];
-		dest++;
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -751,7 +764,7 @@ void R_DrawTranslucentSplat_NPO2_8 (void)
 	UINT8 *source;
 	UINT8 *colormap;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 	UINT32 val;
@@ -799,7 +812,7 @@ void R_DrawTranslucentSplat_NPO2_8 (void)
 		val = source[((y * ds_flatwidth) + x)];
 		if (val != TRANSPARENTPIXEL)
 			*dest = *(ds_transmap + (colormap[val] << 8) + *dest);
-		dest++;
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -820,7 +833,7 @@ void R_DrawFloorSprite_NPO2_8 (void)
 	UINT8 *translation;
 	UINT8 *colormap;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 	UINT32 val;
@@ -869,7 +882,7 @@ void R_DrawFloorSprite_NPO2_8 (void)
 		val = source[((y * ds_flatwidth) + x)];
 		if (val & 0xFF00)
 			*dest = colormap[translation[val & 0xFF]];
-		dest++;
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -890,7 +903,7 @@ void R_DrawTranslucentFloorSprite_NPO2_8 (void)
 	UINT8 *translation;
 	UINT8 *colormap;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 	UINT32 val;
@@ -939,7 +952,7 @@ void R_DrawTranslucentFloorSprite_NPO2_8 (void)
 		val = source[((y * ds_flatwidth) + x)];
 		if (val & 0xFF00)
 			*dest = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + *dest);
-		dest++;
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -966,6 +979,8 @@ void R_DrawTiltedFloorSprite_NPO2_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	struct libdivide_u32_t x_divider = libdivide_u32_gen(ds_flatwidth);
 	struct libdivide_u32_t y_divider = libdivide_u32_gen(ds_flatheight);
@@ -983,13 +998,16 @@ void R_DrawTiltedFloorSprite_NPO2_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL_NPO2);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -998,12 +1016,12 @@ void R_DrawTiltedFloorSprite_NPO2_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			// Lactozilla: Non-powers-of-two
 			fixed_t x = (((fixed_t)u) >> FRACBITS);
@@ -1022,14 +1040,14 @@ void R_DrawTiltedFloorSprite_NPO2_8(void)
 			val = source[((y * ds_flatwidth) + x)];
 			if (val & 0xFF00)
 				*dest = colormap[translation[val & 0xFF]];
-			dest++;
+			dest += spanpitch;
 
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -1092,7 +1110,7 @@ void R_DrawTiltedFloorSprite_NPO2_8(void)
 				val = source[((y * ds_flatwidth) + x)];
 				if (val & 0xFF00)
 					*dest = colormap[translation[val & 0xFF]];
-				dest++;
+				dest += spanpitch;
 
 				u += stepu;
 				v += stepv;
@@ -1122,6 +1140,8 @@ void R_DrawTiltedTranslucentFloorSprite_NPO2_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	struct libdivide_u32_t x_divider = libdivide_u32_gen(ds_flatwidth);
 	struct libdivide_u32_t y_divider = libdivide_u32_gen(ds_flatheight);
@@ -1139,13 +1159,16 @@ void R_DrawTiltedTranslucentFloorSprite_NPO2_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL_NPO2);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -1154,12 +1177,12 @@ void R_DrawTiltedTranslucentFloorSprite_NPO2_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			// Lactozilla: Non-powers-of-two
 			fixed_t x = (((fixed_t)u) >> FRACBITS);
@@ -1178,14 +1201,14 @@ void R_DrawTiltedTranslucentFloorSprite_NPO2_8(void)
 			val = source[((y * ds_flatwidth) + x)];
 			if (val & 0xFF00)
 				*dest = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + *dest);
-			dest++;
+			dest += spanpitch;
 
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -1248,7 +1271,7 @@ void R_DrawTiltedTranslucentFloorSprite_NPO2_8(void)
 				val = source[((y * ds_flatwidth) + x)];
 				if (val & 0xFF00)
 					*dest = *(ds_transmap + (colormap[translation[val & 0xFF]] << 8) + *dest);
-				dest++;
+				dest += spanpitch;
 
 				u += stepu;
 				v += stepv;
@@ -1271,7 +1294,7 @@ void R_DrawTranslucentSpan_NPO2_8 (void)
 	UINT8 *source;
 	UINT8 *colormap;
 	UINT8 *dest;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 	UINT32 val;
@@ -1318,7 +1341,7 @@ void R_DrawTranslucentSpan_NPO2_8 (void)
 		y = (yposition >> FRACBITS);
 		val = ((y * ds_flatwidth) + x);
 		*dest = *(ds_transmap + (colormap[source[val]] << 8) + *dest);
-		dest++;
+		dest += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -1336,7 +1359,7 @@ void R_DrawWaterSpan_NPO2_8(void)
 	UINT8 *colormap;
 	UINT8 *dest;
 	UINT8 *dsrc;
-	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
 
 	size_t count = (ds_x2 - ds_x1 + 1);
 
@@ -1346,7 +1369,7 @@ void R_DrawWaterSpan_NPO2_8(void)
 	source = ds_source;
 	colormap = ds_colormap;
 	dest = ylookup[ds_y] + columnofs[ds_x1];
-	dsrc = screens[1] + (ds_y+ds_bgofs)*vid.width + ds_x1;
+	dsrc = screens[1] + (ds_y+ds_bgofs)*columnpitch + ds_x1*spanpitch;
 
 	fixedwidth = ds_flatwidth << FRACBITS;
 	fixedheight = ds_flatheight << FRACBITS;
@@ -1381,7 +1404,9 @@ void R_DrawWaterSpan_NPO2_8(void)
 
 		x = (xposition >> FRACBITS);
 		y = (yposition >> FRACBITS);
-		*dest++ = colormap[*(ds_transmap + (source[((y * ds_flatwidth) + x)] << 8) + *dsrc++)];
+		*dest = colormap[*(ds_transmap + (source[((y * ds_flatwidth) + x)] << 8) + *dsrc)];
+		dest += spanpitch;
+		dsrc += spanpitch;
 		xposition += xstep;
 		yposition += ystep;
 	}
@@ -1407,6 +1432,8 @@ void R_DrawTiltedWaterSpan_NPO2_8(void)
 	double izstep, uzstep, vzstep;
 	double endz, endu, endv;
 	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
 
 	struct libdivide_u32_t x_divider = libdivide_u32_gen(ds_flatwidth);
 	struct libdivide_u32_t y_divider = libdivide_u32_gen(ds_flatheight);
@@ -1419,7 +1446,7 @@ void R_DrawTiltedWaterSpan_NPO2_8(void)
 	vz = ds_svp->z + ds_svp->y*(centery-ds_y) + ds_svp->x*(ds_x1-centerx);
 
 	dest = ylookup[ds_y] + columnofs[ds_x1];
-	dsrc = screens[1] + (ds_y+ds_bgofs)*vid.width + ds_x1;
+	dsrc = screens[1] + (ds_y+ds_bgofs)*columnpitch + ds_x1*spanpitch;
 	source = ds_source;
 	//colormap = ds_colormap;
 
@@ -1448,9 +1475,10 @@ void R_DrawTiltedWaterSpan_NPO2_8(void)
 			else
 				y -= libdivide_u32_do((UINT32)y, &y_divider) * ds_flatheight;
 
-			*dest = *(ds_transmap + (colormap[source[((y * ds_flatwidth) + x)]] << 8) + *dsrc++);
+			*dest = *(ds_transmap + (colormap[source[((y * ds_flatwidth) + x)]] << 8) + *dsrc);
 		}
-		dest++;
+		dest += spanpitch;
+		dsrc += spanpitch;
 		iz += ds_szp->x;
 		uz += ds_sup->x;
 		vz += ds_svp->x;
@@ -1460,13 +1488,16 @@ void R_DrawTiltedWaterSpan_NPO2_8(void)
 	startu = uz*startz;
 	startv = vz*startz;
 
-	izstep = ds_szp->x * SPANSIZE;
-	uzstep = ds_sup->x * SPANSIZE;
-	vzstep = ds_svp->x * SPANSIZE;
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL_NPO2);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
 	//x1 = 0;
 	width++;
 
-	while (width >= SPANSIZE)
+	while (width >= spansize)
 	{
 		iz += izstep;
 		uz += uzstep;
@@ -1475,12 +1506,12 @@ void R_DrawTiltedWaterSpan_NPO2_8(void)
 		endz = 1.f/iz;
 		endu = uz*endz;
 		endv = vz*endz;
-		stepu = (INT64)((endu - startu) * INVSPAN);
-		stepv = (INT64)((endv - startv) * INVSPAN);
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
 		u = (INT64)(startu);
 		v = (INT64)(startv);
 
-		for (i = SPANSIZE-1; i >= 0; i--)
+		for (i = spansize-1; i >= 0; i--)
 		{
 			colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
 			// Lactozilla: Non-powers-of-two
@@ -1498,15 +1529,16 @@ void R_DrawTiltedWaterSpan_NPO2_8(void)
 				else
 					y -= libdivide_u32_do((UINT32)y, &y_divider) * ds_flatheight;
 
-				*dest = *(ds_transmap + (colormap[source[((y * ds_flatwidth) + x)]] << 8) + *dsrc++);
+				*dest = *(ds_transmap + (colormap[source[((y * ds_flatwidth) + x)]] << 8) + *dsrc);
 			}
-			dest++;
+			dest += spanpitch;
+			dsrc += spanpitch;
 			u += stepu;
 			v += stepv;
 		}
 		startu = endu;
 		startv = endv;
-		width -= SPANSIZE;
+		width -= spansize;
 	}
 	if (width > 0)
 	{
@@ -1530,7 +1562,7 @@ void R_DrawTiltedWaterSpan_NPO2_8(void)
 				else
 					y -= libdivide_u32_do((UINT32)y, &y_divider) * ds_flatheight;
 
-				*dest = *(ds_transmap + (colormap[source[((y * ds_flatwidth) + x)]] << 8) + *dsrc++);
+				*dest = *(ds_transmap + (colormap[source[((y * ds_flatwidth) + x)]] << 8) + *dsrc);
 			}
 		}
 		else
@@ -1567,9 +1599,10 @@ void R_DrawTiltedWaterSpan_NPO2_8(void)
 					else
 						y -= libdivide_u32_do((UINT32)y, &y_divider) * ds_flatheight;
 
-					*dest = *(ds_transmap + (colormap[source[((y * ds_flatwidth) + x)]] << 8) + *dsrc++);
+					*dest = *(ds_transmap + (colormap[source[((y * ds_flatwidth) + x)]] << 8) + *dsrc);
 				}
-				dest++;
+				dest += spanpitch;
+				dsrc += spanpitch;
 				u += stepu;
 				v += stepv;
 			}
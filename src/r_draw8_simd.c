@@ -0,0 +1,303 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 1998-2000 by DooM Legacy Team.
+// Copyright (C) 1999-2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_draw8_simd.c
+/// \brief SSE2, AVX2 and NEON versions of the most used 8bpp drawers
+///        Included by r_draw.c. The vector units only work out where in the
+///        texture each pixel comes from; the colormap and translucency
+///        lookups are still byte loads, so the output is exactly the same
+///        as the plain C drawers'. SCR_SetDrawFuncs picks between them.
+
+// Each instruction set provides:
+//
+// simdspan_t, R_SpanStart and R_SpanNext8, which step through a span
+// eight pixels at a time and give the flat offset of each of them:
+// ((y >> nflatyshift) & nflatmask) | (x >> nflatxshift)
+//
+// simdcolumn_t, R_ColumnStart and R_ColumnNext8, which do the same for
+// a column, giving the texel row of each pixel: frac >> FRACBITS
+//
+// r_draw8_simd_funcs.c then builds the drawers on top of those.
+
+// ==========================================================================
+//                   SSE2 AND AVX2
+// ==========================================================================
+
+#ifdef SIMDDRAWERS_X86
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#if defined (__GNUC__) || defined (__clang__)
+#define SIMDATTR_SSE2 __attribute__((target("sse2")))
+#define SIMDATTR_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMDATTR_SSE2
+#define SIMDATTR_AVX2
+#endif
+
+typedef struct
+{
+	__m128i x[2], y[2];
+	__m128i xstep, ystep; // eight pixels' worth
+	__m128i mask, xshift, yshift;
+} simdspan_sse2_t;
+
+typedef struct
+{
+	__m128i frac[2];
+	__m128i fracstep;
+} simdcolumn_sse2_t;
+
+static inline SIMDATTR_SSE2 void R_SpanStart_SSE2(simdspan_sse2_t *span, UINT32 x, UINT32 y, UINT32 xstep, UINT32 ystep)
+{
+	span->x[0] = _mm_setr_epi32((int)x, (int)(x + xstep), (int)(x + 2*xstep), (int)(x + 3*xstep));
+	span->y[0] = _mm_setr_epi32((int)y, (int)(y + ystep), (int)(y + 2*ystep), (int)(y + 3*ystep));
+	span->x[1] = _mm_add_epi32(span->x[0], _mm_set1_epi32((int)(4*xstep)));
+	span->y[1] = _mm_add_epi32(span->y[0], _mm_set1_epi32((int)(4*ystep)));
+	span->xstep = _mm_set1_epi32((int)(8*xstep));
+	span->ystep = _mm_set1_epi32((int)(8*ystep));
+	span->mask = _mm_set1_epi32((int)nflatmask);
+	span->xshift = _mm_cvtsi32_si128((int)nflatxshift);
+	span->yshift = _mm_cvtsi32_si128((int)nflatyshift);
+}
+
+static inline SIMDATTR_SSE2 void R_SpanNext8_SSE2(simdspan_sse2_t *span, UINT32 *offsets)
+{
+	INT32 i;
+
+	for (i = 0; i < 2; i++)
+	{
+		__m128i offset = _mm_or_si128(
+			_mm_and_si128(_mm_srl_epi32(span->y[i], span->yshift), span->mask),
+			_mm_srl_epi32(span->x[i], span->xshift));
+
+		_mm_storeu_si128((__m128i *)(offsets + 4*i), offset);
+
+		span->x[i] = _mm_add_epi32(span->x[i], span->xstep);
+		span->y[i] = _mm_add_epi32(span->y[i], span->ystep);
+	}
+}
+
+static inline SIMDATTR_SSE2 void R_ColumnStart_SSE2(simdcolumn_sse2_t *column, UINT32 frac, UINT32 fracstep)
+{
+	column->frac[0] = _mm_setr_epi32((int)frac, (int)(frac + fracstep), (int)(frac + 2*fracstep), (int)(frac + 3*fracstep));
+	column->frac[1] = _mm_add_epi32(column->frac[0], _mm_set1_epi32((int)(4*fracstep)));
+	column->fracstep = _mm_set1_epi32((int)(8*fracstep));
+}
+
+static inline SIMDATTR_SSE2 void R_ColumnNext8_SSE2(simdcolumn_sse2_t *column, INT32 *texels)
+{
+	_mm_storeu_si128((__m128i *)texels, _mm_srai_epi32(column->frac[0], FRACBITS));
+	_mm_storeu_si128((__m128i *)(texels + 4), _mm_srai_epi32(column->frac[1], FRACBITS));
+
+	column->frac[0] = _mm_add_epi32(column->frac[0], column->fracstep);
+	column->frac[1] = _mm_add_epi32(column->frac[1], column->fracstep);
+}
+
+typedef struct
+{
+	__m256i x, y;
+	__m256i xstep, ystep; // eight pixels' worth
+	__m256i mask;
+	__m128i xshift, yshift;
+} simdspan_avx2_t;
+
+typedef struct
+{
+	__m256i frac;
+	__m256i fracstep;
+} simdcolumn_avx2_t;
+
+static inline SIMDATTR_AVX2 void R_SpanStart_AVX2(simdspan_avx2_t *span, UINT32 x, UINT32 y, UINT32 xstep, UINT32 ystep)
+{
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	span->x = _mm256_add_epi32(_mm256_set1_epi32((int)x), _mm256_mullo_epi32(lane, _mm256_set1_epi32((int)xstep)));
+	span->y = _mm256_add_epi32(_mm256_set1_epi32((int)y), _mm256_mullo_epi32(lane, _mm256_set1_epi32((int)ystep)));
+	span->xstep = _mm256_set1_epi32((int)(8*xstep));
+	span->ystep = _mm256_set1_epi32((int)(8*ystep));
+	span->mask = _mm256_set1_epi32((int)nflatmask);
+	span->xshift = _mm_cvtsi32_si128((int)nflatxshift);
+	span->yshift = _mm_cvtsi32_si128((int)nflatyshift);
+}
+
+static inline SIMDATTR_AVX2 void R_SpanNext8_AVX2(simdspan_avx2_t *span, UINT32 *offsets)
+{
+	__m256i offset = _mm256_or_si256(
+		_mm256_and_si256(_mm256_srl_epi32(span->y, span->yshift), span->mask),
+		_mm256_srl_epi32(span->x, span->xshift));
+
+	_mm256_storeu_si256((__m256i *)offsets, offset);
+
+	span->x = _mm256_add_epi32(span->x, span->xstep);
+	span->y = _mm256_add_epi32(span->y, span->ystep);
+}
+
+static inline SIMDATTR_AVX2 void R_ColumnStart_AVX2(simdcolumn_avx2_t *column, UINT32 frac, UINT32 fracstep)
+{
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	column->frac = _mm256_add_epi32(_mm256_set1_epi32((int)frac), _mm256_mullo_epi32(lane, _mm256_set1_epi32((int)fracstep)));
+	column->fracstep = _mm256_set1_epi32((int)(8*fracstep));
+}
+
+static inline SIMDATTR_AVX2 void R_ColumnNext8_AVX2(simdcolumn_avx2_t *column, INT32 *texels)
+{
+	_mm256_storeu_si256((__m256i *)texels, _mm256_srai_epi32(column->frac, FRACBITS));
+	column->frac = _mm256_add_epi32(column->frac, column->fracstep);
+}
+
+// Transposes a 16 by 16 block of pixels, for R_TransposeViewBuffer
+static SIMDATTR_SSE2 void R_Transpose16_SSE2(const UINT8 *src, INT32 srcpitch, UINT8 *dest, INT32 destpitch)
+{
+	__m128i a[16], b[16];
+	INT32 i, j;
+
+	for (i = 0; i < 16; i++)
+		a[i] = _mm_loadu_si128((const __m128i *)(src + i*srcpitch));
+
+	// Interleave bytes, then pairs, then quads, then halves
+	for (i = 0; i < 8; i++)
+	{
+		b[2*i] = _mm_unpacklo_epi8(a[2*i], a[2*i+1]);
+		b[2*i+1] = _mm_unpackhi_epi8(a[2*i], a[2*i+1]);
+	}
+	for (i = 0; i < 4; i++)
+	{
+		a[4*i] = _mm_unpacklo_epi16(b[4*i], b[4*i+2]);
+		a[4*i+1] = _mm_unpackhi_epi16(b[4*i], b[4*i+2]);
+		a[4*i+2] = _mm_unpacklo_epi16(b[4*i+1], b[4*i+3]);
+		a[4*i+3] = _mm_unpackhi_epi16(b[4*i+1], b[4*i+3]);
+	}
+	for (i = 0; i < 2; i++)
+	{
+		for (j = 0; j < 4; j++)
+		{
+			b[8*i+2*j] = _mm_unpacklo_epi32(a[8*i+j], a[8*i+j+4]);
+			b[8*i+2*j+1] = _mm_unpackhi_epi32(a[8*i+j], a[8*i+j+4]);
+		}
+	}
+	for (i = 0; i < 8; i++)
+	{
+		a[2*i] = _mm_unpacklo_epi64(b[i], b[i+8]);
+		a[2*i+1] = _mm_unpackhi_epi64(b[i], b[i+8]);
+	}
+
+	for (i = 0; i < 16; i++)
+		_mm_storeu_si128((__m128i *)(dest + i*destpitch), a[i]);
+}
+
+#define SIMDFUNC(name) name##_SSE2
+#define SIMDATTR SIMDATTR_SSE2
+#define simdspan_t simdspan_sse2_t
+#define simdcolumn_t simdcolumn_sse2_t
+#include "r_draw8_simd_funcs.c"
+#undef SIMDFUNC
+#undef SIMDATTR
+#undef simdspan_t
+#undef simdcolumn_t
+
+#define SIMDFUNC(name) name##_AVX2
+#define SIMDATTR SIMDATTR_AVX2
+#define simdspan_t simdspan_avx2_t
+#define simdcolumn_t simdcolumn_avx2_t
+#include "r_draw8_simd_funcs.c"
+#undef SIMDFUNC
+#undef SIMDATTR
+#undef simdspan_t
+#undef simdcolumn_t
+
+#endif // SIMDDRAWERS_X86
+
+// ==========================================================================
+//                   NEON
+// ==========================================================================
+
+#ifdef SIMDDRAWERS_NEON
+
+#include <arm_neon.h>
+
+typedef struct
+{
+	uint32x4_t x[2], y[2];
+	uint32x4_t xstep, ystep; // eight pixels' worth
+	uint32x4_t mask;
+	int32x4_t xshift, yshift; // negative, NEON only shifts left
+} simdspan_neon_t;
+
+typedef struct
+{
+	int32x4_t frac[2];
+	int32x4_t fracstep;
+} simdcolumn_neon_t;
+
+static inline void R_SpanStart_NEON(simdspan_neon_t *span, UINT32 x, UINT32 y, UINT32 xstep, UINT32 ystep)
+{
+	const UINT32 lane[4] = {0, 1, 2, 3};
+	const uint32x4_t lanes = vld1q_u32(lane);
+
+	span->x[0] = vmlaq_u32(vdupq_n_u32(x), lanes, vdupq_n_u32(xstep));
+	span->y[0] = vmlaq_u32(vdupq_n_u32(y), lanes, vdupq_n_u32(ystep));
+	span->x[1] = vaddq_u32(span->x[0], vdupq_n_u32(4*xstep));
+	span->y[1] = vaddq_u32(span->y[0], vdupq_n_u32(4*ystep));
+	span->xstep = vdupq_n_u32(8*xstep);
+	span->ystep = vdupq_n_u32(8*ystep);
+	span->mask = vdupq_n_u32(nflatmask);
+	span->xshift = vdupq_n_s32(-(INT32)nflatxshift);
+	span->yshift = vdupq_n_s32(-(INT32)nflatyshift);
+}
+
+static inline void R_SpanNext8_NEON(simdspan_neon_t *span, UINT32 *offsets)
+{
+	INT32 i;
+
+	for (i = 0; i < 2; i++)
+	{
+		uint32x4_t offset = vorrq_u32(
+			vandq_u32(vshlq_u32(span->y[i], span->yshift), span->mask),
+			vshlq_u32(span->x[i], span->xshift));
+
+		vst1q_u32(offsets + 4*i, offset);
+
+		span->x[i] = vaddq_u32(span->x[i], span->xstep);
+		span->y[i] = vaddq_u32(span->y[i], span->ystep);
+	}
+}
+
+static inline void R_ColumnStart_NEON(simdcolumn_neon_t *column, UINT32 frac, UINT32 fracstep)
+{
+	const UINT32 lane[4] = {0, 1, 2, 3};
+	uint32x4_t fracs = vmlaq_u32(vdupq_n_u32(frac), vld1q_u32(lane), vdupq_n_u32(fracstep));
+
+	column->frac[0] = vreinterpretq_s32_u32(fracs);
+	column->frac[1] = vreinterpretq_s32_u32(vaddq_u32(fracs, vdupq_n_u32(4*fracstep)));
+	column->fracstep = vreinterpretq_s32_u32(vdupq_n_u32(8*fracstep));
+}
+
+static inline void R_ColumnNext8_NEON(simdcolumn_neon_t *column, INT32 *texels)
+{
+	vst1q_s32(texels, vshrq_n_s32(column->frac[0], FRACBITS));
+	vst1q_s32(texels + 4, vshrq_n_s32(column->frac[1], FRACBITS));
+
+	column->frac[0] = vaddq_s32(column->frac[0], column->fracstep);
+	column->frac[1] = vaddq_s32(column->frac[1], column->fracstep);
+}
+
+#define SIMDFUNC(name) name##_NEON
+#define SIMDATTR
+#define simdspan_t simdspan_neon_t
+#define simdcolumn_t simdcolumn_neon_t
+#include "r_draw8_simd_funcs.c"
+#undef SIMDFUNC
+#undef SIMDATTR
+#undef simdspan_t
+#undef simdcolumn_t
+
+#endif // SIMDDRAWERS_NEON
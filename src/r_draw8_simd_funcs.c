@@ -0,0 +1,383 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 1998-2000 by DooM Legacy Team.
+// Copyright (C) 1999-2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_draw8_simd_funcs.c
+/// \brief The SIMD drawers, built once per instruction set
+///        Included by r_draw8_simd.c, with SIMDFUNC, SIMDATTR, simdspan_t
+///        and simdcolumn_t defined. Every drawer here has to come out
+///        exactly the same as its plain C version in r_draw8.c, quirks and
+///        all; the drawerbench command checks that they do.
+
+/**	\brief The R_DrawSpan_8 function, eight pixels at a time
+*/
+SIMDATTR void SIMDFUNC(R_DrawSpan_8)(void)
+{
+	UINT32 xposition, yposition;
+	UINT32 xstep, ystep;
+	UINT32 offsets[8];
+	simdspan_t span;
+
+	UINT8 *source;
+	UINT8 *colormap;
+	UINT8 *dest;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
+
+	size_t count = (ds_x2 - ds_x1 + 1);
+
+	xposition = (UINT32)ds_xfrac << nflatshiftup; yposition = (UINT32)ds_yfrac << nflatshiftup;
+	xstep = (UINT32)ds_xstep << nflatshiftup; ystep = (UINT32)ds_ystep << nflatshiftup;
+
+	source = ds_source;
+	colormap = ds_colormap;
+	dest = ylookup[ds_y] + columnofs[ds_x1];
+
+	if (dest+8 > deststop)
+		return;
+
+	SIMDFUNC(R_SpanStart)(&span, xposition, yposition, xstep, ystep);
+
+	while (count >= 8)
+	{
+		SIMDFUNC(R_SpanNext8)(&span, offsets);
+
+		dest[0] = colormap[source[offsets[0]]];
+		dest[spanpitch] = colormap[source[offsets[1]]];
+		dest[2*spanpitch] = colormap[source[offsets[2]]];
+		dest[3*spanpitch] = colormap[source[offsets[3]]];
+		dest[4*spanpitch] = colormap[source[offsets[4]]];
+		dest[5*spanpitch] = colormap[source[offsets[5]]];
+		dest[6*spanpitch] = colormap[source[offsets[6]]];
+		dest[7*spanpitch] = colormap[source[offsets[7]]];
+
+		xposition += xstep << 3;
+		yposition += ystep << 3;
+		dest += 8*spanpitch;
+		count -= 8;
+	}
+	while (count-- && dest <= deststop)
+	{
+		*dest = colormap[source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)]];
+		dest += spanpitch;
+		xposition += xstep;
+		yposition += ystep;
+	}
+}
+
+/**	\brief The R_DrawTranslucentSpan_8 function, eight pixels at a time
+*/
+SIMDATTR void SIMDFUNC(R_DrawTranslucentSpan_8)(void)
+{
+	UINT32 xposition, yposition;
+	UINT32 xstep, ystep;
+	UINT32 offsets[8];
+	simdspan_t span;
+
+	UINT8 *source;
+	UINT8 *colormap;
+	UINT8 *transmap;
+	UINT8 *dest;
+	const UINT8 *deststop = viewscreen + vid.rowbytes * vid.height;
+
+	size_t count = (ds_x2 - ds_x1 + 1);
+
+	xposition = (UINT32)ds_xfrac << nflatshiftup; yposition = (UINT32)ds_yfrac << nflatshiftup;
+	xstep = (UINT32)ds_xstep << nflatshiftup; ystep = (UINT32)ds_ystep << nflatshiftup;
+
+	source = ds_source;
+	colormap = ds_colormap;
+	transmap = ds_transmap;
+	dest = ylookup[ds_y] + columnofs[ds_x1];
+
+	SIMDFUNC(R_SpanStart)(&span, xposition, yposition, xstep, ystep);
+
+	while (count >= 8)
+	{
+		INT32 i;
+
+		SIMDFUNC(R_SpanNext8)(&span, offsets);
+
+		for (i = 0; i < 8; i++)
+			dest[i*spanpitch] = *(transmap + (colormap[source[offsets[i]]] << 8) + dest[i*spanpitch]);
+
+		xposition += xstep << 3;
+		yposition += ystep << 3;
+		dest += 8*spanpitch;
+		count -= 8;
+	}
+	while (count-- && dest <= deststop)
+	{
+		*dest = *(transmap + (colormap[source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)]] << 8) + *dest);
+		dest += spanpitch;
+		xposition += xstep;
+		yposition += ystep;
+	}
+}
+
+/**	\brief The R_DrawTiltedSpan_8 function, eight pixels at a time
+	Only the affine stretches between the perspective divisions are
+	vectorized, and only when R_TiltedSpanSize makes them eight pixels
+	or longer.
+*/
+SIMDATTR void SIMDFUNC(R_DrawTiltedSpan_8)(void)
+{
+	// x1, x2 = ds_x1, ds_x2
+	int width = ds_x2 - ds_x1;
+	double iz, uz, vz;
+	UINT32 u, v;
+	int i, j;
+
+	UINT32 offsets[8];
+	simdspan_t span;
+
+	UINT8 *source;
+	UINT8 *colormap;
+	UINT8 *dest;
+
+	double startz, startu, startv;
+	double izstep, uzstep, vzstep;
+	double endz, endu, endv;
+	UINT32 stepu, stepv;
+	INT32 spansize;
+	float invspan;
+
+	iz = ds_szp->z + ds_szp->y*(centery-ds_y) + ds_szp->x*(ds_x1-centerx);
+
+	CALC_SLOPE_LIGHT
+
+	uz = ds_sup->z + ds_sup->y*(centery-ds_y) + ds_sup->x*(ds_x1-centerx);
+	vz = ds_svp->z + ds_svp->y*(centery-ds_y) + ds_svp->x*(ds_x1-centerx);
+
+	dest = ylookup[ds_y] + columnofs[ds_x1];
+	source = ds_source;
+
+	startz = 1.f/iz;
+	startu = uz*startz;
+	startv = vz*startz;
+
+	spansize = R_TiltedSpanSize(iz, uz, vz, width, TILTEDTEXEL);
+	invspan = 1.f/spansize;
+
+	izstep = ds_szp->x * spansize;
+	uzstep = ds_sup->x * spansize;
+	vzstep = ds_svp->x * spansize;
+	width++;
+
+	while (width >= spansize)
+	{
+		iz += izstep;
+		uz += uzstep;
+		vz += vzstep;
+
+		endz = 1.f/iz;
+		endu = uz*endz;
+		endv = vz*endz;
+		stepu = (INT64)((endu - startu) * invspan);
+		stepv = (INT64)((endv - startv) * invspan);
+		u = (INT64)(startu);
+		v = (INT64)(startv);
+
+		if (spansize >= 8)
+		{
+			SIMDFUNC(R_SpanStart)(&span, u, v, stepu, stepv);
+
+			for (i = 0; i < spansize; i += 8)
+			{
+				SIMDFUNC(R_SpanNext8)(&span, offsets);
+
+				for (j = 0; j < 8; j++)
+				{
+					colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
+					dest[j] = colormap[source[offsets[j]]];
+				}
+				dest += 8*spanpitch;
+			}
+		}
+		else
+		{
+			for (i = spansize-1; i >= 0; i--)
+			{
+				colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
+				*dest = colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]];
+				dest += spanpitch;
+				u += stepu;
+				v += stepv;
+			}
+		}
+		startu = endu;
+		startv = endv;
+		width -= spansize;
+	}
+	if (width > 0)
+	{
+		if (width == 1)
+		{
+			u = (INT64)(startu);
+			v = (INT64)(startv);
+			colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
+			*dest = colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]];
+		}
+		else
+		{
+			double left = width;
+			iz += ds_szp->x * left;
+			uz += ds_sup->x * left;
+			vz += ds_svp->x * left;
+
+			endz = 1.f/iz;
+			endu = uz*endz;
+			endv = vz*endz;
+			left = 1.f/left;
+			stepu = (INT64)((endu - startu) * left);
+			stepv = (INT64)((endv - startv) * left);
+			u = (INT64)(startu);
+			v = (INT64)(startv);
+
+			for (; width != 0; width--)
+			{
+				colormap = planezlight[tiltlighting[ds_x1++]] + (ds_colormap - colormaps);
+				*dest = colormap[source[((v >> nflatyshift) & nflatmask) | (u >> nflatxshift)]];
+				dest += spanpitch;
+				u += stepu;
+				v += stepv;
+			}
+		}
+	}
+}
+
+/**	\brief The R_DrawTranslucentColumn_8 function, eight pixels at a time
+	Only power of two texture heights are vectorized. The others wrap the
+	texture position around one step at a time, which doesn't vectorize.
+*/
+SIMDATTR void SIMDFUNC(R_DrawTranslucentColumn_8)(void)
+{
+	INT32 count;
+	UINT8 *dest;
+	fixed_t frac, fracstep;
+
+	count = dc_yh - dc_yl + 1;
+
+	if (count <= 0) // Zero length, column does not exceed a pixel.
+		return;
+
+#ifdef RANGECHECK
+	if ((unsigned)dc_x >= (unsigned)vid.width || dc_yl < 0 || dc_yh >= vid.height)
+		I_Error("R_DrawTranslucentColumn_8: %d to %d at %d", dc_yl, dc_yh, dc_x);
+#endif
+
+	dest = &topleft[dc_yl*columnpitch + dc_x*spanpitch];
+
+	fracstep = dc_iscale;
+	frac = (dc_texturemid + FixedMul((dc_yl << FRACBITS) - centeryfrac, fracstep))*(!dc_hires);
+
+	{
+		const UINT8 *source = dc_source;
+		const UINT8 *transmap = dc_transmap;
+		const lighttable_t *colormap = dc_colormap;
+		INT32 heightmask = dc_texheight - 1;
+		if (dc_texheight & heightmask)
+		{
+			heightmask++;
+			heightmask <<= FRACBITS;
+
+			if (frac < 0)
+				while ((frac += heightmask) < 0)
+					;
+			else
+				while (frac >= heightmask)
+					frac -= heightmask;
+
+			do
+			{
+				*dest = *(transmap + (colormap[source[frac>>FRACBITS]]<<8) + (*dest));
+				dest += columnpitch;
+				if ((frac += fracstep) >= heightmask)
+					frac -= heightmask;
+			}
+			while (--count);
+		}
+		else
+		{
+			INT32 texels[8];
+			simdcolumn_t column;
+			INT32 i;
+
+			SIMDFUNC(R_ColumnStart)(&column, frac, fracstep);
+
+			while (count >= 8)
+			{
+				SIMDFUNC(R_ColumnNext8)(&column, texels);
+
+				for (i = 0; i < 8; i++)
+				{
+					*dest = *(transmap + (colormap[source[texels[i]&heightmask]]<<8) + (*dest));
+					dest += columnpitch;
+				}
+
+				frac = (fixed_t)((UINT32)frac + ((UINT32)fracstep << 3));
+				count -= 8;
+			}
+			while (count--)
+			{
+				*dest = *(transmap + (colormap[source[(frac>>FRACBITS)&heightmask]]<<8) + (*dest));
+				dest += columnpitch;
+				frac = (fixed_t)((UINT32)frac + (UINT32)fracstep);
+			}
+		}
+	}
+}
+
+/**	\brief The R_DrawTranslatedColumn_8 function, eight pixels at a time
+*/
+SIMDATTR void SIMDFUNC(R_DrawTranslatedColumn_8)(void)
+{
+	INT32 count;
+	UINT8 *dest;
+	fixed_t frac, fracstep;
+	INT32 texels[8];
+	simdcolumn_t column;
+	INT32 i;
+
+	count = dc_yh - dc_yl;
+	if (count < 0)
+		return;
+
+#ifdef RANGECHECK
+	if ((unsigned)dc_x >= (unsigned)vid.width || dc_yl < 0 || dc_yh >= vid.height)
+		I_Error("R_DrawTranslatedColumn_8: %d to %d at %d", dc_yl, dc_yh, dc_x);
+#endif
+
+	dest = &topleft[dc_yl*columnpitch + dc_x*spanpitch];
+
+	fracstep = dc_iscale;
+	frac = (dc_texturemid + FixedMul((dc_yl << FRACBITS) - centeryfrac, fracstep))*(!dc_hires);
+
+	count++; // pixels left, rather than pixels after this one
+
+	SIMDFUNC(R_ColumnStart)(&column, frac, fracstep);
+
+	while (count >= 8)
+	{
+		SIMDFUNC(R_ColumnNext8)(&column, texels);
+
+		for (i = 0; i < 8; i++)
+		{
+			*dest = dc_colormap[dc_translation[dc_source[texels[i]]]];
+			dest += columnpitch;
+		}
+
+		frac = (fixed_t)((UINT32)frac + ((UINT32)fracstep << 3));
+		count -= 8;
+	}
+	while (count--)
+	{
+		*dest = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
+		dest += columnpitch;
+		frac = (fixed_t)((UINT32)frac + (UINT32)fracstep);
+	}
+}
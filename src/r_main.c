@@ -33,6 +33,7 @@
 #include "z_zone.h"
 #include "m_random.h" // quake camera shake
 #include "r_portal.h"
+#include "r_pvs.h"
 #include "r_main.h"
 #include "i_system.h" // I_GetPreciseTime
 #include "r_fps.h" // Frame interpolation/uncapped
@@ -107,12 +108,24 @@ ps_metric_t ps_sw_spritecliptime = {0};
 ps_metric_t ps_sw_portaltime = {0};
 ps_metric_t ps_sw_planetime = {0};
 ps_metric_t ps_sw_maskedtime = {0};
+ps_metric_t ps_sw_transposetime = {0};
 
 ps_metric_t ps_numbspcalls = {0};
+ps_metric_t ps_numpvsculled = {0};
 ps_metric_t ps_numsprites = {0};
 ps_metric_t ps_numdrawnodes = {0};
 ps_metric_t ps_numpolyobjects = {0};
 
+ps_metric_t ps_numvisplanes = {0};
+ps_metric_t ps_visplanesplits = {0};
+ps_metric_t ps_visplanereuse = {0};
+ps_metric_t ps_visplanepool = {0};
+
+ps_metric_t ps_sw_colpixels[COLDRAWFUNC_MAX + 1];
+ps_metric_t ps_sw_spanpixels[SPANDRAWFUNC_MAX + 1];
+ps_metric_t ps_sw_pixelsdrawn = {0};
+ps_metric_t ps_sw_overdraw = {0};
+
 static CV_PossibleValue_t drawdist_cons_t[] = {
 	{256, "256"},	{512, "512"},	{768, "768"},
 	{1024, "1024"},	{1536, "1536"},	{2048, "2048"},
@@ -130,6 +143,8 @@ static CV_PossibleValue_t fov_cons_t[] = {{60*FRACUNIT, "MIN"}, {179*FRACUNIT, "
 static CV_PossibleValue_t translucenthud_cons_t[] = {{0, "MIN"}, {10, "MAX"}, {0, NULL}};
 static CV_PossibleValue_t maxportals_cons_t[] = {{0, "MIN"}, {12, "MAX"}, {0, NULL}}; // lmao rendering 32 portals, you're a card
 static CV_PossibleValue_t homremoval_cons_t[] = {{0, "No"}, {1, "Yes"}, {2, "Flash"}, {0, NULL}};
+static CV_PossibleValue_t renderthreads_cons_t[] = {{1, "MIN"}, {MAXRENDERTHREADS, "MAX"}, {0, NULL}};
+static CV_PossibleValue_t slopesubdivision_cons_t[] = {{1, "Exact"}, {8, "8"}, {16, "16"}, {0, NULL}};
 
 static void Fov_OnChange(void);
 static void ChaseCam_OnChange(void);
@@ -149,6 +164,11 @@ consvar_t cv_shadow = CVAR_INIT ("shadow", "On", CV_SAVE, CV_OnOff, NULL);
 consvar_t cv_skybox = CVAR_INIT ("skybox", "On", CV_SAVE, CV_OnOff, NULL);
 consvar_t cv_ffloorclip = CVAR_INIT ("r_ffloorclip", "On", CV_SAVE, CV_OnOff, NULL);
 consvar_t cv_spriteclip = CVAR_INIT ("r_spriteclip", "On", CV_SAVE, CV_OnOff, NULL);
+consvar_t cv_renderthreads = CVAR_INIT ("r_threads", "1", CV_SAVE, renderthreads_cons_t, NULL);
+consvar_t cv_slopesubdivision = CVAR_INIT ("r_slopesubdivision", "16", CV_SAVE, slopesubdivision_cons_t, NULL);
+consvar_t cv_columnmajor = CVAR_INIT ("r_columnmajor", "Off", CV_SAVE|CV_CALL, CV_OnOff, R_SetViewSize);
+consvar_t cv_overdraw = CVAR_INIT ("r_overdraw", "Off", 0, CV_OnOff, NULL);
+consvar_t cv_pvs = CVAR_INIT ("r_pvs", "Off", CV_SAVE, CV_OnOff, NULL);
 consvar_t cv_allowmlook = CVAR_INIT ("allowmlook", "Yes", CV_NETVAR|CV_ALLOWLUA, CV_YesNo, NULL);
 consvar_t cv_showhud = CVAR_INIT ("showhud", "Yes", CV_CALL|CV_ALLOWLUA,  CV_YesNo, R_SetViewSize);
 consvar_t cv_translucenthud = CVAR_INIT ("translucenthud", "10", CV_SAVE, translucenthud_cons_t, NULL);
@@ -1443,16 +1463,32 @@ void R_RenderPlayerView(player_t *player)
 
 	if (cv_homremoval.value && player == &players[displayplayer]) // if this is display player 1
 	{
+		UINT8 color;
+
 		if (cv_homremoval.value == 1)
-			V_DrawFill(0, 0, BASEVIDWIDTH, BASEVIDHEIGHT, 31); // No HOM effect!
+			color = 31; // No HOM effect!
 		else //'development' HOM removal -- makes it blindingly obvious if HOM is spotted.
-			V_DrawFill(0, 0, BASEVIDWIDTH, BASEVIDHEIGHT, 32+(timeinmap&15));
+			color = 32+(timeinmap&15);
+
+		V_DrawFill(0, 0, BASEVIDWIDTH, BASEVIDHEIGHT, color);
+
+		// A column-major view is copied over screens[0] once it's drawn,
+		// so it has to be cleared too.
+		if (viewscreen != screens[0])
+			memset(viewscreen, color, vid.width * vid.height);
 	}
 
 	R_SetupFrame(player);
 	framecount++;
 	validcount++;
 
+	// The drawers can only be counted on this thread,
+	// so this has to come before the draw queue starts.
+	if (cv_overdraw.value || cv_perfstats.value == 4)
+		R_BeginDrawerCounting(cv_overdraw.value);
+
+	R_BeginDrawQueue();
+
 	// Clear buffers.
 	R_ClearPlanes();
 	if (viewmorph.use)
@@ -1482,11 +1518,17 @@ void R_RenderPlayerView(player_t *player)
 	Mask_Pre(&masks[nummasks - 1]);
 	curdrawsegs = ds_p;
 	ps_numbspcalls.value.i = ps_numpolyobjects.value.i = ps_numdrawnodes.value.i = 0;
+	ps_numvisplanes.value.i = ps_visplanesplits.value.i = ps_visplanereuse.value.i = 0;
+	ps_numpvsculled.value.i = 0;
 	PS_START_TIMING(ps_bsptime);
+	R_SetupPVS(viewx, viewy);
 	R_RenderBSPNode((INT32)numnodes - 1);
 	PS_STOP_TIMING(ps_bsptime);
 	Mask_Post(&masks[nummasks - 1]);
 
+	// Portals and skyboxes look out from somewhere else entirely.
+	pvsactive = false;
+
 	PS_START_TIMING(ps_sw_spritecliptime);
 	R_ClipSprites(drawsegs, NULL);
 	PS_STOP_TIMING(ps_sw_spritecliptime);
@@ -1540,19 +1582,105 @@ void R_RenderPlayerView(player_t *player)
 	}
 	PS_STOP_TIMING(ps_sw_portaltime);
 
+	// With r_threads, the walls are only drawn here, so that the time
+	// the render threads take over the planes is all in ps_sw_planetime.
+	R_FlushDrawQueue();
+
 	PS_START_TIMING(ps_sw_planetime);
 	R_DrawPlanes();
+	R_FlushDrawQueue();
 	PS_STOP_TIMING(ps_sw_planetime);
 
 	// draw mid texture and sprite
 	// And now 3D floors/sides!
 	PS_START_TIMING(ps_sw_maskedtime);
 	R_DrawMasked(masks, nummasks);
+	R_EndDrawQueue();
 	PS_STOP_TIMING(ps_sw_maskedtime);
 
+	if (drawercounting)
+	{
+		INT32 i;
+
+		ps_sw_pixelsdrawn.value.i = 0;
+		for (i = 0; i <= COLDRAWFUNC_MAX; i++)
+			ps_sw_pixelsdrawn.value.i += ps_sw_colpixels[i].value.i;
+		for (i = 0; i <= SPANDRAWFUNC_MAX; i++)
+			ps_sw_pixelsdrawn.value.i += ps_sw_spanpixels[i].value.i;
+		ps_sw_overdraw.value.i = (INT32)((INT64)ps_sw_pixelsdrawn.value.i * 100 / (viewwidth * viewheight));
+
+		R_EndDrawerCounting();
+	}
+
+	PS_START_TIMING(ps_sw_transposetime);
+	R_TransposeViewBuffer();
+	PS_STOP_TIMING(ps_sw_transposetime);
+
 	free(masks);
 }
 
+/** Renders the current view again with each r_slopesubdivision setting,
+  * and reports how long it took and how far it strayed from the exact
+  * drawers.
+  */
+void Command_Slopebench_f(void)
+{
+	static const INT32 modes[] = {1, 8, 16};
+	const INT32 oldmode = cv_slopesubdivision.value;
+	INT32 frames = 30, i, f;
+	size_t screensize, p;
+	UINT8 *exact;
+	double mspertick = 1000.0 / I_GetPrecisePrecision();
+
+	if (COM_Argc() > 2)
+	{
+		CONS_Printf(M_GetText("slopebench [frames]: time sloped planes with each r_slopesubdivision setting\n"));
+		return;
+	}
+
+	if (rendermode != render_soft || gamestate != GS_LEVEL || !playeringame[displayplayer])
+	{
+		CONS_Printf(M_GetText("You must be in a level, using the software renderer.\n"));
+		return;
+	}
+
+	if (COM_Argc() == 2)
+		frames = max(atoi(COM_Argv(1)), 1);
+
+	screensize = vid.rowbytes * vid.height;
+	exact = Z_Malloc(screensize, PU_STATIC, NULL);
+
+	CONS_Printf("\x82%s", M_GetText("Sloped planes:\n"));
+	for (i = 0; i < (INT32)(sizeof (modes) / sizeof (modes[0])); i++)
+	{
+		precise_t time;
+		size_t differ = 0;
+
+		CV_StealthSetValue(&cv_slopesubdivision, modes[i]);
+
+		time = I_GetPreciseTime();
+		for (f = 0; f < frames; f++)
+			R_RenderPlayerView(&players[displayplayer]);
+		time = I_GetPreciseTime() - time;
+
+		// The first setting is the exact one, compare the others against it
+		if (i == 0)
+			M_Memcpy(exact, screens[0], screensize);
+		else
+		{
+			for (p = 0; p < screensize; p++)
+				if (screens[0][p] != exact[p])
+					differ++;
+		}
+
+		CONS_Printf(M_GetText("%-6s %8.2f ms/frame, %6.2f%% of pixels differ from exact\n"),
+			cv_slopesubdivision.string, time * mspertick / frames, differ * 100.0 / screensize);
+	}
+
+	CV_StealthSetValue(&cv_slopesubdivision, oldmode);
+	Z_Free(exact);
+}
+
 // =========================================================================
 //                    ENGINE COMMANDS & VARS
 // =========================================================================
@@ -1583,6 +1711,11 @@ void R_RegisterEngineStuff(void)
 	CV_RegisterVar(&cv_skybox);
 	CV_RegisterVar(&cv_ffloorclip);
 	CV_RegisterVar(&cv_spriteclip);
+	CV_RegisterVar(&cv_renderthreads);
+	CV_RegisterVar(&cv_slopesubdivision);
+	CV_RegisterVar(&cv_columnmajor);
+	CV_RegisterVar(&cv_overdraw);
+	CV_RegisterVar(&cv_pvs);
 
 	CV_RegisterVar(&cv_cam_dist);
 	CV_RegisterVar(&cv_cam_still);
@@ -98,12 +98,26 @@ extern ps_metric_t ps_sw_spritecliptime;
 extern ps_metric_t ps_sw_portaltime;
 extern ps_metric_t ps_sw_planetime;
 extern ps_metric_t ps_sw_maskedtime;
+extern ps_metric_t ps_sw_transposetime;
 
 extern ps_metric_t ps_numbspcalls;
+extern ps_metric_t ps_numpvsculled;
 extern ps_metric_t ps_numsprites;
 extern ps_metric_t ps_numdrawnodes;
 extern ps_metric_t ps_numpolyobjects;
 
+extern ps_metric_t ps_numvisplanes;
+extern ps_metric_t ps_visplanesplits;
+extern ps_metric_t ps_visplanereuse;
+extern ps_metric_t ps_visplanepool;
+
+// Pixels written by each of colfuncs and spanfuncs, with one more at
+// the end for any other drawer
+extern ps_metric_t ps_sw_colpixels[];
+extern ps_metric_t ps_sw_spanpixels[];
+extern ps_metric_t ps_sw_pixelsdrawn;
+extern ps_metric_t ps_sw_overdraw;
+
 //
 // REFRESH - the actual rendering functions.
 //
@@ -115,6 +129,7 @@ extern consvar_t cv_flipcam, cv_flipcam2;
 
 extern consvar_t cv_shadow;
 extern consvar_t cv_ffloorclip, cv_spriteclip;
+extern consvar_t cv_renderthreads, cv_slopesubdivision, cv_columnmajor, cv_overdraw, cv_pvs;
 extern consvar_t cv_translucency;
 extern consvar_t cv_drawdist, cv_drawdist_nights, cv_drawdist_precip;
 extern consvar_t cv_fov;
@@ -143,6 +158,8 @@ boolean R_IsViewpointThirdPerson(player_t *player, boolean skybox);
 // Called by D_Display.
 void R_RenderPlayerView(player_t *player);
 
+void Command_Slopebench_f(void);
+
 // add commands related to engine, at game startup
 void R_RegisterEngineStuff(void);
 #endif
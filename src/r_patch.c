@@ -15,6 +15,10 @@
 #include "r_defs.h"
 #include "z_zone.h"
 
+#ifdef ROTSPRITE
+#include "r_patchrotation.h" // RotatedPatch_FlushRotations, RotatedPatch_FlushRotationsOf
+#endif
+
 #ifdef HWRENDER
 #include "hardware/hw_glob.h"
 #endif
@@ -69,6 +73,11 @@ static void Patch_FreeData(patch_t *patch)
 {
 	INT32 i;
 
+#ifdef ROTSPRITE
+	// The sprite rotation workers may be reading it.
+	RotatedPatch_FlushRotationsOf(patch);
+#endif
+
 #ifdef HWRENDER
 	if (patch->hardware)
 		HWR_FreeTexture(patch);
@@ -121,6 +130,10 @@ static boolean Patch_FreeTagsCallback(void *mem)
 
 void Patch_FreeTags(INT32 lowtag, INT32 hightag)
 {
+#ifdef ROTSPRITE
+	// The sprite rotation workers may be reading these.
+	RotatedPatch_FlushRotations();
+#endif
 	Z_IterateTags(lowtag, hightag, Patch_FreeTagsCallback);
 }
 
@@ -14,6 +14,10 @@
 #include "z_zone.h"
 #include "w_wad.h"
 #include "r_main.h" // R_PointToAngle
+#include "m_misc.h"
+#include "console.h"
+
+#include "i_jobpool.h"
 
 #ifdef ROTSPRITE
 fixed_t rollcosang[ROTANGLES];
@@ -63,11 +67,335 @@ patch_t *Patch_GetRotated(patch_t *patch, INT32 angle, boolean flip)
 	return rotsprite->patches[angle];
 }
 
-patch_t *Patch_GetRotatedSprite(
+// ==========================================================================
+//                                                   SPRITE ROTATION CACHE
+// ==========================================================================
+// Sprite rotations are kept in one list, most recently used first. Once per
+// frame, RotatedPatch_UpdateCache frees rotations from the back of the list
+// until the total is within cv_rotspritecachesize. Rotations freed by
+// anything else, such as a level change, are dropped as the list is walked.
+//
+// The renderers don't wait for a rotation to be made. They queue it for
+// the worker threads and draw the nearest angle already made in the
+// meantime, and the finished rotations are added between frames.
+
+typedef struct rotspritecachenode_s
+{
+	struct rotspritecachenode_s *prev, *next; // both NULL when not in the order
+	rotsprite_t *rotsprite;
+	INT32 idx; // in rotsprite->patches
+	size_t size; // roughly what the rotated patch takes up
+} rotspritecachenode_t;
+
+static CV_PossibleValue_t rotspritecachesize_cons_t[] = {{0, "MIN"}, {4096, "MAX"}, {0, NULL}};
+consvar_t cv_rotspritecachesize = CVAR_INIT ("rotspritecachesize", "0", CV_SAVE, rotspritecachesize_cons_t, NULL);
+
+static rotspritecachenode_t rotspritelru; // next is the most recently used, prev the least
+static size_t rotspritebytes; // total size of the rotations in rotspritelru
+static size_t rotspritecount; // how many rotations are in rotspritelru
+
+static struct
+{
+	UINT32 hits; // rotation was already made
+	UINT32 misses; // rotation had to be made, counted when it was made or queued
+	UINT32 fallbacks; // another angle was drawn in its place, counted per draw
+	UINT32 evictions; // freed to stay in budget
+} rotspritestats;
+
+static void RotatedPatch_UnlinkCacheNode(rotspritecachenode_t *node)
+{
+	node->prev->next = node->next;
+	node->next->prev = node->prev;
+	node->prev = node->next = NULL;
+	rotspritebytes -= node->size;
+	rotspritecount--;
+}
+
+// Moves a rotation to the front of the list, adding it if it isn't there yet
+static void RotatedPatch_TouchCacheNode(rotsprite_t *rotsprite, INT32 idx)
+{
+	rotspritecachenode_t *node;
+	patch_t *patch = rotsprite->patches[idx];
+
+	if (!rotsprite->cachenodes)
+		rotsprite->cachenodes = Z_Calloc(rotsprite->angles * 2 * sizeof (*rotsprite->cachenodes), PU_STATIC, NULL);
+
+	if (!rotspritelru.next)
+		rotspritelru.next = rotspritelru.prev = &rotspritelru;
+
+	node = &rotsprite->cachenodes[idx];
+
+	if (node->next)
+	{
+		// Already the most recently used, as is usual for a sprite on screen.
+		if (rotspritelru.next == node)
+			return;
+		RotatedPatch_UnlinkCacheNode(node);
+	}
+
+	node->rotsprite = rotsprite;
+	node->idx = idx;
+	node->size = sizeof (patch_t) + patch->width * (sizeof (INT32) + patch->height);
+
+	node->prev = &rotspritelru;
+	node->next = rotspritelru.next;
+	rotspritelru.next->prev = node;
+	rotspritelru.next = node;
+	rotspritebytes += node->size;
+	rotspritecount++;
+}
+
+// Drops rotations that were freed by something other than RotatedPatch_UpdateCache
+static void RotatedPatch_SweepCache(void)
+{
+	rotspritecachenode_t *node, *prev;
+
+	if (!rotspritelru.next)
+		return;
+
+	for (node = rotspritelru.prev; node != &rotspritelru; node = prev)
+	{
+		prev = node->prev;
+		if (node->rotsprite->patches[node->idx] == NULL)
+			RotatedPatch_UnlinkCacheNode(node);
+	}
+}
+
+// Frees least recently used rotations until the cache fits in its budget
+static void RotatedPatch_TrimCache(void)
+{
+	size_t budget = (size_t)cv_rotspritecachesize.value << 20;
+	rotspritecachenode_t *node, *prev;
+
+	if (!budget || !rotspritelru.next || rotspritebytes <= budget)
+		return;
+
+	for (node = rotspritelru.prev; node != &rotspritelru && rotspritebytes > budget; node = prev)
+	{
+		patch_t *patch = node->rotsprite->patches[node->idx];
+
+		prev = node->prev;
+		RotatedPatch_UnlinkCacheNode(node);
+
+		if (patch == NULL)
+			continue;
+
+		// Z_Free clears rotsprite->patches[idx] for us.
+		Patch_Free(patch);
+		rotspritestats.evictions++;
+	}
+}
+
+// A rotation being made, from RotatedPatch_PrepareRotation to RotatedPatch_FinishRotation
+typedef struct
+{
+	job_t job; // for the worker threads
+	rotsprite_t *rotsprite;
+	patch_t *patch; // source
+	INT32 idx; // in rotsprite->patches
+	INT32 angle;
+	INT32 xpivot, ypivot; // already flipped
+	pictureflags_t bflip;
+	boolean adjustfeet;
+
+	INT32 newwidth, newheight;
+	INT32 ox, oy;
+	INT32 minx, miny, maxx, maxy;
+	UINT16 *rawdst;
+	size_t size;
+} rotationjob_t;
+
+static boolean RotatedPatch_PrepareRotation(rotationjob_t *job, rotsprite_t *rotsprite, patch_t *patch, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip);
+static void RotatedPatch_RasterizeRotation(rotationjob_t *job);
+static void RotatedPatch_FinishRotation(rotationjob_t *job);
+
+// Rotations that can be in flight at once; any more are made on a later frame
+#define MAXROTATIONJOBS 256
+
+static jobpool_t rotationpool = JOBPOOL_INIT("sprite-rotation", 4);
+
+// Only the main thread fills or empties a slot
+static struct
+{
+	rotationjob_t jobs[MAXROTATIONJOBS];
+	boolean inflight[MAXROTATIONJOBS]; // queued, and not collected yet
+	INT32 numinflight;
+} rotqueue;
+
+static void RotatedPatch_RotationJob(job_t *job, INT32 worker)
+{
+	(void)worker;
+	RotatedPatch_RasterizeRotation((rotationjob_t *)job);
+}
+
+// Queues a rotation for the workers, unless it's already in flight.
+// Returns false if it couldn't be queued, and has to be made right away.
+static boolean RotatedPatch_QueueRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip, boolean adjustfeet)
+{
+	INT32 idx = angle + (flip ? rotsprite->angles : 0);
+	INT32 i, slot = -1;
+
+	// Without workers, nothing will take the job.
+	if (!I_start_job_pool(&rotationpool, 0))
+		return false;
+
+	for (i = 0; i < MAXROTATIONJOBS; i++)
+	{
+		if (!rotqueue.inflight[i])
+		{
+			if (slot == -1)
+				slot = i;
+		}
+		else if (rotqueue.jobs[i].rotsprite == rotsprite && rotqueue.jobs[i].idx == idx)
+			return true;
+	}
+
+	// Full up; try again next frame.
+	if (slot == -1)
+		return true;
+
+	if (!RotatedPatch_PrepareRotation(&rotqueue.jobs[slot], rotsprite, patch, angle, xpivot, ypivot, flip))
+		return true;
+	rotqueue.jobs[slot].adjustfeet = adjustfeet;
+
+	rotqueue.inflight[slot] = true;
+	rotqueue.numinflight++;
+	rotspritestats.misses++;
+
+	I_queue_job(&rotationpool, &rotqueue.jobs[slot].job, RotatedPatch_RotationJob);
+	return true;
+}
+
+// Finishes the rotations the workers are done with, or throws them away.
+// Only rotations from source, if it isn't NULL.
+static void RotatedPatch_CollectRotations(boolean discard, patch_t *source)
+{
+	INT32 i;
+
+	for (i = 0; i < MAXROTATIONJOBS && rotqueue.numinflight; i++)
+	{
+		rotationjob_t *job = &rotqueue.jobs[i];
+
+		if (!rotqueue.inflight[i] || (source && job->patch != source))
+			continue;
+
+		if (discard)
+			I_cancel_job(&rotationpool, &job->job);
+		else if (!I_job_is_done(&rotationpool, &job->job))
+			continue;
+
+		rotqueue.inflight[i] = false;
+		rotqueue.numinflight--;
+
+		// Throw it away too if it was made some other way in the meantime.
+		if (discard || job->rotsprite->patches[job->idx])
+			Z_Free(job->rawdst);
+		else
+		{
+			RotatedPatch_FinishRotation(job);
+			RotatedPatch_TouchCacheNode(job->rotsprite, job->idx);
+		}
+	}
+}
+
+/** Waits for the sprite rotations in flight, if any, and throws them away.
+  * Anything that frees sprite patches calls this first.
+  */
+void RotatedPatch_FlushRotations(void)
+{
+	RotatedPatch_CollectRotations(true, NULL);
+}
+
+/** Waits for the sprite rotations being made from a patch, if any, and
+  * throws them away. Patch_Free does this for every patch.
+  *
+  * \param patch The source patch about to be freed.
+  */
+void RotatedPatch_FlushRotationsOf(patch_t *patch)
+{
+	RotatedPatch_CollectRotations(true, patch);
+}
+
+/** Checks whether a rotation is being made from a patch, so that it is
+  * in use even if nothing else is holding it.
+  *
+  * \param patch The source patch.
+  * \return true if a rotation from it is still in flight.
+  */
+boolean RotatedPatch_IsRotating(patch_t *patch)
+{
+	INT32 i;
+
+	for (i = 0; i < MAXROTATIONJOBS && rotqueue.numinflight; i++)
+		if (rotqueue.inflight[i] && rotqueue.jobs[i].patch == patch)
+			return true;
+
+	return false;
+}
+
+/** Adds the sprite rotations finished by the worker threads to the cache,
+  * then frees least recently used rotations until the cache fits in
+  * cv_rotspritecachesize megabytes.
+  * Only call this where no rotated patches are being held, such as
+  * between frames.
+  */
+void RotatedPatch_UpdateCache(void)
+{
+	RotatedPatch_CollectRotations(false, NULL);
+	RotatedPatch_TrimCache();
+}
+
+/** The function called by the "rotspritecachestats" console command.
+  * Prints how many sprite rotations are cached, how often they were found,
+  * made, or stood in for, and how many were evicted to stay in budget.
+  */
+void Command_RotSpriteCacheStats_f(void)
+{
+	UINT32 total = rotspritestats.hits + rotspritestats.misses;
+
+	RotatedPatch_SweepCache();
+
+	CONS_Printf("\x82%s", M_GetText("Sprite rotation cache:\n"));
+	if (cv_rotspritecachesize.value)
+		CONS_Printf(M_GetText("%s rotations, %s KB used of %d KB\n"), sizeu1(rotspritecount), sizeu2(rotspritebytes>>10), cv_rotspritecachesize.value<<10);
+	else
+		CONS_Printf(M_GetText("%s rotations, %s KB used, no limit\n"), sizeu1(rotspritecount), sizeu2(rotspritebytes>>10));
+
+	CONS_Printf(M_GetText("%u hits, %u misses (%u%%), %u fallbacks, %u evictions\n"),
+		rotspritestats.hits, rotspritestats.misses, total ? (UINT32)((UINT64)rotspritestats.hits * 100 / total) : 0,
+		rotspritestats.fallbacks, rotspritestats.evictions);
+	CONS_Printf(M_GetText("%d being made, on %d threads\n"), rotqueue.numinflight, rotationpool.numthreads);
+}
+
+// Finds the closest angle to stand in for one that isn't made yet.
+// -1 means the unrotated sprite is the closest.
+static INT32 RotatedPatch_GetNearestAngle(rotsprite_t *rotsprite, INT32 angle, boolean flip)
+{
+	INT32 base = (flip ? rotsprite->angles : 0);
+	INT32 dist, a, b;
+
+	for (dist = 1; dist <= rotsprite->angles / 2; dist++)
+	{
+		a = (angle + dist) % rotsprite->angles;
+		b = (angle - dist + rotsprite->angles) % rotsprite->angles;
+
+		if (!a || !b)
+			break;
+		if (rotsprite->patches[base + a])
+			return base + a;
+		if (rotsprite->patches[base + b])
+			return base + b;
+	}
+
+	return -1;
+}
+
+static patch_t *RotatedPatch_GetSprite(
 	spriteframe_t *sprite,
 	size_t frame, size_t spriteangle,
 	boolean flip, boolean adjustfeet,
-	void *info, INT32 rotationangle)
+	void *info, INT32 rotationangle,
+	boolean wait)
 {
 	rotsprite_t *rotsprite;
 	spriteinfo_t *sprinfo = (spriteinfo_t *)info;
@@ -110,16 +438,53 @@ patch_t *Patch_GetRotatedSprite(
 			ypivot = patch->height / 2;
 		}
 
+		if (!wait && RotatedPatch_QueueRotation(rotsprite, patch, rotationangle, xpivot, ypivot, flip, adjustfeet))
+		{
+			INT32 nearest = RotatedPatch_GetNearestAngle(rotsprite, rotationangle, flip);
+
+			rotspritestats.fallbacks++;
+			if (nearest == -1)
+				return NULL;
+
+			RotatedPatch_TouchCacheNode(rotsprite, nearest);
+			return rotsprite->patches[nearest];
+		}
+
+		rotspritestats.misses++;
 		RotatedPatch_DoRotation(rotsprite, patch, rotationangle, xpivot, ypivot, flip);
 
 		//BP: we cannot use special tric in hardware mode because feet in ground caused by z-buffer
 		if (adjustfeet)
 			((patch_t *)rotsprite->patches[idx])->topoffset += FEETADJUST>>FRACBITS;
 	}
+	else
+		rotspritestats.hits++;
 
+	RotatedPatch_TouchCacheNode(rotsprite, idx);
 	return rotsprite->patches[idx];
 }
 
+// Makes the rotation right away if it isn't cached yet.
+patch_t *Patch_GetRotatedSprite(
+	spriteframe_t *sprite,
+	size_t frame, size_t spriteangle,
+	boolean flip, boolean adjustfeet,
+	void *info, INT32 rotationangle)
+{
+	return RotatedPatch_GetSprite(sprite, frame, spriteangle, flip, adjustfeet, info, rotationangle, true);
+}
+
+// Queues the rotation if it isn't cached yet, and returns the closest
+// angle that is in the meantime. NULL means to draw the sprite unrotated.
+patch_t *Patch_RequestRotatedSprite(
+	spriteframe_t *sprite,
+	size_t frame, size_t spriteangle,
+	boolean flip, boolean adjustfeet,
+	void *info, INT32 rotationangle)
+{
+	return RotatedPatch_GetSprite(sprite, frame, spriteangle, flip, adjustfeet, info, rotationangle, false);
+}
+
 void Patch_Rotate(patch_t *patch, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip)
 {
 	if (patch->rotated == NULL)
@@ -157,31 +522,19 @@ static void RotatedPatch_CalculateDimensions(
 	*newheight = max(height, max(h1, h2));
 }
 
-void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip)
+// Works out the size of the rotation and allocates its buffer.
+// Returns false if there is nothing to make.
+static boolean RotatedPatch_PrepareRotation(rotationjob_t *job, rotsprite_t *rotsprite, patch_t *patch, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip)
 {
-	patch_t *rotated;
-	UINT16 *rawdst, *rawconv;
-	size_t size;
-	pictureflags_t bflip = (flip) ? PICFLAGS_XFLIP : 0;
-
 	INT32 width = patch->width;
 	INT32 height = patch->height;
 	INT32 leftoffset = patch->leftoffset;
 	INT32 newwidth, newheight;
-
-	fixed_t ca = rollcosang[angle];
-	fixed_t sa = rollsinang[angle];
-	fixed_t xcenter, ycenter;
 	INT32 idx = angle;
-	INT32 x, y;
-	INT32 sx, sy;
-	INT32 dx, dy;
-	INT32 ox, oy;
-	INT32 minx, miny, maxx, maxy;
 
 	// Don't cache angle = 0
 	if (angle < 1 || angle >= ROTANGLES)
-		return;
+		return false;
 
 	if (flip)
 	{
@@ -191,13 +544,10 @@ void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle
 	}
 
 	if (rotsprite->patches[idx])
-		return;
+		return false;
 
 	// Find the dimensions of the rotated patch.
-	RotatedPatch_CalculateDimensions(width, height, ca, sa, &newwidth, &newheight);
-
-	xcenter = (xpivot * FRACUNIT);
-	ycenter = (ypivot * FRACUNIT);
+	RotatedPatch_CalculateDimensions(width, height, rollcosang[angle], rollsinang[angle], &newwidth, &newheight);
 
 	if (xpivot != width / 2 || ypivot != height / 2)
 	{
@@ -205,16 +555,48 @@ void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle
 		newheight *= 2;
 	}
 
-	minx = newwidth;
-	miny = newheight;
-	maxx = 0;
-	maxy = 0;
+	job->rotsprite = rotsprite;
+	job->patch = patch;
+	job->idx = idx;
+	job->angle = angle;
+	job->xpivot = xpivot;
+	job->ypivot = ypivot;
+	job->bflip = (flip) ? PICFLAGS_XFLIP : 0;
+	job->adjustfeet = false;
+	job->newwidth = newwidth;
+	job->newheight = newheight;
+	job->ox = (newwidth / 2) + (leftoffset - xpivot);
+	job->oy = (newheight / 2) + (patch->topoffset - ypivot);
+
+	// The rotated sprite is drawn to a temporary buffer.
+	job->size = (newwidth * newheight);
+	if (!job->size)
+		job->size = (width * height);
+	job->rawdst = Z_Calloc(job->size * sizeof(UINT16), PU_STATIC, NULL);
+
+	return true;
+}
 
-	// Draw the rotated sprite to a temporary buffer.
-	size = (newwidth * newheight);
-	if (!size)
-		size = (width * height);
-	rawdst = Z_Calloc(size * sizeof(UINT16), PU_STATIC, NULL);
+// Draws the rotated sprite to the buffer.
+// Touches nothing but the job and its source patch, so it's safe to run
+// on a worker thread.
+static void RotatedPatch_RasterizeRotation(rotationjob_t *job)
+{
+	patch_t *patch = job->patch;
+	UINT16 *rawdst = job->rawdst;
+	INT32 width = patch->width;
+	INT32 height = patch->height;
+	INT32 newwidth = job->newwidth;
+	INT32 newheight = job->newheight;
+
+	fixed_t ca = rollcosang[job->angle];
+	fixed_t sa = rollsinang[job->angle];
+	fixed_t xcenter = (job->xpivot * FRACUNIT);
+	fixed_t ycenter = (job->ypivot * FRACUNIT);
+	INT32 x, y;
+	INT32 sx, sy;
+	INT32 dx, dy;
+	INT32 minx = newwidth, miny = newheight, maxx = 0, maxy = 0;
 
 	for (dy = 0; dy < newheight; dy++)
 	{
@@ -230,7 +612,7 @@ void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle
 
 			if (sx >= 0 && sy >= 0 && sx < width && sy < height)
 			{
-				void *input = Picture_GetPatchPixel(patch, PICFMT_PATCH, sx, sy, bflip);
+				void *input = Picture_GetPatchPixel(patch, PICFMT_PATCH, sx, sy, job->bflip);
 				if (input != NULL)
 				{
 					rawdst[(dy * newwidth) + dx] = (0xFF00 | (*(UINT8 *)input));
@@ -247,10 +629,25 @@ void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle
 		}
 	}
 
-	ox = (newwidth / 2) + (leftoffset - xpivot);
-	oy = (newheight / 2) + (patch->topoffset - ypivot);
-	width = (maxx - minx);
-	height = (maxy - miny);
+	job->minx = minx;
+	job->miny = miny;
+	job->maxx = maxx;
+	job->maxy = maxy;
+}
+
+// Turns the buffer into a patch and puts it in the rotsprite.
+static void RotatedPatch_FinishRotation(rotationjob_t *job)
+{
+	rotsprite_t *rotsprite = job->rotsprite;
+	patch_t *rotated;
+	UINT16 *rawdst = job->rawdst, *rawconv;
+	size_t size = job->size;
+	INT32 newwidth = job->newwidth;
+	INT32 width = (job->maxx - job->minx);
+	INT32 height = (job->maxy - job->miny);
+	INT32 ox = job->ox;
+	INT32 oy = job->oy;
+	INT32 dy;
 
 	if ((unsigned)(width * height) > size)
 	{
@@ -259,7 +656,7 @@ void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle
 		size = (width * height);
 		rawconv = Z_Calloc(size * sizeof(UINT16), PU_STATIC, NULL);
 
-		src = &rawdst[(miny * newwidth) + minx];
+		src = &rawdst[(job->miny * newwidth) + job->minx];
 		dest = rawconv;
 		dy = height;
 
@@ -270,8 +667,8 @@ void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle
 			src += newwidth;
 		}
 
-		ox -= minx;
-		oy -= miny;
+		ox -= job->minx;
+		oy -= job->miny;
 
 		Z_Free(rawdst);
 	}
@@ -279,17 +676,32 @@ void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle
 	{
 		rawconv = rawdst;
 		width = newwidth;
-		height = newheight;
+		height = job->newheight;
 	}
 
 	// make patch
 	rotated = (patch_t *)Picture_Convert(PICFMT_FLAT16, rawconv, PICFMT_PATCH, 0, NULL, width, height, 0, 0, 0);
 
 	Z_ChangeTag(rotated, PU_PATCH_ROTATED);
-	Z_SetUser(rotated, (void **)(&rotsprite->patches[idx]));
+	Z_SetUser(rotated, (void **)(&rotsprite->patches[job->idx]));
 	Z_Free(rawconv);
 
 	rotated->leftoffset = ox;
 	rotated->topoffset = oy;
+
+	//BP: we cannot use special tric in hardware mode because feet in ground caused by z-buffer
+	if (job->adjustfeet)
+		rotated->topoffset += FEETADJUST>>FRACBITS;
+}
+
+void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip)
+{
+	rotationjob_t job;
+
+	if (!RotatedPatch_PrepareRotation(&job, rotsprite, patch, angle, xpivot, ypivot, flip))
+		return;
+
+	RotatedPatch_RasterizeRotation(&job);
+	RotatedPatch_FinishRotation(&job);
 }
 #endif
@@ -11,11 +11,20 @@
 
 #include "r_patch.h"
 #include "r_picformats.h"
+#include "command.h"
 
 #ifdef ROTSPRITE
 rotsprite_t *RotatedPatch_Create(INT32 numangles);
 void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip);
 
+// Keep sprite rotations within cv_rotspritecachesize, least recently used first
+extern consvar_t cv_rotspritecachesize;
+void RotatedPatch_FlushRotations(void);
+void RotatedPatch_FlushRotationsOf(patch_t *patch);
+boolean RotatedPatch_IsRotating(patch_t *patch);
+void RotatedPatch_UpdateCache(void);
+void Command_RotSpriteCacheStats_f(void);
+
 extern fixed_t rollcosang[ROTANGLES];
 extern fixed_t rollsinang[ROTANGLES];
 #endif
@@ -42,16 +42,43 @@ visplane_t *visplanes[MAXVISPLANES];
 static visplane_t *freetail;
 static visplane_t **freehead = &freetail;
 
+// Visplanes are allocated VISPLANEBLOCK at a time, and never freed.
+// R_ClearPlanes puts them all back on the free list at the start of a frame.
+#define VISPLANEBLOCK 64
+
 visplane_t *floorplane;
 visplane_t *ceilingplane;
-static visplane_t *currentplane;
+static DRAWERSTATE visplane_t *currentplane;
 
 visffloor_t ffloor[MAXFFLOORS];
 INT32 numffloors;
 
-//SoM: 3/23/2000: Boom visplane hashing routine.
-#define visplane_hash(picnum,lightlevel,height) \
-  ((unsigned)((picnum)*3+(lightlevel)+(height)*7) & VISPLANEHASHMASK)
+// Hashes everything R_FindPlane compares that usually differs between
+// planes in the same view. Boom's picnum*3+lightlevel+height*7 put most
+// of a detailed map's planes into a handful of chains.
+static unsigned visplane_hash(INT32 picnum, INT32 lightlevel, fixed_t height,
+	fixed_t xoff, fixed_t yoff, extracolormap_t *planecolormap, pslope_t *slope)
+{
+	UINT32 hash = 0;
+
+#define HASHVALUE(value) \
+	hash = (hash ^ (UINT32)(value)) * 0x9E3779B1u; \
+	hash = (hash << 13) | (hash >> 19);
+
+	HASHVALUE(picnum)
+	HASHVALUE(lightlevel)
+	HASHVALUE(height)
+	HASHVALUE(xoff)
+	HASHVALUE(yoff)
+	HASHVALUE((size_t)planecolormap >> 4)
+	HASHVALUE((size_t)slope >> 4)
+#undef HASHVALUE
+
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6Bu;
+	hash ^= hash >> 13;
+	return hash & VISPLANEHASHMASK;
+}
 
 //
 // Clip values are the solid pixel bounding the range.
@@ -70,8 +97,9 @@ static INT32 spanstart[MAXVIDHEIGHT];
 //
 // texture mapping
 //
-lighttable_t **planezlight;
-static fixed_t planeheight;
+DRAWERSTATE lighttable_t **planezlight;
+static DRAWERSTATE fixed_t planeheight;
+static DRAWERSTATE void (*planespanfunc)(void);
 
 //added : 10-02-98: yslopetab is what yslope used to be,
 //                yslope points somewhere into yslopetab,
@@ -88,7 +116,7 @@ fixed_t cacheddistance[MAXVIDHEIGHT];
 fixed_t cachedxstep[MAXVIDHEIGHT];
 fixed_t cachedystep[MAXVIDHEIGHT];
 
-static fixed_t xoffs, yoffs;
+static DRAWERSTATE fixed_t xoffs, yoffs;
 static floatv3_t ds_slope_origin, ds_slope_u, ds_slope_v;
 
 //
@@ -106,7 +134,7 @@ void R_InitPlanes(void)
 // Sets planeripple.xfrac and planeripple.yfrac, added to ds_xfrac and ds_yfrac, if the span is not tilted.
 //
 
-static struct
+static DRAWERSTATE struct
 {
 	INT32 offset;
 	fixed_t xfrac, yfrac;
@@ -220,7 +248,7 @@ static void R_MapPlane(INT32 y, INT32 x1, INT32 x2)
 	ds_x1 = x1;
 	ds_x2 = x2;
 
-	spanfunc();
+	R_RunSpanDrawer(planespanfunc);
 }
 
 static void R_MapTiltedPlane(INT32 y, INT32 x1, INT32 x2)
@@ -259,7 +287,7 @@ static void R_MapTiltedPlane(INT32 y, INT32 x1, INT32 x2)
 	ds_x1 = x1;
 	ds_x2 = x2;
 
-	spanfunc();
+	R_RunSpanDrawer(planespanfunc);
 }
 
 static void R_MapFogPlane(INT32 y, INT32 x1, INT32 x2)
@@ -292,7 +320,7 @@ static void R_MapFogPlane(INT32 y, INT32 x1, INT32 x2)
 	ds_x1 = x1;
 	ds_x2 = x2;
 
-	spanfunc();
+	R_RunSpanDrawer(planespanfunc);
 }
 
 static void R_MapTiltedFogPlane(INT32 y, INT32 x1, INT32 x2)
@@ -314,7 +342,7 @@ static void R_MapTiltedFogPlane(INT32 y, INT32 x1, INT32 x2)
 	ds_x1 = x1;
 	ds_x2 = x2;
 
-	spanfunc();
+	R_RunSpanDrawer(planespanfunc);
 }
 
 void R_ClearFFloorClips (void)
@@ -368,20 +396,32 @@ void R_ClearPlanes(void)
 
 static visplane_t *new_visplane(unsigned hash)
 {
-	visplane_t *check = freetail;
-	if (!check)
-	{
-		check = malloc(sizeof (*check));
-		if (check == NULL) I_Error("%s: Out of memory", "new_visplane"); // FIXME: ugly
-	}
-	else
+	visplane_t *check;
+
+	if (!freetail)
 	{
-		freetail = freetail->next;
-		if (!freetail)
-			freehead = &freetail;
+		visplane_t *block = malloc(VISPLANEBLOCK * sizeof (*block));
+		INT32 i;
+
+		if (block == NULL) I_Error("%s: Out of memory", "new_visplane"); // FIXME: ugly
+
+		for (i = 0; i < VISPLANEBLOCK - 1; i++)
+			block[i].next = &block[i + 1];
+		block[VISPLANEBLOCK - 1].next = NULL;
+
+		freetail = block;
+		freehead = &block[VISPLANEBLOCK - 1].next;
+		ps_visplanepool.value.i += VISPLANEBLOCK;
 	}
+
+	check = freetail;
+	freetail = freetail->next;
+	if (!freetail)
+		freehead = &freetail;
+
 	check->next = visplanes[hash];
 	visplanes[hash] = check;
+	ps_numvisplanes.value.i++;
 	return check;
 }
 
@@ -438,7 +478,7 @@ visplane_t *R_FindPlane(fixed_t height, INT32 picnum, INT32 lightlevel,
 
 	if (!pfloor)
 	{
-		hash = visplane_hash(picnum, lightlevel, height);
+		hash = visplane_hash(picnum, lightlevel, height, xoff, yoff, planecolormap, slope);
 		for (check = visplanes[hash]; check; check = check->next)
 		{
 			if (polyobj != check->polyobj)
@@ -452,6 +492,7 @@ visplane_t *R_FindPlane(fixed_t height, INT32 picnum, INT32 lightlevel,
 				&& check->plangle == plangle
 				&& check->slope == slope)
 			{
+				ps_visplanereuse.value.i++;
 				return check;
 			}
 		}
@@ -480,12 +521,28 @@ visplane_t *R_FindPlane(fixed_t height, INT32 picnum, INT32 lightlevel,
 	check->polyobj = polyobj;
 	check->slope = slope;
 
-	memset(check->top, 0xff, sizeof (check->top));
-	memset(check->bottom, 0x00, sizeof (check->bottom));
+	// Nothing past vid.width is read before R_DrawSinglePlane sets it
+	memset(check->top, 0xff, sizeof (*check->top) * vid.width);
+	memset(check->bottom, 0x00, sizeof (*check->bottom) * vid.width);
 
 	return check;
 }
 
+// Would R_FindPlane have matched these two planes?
+static boolean R_SamePlane(visplane_t *a, visplane_t *b)
+{
+	return a->height == b->height && a->picnum == b->picnum
+		&& a->lightlevel == b->lightlevel
+		&& a->xoffs == b->xoffs && a->yoffs == b->yoffs
+		&& a->extra_colormap == b->extra_colormap
+		&& a->viewx == b->viewx && a->viewy == b->viewy && a->viewz == b->viewz
+		&& a->viewangle == b->viewangle
+		&& a->plangle == b->plangle
+		&& a->polyobj == b->polyobj
+		&& a->slope == b->slope
+		&& a->ffloor == b->ffloor;
+}
+
 //
 // R_CheckPlane: return same visplane or alloc a new one if needed
 //
@@ -530,14 +587,33 @@ visplane_t *R_CheckPlane(visplane_t *pl, INT32 start, INT32 stop)
 	else /* Cannot use existing plane; create a new one */
 	{
 		visplane_t *new_pl;
+
+		ps_visplanesplits.value.i++;
+
 		if (pl->ffloor)
 		{
 			new_pl = new_visplane(MAXVISPLANES - 1);
 		}
 		else
 		{
-			unsigned hash =
-				visplane_hash(pl->picnum, pl->lightlevel, pl->height);
+			unsigned hash = visplane_hash(pl->picnum, pl->lightlevel, pl->height,
+				pl->xoffs, pl->yoffs, pl->extra_colormap, pl->slope);
+
+			// An earlier split of the same plane may not use these columns
+			// at all yet. Nothing outside a plane's minx to maxx is marked,
+			// so that one can take the range instead.
+			for (new_pl = visplanes[hash]; new_pl; new_pl = new_pl->next)
+			{
+				if (new_pl != pl && R_SamePlane(new_pl, pl)
+					&& (stop < new_pl->minx || start > new_pl->maxx))
+				{
+					new_pl->minx = min(new_pl->minx, start);
+					new_pl->maxx = max(new_pl->maxx, stop);
+					ps_visplanereuse.value.i++;
+					return new_pl;
+				}
+			}
+
 			new_pl = new_visplane(hash);
 		}
 
@@ -558,8 +634,8 @@ visplane_t *R_CheckPlane(visplane_t *pl, INT32 start, INT32 stop)
 		pl = new_pl;
 		pl->minx = start;
 		pl->maxx = stop;
-		memset(pl->top, 0xff, sizeof pl->top);
-		memset(pl->bottom, 0x00, sizeof pl->bottom);
+		memset(pl->top, 0xff, sizeof (*pl->top) * vid.width);
+		memset(pl->bottom, 0x00, sizeof (*pl->bottom) * vid.width);
 	}
 	return pl;
 }
@@ -583,7 +659,10 @@ void R_ExpandPlane(visplane_t *pl, INT32 start, INT32 stop)
 	if (pl->maxx < stop)  pl->maxx = stop;
 }
 
-static void R_MakeSpans(void (*mapfunc)(INT32, INT32, INT32), INT32 x, INT32 t1, INT32 b1, INT32 t2, INT32 b2)
+// Only rows top to bottom are looked at. Whether a row's span ends or
+// starts at x doesn't depend on any other row, so the rows can be split
+// between threads.
+static void R_MakeSpans(void (*mapfunc)(INT32, INT32, INT32), INT32 x, INT32 t1, INT32 b1, INT32 t2, INT32 b2, INT32 top, INT32 bottom)
 {
 	//    Alam: from r_splats's R_RasterizeFloorSplat
 	if (t1 >= vid.height) t1 = vid.height-1;
@@ -592,6 +671,11 @@ static void R_MakeSpans(void (*mapfunc)(INT32, INT32, INT32), INT32 x, INT32 t1,
 	if (b2 >= vid.height) b2 = vid.height-1;
 	if (x-1 >= vid.width) x = vid.width;
 
+	if (t1 < top) t1 = top;
+	if (t2 < top) t2 = top;
+	if (b1 > bottom) b1 = bottom;
+	if (b2 > bottom) b2 = bottom;
+
 	while (t1 < t2 && t1 <= b1)
 	{
 		mapfunc(t1, spanstart[t1], x - 1);
@@ -666,7 +750,7 @@ static void R_DrawSkyPlane(visplane_t *pl)
 			dc_source =
 				R_GetColumn(texturetranslation[skytexture],
 					-angle); // get negative of angle for each column to display sky correct way round! --Monster Iestyn 27/01/18
-			colfunc();
+			R_RunColumnDrawer(colfunc);
 		}
 	}
 }
@@ -850,7 +934,7 @@ void R_DrawSinglePlane(visplane_t *pl)
 	INT32 light = 0;
 	INT32 x, stop;
 	ffloor_t *rover;
-	boolean fog = false;
+	boolean fog = false, resetcache = false;
 	INT32 spanfunctype = BASEDRAWFUNC;
 	void (*mapfunc)(INT32, INT32, INT32);
 
@@ -951,10 +1035,25 @@ void R_DrawSinglePlane(visplane_t *pl)
 
 					spanfunctype = SPANDRAWFUNC_WATER;
 
+					// Everything queued so far has to be on the screen first
+					R_FlushDrawQueue();
+
 					// Only copy the part of the screen we need
-					VID_BlitLinearScreen((splitscreen && viewplayer == &players[secondarydisplayplayer]) ? screens[0] + (top+(vid.height>>1))*vid.width : screens[0]+((top)*vid.width), screens[1]+((top)*vid.width),
-										 vid.width, bottom-top,
-										 vid.width, vid.width);
+					if (viewscreen != screens[0])
+					{
+						// Column-major, so that the water drawers can
+						// step through it the same way as the view
+						INT32 col;
+
+						if (bottom > viewheight)
+							bottom = viewheight;
+						for (col = 0; col < viewwidth && top < bottom; col++)
+							M_Memcpy(screens[1] + col*spanpitch + top, ylookup[top] + columnofs[col], bottom-top);
+					}
+					else
+						VID_BlitLinearScreen((splitscreen && viewplayer == &players[secondarydisplayplayer]) ? screens[0] + (top+(vid.height>>1))*vid.width : screens[0]+((top)*vid.width), screens[1]+((top)*vid.width),
+											 vid.width, bottom-top,
+											 vid.width, vid.width);
 				}
 			}
 		}
@@ -1005,6 +1104,7 @@ void R_DrawSinglePlane(visplane_t *pl)
 		{
 			memset(cachedheight, 0, sizeof (cachedheight));
 			viewangle = pl->viewangle+pl->plangle;
+			resetcache = true;
 		}
 
 		mapfunc = R_MapPlane;
@@ -1115,6 +1215,8 @@ void R_DrawSinglePlane(visplane_t *pl)
 	else
 		spanfunc = spanfuncs[spanfunctype];
 
+	planespanfunc = spanfunc;
+
 	// set the maximum value for unsigned
 	pl->top[pl->maxx+1] = 0xffff;
 	pl->top[pl->minx-1] = 0xffff;
@@ -1124,8 +1226,66 @@ void R_DrawSinglePlane(visplane_t *pl)
 	currentplane = pl;
 	stop = pl->maxx + 1;
 
+#ifdef RENDERTHREADS
+	// Hand the whole plane over to the render threads, unless it's a
+	// tilted ripple plane. Those have slope vectors for every row, which
+	// the next tilted plane overwrites, so their spans are made here.
+	if (drawqueueactive && !(pl->slope && planeripple.active))
+	{
+		planespans_t spans;
+
+		spans.pl = pl;
+		spans.mapfunc = mapfunc;
+		spans.spanfunc = spanfunc;
+		spans.planeheight = planeheight;
+		spans.xoffs = xoffs;
+		spans.yoffs = yoffs;
+		spans.rippleoffset = planeripple.offset;
+		spans.ripple = planeripple.active;
+		spans.resetcache = resetcache;
+
+		R_QueuePlaneSpans(&spans);
+		return;
+	}
+#else
+	(void)resetcache;
+#endif
+
+	for (x = pl->minx; x <= stop; x++)
+		R_MakeSpans(mapfunc, x, pl->top[x-1], pl->bottom[x-1], pl->top[x], pl->bottom[x], INT32_MIN, INT32_MAX);
+}
+
+/** Makes and draws the spans of a visplane queued by R_DrawSinglePlane,
+  * on the render threads. Only rows top to bottom are drawn.
+  *
+  * \param spans The plane, and the state it was queued with.
+  * \param top First row to draw.
+  * \param bottom Last row to draw.
+  */
+void R_DrawPlaneSpans(const planespans_t *spans, INT32 top, INT32 bottom)
+{
+	visplane_t *pl = spans->pl;
+	INT32 x, stop = pl->maxx + 1;
+
+	currentplane = pl;
+	planespanfunc = spans->spanfunc;
+	planeheight = spans->planeheight;
+	xoffs = spans->xoffs;
+	yoffs = spans->yoffs;
+	planeripple.offset = spans->rippleoffset;
+	planeripple.active = spans->ripple;
+
+	// The cache rows are this thread's alone for the length of the flush.
+	if (spans->resetcache)
+	{
+		INT32 y, last = min(bottom, vid.height - 1);
+
+		for (y = max(top, 0); y <= last; y++)
+			cachedheight[y] = 0;
+	}
+
 	for (x = pl->minx; x <= stop; x++)
-		R_MakeSpans(mapfunc, x, pl->top[x-1], pl->bottom[x-1], pl->top[x], pl->bottom[x]);
+		R_MakeSpans(spans->mapfunc, x, pl->top[x-1], pl->bottom[x-1], pl->top[x], pl->bottom[x], top, bottom);
 }
 
 void R_PlaneBounds(visplane_t *plane)
@@ -15,11 +15,12 @@
 #define __R_PLANE__
 
 #include "screen.h" // needs MAXVIDWIDTH/MAXVIDHEIGHT
+#include "r_draw.h" // DRAWERSTATE
 #include "r_data.h"
 #include "r_textures.h"
 #include "p_polyobj.h"
 
-#define VISPLANEHASHBITS 9
+#define VISPLANEHASHBITS 10
 #define VISPLANEHASHMASK ((1<<VISPLANEHASHBITS)-1)
 // the last visplane list is outside of the hash table and is used for fof planes
 #define MAXVISPLANES ((1<<VISPLANEHASHBITS)+1)
@@ -68,7 +69,7 @@ extern fixed_t cachedxstep[MAXVIDHEIGHT];
 extern fixed_t cachedystep[MAXVIDHEIGHT];
 
 extern fixed_t *yslope;
-extern lighttable_t **planezlight;
+extern DRAWERSTATE lighttable_t **planezlight;
 
 void R_InitPlanes(void);
 void R_ClearPlanes(void);
@@ -84,6 +85,23 @@ void R_PlaneBounds(visplane_t *plane);
 // Draws a single visplane.
 void R_DrawSinglePlane(visplane_t *pl);
 
+// What the render threads need to know to make a visplane's spans
+typedef struct
+{
+	visplane_t *pl;
+	void (*mapfunc)(INT32, INT32, INT32);
+	void (*spanfunc)(void);
+	fixed_t planeheight, xoffs, yoffs;
+	INT32 rippleoffset;
+	boolean ripple;
+	boolean resetcache; // the distance cache is from another angle
+} planespans_t;
+
+void R_DrawPlaneSpans(const planespans_t *spans, INT32 top, INT32 bottom);
+#ifdef RENDERTHREADS
+void R_QueuePlaneSpans(const planespans_t *spans);
+#endif
+
 // Calculates the slope vectors needed for tilted span drawing.
 void R_SetSlopePlane(pslope_t *slope, fixed_t xpos, fixed_t ypos, fixed_t zpos, fixed_t xoff, fixed_t yoff, angle_t angle, angle_t plangle);
 void R_SetScaledSlopePlane(pslope_t *slope, fixed_t xpos, fixed_t ypos, fixed_t zpos, fixed_t xs, fixed_t ys, fixed_t xoff, fixed_t yoff, angle_t angle, angle_t plangle);
@@ -0,0 +1,1304 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_pvs.c
+/// \brief Potentially visible sets, for culling the BSP before clipping.
+///
+///        Each subsector gets the set of subsectors that could be seen from
+///        anywhere inside it. Sight passes from one subsector to the next
+///        through portals, the stretches of their shared edges that aren't
+///        covered by one-sided walls. Floor and ceiling heights are left
+///        out, since they can change, as are polyobjects, since they move.
+///        So a set can only ever hold too much, never too little.
+///
+///        Sets are built on level load when r_pvs is on, then kept in
+///        srb2home, named after the map's MD5.
+
+#include <math.h>
+#include <float.h>
+
+#include "doomdef.h"
+#include "r_pvs.h"
+#include "r_main.h"
+#include "r_state.h"
+#include "p_setup.h" // mapmd5
+#include "p_polyobj.h"
+#include "g_game.h"
+#include "d_main.h" // srb2home
+#include "d_netcmd.h" // D_MapChange
+#include "i_system.h"
+#include "m_misc.h"
+#include "byteptr.h"
+#include "console.h"
+#include "z_zone.h"
+
+#include "i_jobpool.h"
+
+#define PVSMAGIC "SPVS"
+#define PVSVERSION 1
+
+// How far off a line a vertex can be and still count as on it.
+// Node builders round the vertices they make when splitting segs.
+#define PVSSEGEPSILON 1.0
+
+// Slack for everything else, in map units
+#define PVSEPSILON (1.0/64)
+
+// How many portals to look through from one subsector before giving up,
+// and counting everything it's connected to as visible
+#define PVSMAXSTEPS (1<<20)
+
+#define MAXPVSTHREADS 8
+
+// Doubles, as floats can't hold a fixed_t coordinate exactly
+#define PVSCOORD(x) ((double)(x) / FRACUNIT)
+
+boolean pvsactive = false;
+UINT8 *pvsleafvis = NULL;
+UINT8 *pvsnodevis = NULL;
+
+// All PU_LEVEL, and cleared by the zone when the level is freed
+static UINT8 *pvsdata = NULL; // compressed rows, one per subsector
+static UINT32 *pvsrowofs = NULL; // where each row starts in pvsdata
+static INT32 *pvsparents = NULL; // nodes' parents, then subsectors', -1 for the root
+
+// ==========================================================================
+//                                                            BUILDING
+// ==========================================================================
+
+typedef struct
+{
+	double x, y;
+} pvspoint_t;
+
+typedef struct
+{
+	pvspoint_t a, b;
+} pvsline_t;
+
+typedef struct
+{
+	pvsline_t line;
+	INT32 leaf; // the subsector it leads into
+} pvsportal_t;
+
+// Part of a partition line, and the subsector it ends up in
+typedef struct
+{
+	double t0, t1;
+	INT32 leaf;
+} pvsspan_t;
+
+typedef struct
+{
+	pvsspan_t *spans;
+	size_t numspans, maxspans;
+} pvsspanlist_t;
+
+// How far a portal has been looked through, from part of a source portal
+typedef struct
+{
+	UINT32 stamp; // which source portal this is for
+	double s0, s1; // along the source portal
+	double t0, t1; // along this portal
+} pvsmemo_t;
+
+typedef struct
+{
+	INT32 leaf;
+	INT32 next; // next portal of leaf to try
+	INT32 pass;
+	double p0, p1; // along pass
+	double s0, s1; // along the source portal
+} pvsframe_t;
+
+// Scratch space for one thread
+typedef struct
+{
+	UINT8 *vis, *dilated;
+	pvsframe_t *stack;
+	pvsmemo_t *memo;
+	INT32 *queue;
+	UINT32 stamp;
+	UINT64 numvisible;
+	INT32 numoverflows;
+} pvsworker_t;
+
+typedef struct
+{
+	job_t job;
+	INT32 leaf;
+} pvsjob_t;
+
+static struct
+{
+	pvsportal_t *portals; // grouped by the subsector they lead out of
+	INT32 *firstportal; // numsubsectors + 1
+	size_t numportals, maxportals;
+	INT32 *portalleaf; // the subsector each portal leads out of
+
+	boolean *loose; // subsectors whose segs don't make a convex shape
+	UINT8 *isolated; // subsectors with no portals
+
+	UINT8 **rows; // compressed, one per subsector
+	size_t *rowlen;
+	size_t rowbytes; // bytes in an uncompressed row
+	UINT64 numvisible; // for the average
+	INT32 numoverflows;
+} pvsbuild;
+
+// One for each of the pool's threads, and one for the main thread
+static pvsworker_t pvsworkers[MAXPVSTHREADS + 1];
+
+static jobpool_t pvspool = JOBPOOL_INIT("pvs-build", MAXPVSTHREADS);
+
+static void R_PVSSegLine(const seg_t *seg, pvsline_t *line)
+{
+	line->a.x = PVSCOORD(seg->v1->x);
+	line->a.y = PVSCOORD(seg->v1->y);
+	line->b.x = PVSCOORD(seg->v2->x);
+	line->b.y = PVSCOORD(seg->v2->y);
+}
+
+static pvspoint_t R_PVSLerp(const pvsline_t *line, double t)
+{
+	pvspoint_t p;
+	p.x = line->a.x + (line->b.x - line->a.x) * t;
+	p.y = line->a.y + (line->b.y - line->a.y) * t;
+	return p;
+}
+
+static double R_PVSLength(const pvsline_t *line)
+{
+	double dx = line->b.x - line->a.x, dy = line->b.y - line->a.y;
+	return sqrt(dx*dx + dy*dy);
+}
+
+// Distance of a point from a line, negative in front like R_PointOnSide
+static double R_PVSDist(const pvsline_t *line, pvspoint_t p)
+{
+	double dx = line->b.x - line->a.x, dy = line->b.y - line->a.y;
+	double len = sqrt(dx*dx + dy*dy);
+
+	if (len < PVSEPSILON)
+		return 0.0;
+
+	return (dx * (p.y - line->a.y) - dy * (p.x - line->a.x)) / len;
+}
+
+// Narrows [*t0, *t1] along line to where keep(t) = k0 + (k1 - k0) * t >= -epsilon.
+// Returns false if nothing is left.
+static boolean R_PVSClipRange(double k0, double k1, double epsilon, double *t0, double *t1)
+{
+	double a = k0 + (k1 - k0) * *t0;
+	double b = k0 + (k1 - k0) * *t1;
+	double n0 = *t0, n1 = *t1;
+
+	if (a < -epsilon && b < -epsilon)
+		return false;
+	if (a < -epsilon)
+		n0 = *t0 + (*t1 - *t0) * (-epsilon - a) / (b - a);
+	else if (b < -epsilon)
+		n1 = *t0 + (*t1 - *t0) * (-epsilon - a) / (b - a);
+
+	*t0 = n0;
+	*t1 = n1;
+	return (*t1 >= *t0);
+}
+
+// Whether a subsector's segs all face into each other, so that it's
+// the convex shape the renderer takes it to be
+static boolean R_PVSIsConvex(const subsector_t *sub)
+{
+	INT32 i, j;
+
+	for (i = 0; i < sub->numlines; i++)
+	{
+		const seg_t *seg = &segs[sub->firstline + i];
+		pvsline_t line;
+
+		if (seg->polyseg)
+			continue;
+
+		R_PVSSegLine(seg, &line);
+		if (R_PVSLength(&line) < PVSEPSILON)
+			continue;
+
+		for (j = 0; j < sub->numlines; j++)
+		{
+			const seg_t *other = &segs[sub->firstline + j];
+			pvspoint_t p;
+
+			if (other->polyseg)
+				continue;
+
+			p.x = PVSCOORD(other->v1->x);
+			p.y = PVSCOORD(other->v1->y);
+			if (R_PVSDist(&line, p) > 2*PVSSEGEPSILON)
+				return false;
+
+			p.x = PVSCOORD(other->v2->x);
+			p.y = PVSCOORD(other->v2->y);
+			if (R_PVSDist(&line, p) > 2*PVSSEGEPSILON)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+// Cuts a line down to the part inside a subsector
+static boolean R_PVSClipToSubsector(INT32 leaf, pvsline_t *line)
+{
+	const subsector_t *sub = &subsectors[leaf];
+	double t0 = 0.0, t1 = 1.0;
+	INT32 i;
+
+	// Can't trust the segs to say where it ends.
+	if (pvsbuild.loose[leaf])
+		return true;
+
+	for (i = 0; i < sub->numlines; i++)
+	{
+		const seg_t *seg = &segs[sub->firstline + i];
+		pvsline_t segline;
+
+		if (seg->polyseg)
+			continue;
+
+		R_PVSSegLine(seg, &segline);
+		if (R_PVSLength(&segline) < PVSEPSILON)
+			continue;
+
+		// The subsector is in front of its segs.
+		if (!R_PVSClipRange(-R_PVSDist(&segline, line->a), -R_PVSDist(&segline, line->b), PVSSEGEPSILON, &t0, &t1))
+			return false;
+	}
+
+	{
+		pvsline_t clipped;
+		clipped.a = R_PVSLerp(line, t0);
+		clipped.b = R_PVSLerp(line, t1);
+		*line = clipped;
+	}
+	return true;
+}
+
+static int R_PVSCompareSpans(const void *a, const void *b)
+{
+	const double sa = ((const pvsspan_t *)a)->t0, sb = ((const pvsspan_t *)b)->t0;
+	return (sa > sb) - (sa < sb);
+}
+
+// Whether a line is entirely covered by the one-sided walls of the
+// subsectors on either side of it
+static boolean R_PVSIsBlocked(const pvsline_t *line, INT32 leaf1, INT32 leaf2)
+{
+	pvsspan_t covers[64];
+	size_t numcovers = 0, i;
+	double len = R_PVSLength(line), covered = 0.0;
+	INT32 leaves[2];
+	INT32 l, j;
+
+	leaves[0] = leaf1;
+	leaves[1] = leaf2;
+
+	for (l = 0; l < 2; l++)
+	{
+		const subsector_t *sub = &subsectors[leaves[l]];
+
+		for (j = 0; j < sub->numlines && numcovers < sizeof (covers) / sizeof (covers[0]); j++)
+		{
+			const seg_t *seg = &segs[sub->firstline + j];
+			pvsline_t segline;
+			double u1, u2;
+
+			if (seg->polyseg || !seg->linedef || seg->backsector)
+				continue;
+
+			R_PVSSegLine(seg, &segline);
+			if (fabs(R_PVSDist(line, segline.a)) > PVSSEGEPSILON || fabs(R_PVSDist(line, segline.b)) > PVSSEGEPSILON)
+				continue;
+
+			u1 = ((segline.a.x - line->a.x) * (line->b.x - line->a.x) + (segline.a.y - line->a.y) * (line->b.y - line->a.y)) / len;
+			u2 = ((segline.b.x - line->a.x) * (line->b.x - line->a.x) + (segline.b.y - line->a.y) * (line->b.y - line->a.y)) / len;
+
+			covers[numcovers].t0 = min(u1, u2);
+			covers[numcovers].t1 = max(u1, u2);
+			numcovers++;
+		}
+	}
+
+	qsort(covers, numcovers, sizeof (covers[0]), R_PVSCompareSpans);
+
+	for (i = 0; i < numcovers; i++)
+	{
+		if (covers[i].t0 > covered + PVSSEGEPSILON)
+			break;
+		covered = max(covered, covers[i].t1);
+	}
+
+	return (covered >= len - PVSSEGEPSILON);
+}
+
+static void R_PVSAddSpan(pvsspanlist_t *list, double t0, double t1, INT32 leaf)
+{
+	if (list->numspans == list->maxspans)
+	{
+		list->maxspans = list->maxspans ? list->maxspans * 2 : 16;
+		list->spans = Z_Realloc(list->spans, list->maxspans * sizeof (*list->spans), PU_STATIC, NULL);
+	}
+
+	list->spans[list->numspans].t0 = t0;
+	list->spans[list->numspans].t1 = t1;
+	list->spans[list->numspans].leaf = leaf;
+	list->numspans++;
+}
+
+// Splits part of a partition line between the subsectors under bspnum.
+// nudge points off the line towards the side bspnum is on, for telling
+// which way parts lying on a child's partition line go.
+static void R_PVSSplitPartition(INT32 bspnum, const pvsline_t *partition, pvspoint_t nudge, double t0, double t1, pvsspanlist_t *list)
+{
+	while (!(bspnum & NF_SUBSECTOR))
+	{
+		const node_t *node = &nodes[bspnum];
+		pvsline_t nodeline;
+		double d0, d1;
+
+		nodeline.a.x = PVSCOORD(node->x);
+		nodeline.a.y = PVSCOORD(node->y);
+		nodeline.b.x = nodeline.a.x + PVSCOORD(node->dx);
+		nodeline.b.y = nodeline.a.y + PVSCOORD(node->dy);
+
+		d0 = R_PVSDist(&nodeline, R_PVSLerp(partition, t0));
+		d1 = R_PVSDist(&nodeline, R_PVSLerp(partition, t1));
+
+		if (fabs(d0) <= PVSEPSILON && fabs(d1) <= PVSEPSILON)
+		{
+			pvspoint_t mid = R_PVSLerp(partition, (t0 + t1) / 2);
+			mid.x += nudge.x;
+			mid.y += nudge.y;
+			bspnum = node->children[R_PVSDist(&nodeline, mid) < 0 ? 0 : 1];
+		}
+		else if (d0 <= PVSEPSILON && d1 <= PVSEPSILON)
+			bspnum = node->children[0];
+		else if (d0 >= -PVSEPSILON && d1 >= -PVSEPSILON)
+			bspnum = node->children[1];
+		else
+		{
+			double tm = t0 + (t1 - t0) * d0 / (d0 - d1);
+
+			if (d0 < 0)
+			{
+				R_PVSSplitPartition(node->children[0], partition, nudge, t0, tm, list);
+				R_PVSSplitPartition(node->children[1], partition, nudge, tm, t1, list);
+			}
+			else
+			{
+				R_PVSSplitPartition(node->children[1], partition, nudge, t0, tm, list);
+				R_PVSSplitPartition(node->children[0], partition, nudge, tm, t1, list);
+			}
+			return;
+		}
+	}
+
+	R_PVSAddSpan(list, t0, t1, (bspnum == -1) ? 0 : (bspnum & ~NF_SUBSECTOR));
+}
+
+static void R_PVSAddPortal(INT32 from, INT32 to, const pvsline_t *line)
+{
+	if (pvsbuild.numportals == pvsbuild.maxportals)
+	{
+		pvsbuild.maxportals = pvsbuild.maxportals ? pvsbuild.maxportals * 2 : 1024;
+		pvsbuild.portals = Z_Realloc(pvsbuild.portals, pvsbuild.maxportals * sizeof (*pvsbuild.portals), PU_STATIC, NULL);
+		pvsbuild.portalleaf = Z_Realloc(pvsbuild.portalleaf, pvsbuild.maxportals * sizeof (*pvsbuild.portalleaf), PU_STATIC, NULL);
+	}
+
+	pvsbuild.portals[pvsbuild.numportals].line = *line;
+	pvsbuild.portals[pvsbuild.numportals].leaf = to;
+	pvsbuild.portalleaf[pvsbuild.numportals] = from;
+	pvsbuild.numportals++;
+}
+
+// Finds the portals on a node's partition line, then those of its children.
+// poly is the convex region the node covers, numpoints long.
+static void R_PVSMakePortals(INT32 bspnum, const pvspoint_t *poly, INT32 numpoints)
+{
+	const node_t *node;
+	pvsline_t partition;
+	pvspoint_t *halves[2];
+	INT32 numhalves[2] = {0, 0};
+	double dist[64+1], *d = dist;
+	double tmin = DBL_MAX, tmax = -DBL_MAX, len2;
+	INT32 i, s;
+
+	if (bspnum & NF_SUBSECTOR)
+		return;
+
+	node = &nodes[bspnum];
+	partition.a.x = PVSCOORD(node->x);
+	partition.a.y = PVSCOORD(node->y);
+	partition.b.x = partition.a.x + PVSCOORD(node->dx);
+	partition.b.y = partition.a.y + PVSCOORD(node->dy);
+	len2 = (partition.b.x - partition.a.x) * (partition.b.x - partition.a.x) + (partition.b.y - partition.a.y) * (partition.b.y - partition.a.y);
+
+	if (numpoints >= (INT32)(sizeof (dist) / sizeof (dist[0])))
+		d = Z_Malloc(numpoints * sizeof (*d), PU_STATIC, NULL);
+
+	for (i = 0; i < numpoints; i++)
+		d[i] = R_PVSDist(&partition, poly[i]);
+
+	halves[0] = Z_Malloc((numpoints + 1) * sizeof (pvspoint_t), PU_STATIC, NULL);
+	halves[1] = Z_Malloc((numpoints + 1) * sizeof (pvspoint_t), PU_STATIC, NULL);
+
+	// Split the region, and find where the partition line crosses it.
+	for (i = 0; i < numpoints; i++)
+	{
+		INT32 j = (i + 1) % numpoints;
+		pvspoint_t p = poly[i];
+
+		if (d[i] <= 0)
+			halves[0][numhalves[0]++] = p;
+		if (d[i] >= 0)
+			halves[1][numhalves[1]++] = p;
+
+		if (fabs(d[i]) <= PVSEPSILON)
+		{
+			double t = ((p.x - partition.a.x) * (partition.b.x - partition.a.x) + (p.y - partition.a.y) * (partition.b.y - partition.a.y)) / len2;
+			tmin = min(tmin, t);
+			tmax = max(tmax, t);
+		}
+
+		if ((d[i] < 0 && d[j] > 0) || (d[i] > 0 && d[j] < 0))
+		{
+			double frac = d[i] / (d[i] - d[j]);
+			double t;
+
+			p.x = poly[i].x + (poly[j].x - poly[i].x) * frac;
+			p.y = poly[i].y + (poly[j].y - poly[i].y) * frac;
+			halves[0][numhalves[0]++] = p;
+			halves[1][numhalves[1]++] = p;
+
+			t = ((p.x - partition.a.x) * (partition.b.x - partition.a.x) + (p.y - partition.a.y) * (partition.b.y - partition.a.y)) / len2;
+			tmin = min(tmin, t);
+			tmax = max(tmax, t);
+		}
+	}
+
+	if (d != dist)
+		Z_Free(d);
+
+	if ((tmax - tmin) * sqrt(len2) > PVSEPSILON)
+	{
+		pvsspanlist_t lists[2];
+		pvspoint_t nudge;
+		size_t f, b;
+		double len = sqrt(len2);
+
+		memset(lists, 0, sizeof (lists));
+
+		// Towards the front, then the back.
+		nudge.x = (partition.b.y - partition.a.y) / len;
+		nudge.y = -(partition.b.x - partition.a.x) / len;
+		R_PVSSplitPartition(node->children[0], &partition, nudge, tmin, tmax, &lists[0]);
+		nudge.x = -nudge.x;
+		nudge.y = -nudge.y;
+		R_PVSSplitPartition(node->children[1], &partition, nudge, tmin, tmax, &lists[1]);
+
+		qsort(lists[1].spans, lists[1].numspans, sizeof (pvsspan_t), R_PVSCompareSpans);
+
+		for (f = 0; f < lists[0].numspans; f++)
+		{
+			const pvsspan_t *front = &lists[0].spans[f];
+
+			for (b = 0; b < lists[1].numspans && lists[1].spans[b].t0 < front->t1; b++)
+			{
+				const pvsspan_t *back = &lists[1].spans[b];
+				double t0 = max(front->t0, back->t0);
+				double t1 = min(front->t1, back->t1);
+				pvsline_t line;
+
+				if ((t1 - t0) * len <= PVSEPSILON || front->leaf == back->leaf)
+					continue;
+
+				line.a = R_PVSLerp(&partition, t0);
+				line.b = R_PVSLerp(&partition, t1);
+
+				if (!R_PVSClipToSubsector(front->leaf, &line) || !R_PVSClipToSubsector(back->leaf, &line))
+					continue;
+				if (R_PVSLength(&line) <= PVSEPSILON || R_PVSIsBlocked(&line, front->leaf, back->leaf))
+					continue;
+
+				R_PVSAddPortal(front->leaf, back->leaf, &line);
+				R_PVSAddPortal(back->leaf, front->leaf, &line);
+			}
+		}
+
+		Z_Free(lists[0].spans);
+		Z_Free(lists[1].spans);
+	}
+
+	for (s = 0; s < 2; s++)
+	{
+		if (numhalves[s] >= 3)
+			R_PVSMakePortals(node->children[s], halves[s], numhalves[s]);
+		Z_Free(halves[s]);
+	}
+}
+
+// Groups the portals by the subsector they lead out of
+static void R_PVSGroupPortals(void)
+{
+	pvsportal_t *grouped = Z_Malloc(max(pvsbuild.numportals, 1) * sizeof (*grouped), PU_STATIC, NULL);
+	INT32 *fill = Z_Calloc((numsubsectors + 1) * sizeof (*fill), PU_STATIC, NULL);
+	size_t i;
+
+	pvsbuild.firstportal = Z_Calloc((numsubsectors + 1) * sizeof (*pvsbuild.firstportal), PU_STATIC, NULL);
+
+	for (i = 0; i < pvsbuild.numportals; i++)
+		pvsbuild.firstportal[pvsbuild.portalleaf[i] + 1]++;
+	for (i = 0; i < numsubsectors; i++)
+		pvsbuild.firstportal[i + 1] += pvsbuild.firstportal[i];
+	for (i = 0; i < pvsbuild.numportals; i++)
+	{
+		INT32 leaf = pvsbuild.portalleaf[i];
+		grouped[pvsbuild.firstportal[leaf] + fill[leaf]++] = pvsbuild.portals[i];
+	}
+
+	Z_Free(fill);
+	Z_Free(pvsbuild.portals);
+	Z_Free(pvsbuild.portalleaf);
+	pvsbuild.portals = grouped;
+	pvsbuild.portalleaf = NULL;
+}
+
+// Narrows target to the part that can be seen from source through pass.
+// In two dimensions, that's the part between the two lines that each run
+// from one end of source to the other end of pass.
+static boolean R_PVSClipToSeparators(
+	const pvsline_t *source, double s0, double s1,
+	const pvsline_t *pass, double p0, double p1,
+	const pvsline_t *target, double *t0, double *t1)
+{
+	pvspoint_t sp[2], pp[2];
+	boolean pointsource;
+	INT32 i, j;
+
+	sp[0] = R_PVSLerp(source, s0);
+	sp[1] = R_PVSLerp(source, s1);
+	pp[0] = R_PVSLerp(pass, p0);
+	pp[1] = R_PVSLerp(pass, p1);
+	pointsource = (fabs(sp[1].x - sp[0].x) + fabs(sp[1].y - sp[0].y) < PVSEPSILON);
+
+	for (i = 0; i < 2; i++)
+	{
+		for (j = 0; j < 2; j++)
+		{
+			pvsline_t sep;
+			double ds, dp;
+
+			sep.a = sp[i];
+			sep.b = pp[j];
+			if (R_PVSLength(&sep) < PVSEPSILON)
+				continue;
+
+			// Only a line with source and pass on opposite sides separates them.
+			ds = R_PVSDist(&sep, sp[i^1]);
+			dp = R_PVSDist(&sep, pp[j^1]);
+			if (fabs(dp) <= PVSEPSILON)
+				continue;
+			if (!pointsource && !((ds < -PVSEPSILON && dp > PVSEPSILON) || (ds > PVSEPSILON && dp < -PVSEPSILON)))
+				continue;
+
+			// Keep the side the rest of pass is on.
+			if (dp > 0)
+			{
+				if (!R_PVSClipRange(R_PVSDist(&sep, target->a), R_PVSDist(&sep, target->b), PVSEPSILON, t0, t1))
+					return false;
+			}
+			else if (!R_PVSClipRange(-R_PVSDist(&sep, target->a), -R_PVSDist(&sep, target->b), PVSEPSILON, t0, t1))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+#define PVSMARK(vis, leaf) ((vis)[(leaf)>>3] |= (1<<((leaf)&7)))
+#define PVSTEST(vis, leaf) ((vis)[(leaf)>>3] & (1<<((leaf)&7)))
+
+// Marks everything leaf is connected to, for when looking through the
+// portals one by one would take too long.
+static void R_PVSFloodFill(pvsworker_t *worker, INT32 leaf)
+{
+	INT32 head = 0, tail = 0;
+
+	memset(worker->vis, 0, pvsbuild.rowbytes);
+	PVSMARK(worker->vis, leaf);
+	worker->queue[tail++] = leaf;
+
+	while (head < tail)
+	{
+		INT32 from = worker->queue[head++];
+		INT32 p;
+
+		for (p = pvsbuild.firstportal[from]; p < pvsbuild.firstportal[from + 1]; p++)
+		{
+			INT32 to = pvsbuild.portals[p].leaf;
+			if (!PVSTEST(worker->vis, to))
+			{
+				PVSMARK(worker->vis, to);
+				worker->queue[tail++] = to;
+			}
+		}
+	}
+}
+
+// Looks through every chain of portals starting at source, marking the
+// subsectors that can be seen through them. Returns false if it took too long.
+static boolean R_PVSFlowThrough(pvsworker_t *worker, INT32 sourceleaf, INT32 source, INT32 *steps)
+{
+	const pvsportal_t *portals = pvsbuild.portals;
+	INT32 neighbor = portals[source].leaf;
+	INT32 sp = 0, p;
+
+	worker->stamp++;
+	PVSMARK(worker->vis, neighbor);
+
+	// Everything on the far side of the neighbor's other portals can be
+	// seen through source, so those are where the chains start.
+	for (p = pvsbuild.firstportal[neighbor]; p < pvsbuild.firstportal[neighbor + 1]; p++)
+	{
+		pvsframe_t *frame;
+
+		if (portals[p].leaf == sourceleaf)
+			continue;
+
+		PVSMARK(worker->vis, portals[p].leaf);
+
+		worker->memo[p].stamp = worker->stamp;
+		worker->memo[p].s0 = worker->memo[p].t0 = 0.0;
+		worker->memo[p].s1 = worker->memo[p].t1 = 1.0;
+
+		frame = &worker->stack[sp++];
+		frame->leaf = portals[p].leaf;
+		frame->next = pvsbuild.firstportal[frame->leaf];
+		frame->pass = p;
+		frame->p0 = frame->s0 = 0.0;
+		frame->p1 = frame->s1 = 1.0;
+
+		while (sp)
+		{
+			pvsframe_t *top = &worker->stack[sp - 1];
+			const pvsportal_t *target;
+			pvsmemo_t *memo;
+			double s0, s1, t0, t1;
+			INT32 t;
+
+			if (top->next == pvsbuild.firstportal[top->leaf + 1])
+			{
+				sp--;
+				continue;
+			}
+
+			t = top->next++;
+			target = &portals[t];
+
+			// Narrow the target to what's visible through the chain so far,
+			// then the source to what can see that.
+			t0 = 0.0;
+			t1 = 1.0;
+			if (!R_PVSClipToSeparators(&portals[source].line, top->s0, top->s1, &portals[top->pass].line, top->p0, top->p1, &target->line, &t0, &t1))
+				continue;
+
+			s0 = top->s0;
+			s1 = top->s1;
+			{
+				pvsline_t narrowed;
+				narrowed.a = R_PVSLerp(&target->line, t0);
+				narrowed.b = R_PVSLerp(&target->line, t1);
+				if (!R_PVSClipToSeparators(&narrowed, 0.0, 1.0, &portals[top->pass].line, top->p0, top->p1, &portals[source].line, &s0, &s1))
+					continue;
+			}
+
+			PVSMARK(worker->vis, target->leaf);
+
+			// If this portal has already been looked through from at least
+			// as much of the source, at least as much of it, there's nothing
+			// new past it. Otherwise, look through the lot of both, which
+			// can only see more, so that this doesn't go on forever.
+			memo = &worker->memo[t];
+			if (memo->stamp == worker->stamp)
+			{
+				if (s0 >= memo->s0 - PVSEPSILON && s1 <= memo->s1 + PVSEPSILON
+					&& t0 >= memo->t0 - PVSEPSILON && t1 <= memo->t1 + PVSEPSILON)
+					continue;
+
+				s0 = min(s0, memo->s0);
+				s1 = max(s1, memo->s1);
+				t0 = min(t0, memo->t0);
+				t1 = max(t1, memo->t1);
+			}
+
+			memo->stamp = worker->stamp;
+			memo->s0 = s0;
+			memo->s1 = s1;
+			memo->t0 = t0;
+			memo->t1 = t1;
+
+			if (++*steps > PVSMAXSTEPS || sp == (INT32)pvsbuild.numportals)
+				return false;
+
+			frame = &worker->stack[sp++];
+			frame->leaf = target->leaf;
+			frame->next = pvsbuild.firstportal[frame->leaf];
+			frame->pass = t;
+			frame->p0 = t0;
+			frame->p1 = t1;
+			frame->s0 = s0;
+			frame->s1 = s1;
+		}
+	}
+
+	return true;
+}
+
+// Builds and compresses the row for one subsector
+static void R_PVSBuildRow(pvsworker_t *worker, INT32 leaf)
+{
+	INT32 steps = 0, p;
+	size_t i, len = 0;
+	UINT8 *row;
+	UINT32 count = 0;
+	boolean flooded = false;
+
+	memset(worker->vis, 0, pvsbuild.rowbytes);
+	PVSMARK(worker->vis, leaf);
+
+	for (p = pvsbuild.firstportal[leaf]; p < pvsbuild.firstportal[leaf + 1]; p++)
+	{
+		if (!R_PVSFlowThrough(worker, leaf, p, &steps))
+		{
+			R_PVSFloodFill(worker, leaf);
+			flooded = true;
+			break;
+		}
+	}
+
+	// Things standing just out of sight can still stick out into it,
+	// so the subsectors next to visible ones are visible too.
+	memcpy(worker->dilated, worker->vis, pvsbuild.rowbytes);
+	for (i = 0; i < numsubsectors; i++)
+	{
+		if (!PVSTEST(worker->vis, i))
+			continue;
+		for (p = pvsbuild.firstportal[i]; p < pvsbuild.firstportal[i + 1]; p++)
+			PVSMARK(worker->dilated, pvsbuild.portals[p].leaf);
+	}
+
+	// A subsector with no portals at all is more likely to be one that
+	// couldn't be worked out than a sealed room, so it sees everything
+	// and everything sees it.
+	if (pvsbuild.firstportal[leaf] == pvsbuild.firstportal[leaf + 1])
+	{
+		memset(worker->dilated, 0xFF, pvsbuild.rowbytes);
+		if (numsubsectors & 7)
+			worker->dilated[pvsbuild.rowbytes - 1] = (1 << (numsubsectors & 7)) - 1;
+	}
+	else
+	{
+		for (i = 0; i < pvsbuild.rowbytes; i++)
+			worker->dilated[i] |= pvsbuild.isolated[i];
+	}
+
+	// Runs of zero bytes are stored as a zero and a count.
+	// Without a row, R_BuildPVS treats the build as cut short.
+	row = malloc(pvsbuild.rowbytes * 2 + 2);
+	if (!row)
+		return;
+	for (i = 0; i < pvsbuild.rowbytes; i++)
+	{
+		UINT8 b = worker->dilated[i];
+		INT32 bit;
+
+		for (bit = 0; bit < 8; bit++)
+			count += (b >> bit) & 1;
+
+		row[len++] = b;
+		if (!b)
+		{
+			UINT8 run = 1;
+			while (i + 1 < pvsbuild.rowbytes && !worker->dilated[i + 1] && run < 255)
+			{
+				run++;
+				i++;
+			}
+			row[len++] = run;
+		}
+	}
+
+	pvsbuild.rowlen[leaf] = len;
+	pvsbuild.rows[leaf] = row;
+
+	worker->numvisible += count;
+	if (flooded)
+		worker->numoverflows++;
+}
+
+static void R_PVSBuildJob(job_t *job, INT32 workernum)
+{
+	pvsworker_t *worker = &pvsworkers[workernum];
+
+	// A thread's scratch space is made by its first job.
+	// Plain malloc, as the zone isn't safe to use off the main thread
+	if (!worker->vis)
+	{
+		worker->vis = malloc(pvsbuild.rowbytes);
+		worker->dilated = malloc(pvsbuild.rowbytes);
+		worker->stack = malloc((pvsbuild.numportals + 1) * sizeof (*worker->stack));
+		worker->memo = calloc(pvsbuild.numportals + 1, sizeof (*worker->memo));
+		worker->queue = malloc(numsubsectors * sizeof (*worker->queue));
+
+		if (!worker->vis || !worker->dilated || !worker->stack || !worker->memo || !worker->queue)
+			I_Error("R_PVSBuildJob: out of memory");
+	}
+
+	R_PVSBuildRow(worker, ((pvsjob_t *)job)->leaf);
+}
+
+// Builds the level's PVS from scratch.
+// Returns the size of pvsdata, or 0 if the build was cut short.
+static size_t R_BuildPVS(void)
+{
+	pvspoint_t box[4];
+	fixed_t bbox[4];
+	size_t i, datasize = 0;
+	UINT8 *data;
+	pvsjob_t *jobs;
+
+	memset(&pvsbuild, 0, sizeof (pvsbuild));
+	pvsbuild.rowbytes = (numsubsectors + 7) / 8;
+
+	pvsbuild.loose = Z_Malloc(numsubsectors * sizeof (*pvsbuild.loose), PU_STATIC, NULL);
+	for (i = 0; i < numsubsectors; i++)
+		pvsbuild.loose[i] = !R_PVSIsConvex(&subsectors[i]);
+
+	// Start with a box around the whole map.
+	M_ClearBox(bbox);
+	for (i = 0; i < numvertexes; i++)
+		M_AddToBox(bbox, vertexes[i].x, vertexes[i].y);
+
+	box[0].x = box[3].x = PVSCOORD(bbox[BOXLEFT]) - 64.0;
+	box[1].x = box[2].x = PVSCOORD(bbox[BOXRIGHT]) + 64.0;
+	box[0].y = box[1].y = PVSCOORD(bbox[BOXBOTTOM]) - 64.0;
+	box[2].y = box[3].y = PVSCOORD(bbox[BOXTOP]) + 64.0;
+
+	R_PVSMakePortals((INT32)numnodes - 1, box, 4);
+	R_PVSGroupPortals();
+
+	pvsbuild.isolated = Z_Calloc(pvsbuild.rowbytes, PU_STATIC, NULL);
+	for (i = 0; i < numsubsectors; i++)
+		if (pvsbuild.firstportal[i] == pvsbuild.firstportal[i + 1])
+			PVSMARK(pvsbuild.isolated, i);
+
+	pvsbuild.rows = Z_Calloc(numsubsectors * sizeof (*pvsbuild.rows), PU_STATIC, NULL);
+	pvsbuild.rowlen = Z_Calloc(numsubsectors * sizeof (*pvsbuild.rowlen), PU_STATIC, NULL);
+
+	memset(pvsworkers, 0, sizeof (pvsworkers));
+	jobs = Z_Malloc(max(numsubsectors, 1) * sizeof (*jobs), PU_STATIC, NULL);
+	for (i = 0; i < numsubsectors; i++)
+	{
+		jobs[i].leaf = (INT32)i;
+		I_queue_job(&pvspool, &jobs[i].job, R_PVSBuildJob);
+	}
+
+	I_finish_jobs(&pvspool);
+	Z_Free(jobs);
+
+	for (i = 0; i <= MAXPVSTHREADS; i++)
+	{
+		pvsworker_t *worker = &pvsworkers[i];
+
+		pvsbuild.numvisible += worker->numvisible;
+		pvsbuild.numoverflows += worker->numoverflows;
+
+		free(worker->vis);
+		free(worker->dilated);
+		free(worker->stack);
+		free(worker->memo);
+		free(worker->queue);
+	}
+
+	for (i = 0; i < numsubsectors; i++)
+	{
+		// A row that couldn't be allocated cuts the build short.
+		if (!pvsbuild.rows[i])
+			break;
+		datasize += pvsbuild.rowlen[i];
+	}
+
+	if (i < numsubsectors)
+		datasize = 0;
+	else
+	{
+		Z_Malloc(numsubsectors * sizeof (*pvsrowofs), PU_LEVEL, &pvsrowofs);
+		data = Z_Malloc(max(datasize, 1), PU_LEVEL, &pvsdata);
+
+		for (i = 0, datasize = 0; i < numsubsectors; i++)
+		{
+			pvsrowofs[i] = (UINT32)datasize;
+			M_Memcpy(data + datasize, pvsbuild.rows[i], pvsbuild.rowlen[i]);
+			datasize += pvsbuild.rowlen[i];
+		}
+	}
+
+	for (i = 0; i < numsubsectors; i++)
+		free(pvsbuild.rows[i]);
+
+	Z_Free(pvsbuild.rows);
+	Z_Free(pvsbuild.rowlen);
+	Z_Free(pvsbuild.portals);
+	Z_Free(pvsbuild.firstportal);
+	Z_Free(pvsbuild.loose);
+	Z_Free(pvsbuild.isolated);
+
+	return datasize;
+}
+
+// ==========================================================================
+//                                                          CACHE FILES
+// ==========================================================================
+
+// Changes if the level's BSP is built differently, even with the same MD5
+static UINT32 R_PVSGeometryHash(void)
+{
+	UINT32 hash = 2166136261u;
+	size_t i;
+
+#define HASHVALUE(v) hash = (hash ^ (UINT32)(v)) * 16777619u
+
+	HASHVALUE(numnodes);
+	HASHVALUE(numsubsectors);
+	HASHVALUE(numsegs);
+
+	for (i = 0; i < numnodes; i++)
+	{
+		HASHVALUE(nodes[i].x);
+		HASHVALUE(nodes[i].y);
+		HASHVALUE(nodes[i].dx);
+		HASHVALUE(nodes[i].dy);
+		HASHVALUE(nodes[i].children[0]);
+		HASHVALUE(nodes[i].children[1]);
+	}
+
+	for (i = 0; i < numsubsectors; i++)
+	{
+		HASHVALUE(subsectors[i].firstline);
+		HASHVALUE(subsectors[i].numlines);
+	}
+
+	// Polyobjects have been moved to their spawn points.
+	for (i = 0; i < numsegs; i++)
+	{
+		if (segs[i].polyseg)
+			continue;
+		HASHVALUE(segs[i].v1->x);
+		HASHVALUE(segs[i].v1->y);
+		HASHVALUE(segs[i].v2->x);
+		HASHVALUE(segs[i].v2->y);
+	}
+
+#undef HASHVALUE
+
+	return hash;
+}
+
+static const char *R_PVSFileName(void)
+{
+	char md5[33];
+	INT32 i;
+
+	for (i = 0; i < 16; i++)
+		sprintf(&md5[i*2], "%02x", mapmd5[i]);
+
+	return va("%s"PATHSEP"pvs"PATHSEP"%s.pvs", srb2home, md5);
+}
+
+#define PVSHEADERSIZE (4 + 4*4)
+
+// Checks that a row read from a file decodes to exactly rowbytes bytes
+// without running off the end of the data.
+static boolean R_PVSRowIsValid(const UINT8 *data, size_t datasize, size_t ofs, size_t rowbytes)
+{
+	size_t out = 0;
+
+	while (out < rowbytes)
+	{
+		if (ofs >= datasize)
+			return false;
+
+		if (data[ofs])
+		{
+			ofs++;
+			out++;
+		}
+		else
+		{
+			if (ofs + 1 >= datasize || !data[ofs + 1])
+				return false;
+			out += data[ofs + 1];
+			ofs += 2;
+		}
+	}
+
+	return out == rowbytes;
+}
+
+static boolean R_ReadPVSFile(void)
+{
+	UINT8 *buffer, *p;
+	size_t length = FIL_ReadFile(R_PVSFileName(), &buffer);
+	size_t datasize;
+
+	if (!length)
+		return false;
+
+	p = buffer;
+	if (length < PVSHEADERSIZE + numsubsectors * 4 || memcmp(p, PVSMAGIC, 4))
+	{
+		Z_Free(buffer);
+		return false;
+	}
+	p += 4;
+
+	if (READUINT32(p) != PVSVERSION
+		|| READUINT32(p) != numsubsectors
+		|| READUINT32(p) != numnodes
+		|| READUINT32(p) != R_PVSGeometryHash())
+	{
+		Z_Free(buffer);
+		return false;
+	}
+
+	datasize = length - PVSHEADERSIZE - numsubsectors * 4;
+
+	Z_Malloc(numsubsectors * sizeof (*pvsrowofs), PU_LEVEL, &pvsrowofs);
+	Z_Malloc(max(datasize, 1), PU_LEVEL, &pvsdata);
+
+	{
+		size_t i;
+		const UINT8 *data = p + numsubsectors * 4;
+
+		for (i = 0; i < numsubsectors; i++)
+		{
+			pvsrowofs[i] = READUINT32(p);
+			if (!R_PVSRowIsValid(data, datasize, pvsrowofs[i], (numsubsectors + 7) / 8))
+			{
+				Z_Free(pvsrowofs);
+				Z_Free(pvsdata);
+				Z_Free(buffer);
+				return false;
+			}
+		}
+	}
+	M_Memcpy(pvsdata, p, datasize);
+
+	Z_Free(buffer);
+	return true;
+}
+
+static void R_WritePVSFile(size_t datasize)
+{
+	size_t length = PVSHEADERSIZE + numsubsectors * 4 + datasize;
+	UINT8 *buffer = Z_Malloc(length, PU_STATIC, NULL);
+	UINT8 *p = buffer;
+	size_t i;
+
+	M_Memcpy(p, PVSMAGIC, 4);
+	p += 4;
+	WRITEUINT32(p, PVSVERSION);
+	WRITEUINT32(p, numsubsectors);
+	WRITEUINT32(p, numnodes);
+	WRITEUINT32(p, R_PVSGeometryHash());
+
+	for (i = 0; i < numsubsectors; i++)
+		WRITEUINT32(p, pvsrowofs[i]);
+	M_Memcpy(p, pvsdata, datasize);
+
+	I_mkdir(va("%s"PATHSEP"pvs", srb2home), 0755);
+	if (!FIL_WriteFile(R_PVSFileName(), buffer, length))
+		CONS_Alert(CONS_WARNING, M_GetText("Couldn't save the PVS to %s\n"), R_PVSFileName());
+
+	Z_Free(buffer);
+}
+
+// ==========================================================================
+//                                                             -buildpvs
+// ==========================================================================
+
+static struct
+{
+	INT16 maps[NUMMAPS];
+	INT32 nummaps;
+	INT32 current;
+	boolean built; // the current map's PVS has been built
+} pvsqueue;
+
+void R_QueuePVSBuild(INT16 map)
+{
+	if (pvsqueue.nummaps < NUMMAPS)
+		pvsqueue.maps[pvsqueue.nummaps++] = map;
+}
+
+INT16 R_FirstPVSBuild(void)
+{
+	return pvsqueue.nummaps ? pvsqueue.maps[0] : 0;
+}
+
+/** Moves -buildpvs on to the next map once the current one's PVS has been
+  * built, and quits after the last. Called every tic.
+  */
+void R_BuildPVSTicker(void)
+{
+	if (!pvsqueue.built)
+		return;
+
+	pvsqueue.built = false;
+
+	if (++pvsqueue.current < pvsqueue.nummaps)
+		D_MapChange(pvsqueue.maps[pvsqueue.current], gametype, false, true, 0, false, false);
+	else
+		I_Quit();
+}
+
+// ==========================================================================
+//                                                              LOADING
+// ==========================================================================
+
+static void R_PVSSetParents(INT32 bspnum, INT32 parent)
+{
+	while (!(bspnum & NF_SUBSECTOR))
+	{
+		pvsparents[bspnum] = parent;
+		R_PVSSetParents(nodes[bspnum].children[1], bspnum);
+		parent = bspnum;
+		bspnum = nodes[bspnum].children[0];
+	}
+
+	pvsparents[numnodes + (bspnum & ~NF_SUBSECTOR)] = parent;
+}
+
+/** Gets the level's PVS ready, if r_pvs is on or -buildpvs is running.
+  * It's read from srb2home if it was saved there before, and built and
+  * saved if not. Called by P_LoadLevel once polyobjects are spawned.
+  */
+void R_LoadLevelPVS(void)
+{
+	boolean building = (pvsqueue.current < pvsqueue.nummaps && gamemap == pvsqueue.maps[pvsqueue.current]);
+	precise_t start;
+	size_t datasize;
+
+	pvsactive = false;
+
+	// -buildpvs moves on to the next map whether or not this one worked out.
+	if (building)
+		pvsqueue.built = true;
+
+	if ((!cv_pvs.value && !building) || dedicated || !numnodes)
+		return;
+
+	Z_Malloc((numnodes + numsubsectors) * sizeof (*pvsparents), PU_LEVEL, &pvsparents);
+	R_PVSSetParents((INT32)numnodes - 1, -1);
+
+	Z_Malloc((numsubsectors + 7) / 8, PU_LEVEL, &pvsleafvis);
+	Z_Malloc((numnodes + 7) / 8, PU_LEVEL, &pvsnodevis);
+
+	if (!building && R_ReadPVSFile())
+		return;
+
+	start = I_GetPreciseTime();
+	datasize = R_BuildPVS();
+	if (!datasize)
+		return;
+
+	R_WritePVSFile(datasize);
+
+	CONS_Printf(M_GetText("Built the PVS for %s: %s subsectors, %u%% visible on average, %d flooded, in %u ms\n"),
+		G_BuildMapName(gamemap), sizeu1(numsubsectors),
+		(UINT32)(pvsbuild.numvisible * 100 / ((UINT64)numsubsectors * numsubsectors)),
+		pvsbuild.numoverflows, (UINT32)((I_GetPreciseTime() - start) * 1000 / I_GetPrecisePrecision()));
+}
+
+/** Sets up culling for a view at (x, y), or turns it off if the view isn't
+  * inside a subsector, where there's no telling what it can see.
+  * Subsectors with polyobjects in them are always visible, as polyobjects
+  * are only drawn from the one their center is in.
+  *
+  * \return Whether the PVS will be used.
+  */
+boolean R_SetupPVS(fixed_t x, fixed_t y)
+{
+	subsector_t *viewsub;
+	const UINT8 *in;
+	size_t out = 0, rowbytes = (numsubsectors + 7) / 8, i;
+	INT32 po;
+
+	pvsactive = false;
+
+	if (!cv_pvs.value || !pvsdata || !pvsleafvis || !pvsnodevis || !pvsparents)
+		return false;
+
+	viewsub = R_PointInSubsectorOrNull(x, y);
+	if (!viewsub)
+		return false;
+
+	in = pvsdata + pvsrowofs[viewsub - subsectors];
+	while (out < rowbytes)
+	{
+		if (*in)
+			pvsleafvis[out++] = *in++;
+		else
+		{
+			size_t run = in[1];
+			in += 2;
+			memset(pvsleafvis + out, 0, min(run, rowbytes - out));
+			out += run;
+		}
+	}
+
+	for (po = 0; po < numPolyObjects; po++)
+	{
+		if (!PolyObjects[po].isBad)
+		{
+			size_t leaf = R_PointInSubsector(PolyObjects[po].centerPt.x, PolyObjects[po].centerPt.y) - subsectors;
+			PVSMARK(pvsleafvis, leaf);
+		}
+	}
+
+	// A node is visible if anything under it is.
+	memset(pvsnodevis, 0, (numnodes + 7) / 8);
+	for (i = 0; i < numsubsectors; i++)
+	{
+		INT32 node;
+
+		if (!pvsleafvis[i>>3])
+		{
+			i |= 7;
+			continue;
+		}
+		if (!PVSTEST(pvsleafvis, i))
+			continue;
+
+		for (node = pvsparents[numnodes + i]; node != -1 && !PVSTEST(pvsnodevis, node); node = pvsparents[node])
+			PVSMARK(pvsnodevis, node);
+	}
+
+	pvsactive = true;
+	return true;
+}
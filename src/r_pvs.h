@@ -0,0 +1,37 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_pvs.h
+/// \brief Potentially visible sets, for culling the BSP before clipping.
+
+#ifndef __R_PVS__
+#define __R_PVS__
+
+#include "doomtype.h"
+#include "m_fixed.h"
+
+// Set by R_SetupPVS for the view being rendered
+extern boolean pvsactive;
+extern UINT8 *pvsleafvis; // one bit per subsector
+extern UINT8 *pvsnodevis; // one bit per node with a potentially visible subsector under it
+
+#define R_NodeInPVS(num) (!pvsactive || (pvsnodevis[(num)>>3] & (1<<((num)&7))))
+#define R_SubsectorInPVS(num) (!pvsactive || (pvsleafvis[(num)>>3] & (1<<((num)&7))))
+
+// Load the level's PVS from its cache file, or build it, if r_pvs is on
+void R_LoadLevelPVS(void);
+
+// Cull with the PVS of the subsector a view is in, if it's inside one
+boolean R_SetupPVS(fixed_t x, fixed_t y);
+
+// -buildpvs: build and save the PVS of each map in turn, then quit
+void R_QueuePVSBuild(INT16 map);
+INT16 R_FirstPVSBuild(void);
+void R_BuildPVSTicker(void);
+
+#endif
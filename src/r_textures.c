@@ -27,6 +27,7 @@
 #include "p_setup.h" // levelflats
 #include "byteptr.h"
 #include "dehacked.h"
+#include "i_jobpool.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_glob.h" // HWR_LoadMapTextures
@@ -247,165 +248,180 @@ static inline void R_DrawBlendFlippedColumnInCache(column_t *patch, UINT8 *cache
 }
 
 //
-// R_GenerateTexture
+// TEXTURE GENERATION
+// Generating a texture is done in three steps, so that level textures can be
+//  composited by worker threads. The zone and the lump cache are not
+//  thread-safe, so preparing a texture (caching its patches, allocating its
+//  block) and publishing it into texturecache are done on the main thread;
+//  compositing only writes to the texture's own block.
 //
-// Allocate space for full size texture, either single patch or 'composite'
-// Build the full textures from patches.
-// The texture caching system is a little more hungry of memory, but has
-// been simplified for the sake of highcolor (lol), dynamic ligthing, & speed.
+
+typedef struct
+{
+	void *lump; // the patch's lump, locked as PU_STATIC until published
+	softwarepatch_t *realpatch; // the lump itself, or its conversion to a Doom patch
+} texturepatchref_t;
+
+typedef struct
+{
+	job_t job; // for precaching
+	size_t texnum;
+	UINT8 *block; // PU_STATIC, and without a user until published
+	size_t blocksize;
+	boolean holey; // stored as the patch itself, posts and all
+	texturepatchref_t *patches; // one for each of the texture's patches
+	boolean done; // composited
+} texturejob_t;
+
 //
-// This is not optimised, but it's supposed to be executed only once
-// per level, when enough memory is available.
+// R_IsPatchHoley
+// Checks a single patch for holes.
 //
-UINT8 *R_GenerateTexture(size_t texnum)
+static boolean R_IsPatchHoley(texture_t *texture, softwarepatch_t *realpatch)
+{
+	UINT8 *colofs = (UINT8 *)realpatch->columnofs;
+	int x;
+
+	if (texture->width > SHORT(realpatch->width) || texture->height > SHORT(realpatch->height))
+		return true;
+
+	for (x = 0; x < texture->width; x++)
+	{
+		column_t *col = (column_t *)((UINT8 *)realpatch + LONG(*(UINT32 *)&colofs[x<<2]));
+		INT32 topdelta, prevdelta = -1, y = 0;
+		while (col->topdelta != 0xff)
+		{
+			topdelta = col->topdelta;
+			if (topdelta <= prevdelta)
+				topdelta += prevdelta;
+			prevdelta = topdelta;
+			if (topdelta > y)
+				break;
+			y = topdelta + col->length + 1;
+			col = (column_t *)((UINT8 *)col + col->length + 4);
+		}
+		if (y < texture->height)
+			return true; // this texture is HOLEy! D:
+	}
+
+	return false;
+}
+
+//
+// R_PrepareTexture
+// Caches a texture's patches and allocates its block. Main thread only.
+//
+static void R_PrepareTexture(size_t texnum, texturejob_t *job)
 {
-	UINT8 *block;
-	UINT8 *blocktex;
 	texture_t *texture;
 	texpatch_t *patch;
-	softwarepatch_t *realpatch;
-	UINT8 *pdata;
-	int x, x1, x2, i, width, height;
-	size_t blocksize;
-	column_t *patchcol;
-	UINT8 *colofs;
-
-	UINT16 wadnum;
-	lumpnum_t lumpnum;
 	size_t lumplength;
+	INT32 i;
 
 	I_Assert(texnum <= (size_t)numtextures);
 	texture = textures[texnum];
 	I_Assert(texture != NULL);
 
-	// allocate texture column offset lookup
+	job->texnum = texnum;
+	job->done = false;
+	job->patches = Z_Malloc(max(texture->patchcount, 1) * sizeof (*job->patches), PU_STATIC, NULL);
 
-	// single-patch textures can have holes in them and may be used on
-	// 2sided lines so they need to be kept in 'packed' format
-	// BUT this is wrong for skies and walls with over 255 pixels,
-	// so check if there's holes and if not strip the posts.
-	if (texture->patchcount == 1)
+	for (i = 0, patch = texture->patches; i < texture->patchcount; i++, patch++)
 	{
-		boolean holey = false;
-		patch = texture->patches;
+		texturepatchref_t *ref = &job->patches[i];
 
-		wadnum = patch->wad;
-		lumpnum = patch->lump;
-		lumplength = W_LumpLengthPwad(wadnum, lumpnum);
-		pdata = W_CacheLumpNumPwad(wadnum, lumpnum, PU_CACHE);
-		realpatch = (softwarepatch_t *)pdata;
+		lumplength = W_LumpLengthPwad(patch->wad, patch->lump);
+		ref->lump = W_CacheLumpNumPwad(patch->wad, patch->lump, PU_STATIC);
+		ref->realpatch = (softwarepatch_t *)ref->lump;
 
 #ifndef NO_PNG_LUMPS
-		if (Picture_IsLumpPNG((UINT8 *)realpatch, lumplength))
-			goto multipatch;
+		if (Picture_IsLumpPNG((UINT8 *)ref->lump, lumplength))
+			ref->realpatch = (softwarepatch_t *)Picture_PNGConvert((UINT8 *)ref->lump, PICFMT_DOOMPATCH, NULL, NULL, NULL, NULL, lumplength, NULL, 0);
+		else
 #endif
 #ifdef WALLFLATS
 		if (texture->type == TEXTURETYPE_FLAT)
-			goto multipatch;
+			ref->realpatch = (softwarepatch_t *)Picture_Convert(PICFMT_FLAT, ref->lump, PICFMT_DOOMPATCH, 0, NULL, texture->width, texture->height, 0, 0, 0);
+		else
 #endif
+			(void)lumplength;
+	}
 
-		// Check the patch for holes.
-		if (texture->width > SHORT(realpatch->width) || texture->height > SHORT(realpatch->height))
-			holey = true;
-		colofs = (UINT8 *)realpatch->columnofs;
-		for (x = 0; x < texture->width && !holey; x++)
-		{
-			column_t *col = (column_t *)((UINT8 *)realpatch + LONG(*(UINT32 *)&colofs[x<<2]));
-			INT32 topdelta, prevdelta = -1, y = 0;
-			while (col->topdelta != 0xff)
-			{
-				topdelta = col->topdelta;
-				if (topdelta <= prevdelta)
-					topdelta += prevdelta;
-				prevdelta = topdelta;
-				if (topdelta > y)
-					break;
-				y = topdelta + col->length + 1;
-				col = (column_t *)((UINT8 *)col + col->length + 4);
-			}
-			if (y < texture->height)
-				holey = true; // this texture is HOLEy! D:
-		}
+	// single-patch textures can have holes in them and may be used on
+	// 2sided lines so they need to be kept in 'packed' format
+	// BUT this is wrong for skies and walls with over 255 pixels,
+	// so check if there's holes and if not strip the posts.
+	// PNGs and flats are converted, so they're always done in multipatch format.
+	job->holey = (texture->patchcount == 1
+		&& job->patches[0].realpatch == job->patches[0].lump
+		&& R_IsPatchHoley(texture, job->patches[0].realpatch));
+
+	// If the patch uses transparency, we have to save it this way.
+	if (job->holey)
+	{
+		job->blocksize = W_LumpLengthPwad(texture->patches[0].wad, texture->patches[0].lump);
+		job->block = Z_Malloc(job->blocksize, PU_STATIC, NULL);
+	}
+	else
+	{
+		// Otherwise, do multipatch format.
+		job->blocksize = (texture->width * 4) + (texture->width * texture->height);
+		job->block = Z_Malloc(job->blocksize+1, PU_STATIC, NULL);
+	}
+}
+
+//
+// R_CompositeTexture
+// Builds the full texture from its patches.
+// Only touches the texture's block, so this is safe to run on any thread.
+//
+static void R_CompositeTexture(texturejob_t *job)
+{
+	texture_t *texture = textures[job->texnum];
+	UINT8 *block = job->block;
+	texpatch_t *patch;
+	softwarepatch_t *realpatch;
+	int x, x1, x2, i, width, height;
+	column_t *patchcol;
+	UINT8 *colofs;
+
+	if (job->holey)
+	{
+		realpatch = job->patches[0].realpatch;
+		patch = texture->patches;
+		M_Memcpy(block, realpatch, job->blocksize);
 
-		// If the patch uses transparency, we have to save it this way.
-		if (holey)
+		// use the patch's column lookup
+		colofs = (block + 8);
+		if (patch->flip & 1) // flip the patch horizontally
 		{
-			texture->holes = true;
-			texture->flip = patch->flip;
-			blocksize = lumplength;
-			block = Z_Calloc(blocksize, PU_STATIC, // will change tag at end of this function
-				&texturecache[texnum]);
-			M_Memcpy(block, realpatch, blocksize);
-			texturememory += blocksize;
-
-			// use the patch's column lookup
-			colofs = (block + 8);
-			texturecolumnofs[texnum] = (UINT32 *)colofs;
-			blocktex = block;
-			if (patch->flip & 1) // flip the patch horizontally
-			{
-				UINT8 *realcolofs = (UINT8 *)realpatch->columnofs;
-				for (x = 0; x < texture->width; x++)
-					*(UINT32 *)&colofs[x<<2] = realcolofs[( texture->width-1-x )<<2]; // swap with the offset of the other side of the texture
-			}
-			// we can't as easily flip the patch vertically sadly though,
-			//  we have wait until the texture itself is drawn to do that
+			UINT8 *realcolofs = (UINT8 *)realpatch->columnofs;
 			for (x = 0; x < texture->width; x++)
-				*(UINT32 *)&colofs[x<<2] = LONG(LONG(*(UINT32 *)&colofs[x<<2]) + 3);
-			goto done;
+				*(UINT32 *)&colofs[x<<2] = realcolofs[( texture->width-1-x )<<2]; // swap with the offset of the other side of the texture
 		}
-
-		// Otherwise, do multipatch format.
+		// we can't as easily flip the patch vertically sadly though,
+		//  we have wait until the texture itself is drawn to do that
+		for (x = 0; x < texture->width; x++)
+			*(UINT32 *)&colofs[x<<2] = LONG(LONG(*(UINT32 *)&colofs[x<<2]) + 3);
+		return;
 	}
 
 	// multi-patch textures (or 'composite')
-	multipatch:
-	texture->holes = false;
-	texture->flip = 0;
-	blocksize = (texture->width * 4) + (texture->width * texture->height);
-	texturememory += blocksize;
-	block = Z_Malloc(blocksize+1, PU_STATIC, &texturecache[texnum]);
-
-	memset(block, TRANSPARENTPIXEL, blocksize+1); // Transparency hack
+	memset(block, TRANSPARENTPIXEL, job->blocksize+1); // Transparency hack
 
 	// columns lookup table
 	colofs = block;
-	texturecolumnofs[texnum] = (UINT32 *)colofs;
-
-	// texture data after the lookup table
-	blocktex = block + (texture->width*4);
 
 	// Composite the columns together.
 	for (i = 0, patch = texture->patches; i < texture->patchcount; i++, patch++)
 	{
-		boolean dealloc = true;
-		static void (*ColumnDrawerPointer)(column_t *, UINT8 *, texpatch_t *, INT32, INT32); // Column drawing function pointer.
+		void (*ColumnDrawerPointer)(column_t *, UINT8 *, texpatch_t *, INT32, INT32); // Column drawing function pointer.
 		if (patch->style != AST_COPY)
 			ColumnDrawerPointer = (patch->flip & 2) ? R_DrawBlendFlippedColumnInCache : R_DrawBlendColumnInCache;
 		else
 			ColumnDrawerPointer = (patch->flip & 2) ? R_DrawFlippedColumnInCache : R_DrawColumnInCache;
 
-		wadnum = patch->wad;
-		lumpnum = patch->lump;
-		pdata = W_CacheLumpNumPwad(wadnum, lumpnum, PU_CACHE);
-		lumplength = W_LumpLengthPwad(wadnum, lumpnum);
-		realpatch = (softwarepatch_t *)pdata;
-		dealloc = true;
-
-#ifndef NO_PNG_LUMPS
-		if (Picture_IsLumpPNG((UINT8 *)realpatch, lumplength))
-			realpatch = (softwarepatch_t *)Picture_PNGConvert((UINT8 *)realpatch, PICFMT_DOOMPATCH, NULL, NULL, NULL, NULL, lumplength, NULL, 0);
-		else
-#endif
-#ifdef WALLFLATS
-		if (texture->type == TEXTURETYPE_FLAT)
-			realpatch = (softwarepatch_t *)Picture_Convert(PICFMT_FLAT, pdata, PICFMT_DOOMPATCH, 0, NULL, texture->width, texture->height, 0, 0, 0);
-		else
-#endif
-		{
-			(void)lumplength;
-			dealloc = false;
-		}
+		realpatch = job->patches[i].realpatch;
 
 		x1 = patch->originx;
 		width = SHORT(realpatch->width);
@@ -413,18 +429,10 @@ UINT8 *R_GenerateTexture(size_t texnum)
 		x2 = x1 + width;
 
 		if (x1 > texture->width || x2 < 0)
-		{
-			if (dealloc)
-				Z_Free(realpatch);
 			continue; // patch not located within texture's x bounds, ignore
-		}
 
 		if (patch->originy > texture->height || (patch->originy + height) < 0)
-		{
-			if (dealloc)
-				Z_Free(realpatch);
 			continue; // patch not located within texture's y bounds, ignore
-		}
 
 		// patch is actually inside the texture!
 		// now check if texture is partly off-screen and adjust accordingly
@@ -450,15 +458,172 @@ UINT8 *R_GenerateTexture(size_t texnum)
 			*(UINT32 *)&colofs[x<<2] = LONG((x * texture->height) + (texture->width*4));
 			ColumnDrawerPointer(patchcol, block + LONG(*(UINT32 *)&colofs[x<<2]), patch, texture->height, height);
 		}
+	}
+}
+
+//
+// R_PublishTexture
+// Releases a texture's patches and puts its block in texturecache.
+// Main thread only. Returns NULL if the texture never got composited.
+//
+static UINT8 *R_PublishTexture(texturejob_t *job)
+{
+	texture_t *texture = textures[job->texnum];
+	INT32 i;
+
+	for (i = 0; i < texture->patchcount; i++)
+	{
+		texturepatchref_t *ref = &job->patches[i];
+		if (ref->realpatch != ref->lump)
+			Z_Free(ref->realpatch);
+		Z_ChangeTag(ref->lump, PU_CACHE);
+	}
+	Z_Free(job->patches);
 
-		if (dealloc)
-			Z_Free(realpatch);
+	if (!job->done)
+	{
+		Z_Free(job->block);
+		return NULL;
+	}
+
+	texturememory += job->blocksize;
+
+	if (job->holey)
+	{
+		texture->holes = true;
+		texture->flip = texture->patches[0].flip;
+		texturecolumnofs[job->texnum] = (UINT32 *)(job->block + 8);
+	}
+	else
+	{
+		texture->holes = false;
+		texture->flip = 0;
+		texturecolumnofs[job->texnum] = (UINT32 *)job->block;
 	}
 
-done:
 	// Now that the texture has been built in column cache, it is purgable from zone memory.
-	Z_ChangeTag(block, PU_CACHE);
-	return blocktex;
+	Z_SetUser(job->block, (void **)&texturecache[job->texnum]);
+	Z_ChangeTag(job->block, PU_CACHE);
+
+	// texture data after the lookup table
+	return texture->holes ? job->block : job->block + (texture->width*4);
+}
+
+//
+// R_GenerateTexture
+//
+// Allocate space for full size texture, either single patch or 'composite'
+// Build the full textures from patches.
+// The texture caching system is a little more hungry of memory, but has
+// been simplified for the sake of highcolor (lol), dynamic ligthing, & speed.
+//
+// This is not optimised, but it's supposed to be executed only once
+// per level, when enough memory is available.
+//
+UINT8 *R_GenerateTexture(size_t texnum)
+{
+	texturejob_t job;
+
+	// The texture may be one that's being precached.
+	R_FinishTexturePrecache();
+	if (texturecache[texnum])
+		return textures[texnum]->holes ? texturecache[texnum] : texturecache[texnum] + (textures[texnum]->width*4);
+
+	R_PrepareTexture(texnum, &job);
+	R_CompositeTexture(&job);
+	job.done = true;
+	return R_PublishTexture(&job);
+}
+
+//
+// TEXTURE PRECACHING
+// A level's textures are prepared up front, then composited by worker
+//  threads while the rest of the level loads. They're published all at
+//  once, by the first R_GenerateTexture or R_FinishTexturePrecache call.
+//
+
+static struct
+{
+	texturejob_t *jobs; // NULL when nothing is in flight
+	size_t numjobs;
+} texprecache;
+
+static jobpool_t texprecachepool = JOBPOOL_INIT("texture-precache", 8);
+
+static void R_TexturePrecacheJob(job_t *job, INT32 worker)
+{
+	texturejob_t *texjob = (texturejob_t *)job;
+
+	(void)worker;
+
+	R_CompositeTexture(texjob);
+	texjob->done = true;
+}
+
+/** Waits for the textures being precached, if any, and puts them in the
+  * texture cache. Anything that generates, frees or reallocates textures
+  * calls this first.
+  *
+  * \sa R_PrecacheTextures
+  */
+void R_FinishTexturePrecache(void)
+{
+	size_t i;
+
+	if (!texprecache.jobs)
+		return;
+
+	// Help out with whatever the workers haven't gotten to yet.
+	I_finish_jobs(&texprecachepool);
+
+	for (i = 0; i < texprecache.numjobs; i++)
+		R_PublishTexture(&texprecache.jobs[i]);
+
+	Z_Free(texprecache.jobs);
+	texprecache.jobs = NULL;
+	texprecache.numjobs = 0;
+}
+
+/** Starts generating a list of textures in the background, on as many
+  * worker threads as there are cores. Textures that are already cached
+  * are skipped.
+  *
+  * \param texnums Textures to precache, with no duplicates.
+  * \param count Number of textures in the list.
+  * \sa R_FinishTexturePrecache
+  */
+void R_PrecacheTextures(const INT32 *texnums, size_t count)
+{
+	texturejob_t *jobs;
+	size_t i, numjobs = 0;
+
+	// One batch at a time.
+	R_FinishTexturePrecache();
+
+	if (!count)
+		return;
+
+	jobs = Z_Malloc(count * sizeof (*jobs), PU_STATIC, NULL);
+
+	for (i = 0; i < count; i++)
+	{
+		if (texnums[i] < 0 || texnums[i] >= numtextures || texturecache[texnums[i]])
+			continue;
+
+		R_PrepareTexture((size_t)texnums[i], &jobs[numjobs++]);
+	}
+
+	if (!numjobs)
+	{
+		Z_Free(jobs);
+		return;
+	}
+
+	texprecache.jobs = jobs;
+	texprecache.numjobs = numjobs;
+
+	for (i = 0; i < numjobs; i++)
+		I_queue_job(&texprecachepool, &jobs[i].job, R_TexturePrecacheJob);
 }
 
 //
@@ -720,6 +885,8 @@ void R_FlushTextureCache(void)
 {
 	INT32 i;
 
+	R_FinishTexturePrecache();
+
 	if (numtextures)
 		for (i = 0; i < numtextures; i++)
 			Z_Free(texturecache[i]);
@@ -753,6 +920,9 @@ Rloadflats (INT32 i, INT32 w)
 
 	if (!( texstart == INT16_MAX || texend == INT16_MAX ))
 	{
+		// Every lump is about to be read, so decompress them all up front.
+		W_PrefetchLumpRangePwad((UINT16)w, texstart, texend);
+
 		// Work through each lump between the markers in the WAD.
 		for (j = 0; j < (texend - texstart); j++)
 		{
@@ -781,12 +951,13 @@ Rloadflats (INT32 i, INT32 w)
 #ifndef NO_PNG_LUMPS
 			if (Picture_IsLumpPNG(header, lumplength))
 			{
-				UINT8 *flatlump = W_CacheLumpNumPwad(wadnum, lumpnum, PU_CACHE);
+				void *copy;
+				const UINT8 *flatlump = W_MapLumpNumPwad(wadnum, lumpnum, &copy);
 				INT32 width, height;
-				Picture_PNGDimensions((UINT8 *)flatlump, &width, &height, NULL, NULL, lumplength);
+				Picture_PNGDimensions(flatlump, &width, &height, NULL, NULL, lumplength);
 				texture->width = (INT16)width;
 				texture->height = (INT16)height;
-				Z_Free(flatlump);
+				Z_Free(copy);
 			}
 			else
 #endif
@@ -809,6 +980,8 @@ Rloadflats (INT32 i, INT32 w)
 			textureheight[i] = texture->height << FRACBITS;
 			i++;
 		}
+
+		W_FlushPrefetchedLumps();
 	}
 
 	return i;
@@ -850,6 +1023,9 @@ Rloadtextures (INT32 i, INT32 w)
 
 	if (!( texstart == INT16_MAX || texend == INT16_MAX ))
 	{
+		// Every lump is about to be read, so decompress them all up front.
+		W_PrefetchLumpRangePwad((UINT16)w, texstart, texend);
+
 		// Work through each lump between the markers in the WAD.
 		for (j = 0; j < (texend - texstart); j++)
 		{
@@ -880,12 +1056,13 @@ Rloadtextures (INT32 i, INT32 w)
 #ifndef NO_PNG_LUMPS
 			if (Picture_IsLumpPNG((UINT8 *)&patchlump, lumplength))
 			{
-				UINT8 *png = W_CacheLumpNumPwad(wadnum, lumpnum, PU_CACHE);
+				void *copy;
+				const UINT8 *png = W_MapLumpNumPwad(wadnum, lumpnum, &copy);
 				INT32 width, height;
 				Picture_PNGDimensions(png, &width, &height, NULL, NULL, lumplength);
 				texture->width = (INT16)width;
 				texture->height = (INT16)height;
-				Z_Free(png);
+				Z_Free(copy);
 			}
 			else
 #endif
@@ -911,6 +1088,8 @@ Rloadtextures (INT32 i, INT32 w)
 			textureheight[i] = texture->height << FRACBITS;
 			i++;
 		}
+
+		W_FlushPrefetchedLumps();
 	}
 
 	return i;
@@ -1012,6 +1191,9 @@ static void R_AllocateTextures(INT32 add)
 
 	INT32 i;
 
+	// The workers read from textures, which is about to move.
+	R_FinishTexturePrecache();
+
 	// Allocate memory and initialize to 0 for all the textures we are initialising.
 	recallocuser(&textures, oldsize, newsize);
 
@@ -87,6 +87,10 @@ INT32 R_GetTextureNum(INT32 texnum);
 void R_CheckTextureCache(INT32 tex);
 void R_ClearTextureNumCache(boolean btell);
 
+// Background texture generation, for level precaching
+void R_PrecacheTextures(const INT32 *texnums, size_t count);
+void R_FinishTexturePrecache(void);
+
 // Retrieve texture data.
 void *R_GetLevelFlat(levelflat_t *levelflat);
 UINT8 *R_GetColumn(fixed_t tex, INT32 col);
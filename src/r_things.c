@@ -20,6 +20,7 @@
 #include "z_zone.h"
 #include "m_menu.h" // character select
 #include "m_misc.h"
+#include "m_random.h"
 #include "info.h" // spr2names
 #include "i_video.h" // rendermode
 #include "i_system.h"
@@ -309,16 +310,17 @@ boolean R_AddSingleSpriteDef(const char *sprname, spritedef_t *spritedef, UINT16
 
 #ifndef NO_PNG_LUMPS
 			{
-				softwarepatch_t *png = W_CacheLumpNumPwad(wadnum, l, PU_STATIC);
+				void *copy;
+				const UINT8 *png = W_MapLumpNumPwad(wadnum, l, &copy);
 				size_t len = W_LumpLengthPwad(wadnum, l);
 
-				if (Picture_IsLumpPNG((UINT8 *)png, len))
+				if (Picture_IsLumpPNG(png, len))
 				{
-					Picture_PNGDimensions((UINT8 *)png, &width, &height, &topoffset, &leftoffset, len);
+					Picture_PNGDimensions(png, &width, &height, &topoffset, &leftoffset, len);
 					isPNG = true;
 				}
 
-				Z_Free(png);
+				Z_Free(copy);
 			}
 
 			if (!isPNG)
@@ -688,7 +690,7 @@ void R_DrawMaskedColumn(column_t *column)
 			// FIXTHIS: Figure out what "something more proper" is and do it.
 			// quick fix... something more proper should be done!!!
 			if (ylookup[dc_yl])
-				colfunc();
+				R_RunColumnDrawer(colfunc);
 #ifdef PARANOIA
 			else
 				I_Error("R_DrawMaskedColumn: Invalid ylookup for dc_yl %d", dc_yl);
@@ -752,7 +754,7 @@ void R_DrawFlippedMaskedColumn(column_t *column)
 
 			// Still drawn by R_DrawColumn.
 			if (ylookup[dc_yl])
-				colfunc();
+				R_RunColumnDrawer(colfunc);
 #ifdef PARANOIA
 			else
 				I_Error("R_DrawMaskedColumn: Invalid ylookup for dc_yl %d", dc_yl);
@@ -891,6 +893,19 @@ static void R_DrawVisSprite(vissprite_t *vis)
 	if (!dc_colormap)
 		dc_colormap = colormaps;
 
+	// Draw translated sprites with the translation fused into the colormap,
+	// so that it's one lookup per pixel rather than two.
+	if (dc_translation && (colfunc == colfuncs[COLDRAWFUNC_TRANS] || colfunc == colfuncs[COLDRAWFUNC_TRANSTRANS]))
+	{
+		UINT8 *fused = R_GetFusedColormap(dc_colormap, dc_translation);
+
+		if (fused)
+		{
+			colfunc = colfuncs[(colfunc == colfuncs[COLDRAWFUNC_TRANS]) ? BASEDRAWFUNC : COLDRAWFUNC_FUZZY];
+			dc_colormap = fused;
+		}
+	}
+
 	dc_texturemid = vis->texturemid;
 	dc_texheight = 0;
 
@@ -1794,7 +1809,7 @@ static void R_ProjectSprite(mobj_t *thing)
 			rollangle = R_GetRollAngle(spriterotangle);
 		}
 
-		rotsprite = Patch_GetRotatedSprite(sprframe, (thing->frame & FF_FRAMEMASK), rot, flip, false, sprinfo, rollangle);
+		rotsprite = Patch_RequestRotatedSprite(sprframe, (thing->frame & FF_FRAMEMASK), rot, flip, false, sprinfo, rollangle);
 
 		if (rotsprite != NULL)
 		{
@@ -2609,17 +2624,92 @@ static boolean R_SortVisSpriteFunc(vissprite_t *ds, fixed_t bestscale, INT32 bes
 	return false;
 }
 
+// Merges two lists sorted by R_SortVisSpriteFunc, linked through next.
+// Sprites from a go first when they tie, which keeps the sort stable.
+static vissprite_t *R_MergeVisSprites(vissprite_t *a, vissprite_t *b)
+{
+	vissprite_t *merged = NULL;
+	vissprite_t **tail = &merged;
+
+	while (a && b)
+	{
+		if (R_SortVisSpriteFunc(b, a->sortscale, a->dispoffset) == true)
+		{
+			*tail = b;
+			b = b->next;
+		}
+		else
+		{
+			*tail = a;
+			a = a->next;
+		}
+		tail = &(*tail)->next;
+	}
+
+	*tail = a ? a : b;
+	return merged;
+}
+
+/** Moves every sprite in unsorted over to vsprsortedhead, farthest first.
+  * Sprites at the same scale and dispoffset keep their order. This is a
+  * bottom-up merge sort: runs[i] holds a sorted run of 2^i sprites, all
+  * of them from before the ones in runs[i-1].
+  *
+  * \param unsorted Head of a circular list of sprites.
+  * \param vsprsortedhead Head of the circular list to move them into.
+  */
+static void R_SortVisSpriteList(vissprite_t *unsorted, vissprite_t *vsprsortedhead)
+{
+	vissprite_t *runs[32] = {NULL};
+	vissprite_t *ds, *dsnext, *run;
+	size_t i;
+
+	for (ds = unsorted->next; ds != unsorted; ds = dsnext)
+	{
+#ifdef PARANOIA
+		if (ds->cut & SC_LINKDRAW)
+			I_Error("R_SortVisSprites: no link or discardal made for linkdraw!");
+#endif
+
+		dsnext = ds->next;
+		ds->next = NULL;
+
+		run = ds;
+		for (i = 0; runs[i]; i++)
+		{
+			run = R_MergeVisSprites(runs[i], run);
+			runs[i] = NULL;
+		}
+		runs[i] = run;
+	}
+
+	run = NULL;
+	for (i = 0; i < sizeof (runs) / sizeof (runs[0]); i++)
+		if (runs[i])
+			run = R_MergeVisSprites(runs[i], run);
+
+	unsorted->next = unsorted->prev = unsorted;
+
+	// Put the prev links back, and close the list
+	vsprsortedhead->next = vsprsortedhead->prev = vsprsortedhead;
+	for (ds = run; ds; ds = dsnext)
+	{
+		dsnext = ds->next;
+		ds->next = vsprsortedhead;
+		ds->prev = vsprsortedhead->prev;
+		vsprsortedhead->prev->next = ds;
+		vsprsortedhead->prev = ds;
+	}
+}
+
 //
 // R_SortVisSprites
 //
 static void R_SortVisSprites(vissprite_t* vsprsortedhead, UINT32 start, UINT32 end)
 {
-	UINT32       i, linkedvissprites = 0;
+	UINT32       i;
 	vissprite_t *ds, *dsprev, *dsnext, *dsfirst;
-	vissprite_t *best = NULL;
 	vissprite_t  unsorted;
-	fixed_t      bestscale;
-	INT32        bestdispoffset;
 
 	unsorted.next = unsorted.prev = &unsorted;
 
@@ -2706,8 +2796,6 @@ static void R_SortVisSprites(vissprite_t* vsprsortedhead, UINT32 start, UINT32 e
 		if (ds->cut & SC_NOTVISIBLE)
 			continue;
 
-		linkedvissprites++;
-
 		if (dsfirst != &unsorted)
 		{
 			if (!(ds->cut & SC_FULLBRIGHT))
@@ -2739,17 +2827,23 @@ static void R_SortVisSprites(vissprite_t* vsprsortedhead, UINT32 start, UINT32 e
 	}
 
 	// pull the vissprites out by scale
+	R_SortVisSpriteList(&unsorted, vsprsortedhead);
+}
+
+// The selection sort R_SortVisSpriteList replaced, for spritesortbench
+static void R_SelectionSortVisSpriteList(vissprite_t *unsorted, vissprite_t *vsprsortedhead)
+{
+	vissprite_t *ds, *best;
+	fixed_t bestscale;
+	INT32 bestdispoffset;
+
 	vsprsortedhead->next = vsprsortedhead->prev = vsprsortedhead;
-	for (i = start; i < end-linkedvissprites; i++)
+	while (unsorted->next != unsorted)
 	{
+		best = NULL;
 		bestscale = bestdispoffset = INT32_MAX;
-		for (ds = unsorted.next; ds != &unsorted; ds = ds->next)
+		for (ds = unsorted->next; ds != unsorted; ds = ds->next)
 		{
-#ifdef PARANOIA
-			if (ds->cut & SC_LINKDRAW)
-				I_Error("R_SortVisSprites: no link or discardal made for linkdraw!");
-#endif
-
 			if (R_SortVisSpriteFunc(ds, bestscale, bestdispoffset) == true)
 			{
 				bestscale = ds->sortscale;
@@ -2757,16 +2851,91 @@ static void R_SortVisSprites(vissprite_t* vsprsortedhead, UINT32 start, UINT32 e
 				best = ds;
 			}
 		}
-		if (best)
-		{
-			best->next->prev = best->prev;
-			best->prev->next = best->next;
-			best->next = vsprsortedhead;
-			best->prev = vsprsortedhead->prev;
-			vsprsortedhead->prev->next = best;
-			vsprsortedhead->prev = best;
-		}
+		if (!best)
+			break;
+
+		best->next->prev = best->prev;
+		best->prev->next = best->next;
+		best->next = vsprsortedhead;
+		best->prev = vsprsortedhead->prev;
+		vsprsortedhead->prev->next = best;
+		vsprsortedhead->prev = best;
+	}
+}
+
+static void R_LinkBenchVisSprites(vissprite_t *unsorted, UINT32 count)
+{
+	UINT32 i;
+
+	unsorted->next = unsorted->prev = unsorted;
+	for (i = 0; i < count; i++)
+	{
+		vissprite_t *ds = R_GetVisSprite(i);
+		ds->next = unsorted;
+		ds->prev = unsorted->prev;
+		unsorted->prev->next = ds;
+		unsorted->prev = ds;
+	}
+}
+
+/** Sorts a made up scene of vissprites with both R_SortVisSpriteList and
+  * the selection sort it replaced, times them, and checks that they agree.
+  * Runs between frames, so it can reuse this frame's vissprites.
+  */
+void Command_Spritesortbench_f(void)
+{
+	UINT32 count = 5000, i;
+	vissprite_t unsorted, sorted, *ds;
+	vissprite_t **order;
+	precise_t mergetime, selectiontime;
+	UINT32 mismatches = 0;
+	double mspertick = 1000.0 / I_GetPrecisePrecision();
+
+	if (COM_Argc() > 2)
+	{
+		CONS_Printf(M_GetText("spritesortbench [sprites]: time the vissprite sort\n"));
+		return;
+	}
+
+	if (COM_Argc() == 2)
+		count = atoi(COM_Argv(1));
+	count = min(max(count, 1), MAXVISSPRITES);
+
+	// Plenty of sprites at the same distance, like rows of rings
+	for (i = 0; i < count; i++)
+	{
+		ds = R_GetVisSprite(i);
+		ds->sortscale = (M_RandomKey(256) + 1) * (FRACUNIT/64);
+		ds->dispoffset = M_RandomRange(-2, 2);
+		ds->cut = SC_NONE;
+		ds->linkdraw = NULL;
 	}
+
+	order = Z_Malloc(count * sizeof (*order), PU_STATIC, NULL);
+
+	R_LinkBenchVisSprites(&unsorted, count);
+	mergetime = I_GetPreciseTime();
+	R_SortVisSpriteList(&unsorted, &sorted);
+	mergetime = I_GetPreciseTime() - mergetime;
+
+	for (i = 0, ds = sorted.next; ds != &sorted; ds = ds->next)
+		order[i++] = ds;
+
+	R_LinkBenchVisSprites(&unsorted, count);
+	selectiontime = I_GetPreciseTime();
+	R_SelectionSortVisSpriteList(&unsorted, &sorted);
+	selectiontime = I_GetPreciseTime() - selectiontime;
+
+	for (i = 0, ds = sorted.next; ds != &sorted; ds = ds->next, i++)
+		if (i >= count || order[i] != ds)
+			mismatches++;
+
+	Z_Free(order);
+
+	CONS_Printf(M_GetText("%u sprites: %.3f ms merge sort, %.3f ms selection sort\n"), count,
+		mergetime * mspertick, selectiontime * mspertick);
+	if (mismatches)
+		CONS_Alert(CONS_WARNING, M_GetText("%u sprites were sorted differently\n"), mismatches);
 }
 
 //
@@ -3130,7 +3299,10 @@ static void R_DrawSprite(vissprite_t *spr)
 	mceilingclip = spr->cliptop;
 
 	if (spr->cut & SC_BBOX)
+	{
+		R_FlushDrawQueue(); // draws straight to the screen
 		R_DrawThingBoundingBox(spr);
+	}
 	else if (spr->cut & SC_SPLAT)
 		R_DrawFloorSplat(spr);
 	else
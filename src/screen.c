@@ -72,6 +72,8 @@ consvar_t cv_scr_depth = CVAR_INIT ("scr_depth", "16 bits", CV_SAVE, scr_depth_c
 
 consvar_t cv_renderview = CVAR_INIT ("renderview", "On", 0, CV_OnOff, NULL);
 
+consvar_t cv_simddrawers = CVAR_INIT ("r_simd", "On", CV_SAVE|CV_CALL|CV_NOINIT, CV_OnOff, SCR_SetDrawFuncs);
+
 CV_PossibleValue_t cv_renderer_t[] = {
 	{1, "Software"},
 #ifdef HWRENDER
@@ -105,6 +107,7 @@ boolean R_SSE = false;
 boolean R_3DNow = false;
 boolean R_MMXExt = false;
 boolean R_SSE2 = false;
+boolean R_AVX2 = false;
 
 void SCR_SetDrawFuncs(void)
 {
@@ -164,6 +167,35 @@ void SCR_SetDrawFuncs(void)
 		spanfuncs_npo2[SPANDRAWFUNC_WATER] = R_DrawWaterSpan_NPO2_8;
 		spanfuncs_npo2[SPANDRAWFUNC_TILTEDWATER] = R_DrawTiltedWaterSpan_NPO2_8;
 
+		// Vectorized versions of the busiest drawers, if the CPU has them
+		if (cv_simddrawers.value)
+		{
+#if defined (SIMDDRAWERS_X86)
+			if (R_AVX2)
+			{
+				spanfuncs[BASEDRAWFUNC] = R_DrawSpan_8_AVX2;
+				spanfuncs[SPANDRAWFUNC_TRANS] = R_DrawTranslucentSpan_8_AVX2;
+				spanfuncs[SPANDRAWFUNC_TILTED] = R_DrawTiltedSpan_8_AVX2;
+				colfuncs[COLDRAWFUNC_FUZZY] = R_DrawTranslucentColumn_8_AVX2;
+				colfuncs[COLDRAWFUNC_TRANS] = R_DrawTranslatedColumn_8_AVX2;
+			}
+			else if (R_SSE2)
+			{
+				spanfuncs[BASEDRAWFUNC] = R_DrawSpan_8_SSE2;
+				spanfuncs[SPANDRAWFUNC_TRANS] = R_DrawTranslucentSpan_8_SSE2;
+				spanfuncs[SPANDRAWFUNC_TILTED] = R_DrawTiltedSpan_8_SSE2;
+				colfuncs[COLDRAWFUNC_FUZZY] = R_DrawTranslucentColumn_8_SSE2;
+				colfuncs[COLDRAWFUNC_TRANS] = R_DrawTranslatedColumn_8_SSE2;
+			}
+#elif defined (SIMDDRAWERS_NEON)
+			spanfuncs[BASEDRAWFUNC] = R_DrawSpan_8_NEON;
+			spanfuncs[SPANDRAWFUNC_TRANS] = R_DrawTranslucentSpan_8_NEON;
+			spanfuncs[SPANDRAWFUNC_TILTED] = R_DrawTiltedSpan_8_NEON;
+			colfuncs[COLDRAWFUNC_FUZZY] = R_DrawTranslucentColumn_8_NEON;
+			colfuncs[COLDRAWFUNC_TRANS] = R_DrawTranslatedColumn_8_NEON;
+#endif
+			spanfunc = spanfuncs[BASEDRAWFUNC];
+		}
 	}
 /*	else if (vid.bpp > 1)
 	{
@@ -243,7 +275,9 @@ void SCR_Startup(void)
 			R_SSE = true;
 		if (RCpuInfo->SSE2)
 			R_SSE2 = true;
-		CONS_Printf("CPU Info: 486: %i, 586: %i, MMX: %i, 3DNow: %i, MMXExt: %i, SSE2: %i\n", R_486, R_586, R_MMX, R_3DNow, R_MMXExt, R_SSE2);
+		if (RCpuInfo->AVX2)
+			R_AVX2 = true;
+		CONS_Printf("CPU Info: 486: %i, 586: %i, MMX: %i, 3DNow: %i, MMXExt: %i, SSE2: %i, AVX2: %i\n", R_486, R_586, R_MMX, R_3DNow, R_MMXExt, R_SSE2, R_AVX2);
 	}
 
 	if (M_CheckParm("-486"))
@@ -264,6 +298,8 @@ void SCR_Startup(void)
 
 	if (M_CheckParm("-SSE2"))
 		R_SSE2 = true;
+	if (M_CheckParm("-noAVX2"))
+		R_AVX2 = false;
 
 	M_SetupMemcpy();
 
@@ -281,6 +317,7 @@ void SCR_Startup(void)
 
 	CV_RegisterVar(&cv_ticrate);
 	CV_RegisterVar(&cv_constextsize);
+	CV_RegisterVar(&cv_simddrawers);
 
 	V_SetPalette(0);
 }
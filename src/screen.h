@@ -182,6 +182,7 @@ extern boolean R_MMX;
 extern boolean R_3DNow;
 extern boolean R_MMXExt;
 extern boolean R_SSE2;
+extern boolean R_AVX2;
 
 // ----------------
 // screen variables
@@ -201,6 +202,7 @@ extern UINT8 *scr_borderpatch; // patch used to fill the view borders
 
 extern consvar_t cv_scr_width, cv_scr_height, cv_scr_width_w, cv_scr_height_w, cv_scr_depth, cv_fullscreen;
 extern consvar_t cv_renderview, cv_renderer;
+extern consvar_t cv_simddrawers;
 extern consvar_t cv_renderhitbox, cv_renderhitboxinterpolation, cv_renderhitboxgldepth;
 // wait for page flipping to end or not
 extern consvar_t cv_vidwait;
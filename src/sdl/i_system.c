@@ -2208,6 +2208,11 @@ UINT64 I_GetPrecisePrecision(void)
 	return SDL_GetPerformanceFrequency();
 }
 
+INT32 I_GetCPUCount(void)
+{
+	return max(SDL_GetCPUCount(), 1);
+}
+
 static UINT32 frame_rate;
 
 static double frame_frequency;
@@ -3180,6 +3185,7 @@ const CPUInfoFlags *I_CPUInfo(void)
 	}
 	WIN_CPUInfo.MMXExt      = SDL_FALSE; //SDL_HasMMXExt(); No longer in SDL2
 	WIN_CPUInfo.AMD3DNowExt = SDL_FALSE; //SDL_Has3DNowExt(); No longer in SDL2
+	WIN_CPUInfo.AVX2        = SDL_HasAVX2(); // IsProcessorFeaturePresent can't tell
 #endif
 	GetSystemInfo(&SI);
 	WIN_CPUInfo.CPUs = SI.dwNumberOfProcessors;
@@ -3197,6 +3203,7 @@ const CPUInfoFlags *I_CPUInfo(void)
 	SDL_CPUInfo.SSE         = SDL_HasSSE();
 	SDL_CPUInfo.SSE2        = SDL_HasSSE2();
 	SDL_CPUInfo.AltiVec     = SDL_HasAltiVec();
+	SDL_CPUInfo.AVX2        = SDL_HasAVX2();
 	return &SDL_CPUInfo;
 #else
 	return NULL; /// \todo CPUID asm
@@ -1795,6 +1795,13 @@ void I_StartupGraphics(void)
 
 	keyboard_started = true;
 
+	// -renderbench and -buildpvs don't need a window, just the Software renderer
+	if (M_CheckParm("-renderbench") || M_CheckParm("-buildpvs"))
+	{
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+		chosenrendermode = render_soft;
+	}
+
 #if !defined(HAVE_TTF)
 	// Previously audio was init here for questionable reasons?
 	if (SDL_InitSubSystem(SDL_INIT_VIDEO) < 0)
@@ -26,6 +26,7 @@
 #define _FILE_OFFSET_BITS 0
 #endif
 
+#define ZLIB_CONST // compressed lumps can be inflated straight from the mapping
 #include <zlib.h>
 #endif
 
@@ -33,6 +34,13 @@
 #include <unistd.h>
 #endif
 
+#include <sys/stat.h>
+
+#if defined (UNIXCOMMON) || defined (__APPLE__)
+#include <sys/mman.h>
+#define HAVE_MMAP
+#endif
+
 #define ZWAD
 
 #ifdef ZWAD
@@ -58,9 +66,12 @@
 #include "r_data.h"
 #include "r_textures.h"
 #include "r_patch.h"
+#include "r_patchrotation.h" // RotatedPatch_IsRotating
 #include "r_picformats.h"
 #include "i_time.h"
 #include "i_system.h"
+#include "i_jobpool.h"
+#include "command.h"
 #include "i_video.h" // rendermode
 #include "md5.h"
 #include "lua_script.h"
@@ -68,6 +79,8 @@
 #include "p_setup.h" // P_ScanThings
 #endif
 #include "m_misc.h" // M_MapNumber
+#include "m_argv.h" // M_CheckParm
+#include "m_trace.h"
 #include "g_game.h" // G_SetGameModified
 
 #ifdef HWRENDER
@@ -102,12 +115,142 @@ typedef struct lumpnum_cache_s
 static lumpnum_cache_t lumpnumcache[LUMPNUMCACHESIZE];
 static UINT16 lumpnumcacheindex = 0;
 
+static void W_FinishPrefetch(void);
+
 //===========================================================================
 //                                                                    GLOBALS
 //===========================================================================
 UINT16 numwadfiles; // number of active wadfiles
 wadfile_t **wadfiles; // 0 to numwadfiles-1 are valid
 
+// W_MapWadFile
+// Memory-maps an opened file, so that lumps can be read without going
+// through stdio, or without being copied at all. Failing is harmless;
+// everything falls back to reading through the file handle.
+static void W_MapWadFile(wadfile_t *wadfile)
+{
+	wadfile->mapping = NULL;
+
+#ifdef HAVE_MMAP
+	if (!wadfile->handle || !wadfile->filesize || M_CheckParm("-nommap"))
+		return;
+
+	{
+		void *mapping = mmap(NULL, wadfile->filesize, PROT_READ, MAP_PRIVATE, fileno(wadfile->handle), 0);
+		if (mapping == MAP_FAILED)
+		{
+			CONS_Debug(DBG_SETUP, "Could not memory-map %s, reading it normally\n", wadfile->filename);
+			return;
+		}
+		wadfile->mapping = mapping;
+	}
+#endif
+}
+
+static void W_UnmapWadFile(wadfile_t *wadfile)
+{
+#ifdef HAVE_MMAP
+	if (wadfile->mapping)
+		munmap(wadfile->mapping, wadfile->filesize);
+#endif
+	wadfile->mapping = NULL;
+}
+
+static UINT32 W_LumpNameHash(const lumpinfo_t *lump)
+{
+	return lump->hash;
+}
+
+static UINT32 W_LumpLongNameHash(const lumpinfo_t *lump)
+{
+	return quickncasehash(lump->longname, strlen(lump->longname));
+}
+
+static UINT32 W_LumpFullNameHash(const lumpinfo_t *lump)
+{
+	return quickncasehash(lump->fullname, strlen(lump->fullname));
+}
+
+// W_BuildLumpIndex
+// Chains every lump of a wad by the given hash. The chains are built
+// back to front, so each one lists its lumps in ascending order.
+static void W_BuildLumpIndex(lumpindex_t *index, const wadfile_t *wadfile, UINT32 (*hashfunc)(const lumpinfo_t *))
+{
+	UINT32 numbuckets = 1;
+	UINT16 i;
+
+	while (numbuckets < wadfile->numlumps)
+		numbuckets <<= 1;
+
+	index->mask = numbuckets - 1;
+	index->buckets = Z_Malloc((numbuckets + wadfile->numlumps) * sizeof (*index->buckets), PU_STATIC, NULL);
+	index->next = index->buckets + numbuckets;
+	memset(index->buckets, 0xff, numbuckets * sizeof (*index->buckets)); // LUMPINDEXEND
+
+	for (i = wadfile->numlumps; i-- > 0;)
+	{
+		UINT16 *bucket = &index->buckets[hashfunc(&wadfile->lumpinfo[i]) & index->mask];
+		index->next[i] = *bucket;
+		*bucket = i;
+	}
+}
+
+static int W_CompareFullNames(const void *a, const void *b)
+{
+	return stricmp((*(const lumpinfo_t * const *)a)->fullname, (*(const lumpinfo_t * const *)b)->fullname);
+}
+
+// W_FindExtendedFullNames
+// Marks every lump whose fullname is the start of another, longer one.
+// W_CheckNumForFullNamePK3 matches by prefix, so only an exact match
+// that isn't marked is sure to be the first match in the directory.
+static void W_FindExtendedFullNames(wadfile_t *wadfile)
+{
+	lumpinfo_t **sorted;
+	UINT16 i, j, k;
+
+	wadfile->fullnameextended = Z_Calloc(wadfile->numlumps, PU_STATIC, NULL);
+	if (!wadfile->numlumps)
+		return;
+
+	sorted = Z_Malloc(wadfile->numlumps * sizeof (*sorted), PU_STATIC, NULL);
+	for (i = 0; i < wadfile->numlumps; i++)
+		sorted[i] = &wadfile->lumpinfo[i];
+	qsort(sorted, wadfile->numlumps, sizeof (*sorted), W_CompareFullNames);
+
+	// Names that start with another one sort right after it and its duplicates.
+	for (i = 0; i < wadfile->numlumps; i = j)
+	{
+		for (j = i + 1; j < wadfile->numlumps && !stricmp(sorted[i]->fullname, sorted[j]->fullname); j++)
+			;
+
+		if (j < wadfile->numlumps
+			&& !strnicmp(sorted[i]->fullname, sorted[j]->fullname, strlen(sorted[i]->fullname)))
+		{
+			for (k = i; k < j; k++)
+				wadfile->fullnameextended[sorted[k] - wadfile->lumpinfo] = 1;
+		}
+	}
+
+	Z_Free(sorted);
+}
+
+static void W_BuildLumpIndexes(wadfile_t *wadfile)
+{
+	W_BuildLumpIndex(&wadfile->nameindex, wadfile, W_LumpNameHash);
+	W_BuildLumpIndex(&wadfile->longnameindex, wadfile, W_LumpLongNameHash);
+	W_BuildLumpIndex(&wadfile->fullnameindex, wadfile, W_LumpFullNameHash);
+	W_FindExtendedFullNames(wadfile);
+}
+
+static void W_FreeLumpIndexes(wadfile_t *wadfile)
+{
+	Z_Free(wadfile->nameindex.buckets);
+	Z_Free(wadfile->longnameindex.buckets);
+	Z_Free(wadfile->fullnameindex.buckets);
+	Z_Free(wadfile->fullnameextended);
+}
+
 // W_Shutdown
 // Closes all of the WAD files before quitting
 // If not done on a Mac then open wad files
@@ -115,10 +258,15 @@ wadfile_t **wadfiles; // 0 to numwadfiles-1 are valid
 // being ejected
 void W_Shutdown(void)
 {
+	W_FinishPrefetch();
+	W_SaveFileMD5s();
+
 	while (numwadfiles--)
 	{
 		wadfile_t *wad = wadfiles[numwadfiles];
 
+		W_UnmapWadFile(wad);
+		W_FreeLumpIndexes(wad);
 		if (wad->handle)
 			fclose(wad->handle);
 		Z_Free(wad->filename);
@@ -296,7 +444,300 @@ static void W_LoadDehackedLumps(UINT16 wadnum, boolean mainfile)
 #endif
 }
 
+#ifndef NOMD5
+#define MD5_LEN 16
+
+/**
+  * Prints an MD5 string into a human-readable textual format.
+  *
+  * \param md5 The md5 in binary form -- MD5_LEN (16) bytes.
+  * \param buf Where to print the textual form. Needs 2*MD5_LEN+1 (33) bytes.
+  * \author Graue <graue@oceanbase.org>
+  */
+#define MD5_FORMAT \
+	"%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x"
+static void PrintMD5String(const UINT8 *md5, char *buf)
+{
+	snprintf(buf, 2*MD5_LEN+1, MD5_FORMAT,
+		md5[0], md5[1], md5[2], md5[3],
+		md5[4], md5[5], md5[6], md5[7],
+		md5[8], md5[9], md5[10], md5[11],
+		md5[12], md5[13], md5[14], md5[15]);
+}
+
+// ==========================================================================
+//                                                       FILE MD5 FINGERPRINTS
+// ==========================================================================
+
+// Hashing every file on every launch is slow with big addons, so the MD5 of
+// each file is remembered in srb2home, along with its size and modification
+// time. A file whose size and time haven't changed isn't hashed again.
+
+#define MD5CACHEFILE "md5cache.txt"
+
+typedef struct md5cache_s
+{
+	char *path;
+	unsigned long size;
+	long mtime;
+	UINT8 md5sum[16];
+	struct md5cache_s *next;
+} md5cache_t;
+
+static md5cache_t *md5cache;
+static boolean md5cacheloaded, md5cachedirty;
+
+// A file being hashed in the background
+typedef struct
+{
+	job_t job;
+	char *path;
+	unsigned long size;
+	long mtime;
+	UINT8 md5sum[16];
+	boolean ok;
+} md5job_t;
+
+static struct
+{
+	md5job_t *jobs; // NULL when nothing is being hashed
+	size_t numjobs;
+} md5batch;
+
+static jobpool_t md5pool = JOBPOOL_INIT("md5-hash", 8);
+
+static boolean W_StatFile(const char *filename, unsigned long *size, long *mtime)
+{
+	struct stat st;
+
+	if (stat(filename, &st) < 0)
+		return false;
+
+	*size = (unsigned long)st.st_size;
+	*mtime = (long)st.st_mtime;
+	return true;
+}
+
+static void W_LoadMD5Cache(void)
+{
+	FILE *f;
+	char line[MAX_WADPATH + 64];
+
+	md5cacheloaded = true;
+
+	f = fopen(va("%s"PATHSEP"%s", srb2home, MD5CACHEFILE), "r");
+	if (!f)
+		return;
+
+	while (fgets(line, sizeof line, f))
+	{
+		char md5text[2*MD5_LEN + 1];
+		unsigned long size;
+		long mtime;
+		int pathpos = 0;
+		md5cache_t *entry;
+		size_t len;
+		INT32 i;
+
+		if (sscanf(line, "%32s %lu %ld %n", md5text, &size, &mtime, &pathpos) < 3 || !pathpos
+			|| strlen(md5text) != 2*MD5_LEN)
+			continue;
+
+		len = strcspn(&line[pathpos], "\r\n");
+		if (!len)
+			continue;
+
+		entry = Z_Malloc(sizeof (*entry), PU_STATIC, NULL);
+		entry->path = Z_Malloc(len + 1, PU_STATIC, NULL);
+		memcpy(entry->path, &line[pathpos], len);
+		entry->path[len] = '\0';
+		entry->size = size;
+		entry->mtime = mtime;
+		for (i = 0; i < MD5_LEN; i++)
+		{
+			unsigned int byte;
+			sscanf(&md5text[2*i], "%2x", &byte);
+			entry->md5sum[i] = (UINT8)byte;
+		}
+
+		entry->next = md5cache;
+		md5cache = entry;
+	}
+
+	fclose(f);
+}
+
+/** Writes the MD5 fingerprint cache out, if anything new went into it.
+  * Files that can't be found anymore are dropped from it.
+  */
+static void W_SaveMD5Cache(void)
+{
+	FILE *f;
+	md5cache_t *entry, **link;
+
+	if (!md5cachedirty)
+		return;
+	md5cachedirty = false;
+
+	f = fopen(va("%s"PATHSEP"%s", srb2home, MD5CACHEFILE), "w");
+	if (!f)
+	{
+		CONS_Debug(DBG_SETUP, "Could not write %s\n", MD5CACHEFILE);
+		return;
+	}
+
+	for (link = &md5cache; (entry = *link) != NULL;)
+	{
+		char md5text[2*MD5_LEN + 1];
+		unsigned long size;
+		long mtime;
+
+		// Deleted or moved, so it'd never be looked up again.
+		if (!W_StatFile(entry->path, &size, &mtime))
+		{
+			*link = entry->next;
+			Z_Free(entry->path);
+			Z_Free(entry);
+			continue;
+		}
+
+		PrintMD5String(entry->md5sum, md5text);
+		fprintf(f, "%s %lu %ld %s\n", md5text, entry->size, entry->mtime, entry->path);
+		link = &entry->next;
+	}
+
+	fclose(f);
+}
+
+static md5cache_t *W_FindMD5Cache(const char *filename)
+{
+	md5cache_t *entry;
+
+	if (!md5cacheloaded)
+		W_LoadMD5Cache();
+
+	for (entry = md5cache; entry; entry = entry->next)
+		if (!strcmp(entry->path, filename))
+			return entry;
+
+	return NULL;
+}
+
+static void W_StoreMD5Cache(const char *filename, unsigned long size, long mtime, const UINT8 *md5sum)
+{
+	md5cache_t *entry = W_FindMD5Cache(filename);
+
+	if (!entry)
+	{
+		entry = Z_Malloc(sizeof (*entry), PU_STATIC, NULL);
+		entry->path = Z_StrDup(filename);
+		entry->next = md5cache;
+		md5cache = entry;
+	}
+
+	entry->size = size;
+	entry->mtime = mtime;
+	memcpy(entry->md5sum, md5sum, 16);
+	md5cachedirty = true;
+}
+
+static void W_MD5Job(job_t *job, INT32 worker)
+{
+	md5job_t *md5job = (md5job_t *)job;
+	FILE *fhandle = fopen(md5job->path, "rb");
+
+	(void)worker;
+
+	md5job->ok = false;
+	if (fhandle)
+	{
+		md5job->ok = (md5_stream(fhandle, md5job->md5sum) == 0);
+		fclose(fhandle);
+	}
+}
+
+/** Waits for every file being hashed in the background, and puts the
+  * results in the fingerprint cache.
+  */
+static void W_FinishMD5Jobs(void)
+{
+	size_t i;
+
+	if (!md5batch.jobs)
+		return;
+
+	I_finish_jobs(&md5pool);
+
+	for (i = 0; i < md5batch.numjobs; i++)
+	{
+		md5job_t *job = &md5batch.jobs[i];
+		if (job->ok)
+			W_StoreMD5Cache(job->path, job->size, job->mtime, job->md5sum);
+		Z_Free(job->path);
+	}
+
+	Z_Free(md5batch.jobs);
+	md5batch.jobs = NULL;
+	md5batch.numjobs = 0;
+}
+
+/** Starts hashing, on worker threads, every file in a list that isn't in
+  * the fingerprint cache, so that W_InitFile doesn't have to hash them one
+  * after the other.
+  *
+  * \param list Files about to be added.
+  */
+static void W_StartMD5Jobs(addfilelist_t *list)
+{
+	size_t i;
+
+	W_FinishMD5Jobs();
+
+	md5batch.jobs = Z_Calloc(list->numfiles * sizeof (*md5batch.jobs), PU_STATIC, NULL);
+	md5batch.numjobs = 0;
+
+	for (i = 0; i < list->numfiles; i++)
+	{
+		const char *fn = list->files[i];
+		char pathsep = fn[strlen(fn) - 1];
+		md5job_t *job = &md5batch.jobs[md5batch.numjobs];
+		md5cache_t *entry;
+		FILE *handle;
+
+		if (pathsep == '\\' || pathsep == '/')
+			continue; // folders aren't hashed
+
+		// Find it the same way W_InitFile will.
+		if ((handle = W_OpenWadFile(&fn, false)) == NULL)
+			continue;
+		fclose(handle);
+
+		if (!W_StatFile(fn, &job->size, &job->mtime))
+			continue;
+
+		entry = W_FindMD5Cache(fn);
+		if (entry && entry->size == job->size && entry->mtime == job->mtime)
+			continue;
+
+		job->path = Z_StrDup(fn);
+		md5batch.numjobs++;
+	}
+
+	if (!md5batch.numjobs)
+	{
+		Z_Free(md5batch.jobs);
+		md5batch.jobs = NULL;
+		return;
+	}
+
+	for (i = 0; i < md5batch.numjobs; i++)
+		I_queue_job(&md5pool, &md5batch.jobs[i].job, W_MD5Job);
+}
+#endif/*NOMD5*/
+
 /** Compute MD5 message digest for bytes read from STREAM of this filname.
+  * Files that haven't changed since they were last hashed are looked up
+  * in the fingerprint cache instead.
   *
   * The resulting message digest number will be written into the 16 bytes
   * beginning at RESBLOCK.
@@ -305,13 +746,44 @@ static void W_LoadDehackedLumps(UINT16 wadnum, boolean mainfile)
   * \param resblock resulting MD5 checksum
   * \return 0 if MD5 checksum was made, and is at resblock, 1 if error was found
   */
-static INT32 W_MakeFileMD5(const char *filename, void *resblock)
+INT32 W_MakeFileMD5(const char *filename, void *resblock)
 {
 #ifdef NOMD5
 	(void)filename;
 	memset(resblock, 0x00, 16);
 #else
 	FILE *fhandle;
+	unsigned long size;
+	long mtime;
+	md5cache_t *entry;
+	size_t i;
+
+	if (!W_StatFile(filename, &size, &mtime))
+		return 1;
+
+	entry = W_FindMD5Cache(filename);
+	if (entry && entry->size == size && entry->mtime == mtime)
+	{
+		memcpy(resblock, entry->md5sum, 16);
+		return 0;
+	}
+
+	// Is it being hashed in the background?
+	for (i = 0; i < md5batch.numjobs; i++)
+	{
+		md5job_t *job = &md5batch.jobs[i];
+		if (strcmp(job->path, filename))
+			continue;
+
+		I_wait_job(&md5pool, &job->job);
+		if (job->ok && job->size == size && job->mtime == mtime)
+		{
+			W_StoreMD5Cache(filename, size, mtime, job->md5sum);
+			memcpy(resblock, job->md5sum, 16);
+			return 0;
+		}
+		break;
+	}
 
 	if ((fhandle = fopen(filename, "rb")) != NULL)
 	{
@@ -325,12 +797,23 @@ static INT32 W_MakeFileMD5(const char *filename, void *resblock)
 		CONS_Debug(DBG_SETUP, "MD5 calc for %s took %f seconds\n",
 			filename, (float)(I_GetTime() - t)/NEWTICRATE);
 		fclose(fhandle);
+		W_StoreMD5Cache(filename, size, mtime, resblock);
 		return 0;
 	}
 #endif
 	return 1;
 }
 
+/** Writes out any new MD5 fingerprints.
+  */
+void W_SaveFileMD5s(void)
+{
+#ifndef NOMD5
+	W_FinishMD5Jobs();
+	W_SaveMD5Cache();
+#endif
+}
+
 // Invalidates the cache of lump numbers. Call this whenever a wad is added.
 static void W_InvalidateLumpnumCache(void)
 {
@@ -557,33 +1040,271 @@ typedef struct zlentry_s
 #pragma pack()
 #endif
 
-/** Create a lumpinfo_t array for a PKZip file.
+/** Fills in the names of a PK3 lump from its path in the archive.
  */
-static lumpinfo_t* ResGetLumpsZip (FILE* handle, UINT16* nlmp)
+static void ResSetZipLumpNames(lumpinfo_t *lump_p, const char *fullname, size_t namelen)
 {
-    zend_t zend;
-    zentry_t zentry;
-    zlentry_t zlentry;
+	const char *trimname;
+	const char *dotpos;
 
-	UINT16 numlumps = *nlmp;
-	lumpinfo_t* lumpinfo;
-	lumpinfo_t *lump_p;
-	size_t i;
+	// Strip away file address and extension for the 8char name.
+	if ((trimname = strrchr(fullname, '/')) != 0)
+		trimname++;
+	else
+		trimname = fullname; // Care taken for root files.
 
-	char pat_central[] = {0x50, 0x4b, 0x01, 0x02, 0x00};
-	char pat_end[] = {0x50, 0x4b, 0x05, 0x06, 0x00};
+	if ((dotpos = strrchr(trimname, '.')) == 0)
+		dotpos = fullname + strlen(fullname); // Watch for files without extension.
 
-	// Look for central directory end signature near end of file.
-	// Contains entry number (number of lumps), and central directory start offset.
-	fseek(handle, 0, SEEK_END);
-	if (!ResFindSignature(handle, pat_end, max(0, ftell(handle) - (22 + 65536))))
+	memset(lump_p->name, '\0', 9); // Making sure they're initialized to 0. Is it necessary?
+	strncpy(lump_p->name, trimname, min(8, dotpos - trimname));
+	lump_p->hash = quickncasehash(lump_p->name, 8);
+
+	lump_p->longname = Z_Calloc(dotpos - trimname + 1, PU_STATIC, NULL);
+	strlcpy(lump_p->longname, trimname, dotpos - trimname + 1);
+
+	lump_p->fullname = Z_Calloc(namelen + 1, PU_STATIC, NULL);
+	strncpy(lump_p->fullname, fullname, namelen);
+}
+
+/** Turns a PKZip compression method into ours.
+ */
+static compmethod ResZipCompression(UINT16 method, const char *fullname)
+{
+	switch(method)
 	{
-		CONS_Alert(CONS_ERROR, "Missing central directory\n");
-		return NULL;
+	case 0:
+		return CM_NOCOMPRESSION;
+#ifdef HAVE_ZLIB
+	case 8:
+		return CM_DEFLATE;
+#endif
+	case 14:
+		return CM_LZF;
+	default:
+		CONS_Alert(CONS_WARNING, "%s: Unsupported compression method\n", fullname);
+		return CM_UNSUPPORTED;
 	}
+}
 
-	fseek(handle, -4, SEEK_CUR);
-	if (fread(&zend, 1, sizeof zend, handle) < sizeof zend)
+/** Turns one of our compression methods back into PKZip's.
+ */
+static UINT16 ResZipMethod(compmethod compression)
+{
+	switch(compression)
+	{
+	case CM_NOCOMPRESSION:
+		return 0;
+#ifdef HAVE_ZLIB
+	case CM_DEFLATE:
+		return 8;
+#endif
+	case CM_LZF:
+		return 14;
+	default:
+		return UINT16_MAX;
+	}
+}
+
+#ifndef NOMD5
+// Parsing the central directory of a big PK3 means thousands of small reads
+// and seeks, so the result is kept in srb2home, in a file named after the
+// archive's MD5. It's only used if the archive's size, modification time and
+// MD5 still match. The layout is a header, an entry per lump, then the lumps'
+// full names one after the other, each null-terminated.
+
+#define ZIPCACHEFOLDER "cache"
+#define ZIPCACHEMAGIC "SRB2DIR\x01"
+
+typedef struct
+{
+	char magic[8];
+	INT64 mtime;
+	UINT32 filesize;
+	UINT32 numlumps;
+	UINT32 namesize; // bytes of full names
+	UINT8 md5sum[16];
+} zipcacheheader_t;
+
+typedef struct
+{
+	UINT32 position;
+	UINT32 disksize;
+	UINT32 size;
+	UINT16 method; // PKZip compression method
+	UINT16 namelen; // full name length, without the terminator
+} zipcacheentry_t;
+
+static const char *ResZipCachePath(const UINT8 *md5sum)
+{
+	char md5text[2*MD5_LEN + 1];
+	PrintMD5String(md5sum, md5text);
+	return va("%s"PATHSEP ZIPCACHEFOLDER PATHSEP"%s.dir", srb2home, md5text);
+}
+
+/** Loads a PK3's lumpinfo from its cached directory, if the cache is valid.
+ *
+ * \param filename Path of the archive.
+ * \param md5sum The archive's MD5.
+ * \param nlmp Gets the number of lumps.
+ * \return The lumpinfo array, or NULL if there's no valid cache for this file.
+ */
+static lumpinfo_t* ResGetLumpsZipCached (const char *filename, const UINT8 *md5sum, UINT16* nlmp)
+{
+	FILE *f;
+	UINT8 *data;
+	long length;
+	const zipcacheheader_t *header;
+	const zipcacheentry_t *entry;
+	const char *names, *namesend;
+	unsigned long filesize;
+	long mtime;
+	lumpinfo_t *lumpinfo, *lump_p;
+	UINT32 i;
+
+	if (!W_StatFile(filename, &filesize, &mtime))
+		return NULL;
+
+	if ((f = fopen(ResZipCachePath(md5sum), "rb")) == NULL)
+		return NULL;
+
+	// One read for the whole thing.
+	fseek(f, 0, SEEK_END);
+	length = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if (length < (long)sizeof (*header))
+	{
+		fclose(f);
+		return NULL;
+	}
+
+	data = malloc(length);
+	if (!data || fread(data, 1, length, f) < (size_t)length)
+	{
+		free(data);
+		fclose(f);
+		return NULL;
+	}
+	fclose(f);
+
+	header = (const zipcacheheader_t *)data;
+	if (memcmp(header->magic, ZIPCACHEMAGIC, sizeof header->magic)
+		|| header->filesize != filesize || header->mtime != mtime
+		|| memcmp(header->md5sum, md5sum, 16)
+		|| !header->numlumps || header->numlumps > UINT16_MAX
+		|| (size_t)length != sizeof (*header) + header->numlumps * sizeof (*entry) + header->namesize)
+	{
+		free(data);
+		return NULL;
+	}
+
+	entry = (const zipcacheentry_t *)(header + 1);
+	names = (const char *)(entry + header->numlumps);
+	namesend = names + header->namesize;
+
+	lump_p = lumpinfo = Z_Calloc(header->numlumps * sizeof (*lumpinfo), PU_STATIC, NULL);
+	for (i = 0; i < header->numlumps; i++, entry++, lump_p++)
+	{
+		if (names + entry->namelen >= namesend || names[entry->namelen] != '\0')
+		{
+			// Don't leave any half-made lumps behind.
+			while (lump_p-- > lumpinfo)
+			{
+				Z_Free(lump_p->longname);
+				Z_Free(lump_p->fullname);
+			}
+			Z_Free(lumpinfo);
+			free(data);
+			return NULL;
+		}
+
+		lump_p->position = entry->position;
+		lump_p->disksize = entry->disksize;
+		lump_p->size = entry->size;
+		lump_p->diskpath = NULL;
+		ResSetZipLumpNames(lump_p, names, entry->namelen);
+		lump_p->compression = ResZipCompression(entry->method, names);
+
+		names += entry->namelen + 1;
+	}
+
+	*nlmp = (UINT16)header->numlumps;
+	free(data);
+	return lumpinfo;
+}
+
+/** Writes a PK3's parsed directory out, for ResGetLumpsZipCached.
+ */
+static void ResSaveZipCache (const char *filename, const UINT8 *md5sum, const lumpinfo_t *lumpinfo, UINT16 numlumps)
+{
+	FILE *f;
+	zipcacheheader_t header;
+	unsigned long filesize;
+	long mtime;
+	UINT16 i;
+
+	if (!W_StatFile(filename, &filesize, &mtime))
+		return;
+
+	memcpy(header.magic, ZIPCACHEMAGIC, sizeof header.magic);
+	header.mtime = mtime;
+	header.filesize = (UINT32)filesize;
+	header.numlumps = numlumps;
+	header.namesize = 0;
+	memcpy(header.md5sum, md5sum, 16);
+	for (i = 0; i < numlumps; i++)
+		header.namesize += (UINT32)strlen(lumpinfo[i].fullname) + 1;
+
+	I_mkdir(va("%s"PATHSEP ZIPCACHEFOLDER, srb2home), 0755);
+	if ((f = fopen(ResZipCachePath(md5sum), "wb")) == NULL)
+		return;
+
+	fwrite(&header, sizeof header, 1, f);
+	for (i = 0; i < numlumps; i++)
+	{
+		zipcacheentry_t entry;
+		entry.position = (UINT32)lumpinfo[i].position;
+		entry.disksize = (UINT32)lumpinfo[i].disksize;
+		entry.size = (UINT32)lumpinfo[i].size;
+		entry.method = ResZipMethod(lumpinfo[i].compression);
+		entry.namelen = (UINT16)strlen(lumpinfo[i].fullname);
+		fwrite(&entry, sizeof entry, 1, f);
+	}
+	for (i = 0; i < numlumps; i++)
+		fwrite(lumpinfo[i].fullname, strlen(lumpinfo[i].fullname) + 1, 1, f);
+
+	// A short write leaves a cache that fails the length check, which is fine.
+	fclose(f);
+}
+#endif/*NOMD5*/
+
+/** Create a lumpinfo_t array for a PKZip file.
+ */
+static lumpinfo_t* ResGetLumpsZip (FILE* handle, UINT16* nlmp)
+{
+    zend_t zend;
+    zentry_t zentry;
+    zlentry_t zlentry;
+
+	UINT16 numlumps = *nlmp;
+	lumpinfo_t* lumpinfo;
+	lumpinfo_t *lump_p;
+	size_t i;
+
+	char pat_central[] = {0x50, 0x4b, 0x01, 0x02, 0x00};
+	char pat_end[] = {0x50, 0x4b, 0x05, 0x06, 0x00};
+
+	// Look for central directory end signature near end of file.
+	// Contains entry number (number of lumps), and central directory start offset.
+	fseek(handle, 0, SEEK_END);
+	if (!ResFindSignature(handle, pat_end, max(0, ftell(handle) - (22 + 65536))))
+	{
+		CONS_Alert(CONS_ERROR, "Missing central directory\n");
+		return NULL;
+	}
+
+	fseek(handle, -4, SEEK_CUR);
+	if (fread(&zend, 1, sizeof zend, handle) < sizeof zend)
 	{
 		CONS_Alert(CONS_ERROR, "Corrupt central directory (%s)\n", M_FileError(handle));
 		return NULL;
@@ -596,8 +1317,6 @@ static lumpinfo_t* ResGetLumpsZip (FILE* handle, UINT16* nlmp)
 	for (i = 0; i < numlumps; i++, lump_p++)
 	{
 		char* fullname;
-		char* trimname;
-		char* dotpos;
 
 		if (fread(&zentry, 1, sizeof(zentry_t), handle) < sizeof(zentry_t))
 		{
@@ -626,43 +1345,8 @@ static lumpinfo_t* ResGetLumpsZip (FILE* handle, UINT16* nlmp)
 			return NULL;
 		}
 
-		// Strip away file address and extension for the 8char name.
-		if ((trimname = strrchr(fullname, '/')) != 0)
-			trimname++;
-		else
-			trimname = fullname; // Care taken for root files.
-
-		if ((dotpos = strrchr(trimname, '.')) == 0)
-			dotpos = fullname + strlen(fullname); // Watch for files without extension.
-
-		memset(lump_p->name, '\0', 9); // Making sure they're initialized to 0. Is it necessary?
-		strncpy(lump_p->name, trimname, min(8, dotpos - trimname));
-		lump_p->hash = quickncasehash(lump_p->name, 8);
-
-		lump_p->longname = Z_Calloc(dotpos - trimname + 1, PU_STATIC, NULL);
-		strlcpy(lump_p->longname, trimname, dotpos - trimname + 1);
-
-		lump_p->fullname = Z_Calloc(zentry.namelen + 1, PU_STATIC, NULL);
-		strncpy(lump_p->fullname, fullname, zentry.namelen);
-
-		switch(zentry.compression)
-		{
-		case 0:
-			lump_p->compression = CM_NOCOMPRESSION;
-			break;
-#ifdef HAVE_ZLIB
-		case 8:
-			lump_p->compression = CM_DEFLATE;
-			break;
-#endif
-		case 14:
-			lump_p->compression = CM_LZF;
-			break;
-		default:
-			CONS_Alert(CONS_WARNING, "%s: Unsupported compression method\n", fullname);
-			lump_p->compression = CM_UNSUPPORTED;
-			break;
-		}
+		ResSetZipLumpNames(lump_p, fullname, zentry.namelen);
+		lump_p->compression = ResZipCompression(zentry.compression, fullname);
 
 		free(fullname);
 
@@ -896,7 +1580,9 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 	// Let's not add a wad file if the MD5 matches
 	// an MD5 of an already added WAD file!
 	//
+	M_TraceBegin("W_MakeFileMD5", NULL);
 	W_MakeFileMD5(filename, md5sum);
+	M_TraceEnd();
 
 	for (i = 0; i < numwadfiles; i++)
 	{
@@ -913,6 +1599,7 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 	}
 #endif
 
+	M_TraceBegin("Read directory", NULL);
 	switch(type = ResourceFileDetect(filename))
 	{
 	case RET_SOC:
@@ -922,7 +1609,16 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 		lumpinfo = ResGetLumpsStandalone(handle, &numlumps, "LUA_INIT");
 		break;
 	case RET_PK3:
+#ifndef NOMD5
+		lumpinfo = ResGetLumpsZipCached(filename, md5sum, &numlumps);
+		if (lumpinfo)
+			break;
+#endif
 		lumpinfo = ResGetLumpsZip(handle, &numlumps);
+#ifndef NOMD5
+		if (lumpinfo)
+			ResSaveZipCache(filename, md5sum, lumpinfo, numlumps);
+#endif
 		break;
 	case RET_WAD:
 		lumpinfo = ResGetLumpsWad(handle, &numlumps, filename);
@@ -930,6 +1626,7 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 	default:
 		CONS_Alert(CONS_ERROR, "Unsupported file format\n");
 	}
+	M_TraceEnd();
 
 	if (lumpinfo == NULL)
 	{
@@ -958,6 +1655,8 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 	fseek(handle, 0, SEEK_END);
 	wadfile->filesize = (unsigned)ftell(handle);
 	wadfile->type = type;
+	W_MapWadFile(wadfile);
+	W_BuildLumpIndexes(wadfile);
 
 	// already generated, just copy it over
 	M_Memcpy(&wadfile->md5sum, &md5sum, 16);
@@ -967,6 +1666,7 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 	//
 	Z_Calloc(numlumps * sizeof (*wadfile->lumpcache), PU_STATIC, &wadfile->lumpcache);
 	Z_Calloc(numlumps * sizeof (*wadfile->patchcache), PU_STATIC, &wadfile->patchcache);
+	Z_Calloc(numlumps * 2 * sizeof (*wadfile->cachenodes), PU_STATIC, &wadfile->cachenodes);
 
 	//
 	// add the wadfile
@@ -980,6 +1680,7 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 	W_ReadFileShaders(wadfile);
 
 	// TODO: HACK ALERT - Load Lua & SOC stuff right here. I feel like this should be out of this place, but... Let's stick with this for now.
+	M_TraceBegin("Load Lua and SOC", NULL);
 	switch (wadfile->type)
 	{
 	case RET_WAD:
@@ -998,6 +1699,10 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 	default:
 		break;
 	}
+	M_TraceEnd();
+
+	if (!startup)
+		W_SaveFileMD5s();
 
 	W_InvalidateLumpnumCache();
 	return wadfile->numlumps;
@@ -1137,10 +1842,12 @@ UINT16 W_InitFolder(const char *path, boolean mainfile, boolean startup)
 	wadfile->path = fullpath;
 	wadfile->type = RET_FOLDER;
 	wadfile->handle = NULL;
+	wadfile->mapping = NULL;
 	wadfile->numlumps = numlumps;
 	wadfile->foldercount = foldercount;
 	wadfile->lumpinfo = lumpinfo;
 	wadfile->important = important;
+	W_BuildLumpIndexes(wadfile);
 
 	// Irrelevant.
 	wadfile->filesize = 0;
@@ -1148,6 +1855,7 @@ UINT16 W_InitFolder(const char *path, boolean mainfile, boolean startup)
 
 	Z_Calloc(numlumps * sizeof (*wadfile->lumpcache), PU_STATIC, &wadfile->lumpcache);
 	Z_Calloc(numlumps * sizeof (*wadfile->patchcache), PU_STATIC, &wadfile->patchcache);
+	Z_Calloc(numlumps * 2 * sizeof (*wadfile->cachenodes), PU_STATIC, &wadfile->cachenodes);
 
 	CONS_Printf(M_GetText("Added folder %s (%u files, %u folders)\n"), fn, numlumps, foldercount);
 	wadfiles = Z_Realloc(wadfiles, sizeof(wadfile_t *) * (numwadfiles + 1), PU_STATIC, NULL);
@@ -1174,6 +1882,10 @@ void W_InitMultipleFiles(addfilelist_t *list)
 {
 	size_t i = 0;
 
+#ifndef NOMD5
+	W_StartMD5Jobs(list);
+#endif
+
 	for (; i < list->numfiles; i++)
 	{
 		const char *fn = list->files[i];
@@ -1182,11 +1894,15 @@ void W_InitMultipleFiles(addfilelist_t *list)
 
 		//CONS_Debug(DBG_SETUP, "Loading %s\n", fn);
 
+		M_TraceBegin("W_InitFile", fn);
 		if (pathsep == '\\' || pathsep == '/')
 			W_InitFolder(fn, mainfile, true);
 		else
 			W_InitFile(fn, mainfile, true);
+		M_TraceEnd();
 	}
+
+	W_SaveFileMD5s();
 }
 
 /** Make sure a lump number is valid.
@@ -1231,6 +1947,7 @@ UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	UINT16 i;
 	static char uname[8 + 1];
 	UINT32 hash;
+	const lumpindex_t *index;
 
 	if (!TestValidLump(wad,0))
 		return INT16_MAX;
@@ -1240,16 +1957,16 @@ UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	hash = quickncasehash(uname, 8);
 
 	//
-	// scan forward
+	// walk the name's hash chain, which is in lump order
 	// start at 'startlump', useful parameter when there are multiple
 	//                       resources with the same name
 	//
-	if (startlump < wadfiles[wad]->numlumps)
+	index = &wadfiles[wad]->nameindex;
+	for (i = index->buckets[hash & index->mask]; i != LUMPINDEXEND; i = index->next[i])
 	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-			if (lump_p->hash == hash && !strncmp(lump_p->name, uname, sizeof(uname) - 1))
-				return i;
+		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + i;
+		if (i >= startlump && lump_p->hash == hash && !strncmp(lump_p->name, uname, sizeof(uname) - 1))
+			return i;
 	}
 
 	// not found.
@@ -1266,25 +1983,25 @@ UINT16 W_CheckNumForLongNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 {
 	UINT16 i;
 	static char uname[256 + 1];
+	UINT32 hash;
+	const lumpindex_t *index;
 
 	if (!TestValidLump(wad,0))
 		return INT16_MAX;
 
 	strlcpy(uname, name, sizeof uname);
 	strupr(uname);
+	hash = quickncasehash(uname, strlen(uname));
 
 	//
-	// scan forward
+	// walk the name's hash chain, which is in lump order
 	// start at 'startlump', useful parameter when there are multiple
 	//                       resources with the same name
 	//
-	if (startlump < wadfiles[wad]->numlumps)
-	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-			if (!strcmp(lump_p->longname, uname))
-				return i;
-	}
+	index = &wadfiles[wad]->longnameindex;
+	for (i = index->buckets[hash & index->mask]; i != LUMPINDEXEND; i = index->next[i])
+		if (i >= startlump && !strcmp(wadfiles[wad]->lumpinfo[i].longname, uname))
+			return i;
 
 	// not found.
 	return INT16_MAX;
@@ -1335,12 +2052,29 @@ UINT16 W_CheckNumForFolderEndPK3(const char *name, UINT16 wad, UINT16 startlump)
 	return i;
 }
 
-// In a PK3 type of resource file, it looks for an entry with the specified full name.
+// In a PK3 type of resource file, it looks for the first entry whose full name starts with the specified one.
+// An exact match found through the wad's index is only taken if no longer
+// name could match first; anything else is scanned for, like it always was.
 // Returns lump position in PK3's lumpinfo, or INT16_MAX if not found.
 UINT16 W_CheckNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump)
 {
 	INT32 i;
-	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
+	lumpinfo_t *lump_p;
+	const lumpindex_t *index = &wadfiles[wad]->fullnameindex;
+	UINT32 hash = quickncasehash(name, strlen(name));
+	UINT16 j;
+
+	for (j = index->buckets[hash & index->mask]; j != LUMPINDEXEND; j = index->next[j])
+	{
+		if (j >= startlump && !stricmp(name, wadfiles[wad]->lumpinfo[j].fullname))
+		{
+			if (!wadfiles[wad]->fullnameextended[j])
+				return j;
+			break;
+		}
+	}
+
+	lump_p = wadfiles[wad]->lumpinfo + startlump;
 	for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
 	{
 		if (!strnicmp(name, lump_p->fullname, strlen(name)))
@@ -1558,131 +2292,515 @@ lumpnum_t W_CheckNumForNameInBlock(const char *name, const char *blockstart, con
 #include "fastcmp.h"
 UINT8 W_LumpExists(const char *name)
 {
-	INT32 i,j;
+	INT32 i;
+	UINT16 j;
+	UINT32 hash = quickncasehash(name, strlen(name));
 	for (i = numwadfiles - 1; i >= 0; i--)
 	{
-		lumpinfo_t *lump_p = wadfiles[i]->lumpinfo;
-		for (j = 0; j < wadfiles[i]->numlumps; ++j, ++lump_p)
-			if (fastcmp(lump_p->longname, name))
+		const lumpindex_t *index = &wadfiles[i]->longnameindex;
+		for (j = index->buckets[hash & index->mask]; j != LUMPINDEXEND; j = index->next[j])
+			if (fastcmp(wadfiles[i]->lumpinfo[j].longname, name))
 				return true;
 	}
 	return false;
 }
 
+enum
+{
+	LOOKUP_NAME,
+	LOOKUP_LONGNAME,
+	LOOKUP_FULLNAME,
+	NUMLOOKUPS
+};
+
+static const char *lookupnames[NUMLOOKUPS] = {"name", "longname", "fullname"};
+
+static const char *W_LookupKey(const lumpinfo_t *lump, INT32 kind)
+{
+	switch (kind)
+	{
+		case LOOKUP_NAME: return lump->name;
+		case LOOKUP_LONGNAME: return lump->longname;
+		default: return lump->fullname;
+	}
+}
+
+static UINT16 W_IndexedLookup(const char *key, UINT16 wad, INT32 kind)
+{
+	switch (kind)
+	{
+		case LOOKUP_NAME: return W_CheckNumForNamePwad(key, wad, 0);
+		case LOOKUP_LONGNAME: return W_CheckNumForLongNamePwad(key, wad, 0);
+		default: return W_CheckNumForFullNamePK3(key, wad, 0);
+	}
+}
+
+// The directory scans the lookups did before they had an index,
+// for comparison.
+static UINT16 W_ScannedLookup(const char *key, UINT16 wad, INT32 kind)
+{
+	char uname[256 + 1];
+	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo;
+	UINT32 hash;
+	UINT16 i;
+
+	strlcpy(uname, key, kind == LOOKUP_NAME ? 8 + 1 : sizeof uname);
+	strupr(uname);
+	hash = quickncasehash(uname, 8);
+
+	for (i = 0; i < wadfiles[wad]->numlumps; i++, lump_p++)
+	{
+		switch (kind)
+		{
+			case LOOKUP_NAME:
+				if (lump_p->hash == hash && !strncmp(lump_p->name, uname, 8))
+					return i;
+				break;
+			case LOOKUP_LONGNAME:
+				if (!strcmp(lump_p->longname, uname))
+					return i;
+				break;
+			default:
+				if (!strnicmp(key, lump_p->fullname, strlen(key)))
+					return i;
+				break;
+		}
+	}
+	return INT16_MAX;
+}
+
+/** The function called by the "lumpbench" console command.
+  * Looks up every lump of every loaded file by each kind of name, once
+  * through the lump indexes and once by scanning the directory, and
+  * prints the average time per lookup for both. Any lookup where the two
+  * disagree is counted as a mismatch.
+  */
+void Command_Lumpbench_f(void)
+{
+	INT32 passes = 1, pass, kind;
+	UINT16 wad, lump;
+	UINT16 *results;
+	UINT32 mismatches = 0;
+	UINT32 lookups[NUMLOOKUPS] = {0};
+	precise_t indexedtime[NUMLOOKUPS] = {0};
+	precise_t scannedtime[NUMLOOKUPS] = {0};
+	precise_t start;
+	double nspertick = 1000000000.0 / I_GetPrecisePrecision();
+
+	if (COM_Argc() > 2)
+	{
+		CONS_Printf(M_GetText("lumpbench [passes]: time lump name lookups\n"));
+		return;
+	}
+
+	if (COM_Argc() == 2)
+		passes = max(atoi(COM_Argv(1)), 1);
+
+	results = Z_Malloc(UINT16_MAX * sizeof (*results), PU_STATIC, NULL);
+
+	for (pass = 0; pass < passes; pass++)
+		for (wad = 0; wad < numwadfiles; wad++)
+			for (kind = 0; kind < NUMLOOKUPS; kind++)
+			{
+				lumpinfo_t *lumpinfo = wadfiles[wad]->lumpinfo;
+				UINT16 numlumps = wadfiles[wad]->numlumps;
+
+				if (kind == LOOKUP_FULLNAME && !W_FileHasFolders(wadfiles[wad]))
+					continue;
+
+				start = I_GetPreciseTime();
+				for (lump = 0; lump < numlumps; lump++)
+					results[lump] = W_IndexedLookup(W_LookupKey(&lumpinfo[lump], kind), wad, kind);
+				indexedtime[kind] += I_GetPreciseTime() - start;
+
+				start = I_GetPreciseTime();
+				for (lump = 0; lump < numlumps; lump++)
+					if (W_ScannedLookup(W_LookupKey(&lumpinfo[lump], kind), wad, kind) != results[lump])
+						mismatches++;
+				scannedtime[kind] += I_GetPreciseTime() - start;
+
+				lookups[kind] += numlumps;
+			}
+
+	Z_Free(results);
+
+	CONS_Printf("\x82%s", M_GetText("Lump lookups:\n"));
+	for (kind = 0; kind < NUMLOOKUPS; kind++)
+	{
+		if (!lookups[kind])
+			continue;
+		CONS_Printf(M_GetText("%-8s %9u lookups, %9.1f ns indexed, %11.1f ns scanned\n"), lookupnames[kind], lookups[kind],
+			indexedtime[kind] * nspertick / lookups[kind], scannedtime[kind] * nspertick / lookups[kind]);
+	}
+	if (mismatches)
+		CONS_Alert(CONS_WARNING, M_GetText("%u lookups disagreed with a directory scan\n"), mismatches);
+}
+
 size_t W_LumpLengthPwad(UINT16 wad, UINT16 lump)
 {
 	lumpinfo_t *l;
 
-	if (!TestValidLump(wad, lump))
-		return 0;
+	if (!TestValidLump(wad, lump))
+		return 0;
+
+	W_FinishPrefetch();
+
+	l = wadfiles[wad]->lumpinfo + lump;
+
+	// Open the external file for this lump, if the WAD is a folder.
+	if (wadfiles[wad]->type == RET_FOLDER)
+	{
+		// pathisdirectory calls stat, so if anything wrong has happened,
+		// this is the time to be aware of it.
+		INT32 stat = pathisdirectory(l->diskpath);
+
+		if (stat < 0)
+		{
+#ifndef AVOID_ERRNO
+			if (direrror == ENOENT)
+				I_Error("W_LumpLengthPwad: file %s doesn't exist", l->diskpath);
+			else
+				I_Error("W_LumpLengthPwad: could not stat %s: %s", l->diskpath, strerror(direrror));
+#else
+			I_Error("W_LumpLengthPwad: could not access %s", l->diskpath);
+#endif
+		}
+		else if (stat == 1) // Path is a folder.
+			return 0;
+		else
+		{
+			FILE *handle = fopen(l->diskpath, "rb");
+			if (handle == NULL)
+				I_Error("W_LumpLengthPwad: could not open file %s", l->diskpath);
+
+			fseek(handle, 0, SEEK_END);
+			l->size = l->disksize = ftell(handle);
+			fclose(handle);
+		}
+	}
+
+	return l->size;
+}
+
+/** Returns the buffer size needed to load the given lump.
+  *
+  * \param lump Lump number to look at.
+  * \return Buffer size needed, in bytes.
+  */
+size_t W_LumpLength(lumpnum_t lumpnum)
+{
+	return W_LumpLengthPwad(WADFILENUM(lumpnum),LUMPNUM(lumpnum));
+}
+
+//
+// W_IsLumpWad
+// Is the lump a WAD? (presumably not in a WAD)
+//
+boolean W_IsLumpWad(lumpnum_t lumpnum)
+{
+	if (W_FileHasFolders(wadfiles[WADFILENUM(lumpnum)]))
+	{
+		const char *lumpfullName = (wadfiles[WADFILENUM(lumpnum)]->lumpinfo + LUMPNUM(lumpnum))->fullname;
+
+		if (strlen(lumpfullName) < 4)
+			return false; // can't possibly be a WAD can it?
+		return !strnicmp(lumpfullName + strlen(lumpfullName) - 4, ".wad", 4);
+	}
+
+	return false; // WADs should never be inside WADs as far as SRB2 is concerned
+}
+
+//
+// W_IsLumpFolder
+// Is the lump a folder? (not in a WAD obviously)
+//
+boolean W_IsLumpFolder(UINT16 wad, UINT16 lump)
+{
+	if (W_FileHasFolders(wadfiles[wad]))
+	{
+		const char *name = wadfiles[wad]->lumpinfo[lump].fullname;
+
+		return (name[strlen(name)-1] == '/'); // folders end in '/'
+	}
+
+	return false; // WADs don't have folders
+}
+
+#ifdef HAVE_ZLIB
+/* report a zlib or i/o error */
+void zerr(int ret)
+{
+    CONS_Printf("zpipe: ");
+    switch (ret) {
+    case Z_ERRNO:
+        if (ferror(stdin))
+            CONS_Printf("error reading stdin\n");
+        if (ferror(stdout))
+            CONS_Printf("error writing stdout\n");
+        break;
+    case Z_STREAM_ERROR:
+        CONS_Printf("invalid compression level\n");
+        break;
+    case Z_DATA_ERROR:
+        CONS_Printf("invalid or incomplete deflate data\n");
+        break;
+    case Z_MEM_ERROR:
+        CONS_Printf("out of memory\n");
+        break;
+    case Z_VERSION_ERROR:
+        CONS_Printf("zlib version mismatch!\n");
+    }
+}
+#endif
+
+// ==========================================================================
+//                                                              LUMP PREFETCH
+// ==========================================================================
+
+// Compressed lumps can be decompressed ahead of time by worker threads,
+// straight into the lump cache. The zone is not thread-safe, so all of the
+// allocating, freeing and tagging is done here on the main thread; the
+// workers only ever touch the two buffers of the lumps they've been given.
+
+typedef struct
+{
+	job_t job;
+	UINT8 *dest; // the lump's cache block, in-flight as PU_STATIC
+	const UINT8 *src; // compressed data, either mapped or in raw
+	UINT8 *raw; // compressed data read from the file, if it isn't mapped
+	size_t srcsize, destsize;
+	compmethod compression;
+	boolean ok; // decompressed successfully
+} prefetchjob_t;
+
+static struct
+{
+	prefetchjob_t *jobs; // NULL when nothing is in flight
+	size_t numjobs;
+} prefetch;
+
+static jobpool_t prefetchpool = JOBPOOL_INIT("lump-prefetch", 8);
+
+static boolean W_DecompressLump(compmethod compression, const UINT8 *src, size_t srcsize, UINT8 *dest, size_t destsize)
+{
+	switch (compression)
+	{
+#ifdef ZWAD
+	case CM_LZF:
+		return lzf_decompress(src, srcsize, dest, destsize) == destsize;
+#endif
+#ifdef HAVE_ZLIB
+	case CM_DEFLATE:
+		{
+			z_stream strm;
+			int zErr;
+
+			strm.zalloc = Z_NULL;
+			strm.zfree = Z_NULL;
+			strm.opaque = Z_NULL;
+
+			strm.total_in = strm.avail_in = srcsize;
+			strm.total_out = strm.avail_out = destsize;
+
+			strm.next_in = src;
+			strm.next_out = dest;
+
+			if (inflateInit2(&strm, -15) != Z_OK)
+				return false;
+			zErr = inflate(&strm, Z_FINISH);
+			(void)inflateEnd(&strm);
+
+			return zErr == Z_STREAM_END;
+		}
+#endif
+	default:
+		return false;
+	}
+}
+
+static void W_PrefetchJob(job_t *job, INT32 worker)
+{
+	prefetchjob_t *prefetchjob = (prefetchjob_t *)job;
+
+	(void)worker;
+
+	prefetchjob->ok = W_DecompressLump(prefetchjob->compression, prefetchjob->src, prefetchjob->srcsize, prefetchjob->dest, prefetchjob->destsize);
+}
+
+/** Waits for the lumps being prefetched, if any, and puts them in the lump
+  * cache. Anything that looks at the lump cache calls this first, since
+  * the cache entries of lumps still being decompressed aren't ready yet.
+  *
+  * \sa W_PrefetchLumps
+  */
+static void W_FinishPrefetch(void)
+{
+	size_t i;
+
+	if (!prefetch.jobs)
+		return;
+
+	// Help out with whatever the workers haven't gotten to yet.
+	I_finish_jobs(&prefetchpool);
+
+	for (i = 0; i < prefetch.numjobs; i++)
+	{
+		prefetchjob_t *job = &prefetch.jobs[i];
+
+		if (job->raw)
+			Z_Free(job->raw);
+
+		// Unused prefetched lumps are purgable, the first W_CacheLumpNum
+		// on one of them gives it a proper tag. Failed lumps are left for
+		// W_ReadLumpHeaderPwad to read again and report on.
+		if (job->ok)
+			Z_ChangeTag(job->dest, PU_CACHE_UNLOCKED);
+		else
+			Z_Free(job->dest);
+	}
+
+	Z_Free(prefetch.jobs);
+	prefetch.jobs = NULL;
+	prefetch.numjobs = 0;
+}
+
+static boolean W_IsLumpPrefetchable(const lumpinfo_t *l)
+{
+	if (!l->size)
+		return false;
+
+	switch (l->compression)
+	{
+#ifdef ZWAD
+	case CM_LZF:
+		return true;
+#endif
+#ifdef HAVE_ZLIB
+	case CM_DEFLATE:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+/** Starts decompressing a list of lumps into the lump cache in the
+  * background, on as many worker threads as there are cores.
+  * Only compressed lumps that aren't cached yet are prefetched; reading
+  * the others would gain nothing from being done ahead of time.
+  *
+  * Prefetched lumps are cached as PU_CACHE_UNLOCKED, until the first
+  * W_CacheLumpNum on them gives them a real tag. Anything that reads a
+  * lump waits for the prefetch to finish first.
+  *
+  * \param lumps Lumps to prefetch.
+  * \param count Number of lumps in the list.
+  * \sa W_PrefetchLumpRangePwad, W_FlushPrefetchedLumps
+  */
+void W_PrefetchLumps(const lumpnum_t *lumps, size_t count)
+{
+	prefetchjob_t *jobs;
+	size_t i, numjobs = 0;
+
+	// One batch at a time.
+	W_FinishPrefetch();
 
-	l = wadfiles[wad]->lumpinfo + lump;
+	if (!count)
+		return;
 
-	// Open the external file for this lump, if the WAD is a folder.
-	if (wadfiles[wad]->type == RET_FOLDER)
+	jobs = Z_Malloc(count * sizeof (*jobs), PU_STATIC, NULL);
+
+	for (i = 0; i < count; i++)
 	{
-		// pathisdirectory calls stat, so if anything wrong has happened,
-		// this is the time to be aware of it.
-		INT32 stat = pathisdirectory(l->diskpath);
+		UINT16 wad = WADFILENUM(lumps[i]), lump = LUMPNUM(lumps[i]);
+		wadfile_t *wadfile;
+		lumpinfo_t *l;
+		prefetchjob_t *job;
 
-		if (stat < 0)
+		if (!TestValidLump(wad, lump))
+			continue;
+
+		wadfile = wadfiles[wad];
+		l = wadfile->lumpinfo + lump;
+
+		if (wadfile->lumpcache[lump] || !W_IsLumpPrefetchable(l))
+			continue;
+
+		job = &jobs[numjobs];
+		job->compression = l->compression;
+		job->srcsize = l->disksize;
+		job->destsize = l->size;
+		job->ok = false;
+
+		// The workers can't use the file handle, so read the compressed
+		// data in here unless the file is memory-mapped.
+		if (wadfile->mapping && l->position + l->disksize <= wadfile->filesize)
 		{
-#ifndef AVOID_ERRNO
-			if (direrror == ENOENT)
-				I_Error("W_LumpLengthPwad: file %s doesn't exist", l->diskpath);
-			else
-				I_Error("W_LumpLengthPwad: could not stat %s: %s", l->diskpath, strerror(direrror));
-#else
-			I_Error("W_LumpLengthPwad: could not access %s", l->diskpath);
-#endif
+			job->src = wadfile->mapping + l->position;
+			job->raw = NULL;
 		}
-		else if (stat == 1) // Path is a folder.
-			return 0;
 		else
 		{
-			FILE *handle = fopen(l->diskpath, "rb");
-			if (handle == NULL)
-				I_Error("W_LumpLengthPwad: could not open file %s", l->diskpath);
-
-			fseek(handle, 0, SEEK_END);
-			l->size = l->disksize = ftell(handle);
-			fclose(handle);
+			job->raw = Z_Malloc(l->disksize, PU_STATIC, NULL);
+			fseek(wadfile->handle, (long)l->position, SEEK_SET);
+			if (fread(job->raw, 1, l->disksize, wadfile->handle) < l->disksize)
+			{
+				Z_Free(job->raw);
+				continue;
+			}
+			job->src = job->raw;
 		}
-	}
-
-	return l->size;
-}
 
-/** Returns the buffer size needed to load the given lump.
-  *
-  * \param lump Lump number to look at.
-  * \return Buffer size needed, in bytes.
-  */
-size_t W_LumpLength(lumpnum_t lumpnum)
-{
-	return W_LumpLengthPwad(WADFILENUM(lumpnum),LUMPNUM(lumpnum));
-}
+		job->dest = Z_Malloc(l->size, PU_STATIC, &wadfile->lumpcache[lump]);
+		numjobs++;
+	}
 
-//
-// W_IsLumpWad
-// Is the lump a WAD? (presumably not in a WAD)
-//
-boolean W_IsLumpWad(lumpnum_t lumpnum)
-{
-	if (W_FileHasFolders(wadfiles[WADFILENUM(lumpnum)]))
+	if (!numjobs)
 	{
-		const char *lumpfullName = (wadfiles[WADFILENUM(lumpnum)]->lumpinfo + LUMPNUM(lumpnum))->fullname;
-
-		if (strlen(lumpfullName) < 4)
-			return false; // can't possibly be a WAD can it?
-		return !strnicmp(lumpfullName + strlen(lumpfullName) - 4, ".wad", 4);
+		Z_Free(jobs);
+		return;
 	}
 
-	return false; // WADs should never be inside WADs as far as SRB2 is concerned
+	prefetch.jobs = jobs;
+	prefetch.numjobs = numjobs;
+
+	for (i = 0; i < numjobs; i++)
+		I_queue_job(&prefetchpool, &jobs[i].job, W_PrefetchJob);
 }
 
-//
-// W_IsLumpFolder
-// Is the lump a folder? (not in a WAD obviously)
-//
-boolean W_IsLumpFolder(UINT16 wad, UINT16 lump)
+/** Prefetches all of the lumps from start up to, but not including, end.
+  *
+  * \param wad Wad number the lumps are in.
+  * \param start First lump to prefetch.
+  * \param end Lump to stop at.
+  * \sa W_PrefetchLumps
+  */
+void W_PrefetchLumpRangePwad(UINT16 wad, UINT16 start, UINT16 end)
 {
-	if (W_FileHasFolders(wadfiles[wad]))
-	{
-		const char *name = wadfiles[wad]->lumpinfo[lump].fullname;
+	lumpnum_t *lumps;
+	UINT16 i;
 
-		return (name[strlen(name)-1] == '/'); // folders end in '/'
-	}
+	if (start >= end)
+		return;
 
-	return false; // WADs don't have folders
+	lumps = Z_Malloc((end - start) * sizeof (*lumps), PU_STATIC, NULL);
+	for (i = start; i < end; i++)
+		lumps[i - start] = (wad << 16) + i;
+
+	W_PrefetchLumps(lumps, end - start);
+	Z_Free(lumps);
 }
 
-#ifdef HAVE_ZLIB
-/* report a zlib or i/o error */
-void zerr(int ret)
+/** Drops every prefetched lump that hasn't been claimed by a
+  * W_CacheLumpNum, for when whatever they were prefetched for is done.
+  *
+  * \sa W_PrefetchLumps
+  */
+void W_FlushPrefetchedLumps(void)
 {
-    CONS_Printf("zpipe: ");
-    switch (ret) {
-    case Z_ERRNO:
-        if (ferror(stdin))
-            CONS_Printf("error reading stdin\n");
-        if (ferror(stdout))
-            CONS_Printf("error writing stdout\n");
-        break;
-    case Z_STREAM_ERROR:
-        CONS_Printf("invalid compression level\n");
-        break;
-    case Z_DATA_ERROR:
-        CONS_Printf("invalid or incomplete deflate data\n");
-        break;
-    case Z_MEM_ERROR:
-        CONS_Printf("out of memory\n");
-        break;
-    case Z_VERSION_ERROR:
-        CONS_Printf("zlib version mismatch!\n");
-    }
+	W_FinishPrefetch();
+	Z_FreeTag(PU_CACHE_UNLOCKED);
 }
-#endif
 
 /** Reads bytes from the head of a lump.
   * Note: If the lump is compressed, the whole thing has to be read anyway.
@@ -1700,6 +2818,10 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 	size_t lumpsize, bytesread;
 	lumpinfo_t *l;
 	FILE *handle = NULL;
+	const UINT8 *mapped = NULL; // the lump's raw data, if its file is memory-mapped
+
+	// A prefetched lump's cache block is set before it's been decompressed.
+	W_FinishPrefetch();
 
 	if (!TestValidLump(wad, lump))
 		return 0;
@@ -1751,17 +2873,39 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 	if (!size || size+offset > lumpsize)
 		size = lumpsize - offset;
 
+	// A compressed lump that's already cached doesn't need to be decompressed
+	// again. (W_CacheLumpNumPwad reads into its cache block, so skip that.)
+	if (l->compression != CM_NOCOMPRESSION && wadfiles[wad]->lumpcache[lump]
+		&& wadfiles[wad]->lumpcache[lump] != dest)
+	{
+		M_Memcpy(dest, (UINT8 *)wadfiles[wad]->lumpcache[lump] + offset, size);
+		return size;
+	}
+
 	// Let's get the raw lump data.
-	// We setup the desired file handle to read the lump data.
-	if (wadfiles[wad]->type != RET_FOLDER)
-		handle = wadfiles[wad]->handle;
-	fseek(handle, (long)(l->position + offset), SEEK_SET);
+	// If the file is memory-mapped, it's already right there.
+	// Otherwise, we setup the desired file handle to read the lump data.
+	if (wadfiles[wad]->mapping && l->position + l->disksize <= wadfiles[wad]->filesize)
+		mapped = wadfiles[wad]->mapping + l->position;
+	else
+	{
+		if (wadfiles[wad]->type != RET_FOLDER)
+			handle = wadfiles[wad]->handle;
+		// Compressed lumps are always read from the start, offset applies to the decompressed data
+		fseek(handle, (long)(l->position + (l->compression == CM_NOCOMPRESSION ? offset : 0)), SEEK_SET);
+	}
 
 	// But let's not copy it yet. We support different compression formats on lumps, so we need to take that into account.
 	switch(wadfiles[wad]->lumpinfo[lump].compression)
 	{
 	case CM_NOCOMPRESSION:		// If it's uncompressed, we directly write the data into our destination, and return the bytes read.
-		bytesread = fread(dest, 1, size, handle);
+		if (mapped)
+		{
+			M_Memcpy(dest, mapped + offset, size);
+			bytesread = size;
+		}
+		else
+			bytesread = fread(dest, 1, size, handle);
 		if (wadfiles[wad]->type == RET_FOLDER)
 			fclose(handle);
 #ifdef NO_PNG_LUMPS
@@ -1772,16 +2916,20 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 	case CM_LZF:		// Is it LZF compressed? Used by ZWADs.
 		{
 #ifdef ZWAD
-			char *rawData; // The lump's raw data.
+			char *rawData = NULL; // The lump's raw data, unless it's memory-mapped.
 			char *decData; // Lump's decompressed real data.
 			size_t retval; // Helper var, lzf_decompress returns 0 when an error occurs.
 
-			rawData = Z_Malloc(l->disksize, PU_STATIC, NULL);
-			decData = Z_Malloc(l->size, PU_STATIC, NULL);
+			if (!mapped)
+			{
+				rawData = Z_Malloc(l->disksize, PU_STATIC, NULL);
+				if (fread(rawData, 1, l->disksize, handle) < l->disksize)
+					I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+				mapped = (UINT8 *)rawData;
+			}
 
-			if (fread(rawData, 1, l->disksize, handle) < l->disksize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
-			retval = lzf_decompress(rawData, l->disksize, decData, l->size);
+			decData = Z_Malloc(l->size, PU_STATIC, NULL);
+			retval = lzf_decompress(mapped, l->disksize, decData, l->size);
 #ifndef AVOID_ERRNO
 			if (retval == 0) // If this was returned, check if errno was set
 			{
@@ -1801,7 +2949,8 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			if (!decData) // Did we get no data at all?
 				return 0;
 			M_Memcpy(dest, decData + offset, size);
-			Z_Free(rawData);
+			if (rawData)
+				Z_Free(rawData);
 			Z_Free(decData);
 #ifdef NO_PNG_LUMPS
 			if (Picture_IsLumpPNG((UINT8 *)dest, size))
@@ -1817,7 +2966,7 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 #ifdef HAVE_ZLIB
 	case CM_DEFLATE: // Is it compressed via DEFLATE? Very common in ZIPs/PK3s, also what most doom-related editors support.
 		{
-			UINT8 *rawData; // The lump's raw data.
+			UINT8 *rawData = NULL; // The lump's raw data, unless it's memory-mapped.
 			UINT8 *decData; // Lump's decompressed real data.
 
 			int zErr; // Helper var.
@@ -1825,11 +2974,15 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			unsigned long rawSize = l->disksize;
 			unsigned long decSize = l->size;
 
-			rawData = Z_Malloc(rawSize, PU_STATIC, NULL);
-			decData = Z_Malloc(decSize, PU_STATIC, NULL);
+			if (!mapped)
+			{
+				rawData = Z_Malloc(rawSize, PU_STATIC, NULL);
+				if (fread(rawData, 1, rawSize, handle) < rawSize)
+					I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+				mapped = rawData;
+			}
 
-			if (fread(rawData, 1, rawSize, handle) < rawSize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+			decData = Z_Malloc(decSize, PU_STATIC, NULL);
 
 			strm.zalloc = Z_NULL;
 			strm.zfree = Z_NULL;
@@ -1838,7 +2991,7 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			strm.total_in = strm.avail_in = rawSize;
 			strm.total_out = strm.avail_out = decSize;
 
-			strm.next_in = rawData;
+			strm.next_in = mapped;
 			strm.next_out = decData;
 
 			zErr = inflateInit2(&strm, -15);
@@ -1847,7 +3000,7 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 				zErr = inflate(&strm, Z_FINISH);
 				if (zErr == Z_STREAM_END)
 				{
-					M_Memcpy(dest, decData, size);
+					M_Memcpy(dest, decData + offset, size);
 				}
 				else
 				{
@@ -1863,7 +3016,8 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 				zerr(zErr);
 			}
 
-			Z_Free(rawData);
+			if (rawData)
+				Z_Free(rawData);
 			Z_Free(decData);
 
 #ifdef NO_PNG_LUMPS
@@ -1901,6 +3055,166 @@ void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest)
 	W_ReadLumpHeaderPwad(wad, lump, dest, 0, 0);
 }
 
+// ==========================================================================
+//                                                         LUMP CACHE BUDGET
+// ==========================================================================
+// Every lump and patch handed out by the caches is kept in one list, most
+// recently used first. Once per frame, W_TrimLumpCache frees PU_CACHE
+// entries from the back of the list until the total is within budget.
+// Entries freed by anything else are dropped from the list as it's walked.
+
+static CV_PossibleValue_t lumpcachesize_cons_t[] = {{0, "MIN"}, {4096, "MAX"}, {0, NULL}};
+consvar_t cv_lumpcachesize = CVAR_INIT ("lumpcachesize", "0", CV_SAVE, lumpcachesize_cons_t, NULL);
+
+static lumpcachenode_t lumpcachelru; // next is the most recently used, prev the least
+static size_t lumpcachebytes; // total size of the entries in lumpcachelru
+
+static lumpcache_t *W_CacheNodeEntry(lumpcachenode_t *node)
+{
+	wadfile_t *wadfile = wadfiles[node->wad];
+	return node->patch ? &wadfile->patchcache[node->lump] : &wadfile->lumpcache[node->lump];
+}
+
+static void W_UnlinkCacheNode(lumpcachenode_t *node)
+{
+	node->prev->next = node->next;
+	node->next->prev = node->prev;
+	node->prev = node->next = NULL;
+	lumpcachebytes -= node->size;
+}
+
+// Moves a cache entry to the front of the list, adding it if it isn't there yet.
+// Nothing is tracked while there's no budget to keep to.
+static void W_TouchCacheNode(UINT16 wad, UINT16 lump, boolean patch)
+{
+	wadfile_t *wadfile = wadfiles[wad];
+	lumpcachenode_t *node;
+
+	if (!cv_lumpcachesize.value)
+		return;
+
+	node = &wadfile->cachenodes[patch ? wadfile->numlumps + lump : lump];
+
+	if (!lumpcachelru.next)
+		lumpcachelru.next = lumpcachelru.prev = &lumpcachelru;
+
+	if (node->next)
+		W_UnlinkCacheNode(node);
+
+	node->wad = wad;
+	node->lump = lump;
+	node->patch = patch;
+	node->size = wadfile->lumpinfo[lump].size;
+	if (patch)
+		node->size += sizeof (patch_t);
+
+	node->prev = &lumpcachelru;
+	node->next = lumpcachelru.next;
+	lumpcachelru.next->prev = node;
+	lumpcachelru.next = node;
+	lumpcachebytes += node->size;
+}
+
+// Drops entries that were freed by something other than W_TrimLumpCache
+static void W_SweepLumpCache(void)
+{
+	lumpcachenode_t *node, *prev;
+
+	if (!lumpcachelru.next)
+		return;
+
+	for (node = lumpcachelru.prev; node != &lumpcachelru; node = prev)
+	{
+		prev = node->prev;
+		if (*W_CacheNodeEntry(node) == NULL)
+			W_UnlinkCacheNode(node);
+	}
+}
+
+/** Frees least recently used PU_CACHE lumps and patches until the lump
+  * cache fits in cv_lumpcachesize megabytes. Entries whose tag has been
+  * changed to anything else are in use, and are skipped, as are patches
+  * that sprite rotations are still being made from.
+  * Only call this where no cached pointers are being held, such as
+  * between frames.
+  */
+void W_TrimLumpCache(void)
+{
+	size_t budget = (size_t)cv_lumpcachesize.value << 20;
+	lumpcachenode_t *node, *prev;
+
+	if (!budget || !lumpcachelru.next || lumpcachebytes <= budget)
+		return;
+
+	for (node = lumpcachelru.prev; node != &lumpcachelru && lumpcachebytes > budget; node = prev)
+	{
+		lumpcache_t *entry = W_CacheNodeEntry(node);
+		INT32 tag;
+
+		prev = node->prev;
+
+		if (*entry == NULL)
+		{
+			W_UnlinkCacheNode(node);
+			continue;
+		}
+
+		tag = Z_GetTag(*entry);
+		if (tag != PU_CACHE && tag != PU_CACHE_UNLOCKED)
+			continue;
+
+#ifdef ROTSPRITE
+		// A sprite rotation being made from it is still using it.
+		if (node->patch && RotatedPatch_IsRotating(*entry))
+			continue;
+#endif
+
+		W_UnlinkCacheNode(node);
+		if (node->patch)
+			Patch_Free(*entry);
+		else
+			Z_Free(*entry);
+		wadfiles[node->wad]->cacheevictions++;
+	}
+}
+
+/** The function called by the "lumpcachestats" console command.
+  * Prints how many times each file's lumps and patches were found in the
+  * cache or had to be read, and how many were evicted to stay in budget.
+  */
+void Command_LumpCacheStats_f(void)
+{
+	UINT32 hits = 0, misses = 0, evictions = 0;
+	UINT16 i;
+
+	W_SweepLumpCache();
+
+	CONS_Printf("\x82%s", M_GetText("Lump cache:\n"));
+	if (cv_lumpcachesize.value)
+		CONS_Printf(M_GetText("%s KB used of %d KB\n"), sizeu1(lumpcachebytes>>10), cv_lumpcachesize.value<<10);
+	else
+		CONS_Printf(M_GetText("No limit, so nothing new is being tracked\n"));
+
+	for (i = 0; i < numwadfiles; i++)
+	{
+		wadfile_t *wadfile = wadfiles[i];
+		UINT32 total = wadfile->cachehits + wadfile->cachemisses;
+
+		hits += wadfile->cachehits;
+		misses += wadfile->cachemisses;
+		evictions += wadfile->cacheevictions;
+
+		if (!total)
+			continue;
+
+		CONS_Printf(M_GetText("%.2d: %s: %u hits, %u misses (%u%%), %u evictions\n"), i, wadfile->filename,
+			wadfile->cachehits, wadfile->cachemisses, (UINT32)((UINT64)wadfile->cachehits * 100 / total),
+			wadfile->cacheevictions);
+	}
+
+	CONS_Printf(M_GetText("Total: %u hits, %u misses, %u evictions\n"), hits, misses, evictions);
+}
+
 // ==========================================================================
 // W_CacheLumpNum
 // ==========================================================================
@@ -1911,18 +3225,69 @@ void *W_CacheLumpNumPwad(UINT16 wad, UINT16 lump, INT32 tag)
 	if (!TestValidLump(wad,lump))
 		return NULL;
 
+	W_FinishPrefetch();
+
 	lumpcache = wadfiles[wad]->lumpcache;
 	if (!lumpcache[lump])
 	{
 		void *ptr = Z_Malloc(W_LumpLengthPwad(wad, lump), tag, &lumpcache[lump]);
 		W_ReadLumpHeaderPwad(wad, lump, ptr, 0, 0);  // read the lump in full
+		wadfiles[wad]->cachemisses++;
 	}
 	else
+	{
 		Z_ChangeTag(lumpcache[lump], tag);
+		wadfiles[wad]->cachehits++;
+	}
 
+	W_TouchCacheNode(wad, lump, false);
 	return lumpcache[lump];
 }
 
+/** Gets read-only access to a whole lump.
+  * If the lump's file is memory-mapped and the lump is stored uncompressed,
+  * this points straight into the mapping and nothing is read or copied.
+  * Otherwise, it comes from the lump cache if it's cached there,
+  * or is read into a new block of memory.
+  *
+  * \param wad Wad number to read from.
+  * \param lump Lump number to read from.
+  * \param copy Set to the new block the lump had to be read into, if any,
+  *             which the caller must Z_Free when done. NULL otherwise.
+  * \return The lump's data, which must not be modified. NULL if the lump is invalid.
+  * \sa W_CacheLumpNumPwad
+  */
+const void *W_MapLumpNumPwad(UINT16 wad, UINT16 lump, void **copy)
+{
+	lumpinfo_t *l;
+
+	*copy = NULL;
+
+	if (!TestValidLump(wad,lump))
+		return NULL;
+
+	l = wadfiles[wad]->lumpinfo + lump;
+
+	if (wadfiles[wad]->mapping && l->compression == CM_NOCOMPRESSION
+		&& l->position + l->disksize <= wadfiles[wad]->filesize)
+	{
+#ifdef NO_PNG_LUMPS
+		if (Picture_IsLumpPNG(wadfiles[wad]->mapping + l->position, l->size))
+			Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
+#endif
+		return wadfiles[wad]->mapping + l->position;
+	}
+
+	// Don't decompress a lump again if it's cached.
+	W_FinishPrefetch();
+	if (wadfiles[wad]->lumpcache[lump])
+		return wadfiles[wad]->lumpcache[lump];
+
+	*copy = Z_Malloc(W_LumpLengthPwad(wad, lump), PU_STATIC, NULL);
+	W_ReadLumpHeaderPwad(wad, lump, *copy, 0, 0);
+	return *copy;
+}
+
 void *W_CacheLumpNum(lumpnum_t lumpnum, INT32 tag)
 {
 	return W_CacheLumpNumPwad(WADFILENUM(lumpnum),LUMPNUM(lumpnum),tag);
@@ -1964,6 +3329,8 @@ static boolean W_IsLumpCachedPWAD(UINT16 wad, UINT16 lump, void *ptr)
 	if (!TestValidLump(wad, lump))
 		return false;
 
+	W_FinishPrefetch();
+
 	lcache = wadfiles[wad]->lumpcache[lump];
 
 	if (ptr)
@@ -2064,10 +3431,15 @@ void *W_CacheSoftwarePatchNumPwad(UINT16 wad, UINT16 lump, INT32 tag)
 		Patch_Create(ptr, len, dest);
 
 		Z_Free(ptr);
+		wadfiles[wad]->cachemisses++;
 	}
 	else
+	{
 		Z_ChangeTag(lumpcache[lump], tag);
+		wadfiles[wad]->cachehits++;
+	}
 
+	W_TouchCacheNode(wad, lump, true);
 	return lumpcache[lump];
 }
 
@@ -2138,27 +3510,6 @@ void *W_CachePatchLongName(const char *name, INT32 tag)
 		return W_CachePatchNum(W_GetNumForLongName("MISSING"), tag);
 	return W_CachePatchNum(num, tag);
 }
-#ifndef NOMD5
-#define MD5_LEN 16
-
-/**
-  * Prints an MD5 string into a human-readable textual format.
-  *
-  * \param md5 The md5 in binary form -- MD5_LEN (16) bytes.
-  * \param buf Where to print the textual form. Needs 2*MD5_LEN+1 (33) bytes.
-  * \author Graue <graue@oceanbase.org>
-  */
-#define MD5_FORMAT \
-	"%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x"
-static void PrintMD5String(const UINT8 *md5, char *buf)
-{
-	snprintf(buf, 2*MD5_LEN+1, MD5_FORMAT,
-		md5[0], md5[1], md5[2], md5[3],
-		md5[4], md5[5], md5[6], md5[7],
-		md5[8], md5[9], md5[10], md5[11],
-		md5[12], md5[13], md5[14], md5[15]);
-}
-#endif
 /** Verifies a file's MD5 is as it should be.
   * For releases, used as cheat prevention -- if the MD5 doesn't match, a
   * fatal error is thrown. In debug mode, an MD5 mismatch only triggers a
@@ -2557,6 +3908,18 @@ int W_VerifyNMUSlumps(const char *filename, boolean exit_on_error)
 	return status;
 }
 
+// Count number of lumps until the end of resource OR up until next "MAPXX" lump.
+static size_t vres_CountMapLumps(lumpnum_t lumpnum)
+{
+	size_t numlumps = 0;
+	lumpnum_t lumppos = lumpnum + 1;
+	UINT32 i;
+	for (i = LUMPNUM(lumppos); i < wadfiles[WADFILENUM(lumpnum)]->numlumps; i++, lumppos++, numlumps++)
+		if (memcmp(W_CheckNameForNum(lumppos), "MAP", 3) == 0)
+			break;
+	return numlumps + 1;
+}
+
 /** \brief Generates a virtual resource used for level data loading.
  *
  * \param lumpnum_t reference
@@ -2593,12 +3956,7 @@ virtres_t* vres_GetMap(lumpnum_t lumpnum)
 	}
 	else
 	{
-		// Count number of lumps until the end of resource OR up until next "MAPXX" lump.
-		lumpnum_t lumppos = lumpnum + 1;
-		for (i = LUMPNUM(lumppos); i < wadfiles[WADFILENUM(lumpnum)]->numlumps; i++, lumppos++, numlumps++)
-			if (memcmp(W_CheckNameForNum(lumppos), "MAP", 3) == 0)
-				break;
-		numlumps++;
+		numlumps = vres_CountMapLumps(lumpnum);
 
 		vlumps = Z_Malloc(sizeof(virtlump_t)*numlumps, PU_LEVEL, NULL);
 		for (i = 0; i < numlumps; i++, lumpnum++)
@@ -2616,6 +3974,19 @@ virtres_t* vres_GetMap(lumpnum_t lumpnum)
 	return vres;
 }
 
+/** \brief Starts decompressing a map's lumps in the background, so that
+ *         vres_GetMap has less to wait for.
+ *
+ * \param lumpnum The map's marker lump, or WAD lump inside a PK3.
+ */
+void vres_PrefetchMap(lumpnum_t lumpnum)
+{
+	if (W_IsLumpWad(lumpnum))
+		W_PrefetchLumps(&lumpnum, 1);
+	else
+		W_PrefetchLumpRangePwad(WADFILENUM(lumpnum), LUMPNUM(lumpnum), (UINT16)(LUMPNUM(lumpnum) + vres_CountMapLumps(lumpnum)));
+}
+
 /** \brief Frees zone memory for a given virtual resource.
  *
  * \param Virtual resource
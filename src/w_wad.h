@@ -18,6 +18,8 @@
 #include "hardware/hw_data.h"
 #endif
 
+#include "command.h"
+
 #ifdef __GNUG__
 #pragma interface
 #endif
@@ -91,6 +93,7 @@ typedef struct {
 } virtres_t;
 
 virtres_t* vres_GetMap(lumpnum_t);
+void vres_PrefetchMap(lumpnum_t);
 void vres_Free(virtres_t*);
 virtlump_t* vres_Find(const virtres_t*, const char*);
 
@@ -121,6 +124,27 @@ typedef enum restype
 	RET_UNKNOWN,
 } restype_t;
 
+// Hash chains over one kind of name in a wad's directory.
+// Chains list lumps in ascending order, so the first match found
+// is the same one a forward scan of the directory would find.
+#define LUMPINDEXEND UINT16_MAX
+
+typedef struct
+{
+	UINT16 *buckets; // first lump of each chain, LUMPINDEXEND if empty
+	UINT16 *next; // next lump in the same chain, per lump
+	UINT32 mask; // number of buckets minus one
+} lumpindex_t;
+
+// A lump or patch cache entry's place in the lump cache's LRU order
+typedef struct lumpcachenode_s
+{
+	struct lumpcachenode_s *prev, *next; // both NULL when not in the order
+	size_t size; // bytes the entry counts for
+	UINT16 wad, lump;
+	boolean patch; // patchcache rather than lumpcache
+} lumpcachenode_t;
+
 typedef struct wadfile_s
 {
 	char *filename, *path;
@@ -128,9 +152,16 @@ typedef struct wadfile_s
 	lumpinfo_t *lumpinfo;
 	lumpcache_t *lumpcache;
 	lumpcache_t *patchcache;
+	lumpcachenode_t *cachenodes; // lumpcache's, then patchcache's
+	UINT32 cachehits, cachemisses, cacheevictions;
 	UINT16 numlumps; // this wad's number of resources
 	UINT16 foldercount; // folder count
 	FILE *handle;
+	UINT8 *mapping; // the whole file, if it could be memory-mapped
+	lumpindex_t nameindex; // by name
+	lumpindex_t longnameindex; // by longname
+	lumpindex_t fullnameindex; // by fullname
+	UINT8 *fullnameextended; // per lump, whether a longer fullname starts with its own
 	UINT32 filesize; // for network
 	UINT8 md5sum[16];
 
@@ -189,6 +220,8 @@ lumpnum_t W_GetNumForLongName(const char *name);
 lumpnum_t W_CheckNumForNameInBlock(const char *name, const char *blockstart, const char *blockend);
 UINT8 W_LumpExists(const char *name); // Lua uses this.
 
+void Command_Lumpbench_f(void);
+
 size_t W_LumpLengthPwad(UINT16 wad, UINT16 lump);
 size_t W_LumpLength(lumpnum_t lumpnum);
 
@@ -204,7 +237,21 @@ size_t W_ReadLumpHeader(lumpnum_t lump, void *dest, size_t size, size_t offest);
 void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest);
 void W_ReadLump(lumpnum_t lump, void *dest);
 
+// Decompress lumps into the lump cache ahead of time, on worker threads
+void W_PrefetchLumps(const lumpnum_t *lumps, size_t count);
+void W_PrefetchLumpRangePwad(UINT16 wad, UINT16 start, UINT16 end);
+void W_FlushPrefetchedLumps(void);
+
+// Keep PU_CACHE lumps and patches within cv_lumpcachesize, least recently used first
+extern consvar_t cv_lumpcachesize;
+void W_TrimLumpCache(void);
+void Command_LumpCacheStats_f(void);
+
 void *W_CacheLumpNumPwad(UINT16 wad, UINT16 lump, INT32 tag);
+
+// Read-only access to a whole lump, without copying it if its file is
+// memory-mapped and it isn't compressed. Z_Free the copy when done.
+const void *W_MapLumpNumPwad(UINT16 wad, UINT16 lump, void **copy);
 void *W_CacheLumpNum(lumpnum_t lump, INT32 tag);
 void *W_CacheLumpNumForce(lumpnum_t lumpnum, INT32 tag);
 
@@ -227,6 +274,9 @@ void *W_CacheSoftwarePatchNum(lumpnum_t lumpnum, INT32 tag);
 
 void W_UnlockCachedPatch(void *patch);
 
+// Gets a file's MD5, from the fingerprint cache if the file hasn't changed
+INT32 W_MakeFileMD5(const char *filename, void *resblock);
+void W_SaveFileMD5s(void);
 void W_VerifyFileMD5(UINT16 wadfilenum, const char *matchmd5);
 
 int W_VerifyNMUSlumps(const char *filename, boolean exit_on_error);
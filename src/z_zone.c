@@ -24,6 +24,24 @@
 ///        caught with this direct-malloc version. We also suspected that SRB2's
 ///        allocator was fragmenting badly. Finally, this version is a bit
 ///        simpler (about half the lines of code).
+///
+///        Blocks are kept in one list per purge tag, so freeing a tag never
+///        has to look at anything else. Small blocks are not malloc'd on their
+///        own; they are carved out of chunks owned by the tag they were
+///        allocated with, recycled through per-size freelists, and released
+///        all at once when the tag is emptied. Large blocks are still plain
+///        malloc'd memory.
+///
+///        Only blocks that need something done when they go (large or pooled
+///        ones, ones with a user pointer, ones Lua has a userdata for) are
+///        kept on the tag's main list and freed one by one. The rest sit on
+///        a second list and simply vanish with their chunks, so freeing a tag
+///        costs one step per chunk rather than per allocation.
+///
+///        Pools are a variant of the arenas for objects that are created and
+///        destroyed constantly (mobjs, sector nodes): every slot is the same
+///        size and cache-line aligned, and the chunks are kept for reuse
+///        even after the tag the objects were allocated with is freed.
 
 #include "doomdef.h"
 #include "doomstat.h"
@@ -33,6 +51,8 @@
 #include "i_video.h" // rendermode
 #include "z_zone.h"
 #include "m_misc.h" // M_Memcpy
+#include "i_time.h" // I_GetTime
+#include "d_main.h" // srb2home
 #include "lua_script.h"
 
 #ifdef HWRENDER
@@ -56,10 +76,14 @@ typedef struct memblock_s
 	void **user;
 	INT32 tag; // purgelevel
 	UINT32 id; // Should be ZONEID
+	boolean tracked; // on its tag's main list, see Z_TrackBlock
 
 	size_t size; // including the header and blocks
 	size_t realsize; // size of real data only
 
+	struct memchunk_s *chunk; // arena chunk this block was carved from, NULL if malloc'd
+	struct memsite_s *site; // where it was allocated, if the profiler was running
+
 #ifdef ZDEBUG
 	const char *ownerfile;
 	INT32 ownerline;
@@ -71,13 +95,101 @@ typedef struct memblock_s
 #define MEMORY(x) (void *)((uintptr_t)(x) + sizeof(memblock_t))
 #define MEMBLOCK(x) (memblock_t *)((uintptr_t)(x) - sizeof(memblock_t))
 
-// both the head and tail of the zone memory block list
-static memblock_t head;
+// Blocks up to this size (header included) come from the tag arenas
+#define ARENAGRAIN 16
+#define ARENAMAXBLOCK 1024
+#define ARENACLASSES (ARENAMAXBLOCK / ARENAGRAIN)
+#define ARENACHUNKSIZE (64<<10)
+
+// Tags at or above this share the last list
+#define NUMZONETAGS 128
+
+// Pool slots are aligned to this
+#define POOLALIGN 64
+#define POOLMINSLOTS 32
+
+typedef struct memchunk_s
+{
+	struct memchunk_s *next, *prev;
+	mempool_t *pool; // pool this chunk belongs to, if any
+	struct memchunk_s *nexthash; // in chunkhash, arena chunks only
+	INT32 owner; // tag list this chunk belongs to, -1 if orphaned
+	size_t used; // offset of the first never-used byte
+	size_t live; // number of allocated blocks carved from this chunk
+	size_t tracked; // how many of those are tracked blocks
+} memchunk_t;
+
+#define CHUNKHEADERSIZE ((sizeof (memchunk_t) + ARENAGRAIN - 1) & ~(size_t)(ARENAGRAIN - 1))
+
+typedef struct
+{
+	memblock_t head; // both the head and tail of the tag's tracked blocks
+	memblock_t arena; // both the head and tail of its other arena blocks
+	memchunk_t chunks; // both the head and tail of the tag's chunk list
+	memblock_t *freeblocks[ARENACLASSES]; // recycled arena blocks, linked through next
+} memzone_t;
+
+static memzone_t zones[NUMZONETAGS];
+
+// Chunks whose tag was freed while some of their blocks had been moved
+// to another tag with Z_ChangeTag. Freed once those blocks are gone.
+static memchunk_t orphanchunks;
+
+// Arena chunks by address, so Z_MarkUserdata can tell whether
+// a pointer is the start of an arena block without touching
+// memory it doesn't own
+#define CHUNKHASHSIZE 1024
+#define CHUNKHASH(p) (((uintptr_t)(p) / ARENACHUNKSIZE) % CHUNKHASHSIZE)
+
+static memchunk_t *chunkhash[CHUNKHASHSIZE];
+
+struct mempool_s
+{
+	const char *name;
+	size_t size; // object size, as asked for
+	size_t stride; // slot size, header included
+	size_t slots; // slots per chunk
+	memblock_t *freeblocks; // recycled slots, linked through next
+	memchunk_t chunks; // both the head and tail of the pool's chunk list
+	size_t numchunks;
+	size_t used, peak;
+	struct mempool_s *nextpool;
+};
+
+static mempool_t *mempools = NULL;
+
+// Allocation statistics for one file:line and tag, kept by "memprofile"
+#define MEMSITEHASHSIZE 1024
+
+typedef struct memsite_s
+{
+	const char *file;
+	INT32 line;
+	INT32 tag;
+	size_t liveblocks, livebytes; // still allocated right now
+	size_t allocs, allocbytes, frees; // since profiling started
+	tic_t lasttic;
+	size_t ticallocs, peakticallocs; // allocations made during a single tic
+	struct memsite_s *next; // in the hash chain
+	struct memsite_s *nextsite; // in the list of all sites
+} memsite_t;
+
+static boolean memprofiling = false;
+static tic_t memprofilestart, memprofilestop;
+static memsite_t *memsitehash[MEMSITEHASHSIZE];
+static memsite_t *memsites = NULL;
+static size_t nummemsites = 0;
+
+#define ZONENUM(tag) ((tag) < 0 ? 0 : ((tag) >= NUMZONETAGS ? NUMZONETAGS-1 : (tag)))
+#define ARENACLASS(size) ((size) / ARENAGRAIN - 1)
+#define ZONELIST(z, l) ((l) ? &zones[z].arena : &zones[z].head)
 
 //
 // Function prototypes
 //
 static void Command_Memfree_f(void);
+static void Command_Mempools_f(void);
+static void Command_Memprofile_f(void);
 #ifdef ZDEBUG
 static void Command_Memdump_f(void);
 #endif
@@ -94,16 +206,26 @@ static void Command_Memdump_f(void);
 void Z_Init(void)
 {
 	size_t total, memfree;
+	INT32 i;
+
+	memset(zones, 0x00, sizeof(zones));
 
-	memset(&head, 0x00, sizeof(head));
+	for (i = 0; i < NUMZONETAGS; i++)
+	{
+		zones[i].head.next = zones[i].head.prev = &zones[i].head;
+		zones[i].arena.next = zones[i].arena.prev = &zones[i].arena;
+		zones[i].chunks.next = zones[i].chunks.prev = &zones[i].chunks;
+	}
 
-	head.next = head.prev = &head;
+	orphanchunks.next = orphanchunks.prev = &orphanchunks;
 
 	memfree = I_GetFreeMem(&total)>>20;
 	CONS_Printf("System memory: %sMB - Free: %sMB\n", sizeu1(total>>20), sizeu2(memfree));
 
 	// Note: This allocates memory. Watch out.
 	COM_AddCommand("memfree", Command_Memfree_f, COM_LUA);
+	COM_AddCommand("mempools", Command_Mempools_f, COM_LUA);
+	COM_AddCommand("memprofile", Command_Memprofile_f, 0);
 
 #ifdef ZDEBUG
 	COM_AddCommand("memdump", Command_Memdump_f, COM_LUA);
@@ -115,20 +237,137 @@ void Z_Init(void)
 // Zone memory allocation
 // ----------------------
 
+/** Frees a chunk, or leaves it to be freed once its last block goes
+  * if some of its blocks are still in use under another tag.
+  *
+  * \param chunk The chunk to release.
+  */
+static void Z_ReleaseChunk(memchunk_t *chunk)
+{
+	chunk->prev->next = chunk->next;
+	chunk->next->prev = chunk->prev;
+
+	if (chunk->live)
+	{
+		chunk->owner = -1;
+		chunk->next = orphanchunks.next;
+		chunk->prev = &orphanchunks;
+		orphanchunks.next = chunk;
+		chunk->next->prev = chunk;
+		return;
+	}
+
+	if (chunk->pool == NULL)
+	{
+		memchunk_t **link = &chunkhash[CHUNKHASH(chunk)];
+
+		while (*link != chunk)
+			link = &(*link)->nexthash;
+		*link = chunk->nexthash;
+	}
+
+	free(chunk);
+}
+
+/** Drops every chunk and recycled block of a tag at once,
+  * along with the untracked blocks carved from them.
+  * Only safe once the tag's tracked list is empty.
+  *
+  * \param zone The tag whose arena should be emptied.
+  */
+static void Z_ResetArena(memzone_t *zone)
+{
+	while (zone->chunks.next != &zone->chunks)
+	{
+		memchunk_t *chunk = zone->chunks.next;
+
+		// Whatever is still tracked was moved to another tag
+		chunk->live = chunk->tracked;
+		Z_ReleaseChunk(chunk);
+	}
+
+	zone->arena.next = zone->arena.prev = &zone->arena;
+	memset(zone->freeblocks, 0x00, sizeof(zone->freeblocks));
+}
+
+/** Moves a block to its tag's main list, so that it gets freed
+  * on its own rather than dropped along with its chunk.
+  *
+  * \param block The block to track.
+  */
+static void Z_TrackBlock(memblock_t *block)
+{
+	memblock_t *head = &zones[ZONENUM(block->tag)].head;
+
+	if (block->tracked)
+		return;
+
+	block->prev->next = block->next;
+	block->next->prev = block->prev;
+
+	block->next = head->next;
+	block->prev = head;
+	head->next = block;
+	block->next->prev = block;
+
+	block->tracked = true;
+	block->chunk->tracked++;
+}
+
+/** Gives the memory of an unlinked block back to wherever it came from.
+  *
+  * \param block The block to release.
+  */
+static void Z_ReleaseBlock(memblock_t *block)
+{
+	memchunk_t *chunk = block->chunk;
+
+	block->id = 0;
+
+	if (chunk == NULL)
+	{
+		free(block);
+		return;
+	}
+
+	chunk->live--;
+	if (block->tracked)
+		chunk->tracked--;
+
+	if (chunk->pool != NULL)
+	{
+		block->next = chunk->pool->freeblocks;
+		chunk->pool->freeblocks = block;
+		chunk->pool->used--;
+		return;
+	}
+
+	if (chunk->owner < 0)
+	{
+		if (!chunk->live)
+			Z_ReleaseChunk(chunk);
+		return;
+	}
+
+	block->next = zones[chunk->owner].freeblocks[ARENACLASS(block->size)];
+	zones[chunk->owner].freeblocks[ARENACLASS(block->size)] = block;
+}
+
 /** Frees allocated memory.
   *
   * \param ptr A pointer to allocated memory,
   *             assumed to have been allocated with Z_Malloc/Z_Calloc.
   * \sa Z_FreeTags
   */
-#ifdef ZDEBUG
 void Z_Free2(void *ptr, const char *file, INT32 line)
-#else
-void Z_Free(void *ptr)
-#endif
 {
 	memblock_t *block;
 
+#if !defined (ZDEBUG) && !defined (PARANOIA)
+	(void)file;
+	(void)line;
+#endif
+
 	if (ptr == NULL)
 		return;
 
@@ -139,11 +378,7 @@ void Z_Free(void *ptr)
 	block = MEMBLOCK(ptr);
 #ifdef PARANOIA
 	if (block->id != ZONEID)
-#ifdef ZDEBUG
 		I_Error("Z_Free at %s:%d: wrong id", file, line);
-#else
-		I_Error("Z_Free: wrong id");
-#endif
 #endif
 
 #ifdef ZDEBUG
@@ -152,7 +387,8 @@ void Z_Free(void *ptr)
 #endif
 
 	// anything that isn't by lua gets passed to lua just in case.
-	if (block->tag != PU_LUA)
+	// Untracked blocks were never pushed, see Z_MarkUserdata.
+	if (block->tracked && block->tag != PU_LUA)
 		LUA_InvalidateUserdata(ptr);
 
 	// TODO: if zdebugging, make sure no other block has a user
@@ -162,12 +398,19 @@ void Z_Free(void *ptr)
 	if (block->user != NULL)
 		*block->user = NULL;
 
+	if (block->site != NULL)
+	{
+		block->site->liveblocks--;
+		block->site->livebytes -= block->realsize;
+		block->site->frees++;
+	}
+
 #ifdef VALGRIND_DESTROY_MEMPOOL
 	VALGRIND_DESTROY_MEMPOOL(block);
 #endif
 	block->prev->next = block->next;
 	block->next->prev = block->prev;
-	free(block);
+	Z_ReleaseBlock(block);
 }
 
 /** malloc() that doesn't accept failure.
@@ -199,53 +442,167 @@ static void *xm(size_t size)
 	return p;
 }
 
-/** The Z_MallocAlign function.
-  * Allocates a block of memory, adds it to a linked list so we can keep track of it.
+/** Gets memory for a new block, from the tag's arena if it is small enough.
   *
-  * \param size Amount of memory to be allocated, in bytes.
-  * \param tag Purge tag.
-  * \param user The address of a pointer to the memory to be allocated.
-  *             When the memory is freed by Z_Free later,
-  *             the pointer at this address will then be automatically set to NULL.
-  * \param alignbits The alignment of the memory to be allocated, in bits. Can be 0.
-  * \note You can pass Z_Malloc() a NULL user if the tag is less than PU_PURGELEVEL.
-  * \sa Z_CallocAlign, Z_ReallocAlign
+  * \param size Amount of memory the caller asked for, in bytes.
+  * \param tag Purge tag the block is allocated with.
+  * \return The block, with only its size and chunk filled in.
   */
-#ifdef ZDEBUG
-void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits,
-	const char *file, INT32 line)
-#else
-void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
-#endif
+static memblock_t *Z_NewBlock(size_t size, INT32 tag)
 {
+	size_t blocksize = sizeof (memblock_t) + size;
+	memzone_t *zone;
+	memchunk_t *chunk;
 	memblock_t *block;
-	void *ptr;
-	(void)(alignbits); // no longer used, so silence warnings.
 
-#ifdef ZDEBUG2
-	CONS_Debug(DBG_MEMORY, "Z_Malloc %s:%d\n", file, line);
-#endif
+	if (blocksize < size || blocksize > ARENAMAXBLOCK)
+	{
+		block = xm(blocksize);
+		block->size = blocksize;
+		block->chunk = NULL;
+		return block;
+	}
+
+	blocksize = (blocksize + ARENAGRAIN - 1) & ~(size_t)(ARENAGRAIN - 1);
+	zone = &zones[ZONENUM(tag)];
+
+	block = zone->freeblocks[ARENACLASS(blocksize)];
+	if (block != NULL)
+	{
+		zone->freeblocks[ARENACLASS(blocksize)] = block->next;
+		block->chunk->live++;
+		return block;
+	}
+
+	chunk = zone->chunks.next;
+	if (chunk == &zone->chunks || chunk->used + blocksize > ARENACHUNKSIZE)
+	{
+		chunk = xm(ARENACHUNKSIZE);
+		chunk->pool = NULL;
+		chunk->owner = ZONENUM(tag);
+		chunk->used = CHUNKHEADERSIZE;
+		chunk->live = chunk->tracked = 0;
+		chunk->nexthash = chunkhash[CHUNKHASH(chunk)];
+		chunkhash[CHUNKHASH(chunk)] = chunk;
+		chunk->next = zone->chunks.next;
+		chunk->prev = &zone->chunks;
+		zone->chunks.next = chunk;
+		chunk->next->prev = chunk;
+	}
+
+	block = (memblock_t *)((UINT8 *)chunk + chunk->used);
+	chunk->used += blocksize;
+	chunk->live++;
+
+	block->size = blocksize;
+	block->chunk = chunk;
+	return block;
+}
+
+/** Finds or adds the profiler entry for an allocation site.
+  *
+  * \param file Source file of the allocation.
+  * \param line Line of the allocation.
+  * \param tag Purge tag it was allocated with.
+  * \return The entry, or NULL if there was no memory left for a new one.
+  */
+static memsite_t *Z_GetMemSite(const char *file, INT32 line, INT32 tag)
+{
+	// File names are string literals, so comparing pointers is enough
+	UINT32 hash = (UINT32)(((uintptr_t)file >> 3) ^ ((UINT32)line * 2654435761u) ^ ((UINT32)tag << 20)) % MEMSITEHASHSIZE;
+	memsite_t *site;
+
+	for (site = memsitehash[hash]; site; site = site->next)
+		if (site->file == file && site->line == line && site->tag == tag)
+			return site;
+
+	// Not zone memory, or we'd be profiling ourselves
+	site = calloc(1, sizeof (*site));
+	if (site == NULL)
+		return NULL;
+
+	site->file = file;
+	site->line = line;
+	site->tag = tag;
+	site->next = memsitehash[hash];
+	memsitehash[hash] = site;
+	site->nextsite = memsites;
+	memsites = site;
+	nummemsites++;
+
+	return site;
+}
+
+/** Counts a new allocation towards its site's statistics.
+  *
+  * \param block The newly allocated block.
+  * \param file Source file of the allocation.
+  * \param line Line of the allocation.
+  */
+static void Z_ProfileAlloc(memblock_t *block, const char *file, INT32 line)
+{
+	memsite_t *site = Z_GetMemSite(file, line, block->tag);
+	tic_t tic = I_GetTime();
+
+	block->site = site;
+	if (site == NULL)
+		return;
+
+	// Its site has to hear about it being freed
+	Z_TrackBlock(block);
+
+	site->liveblocks++;
+	site->livebytes += block->realsize;
+	site->allocs++;
+	site->allocbytes += block->realsize;
+
+	if (site->lasttic != tic)
+	{
+		site->lasttic = tic;
+		site->ticallocs = 0;
+	}
+	if (++site->ticallocs > site->peakticallocs)
+		site->peakticallocs = site->ticallocs;
+}
+
+/** Puts a freshly allocated block on its tag's list and sets its user.
+  *
+  * \param block The block, as returned by Z_NewBlock or taken from a pool.
+  * \param size Amount of memory the caller asked for, in bytes.
+  * \param tag Purge tag.
+  * \param user The address of a pointer to the memory, or NULL.
+  * \return A pointer to the block's memory.
+  */
+static void *Z_LinkBlock(memblock_t *block, size_t size, INT32 tag, void *user)
+{
+	memblock_t *head;
+	void *ptr = MEMORY(block);
 
-	block = xm(sizeof (memblock_t) + size);
-	ptr = MEMORY(block);
 	I_Assert((intptr_t)ptr % sizeof (void *) == 0);
 
 #ifdef HAVE_VALGRIND
 	Z_calloc = false;
 #endif
 
-	block->next = head.next;
-	block->prev = &head;
-	head.next = block;
+	// Malloc'd and pooled blocks never go away with a tag's chunks.
+	// Valgrind has to see every block go, too.
+#ifdef VALGRIND_CREATE_MEMPOOL
+	block->tracked = true;
+#else
+	block->tracked = (user != NULL || block->chunk == NULL || block->chunk->pool != NULL);
+#endif
+	if (block->tracked && block->chunk != NULL)
+		block->chunk->tracked++;
+
+	head = ZONELIST(ZONENUM(tag), !block->tracked);
+	block->next = head->next;
+	block->prev = head;
+	head->next = block;
 	block->next->prev = block;
 
 	block->tag = tag;
 	block->user = NULL;
-#ifdef ZDEBUG
-	block->ownerline = line;
-	block->ownerfile = file;
-#endif
-	block->size = sizeof (memblock_t) + size;
+	block->site = NULL;
 	block->realsize = size;
 
 #ifdef VALGRIND_CREATE_MEMPOOL
@@ -266,6 +623,43 @@ void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
 	return ptr;
 }
 
+/** The Z_MallocAlign function.
+  * Allocates a block of memory, adds it to a linked list so we can keep track of it.
+  *
+  * \param size Amount of memory to be allocated, in bytes.
+  * \param tag Purge tag.
+  * \param user The address of a pointer to the memory to be allocated.
+  *             When the memory is freed by Z_Free later,
+  *             the pointer at this address will then be automatically set to NULL.
+  * \param alignbits The alignment of the memory to be allocated, in bits. Can be 0.
+  * \note You can pass Z_Malloc() a NULL user if the tag is less than PU_PURGELEVEL.
+  * \sa Z_CallocAlign, Z_ReallocAlign
+  */
+void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits,
+	const char *file, INT32 line)
+{
+	memblock_t *block;
+	void *ptr;
+	(void)(alignbits); // no longer used, so silence warnings.
+
+#ifdef ZDEBUG2
+	CONS_Debug(DBG_MEMORY, "Z_Malloc %s:%d\n", file, line);
+#endif
+
+	block = Z_NewBlock(size, tag);
+	ptr = Z_LinkBlock(block, size, tag, user);
+
+	if (memprofiling)
+		Z_ProfileAlloc(block, file, line);
+
+#ifdef ZDEBUG
+	block->ownerline = line;
+	block->ownerfile = file;
+#endif
+
+	return ptr;
+}
+
 /** The Z_CallocAlign function.
   * Allocates a block of memory, adds it to a linked list so we can keep track of it.
   * Unlike Z_MallocAlign, this also initialises the bytes to zero.
@@ -279,20 +673,12 @@ void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
   * \note You can pass Z_Calloc() a NULL user if the tag is less than PU_PURGELEVEL.
   * \sa Z_MallocAlign, Z_ReallocAlign
   */
-#ifdef ZDEBUG
 void *Z_Calloc2(size_t size, INT32 tag, void *user, INT32 alignbits, const char *file, INT32 line)
-#else
-void *Z_CallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
-#endif
 {
 #ifdef VALGRIND_MEMPOOL_ALLOC
 	Z_calloc = true;
 #endif
-#ifdef ZDEBUG
-	return memset(Z_Malloc2    (size, tag, user, alignbits, file, line), 0, size);
-#else
-	return memset(Z_MallocAlign(size, tag, user, alignbits            ), 0, size);
-#endif
+	return memset(Z_Malloc2(size, tag, user, alignbits, file, line), 0, size);
 }
 
 /** The Z_ReallocAlign function.
@@ -311,11 +697,7 @@ void *Z_CallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
   * \note You can pass Z_Realloc() a NULL user if the tag is less than PU_PURGELEVEL.
   * \sa Z_MallocAlign, Z_CallocAlign
   */
-#ifdef ZDEBUG
 void *Z_Realloc2(void *ptr, size_t size, INT32 tag, void *user, INT32 alignbits, const char *file, INT32 line)
-#else
-void *Z_ReallocAlign(void *ptr, size_t size, INT32 tag, void *user, INT32 alignbits)
-#endif
 {
 	void *rez;
 	memblock_t *block;
@@ -333,21 +715,13 @@ void *Z_ReallocAlign(void *ptr, size_t size, INT32 tag, void *user, INT32 alignb
 
 	if (!ptr)
 	{
-#ifdef ZDEBUG
 		return Z_Calloc2(size, tag, user, alignbits, file , line);
-#else
-		return Z_CallocAlign(size, tag, user, alignbits);
-#endif
 	}
 
 	block = MEMBLOCK(ptr);
 #ifdef PARANOIA
 	if (block->id != ZONEID)
-#ifdef ZDEBUG
 		I_Error("Z_ReallocAlign at %s:%d: wrong id", file, line);
-#else
-		I_Error("Z_ReallocAlign: wrong id");
-#endif
 #endif
 
 	if (block == NULL)
@@ -356,10 +730,8 @@ void *Z_ReallocAlign(void *ptr, size_t size, INT32 tag, void *user, INT32 alignb
 #ifdef ZDEBUG
 	// Write every Z_Realloc call to a debug file.
 	DEBFILE(va("Z_Realloc at %s:%d\n", file, line));
-	rez = Z_Malloc2(size, tag, user, alignbits, file, line);
-#else
-	rez = Z_MallocAlign(size, tag, user, alignbits);
 #endif
+	rez = Z_Malloc2(size, tag, user, alignbits, file, line);
 
 	if (size < block->realsize)
 		copysize = size;
@@ -368,11 +740,7 @@ void *Z_ReallocAlign(void *ptr, size_t size, INT32 tag, void *user, INT32 alignb
 
 	M_Memcpy(rez, ptr, copysize);
 
-#ifdef ZDEBUG
 	Z_Free2(ptr, file, line);
-#else
-	Z_Free(ptr);
-#endif
 
 	// Need to set the user in case the old block had the same one, in
 	// which case the Z_Free will just have NULLed it out.
@@ -385,6 +753,124 @@ void *Z_ReallocAlign(void *ptr, size_t size, INT32 tag, void *user, INT32 alignb
 	return rez;
 }
 
+// ------------
+// Memory pools
+// ------------
+
+/** Creates a pool of fixed-size, cache-line aligned objects.
+  * Blocks allocated from it behave like any other zone memory;
+  * Z_Free just hands their slot back to the pool instead of the heap.
+  *
+  * \param name Name shown by the "mempools" command.
+  * \param size Size of the objects, in bytes.
+  * \return The new pool. It lives for the entire execution time.
+  * \sa Z_PoolMalloc, Z_PoolCalloc
+  */
+mempool_t *Z_CreatePool(const char *name, size_t size)
+{
+	mempool_t *pool = xm(sizeof (*pool));
+
+	memset(pool, 0x00, sizeof (*pool));
+	pool->name = name;
+	pool->size = size;
+	pool->stride = (sizeof (memblock_t) + size + POOLALIGN - 1) & ~(size_t)(POOLALIGN - 1);
+	pool->slots = max(ARENACHUNKSIZE / pool->stride, POOLMINSLOTS);
+	pool->chunks.next = pool->chunks.prev = &pool->chunks;
+
+	pool->nextpool = mempools;
+	mempools = pool;
+
+	return pool;
+}
+
+/** Adds one more chunk worth of slots to a pool's freelist.
+  *
+  * \param pool The pool to grow.
+  */
+static void Z_GrowPool(mempool_t *pool)
+{
+	memchunk_t *chunk = xm(CHUNKHEADERSIZE + POOLALIGN + pool->slots * pool->stride);
+	uintptr_t first;
+	size_t i;
+
+	chunk->pool = pool;
+	chunk->owner = -1;
+	chunk->live = 0;
+	chunk->next = pool->chunks.next;
+	chunk->prev = &pool->chunks;
+	pool->chunks.next = chunk;
+	chunk->next->prev = chunk;
+	pool->numchunks++;
+
+	// Align the memory after each header, not the header itself
+	first = (uintptr_t)chunk + CHUNKHEADERSIZE + sizeof (memblock_t);
+	first = ((first + POOLALIGN - 1) & ~(uintptr_t)(POOLALIGN - 1)) - sizeof (memblock_t);
+	chunk->used = first - (uintptr_t)chunk + pool->slots * pool->stride;
+
+	// Link them backwards so the lowest addresses get used first
+	for (i = pool->slots; i-- > 0;)
+	{
+		memblock_t *block = (memblock_t *)(first + i * pool->stride);
+		block->id = 0;
+		block->size = pool->stride;
+		block->chunk = chunk;
+		block->next = pool->freeblocks;
+		pool->freeblocks = block;
+	}
+}
+
+/** Allocates an object from a pool.
+  *
+  * \param pool The pool, as returned by Z_CreatePool.
+  * \param tag Purge tag.
+  * \param user The address of a pointer to the memory to be allocated.
+  * \return A pointer to the allocated memory, aligned to a cache line.
+  * \sa Z_PoolCalloc, Z_MallocAlign
+  */
+void *Z_PoolMalloc2(mempool_t *pool, INT32 tag, void *user, const char *file, INT32 line)
+{
+	memblock_t *block;
+	void *ptr;
+
+	if (pool->freeblocks == NULL)
+		Z_GrowPool(pool);
+
+	block = pool->freeblocks;
+	pool->freeblocks = block->next;
+	block->chunk->live++;
+
+	if (++pool->used > pool->peak)
+		pool->peak = pool->used;
+
+	ptr = Z_LinkBlock(block, pool->size, tag, user);
+
+	if (memprofiling)
+		Z_ProfileAlloc(block, file, line);
+
+#ifdef ZDEBUG
+	block->ownerline = line;
+	block->ownerfile = file;
+#endif
+
+	return ptr;
+}
+
+/** Allocates an object from a pool and initialises it to zero.
+  *
+  * \param pool The pool, as returned by Z_CreatePool.
+  * \param tag Purge tag.
+  * \param user The address of a pointer to the memory to be allocated.
+  * \return A pointer to the allocated memory, aligned to a cache line.
+  * \sa Z_PoolMalloc, Z_CallocAlign
+  */
+void *Z_PoolCalloc2(mempool_t *pool, INT32 tag, void *user, const char *file, INT32 line)
+{
+#ifdef VALGRIND_MEMPOOL_ALLOC
+	Z_calloc = true;
+#endif
+	return memset(Z_PoolMalloc2(pool, tag, user, file, line), 0, pool->size);
+}
+
 /** Frees all memory for a given set of tags.
   *
   * \param lowtag The lowest tag to consider.
@@ -393,13 +879,42 @@ void *Z_ReallocAlign(void *ptr, size_t size, INT32 tag, void *user, INT32 alignb
 void Z_FreeTags(INT32 lowtag, INT32 hightag)
 {
 	memblock_t *block, *next;
+	INT32 i, l;
 
 	Z_CheckHeap(420);
-	for (block = head.next; block != &head; block = next)
+	for (i = ZONENUM(lowtag); i <= ZONENUM(hightag); i++)
 	{
-		next = block->next; // get link before freeing
-		if (block->tag >= lowtag && block->tag <= hightag)
-			Z_Free(MEMORY(block));
+		memzone_t *zone = &zones[i];
+
+		// Every tag sharing this list goes, so only the tracked
+		// blocks need a look. The rest go with their chunks.
+		if ((i > 0 || lowtag == INT32_MIN) && (i < NUMZONETAGS-1 || hightag == INT32_MAX))
+		{
+			for (block = zone->head.next; block != &zone->head; block = next)
+			{
+				next = block->next; // get link before freeing
+				Z_Free(MEMORY(block));
+			}
+
+			Z_ResetArena(zone);
+			continue;
+		}
+
+		for (l = 0; l < 2; l++)
+		{
+			memblock_t *head = ZONELIST(i, l);
+
+			for (block = head->next; block != head; block = next)
+			{
+				next = block->next; // get link before freeing
+				if (block->tag >= lowtag && block->tag <= hightag)
+					Z_Free(MEMORY(block));
+			}
+		}
+
+		// Nothing is left under this tag, so its arena can go in one go
+		if (zone->head.next == &zone->head && zone->arena.next == &zone->arena)
+			Z_ResetArena(zone);
 	}
 }
 
@@ -412,22 +927,29 @@ void Z_FreeTags(INT32 lowtag, INT32 hightag)
 void Z_IterateTags(INT32 lowtag, INT32 hightag, boolean (*iterfunc)(void *))
 {
 	memblock_t *block, *next;
+	INT32 i, l;
 
 	if (!iterfunc)
 		I_Error("Z_IterateTags: no iterator function was given");
 
-	for (block = head.next; block != &head; block = next)
-	{
-		next = block->next; // get link before possibly freeing
-
-		if (block->tag >= lowtag && block->tag <= hightag)
+	for (i = ZONENUM(lowtag); i <= ZONENUM(hightag); i++)
+		for (l = 0; l < 2; l++)
 		{
-			void *mem = MEMORY(block);
-			boolean free = iterfunc(mem);
-			if (free)
-				Z_Free(mem);
+			memblock_t *head = ZONELIST(i, l);
+
+			for (block = head->next; block != head; block = next)
+			{
+				next = block->next; // get link before possibly freeing
+
+				if (block->tag >= lowtag && block->tag <= hightag)
+				{
+					void *mem = MEMORY(block);
+					boolean free = iterfunc(mem);
+					if (free)
+						Z_Free(mem);
+				}
+			}
 		}
-	}
 }
 
 // -----------------
@@ -468,77 +990,108 @@ void Z_CheckHeap(INT32 i)
 {
 	memblock_t *block;
 	UINT32 blocknumon = 0;
+	INT32 z, l;
 	void *given;
 
-	for (block = head.next; block != &head; block = block->next)
+	for (z = 0; z < NUMZONETAGS; z++)
+	for (l = 0; l < 2; l++)
 	{
-		blocknumon++;
-		given = MEMORY(block);
+		memblock_t *head = ZONELIST(z, l);
+
+		for (block = head->next; block != head; block = block->next)
+		{
+			blocknumon++;
+			given = MEMORY(block);
 #ifdef ZDEBUG2
-		CONS_Debug(DBG_MEMORY, "block %u owned by %s:%d\n",
-			blocknumon, block->ownerfile, block->ownerline);
+			CONS_Debug(DBG_MEMORY, "block %u owned by %s:%d\n",
+				blocknumon, block->ownerfile, block->ownerline);
 #endif
 #ifdef VALGRIND_MEMPOOL_EXISTS
-		if (!VALGRIND_MEMPOOL_EXISTS(block))
-		{
-			I_Error("Z_CheckHeap %d: block %u"
+			if (!VALGRIND_MEMPOOL_EXISTS(block))
+			{
+				I_Error("Z_CheckHeap %d: block %u"
 #ifdef ZDEBUG
-				"(owned by %s:%d)"
+					"(owned by %s:%d)"
 #endif
-				" should not exist", i, blocknumon
+					" should not exist", i, blocknumon
 #ifdef ZDEBUG
-				, block->ownerfile, block->ownerline
+					, block->ownerfile, block->ownerline
 #endif
-				);
-		}
+					);
+			}
 #endif
-		if (block->user != NULL && *(block->user) != given)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
+			if (block->user != NULL && *(block->user) != given)
+			{
+				I_Error("Z_CheckHeap %d: block %u"
 #ifdef ZDEBUG
-				"(owned by %s:%d)"
+					"(owned by %s:%d)"
 #endif
-				" doesn't have a proper user", i, blocknumon
+					" doesn't have a proper user", i, blocknumon
 #ifdef ZDEBUG
-				, block->ownerfile, block->ownerline
+					, block->ownerfile, block->ownerline
 #endif
-				);
-		}
-		if (block->next->prev != block)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
+					);
+			}
+			if (block->next->prev != block)
+			{
+				I_Error("Z_CheckHeap %d: block %u"
 #ifdef ZDEBUG
-				"(owned by %s:%d)"
+					"(owned by %s:%d)"
 #endif
-				" lacks proper backlink", i, blocknumon
+					" lacks proper backlink", i, blocknumon
 #ifdef ZDEBUG
-				, block->ownerfile, block->ownerline
+					, block->ownerfile, block->ownerline
 #endif
-				);
-		}
-		if (block->prev->next != block)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
+					);
+			}
+			if (block->prev->next != block)
+			{
+				I_Error("Z_CheckHeap %d: block %u"
 #ifdef ZDEBUG
-				"(owned by %s:%d)"
+					"(owned by %s:%d)"
 #endif
-				" lacks proper forward link", i, blocknumon
+					" lacks proper forward link", i, blocknumon
 #ifdef ZDEBUG
-				, block->ownerfile, block->ownerline
+					, block->ownerfile, block->ownerline
 #endif
-				);
-		}
-		if (block->id != ZONEID)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
+					);
+			}
+			if (block->id != ZONEID)
+			{
+				I_Error("Z_CheckHeap %d: block %u"
+#ifdef ZDEBUG
+					"(owned by %s:%d)"
+#endif
+					" have the wrong ID", i, blocknumon
+#ifdef ZDEBUG
+					, block->ownerfile, block->ownerline
+#endif
+					);
+			}
+			if (ZONENUM(block->tag) != z)
+			{
+				I_Error("Z_CheckHeap %d: block %u"
 #ifdef ZDEBUG
-				"(owned by %s:%d)"
+					"(owned by %s:%d)"
 #endif
-				" have the wrong ID", i, blocknumon
+					" is in the wrong tag list", i, blocknumon
 #ifdef ZDEBUG
-				, block->ownerfile, block->ownerline
+					, block->ownerfile, block->ownerline
 #endif
-				);
+					);
+			}
+			if (block->tracked != !l)
+			{
+				I_Error("Z_CheckHeap %d: block %u"
+#ifdef ZDEBUG
+					"(owned by %s:%d)"
+#endif
+					" is in the wrong list for its tag", i, blocknumon
+#ifdef ZDEBUG
+					, block->ownerfile, block->ownerline
+#endif
+					);
+			}
 		}
 	}
 }
@@ -575,6 +1128,28 @@ void Z_ChangeTag(void *ptr, INT32 tag)
 		I_Error("Internal memory management error: "
 			"tried to make block purgable but it has no owner");
 
+	if (ZONENUM(tag) != ZONENUM(block->tag))
+	{
+		// Move it to the new tag's list. Its memory stays in the old
+		// tag's arena, which keeps the chunk alive until it is freed,
+		// so the new tag has to free it on its own.
+		memblock_t *head = &zones[ZONENUM(tag)].head;
+
+		block->prev->next = block->next;
+		block->next->prev = block->prev;
+
+		block->next = head->next;
+		block->prev = head;
+		head->next = block;
+		block->next->prev = block;
+
+		if (!block->tracked)
+		{
+			block->tracked = true;
+			block->chunk->tracked++;
+		}
+	}
+
 	block->tag = tag;
 }
 
@@ -608,6 +1183,49 @@ void Z_SetUser(void *ptr, void **newuser)
 
 	block->user = (void*)newuser;
 	*newuser = ptr;
+	Z_TrackBlock(block);
+}
+
+/** Makes sure Lua's userdata for some memory is invalidated when it is freed.
+  * Called whenever Lua makes a userdata. The pointer does not have to be
+  * zone memory; nothing happens unless it is the start of an arena block.
+  *
+  * \param ptr The pointer Lua has a userdata for.
+  * \sa Z_FreeTags
+  */
+void Z_MarkUserdata(void *ptr)
+{
+	// A chunk holding ptr starts in the same stretch of memory or the one before
+	uintptr_t keys[2] = {(uintptr_t)ptr, (uintptr_t)ptr - ARENACHUNKSIZE};
+	memchunk_t *chunk;
+	INT32 i;
+
+	for (i = 0; i < 2; i++)
+		for (chunk = chunkhash[CHUNKHASH(keys[i])]; chunk; chunk = chunk->nexthash)
+		{
+			UINT8 *start = (UINT8 *)chunk + CHUNKHEADERSIZE + sizeof (memblock_t);
+			memblock_t *block;
+
+			if ((UINT8 *)ptr < start || (UINT8 *)ptr >= (UINT8 *)chunk + chunk->used)
+				continue;
+
+			block = MEMBLOCK(ptr);
+			if (block->id == ZONEID && block->chunk == chunk)
+				Z_TrackBlock(block);
+			return;
+		}
+}
+
+/** Gets the tag of a memory block.
+  *
+  * \param ptr A pointer to allocated memory.
+  * \return The block's tag.
+  * \sa Z_ChangeTag
+  */
+INT32 Z_GetTag(void *ptr)
+{
+	memblock_t *block = MEMBLOCK(ptr);
+	return block->tag;
 }
 
 // -----------------
@@ -625,12 +1243,19 @@ size_t Z_TagsUsage(INT32 lowtag, INT32 hightag)
 {
 	size_t cnt = 0;
 	memblock_t *rover;
+	INT32 i, l;
 
-	for (rover = head.next; rover != &head; rover = rover->next)
+	for (i = ZONENUM(lowtag); i <= ZONENUM(hightag); i++)
+	for (l = 0; l < 2; l++)
 	{
-		if (rover->tag < lowtag || rover->tag > hightag)
-			continue;
-		cnt += rover->size + sizeof *rover;
+		memblock_t *head = ZONELIST(i, l);
+
+		for (rover = head->next; rover != head; rover = rover->next)
+		{
+			if (rover->tag < lowtag || rover->tag > hightag)
+				continue;
+			cnt += rover->size + sizeof *rover;
+		}
 	}
 
 	return cnt;
@@ -682,6 +1307,187 @@ static void Command_Memfree_f(void)
 	CONS_Printf(M_GetText("Available physical memory: %s KB\n"), sizeu1(freebytes>>10));
 }
 
+/** The function called by the "mempools" console command.
+  * Prints how many objects each memory pool holds, and has ever held at once.
+  */
+static void Command_Mempools_f(void)
+{
+	mempool_t *pool;
+
+	CONS_Printf("\x82%s", M_GetText("Memory Pools\n"));
+	for (pool = mempools; pool; pool = pool->nextpool)
+	{
+		CONS_Printf(M_GetText("%-22s : %6s used, %6s peak, %6s slots of %4s bytes, %7s KB\n"),
+			pool->name,
+			sizeu1(pool->used),
+			sizeu2(pool->peak),
+			sizeu3(pool->numchunks * pool->slots),
+			sizeu4(pool->stride),
+			sizeu5((pool->numchunks * (CHUNKHEADERSIZE + POOLALIGN + pool->slots * pool->stride))>>10));
+	}
+}
+
+/** Orders allocation sites by the memory they hold, then by churn.
+  */
+static int Z_CompareMemSites(const void *a, const void *b)
+{
+	const memsite_t *sa = *(const memsite_t * const *)a;
+	const memsite_t *sb = *(const memsite_t * const *)b;
+
+	if (sa->livebytes != sb->livebytes)
+		return (sa->livebytes < sb->livebytes) ? 1 : -1;
+	if (sa->allocs != sb->allocs)
+		return (sa->allocs < sb->allocs) ? 1 : -1;
+	return 0;
+}
+
+/** Writes the allocation profile, sorted by live bytes,
+  * followed by the same numbers summed up per tag.
+  *
+  * \param f File to write to.
+  */
+static void Z_WriteMemProfile(FILE *f)
+{
+	tic_t tics = (memprofiling ? I_GetTime() : memprofilestop) - memprofilestart;
+	memsite_t **sorted, *site;
+	size_t i, n = 0;
+	INT32 tag;
+
+	if (!tics)
+		tics = 1;
+
+	sorted = malloc(nummemsites * sizeof (*sorted));
+	if (sorted == NULL && nummemsites)
+	{
+		CONS_Alert(CONS_ERROR, "memprofile: out of memory\n");
+		return;
+	}
+
+	for (site = memsites; site; site = site->nextsite)
+		sorted[n++] = site;
+	qsort(sorted, n, sizeof (*sorted), Z_CompareMemSites);
+
+	fprintf(f, "# Zone allocations over %u tics (%.2f seconds)\n", tics, (double)tics / TICRATE);
+	fprintf(f, "%12s %9s %10s %12s %10s %10s %9s %4s  %s\n",
+		"live bytes", "live", "allocs", "alloc bytes", "frees", "allocs/tic", "peak/tic", "tag", "site");
+
+	for (i = 0; i < n; i++)
+	{
+		const char *filename = strrchr(sorted[i]->file, PATHSEP[0]);
+		fprintf(f, "%12s %9s %10s %12s %10s %10.2f %9u %4d  %s:%d\n",
+			sizeu1(sorted[i]->livebytes), sizeu2(sorted[i]->liveblocks),
+			sizeu3(sorted[i]->allocs), sizeu4(sorted[i]->allocbytes),
+			sizeu5(sorted[i]->frees), (double)sorted[i]->allocs / tics,
+			(UINT32)sorted[i]->peakticallocs, sorted[i]->tag,
+			filename ? filename + 1 : sorted[i]->file, sorted[i]->line);
+	}
+
+	fprintf(f, "\n# Per tag\n");
+	fprintf(f, "%12s %9s %10s %12s %10s %10s %4s\n",
+		"live bytes", "live", "allocs", "alloc bytes", "frees", "allocs/tic", "tag");
+
+	for (tag = 0; tag < NUMZONETAGS; tag++)
+	{
+		size_t livebytes = 0, liveblocks = 0, allocs = 0, allocbytes = 0, frees = 0;
+
+		for (i = 0; i < n; i++)
+		{
+			if (ZONENUM(sorted[i]->tag) != tag)
+				continue;
+			livebytes += sorted[i]->livebytes;
+			liveblocks += sorted[i]->liveblocks;
+			allocs += sorted[i]->allocs;
+			allocbytes += sorted[i]->allocbytes;
+			frees += sorted[i]->frees;
+		}
+
+		if (!allocs && !liveblocks)
+			continue;
+
+		fprintf(f, "%12s %9s %10s %12s %10s %10.2f %4d\n",
+			sizeu1(livebytes), sizeu2(liveblocks), sizeu3(allocs),
+			sizeu4(allocbytes), sizeu5(frees), (double)allocs / tics, tag);
+	}
+
+	free(sorted);
+}
+
+/** The function called by the "memprofile" console command.
+  * Tracks live memory and allocation churn per allocation site and tag.
+  * "start" throws away previous results, "dump" writes them to a file.
+  */
+static void Command_Memprofile_f(void)
+{
+	const char *arg = COM_Argv(1);
+
+	if (!stricmp(arg, "start"))
+	{
+		memsite_t *site, *next;
+		memblock_t *block;
+		INT32 i;
+
+		// Blocks from an earlier run must not touch the new numbers.
+		// Only tracked blocks can have a site.
+		for (i = 0; i < NUMZONETAGS; i++)
+			for (block = zones[i].head.next; block != &zones[i].head; block = block->next)
+				block->site = NULL;
+
+		for (site = memsites; site; site = next)
+		{
+			next = site->nextsite;
+			free(site);
+		}
+		memsites = NULL;
+		nummemsites = 0;
+		memset(memsitehash, 0x00, sizeof(memsitehash));
+
+		memprofilestart = I_GetTime();
+		memprofiling = true;
+		CONS_Printf(M_GetText("Memory profiling started.\n"));
+	}
+	else if (!stricmp(arg, "stop"))
+	{
+		if (!memprofiling)
+			return;
+		memprofilestop = I_GetTime();
+		memprofiling = false;
+		CONS_Printf(M_GetText("Memory profiling stopped after %u tics, %s allocation sites.\n"),
+			memprofilestop - memprofilestart, sizeu1(nummemsites));
+	}
+	else if (!stricmp(arg, "dump") && COM_Argc() > 2)
+	{
+		const char *name = COM_Argv(2);
+		const char *path;
+		FILE *f;
+
+		// Keep it inside the home folder
+		if (strchr(name, '/') || strchr(name, '\\') || strstr(name, ".."))
+		{
+			CONS_Alert(CONS_WARNING, M_GetText("memprofile: file name can't contain a path\n"));
+			return;
+		}
+
+		path = va("%s"PATHSEP"%s", srb2home, name);
+		f = fopen(path, "w");
+		if (!f)
+		{
+			CONS_Alert(CONS_ERROR, M_GetText("Couldn't open %s for writing\n"), path);
+			return;
+		}
+		Z_WriteMemProfile(f);
+		fclose(f);
+		CONS_Printf(M_GetText("Memory profile saved to '%s'\n"), path);
+	}
+	else
+	{
+		CONS_Printf(M_GetText("memprofile start: start tracking allocations\n"));
+		CONS_Printf(M_GetText("memprofile stop: stop tracking allocations\n"));
+		CONS_Printf(M_GetText("memprofile dump <file>: save the results\n"));
+		CONS_Printf(M_GetText("Profiling is %s, %s allocation sites.\n"),
+			memprofiling ? M_GetText("on") : M_GetText("off"), sizeu1(nummemsites));
+	}
+}
+
 #ifdef ZDEBUG
 /** The function called by the "memdump" console command.
   * Prints zone memory debugging information (i.e. tag, size, location in code allocated).
@@ -692,7 +1498,7 @@ static void Command_Memdump_f(void)
 {
 	memblock_t *block;
 	INT32 mintag = 0, maxtag = INT32_MAX;
-	INT32 i;
+	INT32 i, l;
 
 	if ((i = COM_CheckParm("-min")))
 		mintag = atoi(COM_Argv(i + 1));
@@ -700,12 +1506,18 @@ static void Command_Memdump_f(void)
 	if ((i = COM_CheckParm("-max")))
 		maxtag = atoi(COM_Argv(i + 1));
 
-	for (block = head.next; block != &head; block = block->next)
-		if (block->tag >= mintag && block->tag <= maxtag)
-		{
-			char *filename = strrchr(block->ownerfile, PATHSEP[0]);
-			CONS_Printf("[%3d] %s (%s) bytes @ %s:%d\n", block->tag, sizeu1(block->size), sizeu2(block->realsize), filename ? filename + 1 : block->ownerfile, block->ownerline);
-		}
+	for (i = ZONENUM(mintag); i <= ZONENUM(maxtag); i++)
+	for (l = 0; l < 2; l++)
+	{
+		memblock_t *head = ZONELIST(i, l);
+
+		for (block = head->next; block != head; block = block->next)
+			if (block->tag >= mintag && block->tag <= maxtag)
+			{
+				char *filename = strrchr(block->ownerfile, PATHSEP[0]);
+				CONS_Printf("[%3d] %s (%s) bytes @ %s:%d\n", block->tag, sizeu1(block->size), sizeu2(block->realsize), filename ? filename + 1 : block->ownerfile, block->ownerline);
+			}
+	}
 }
 #endif
 
@@ -66,7 +66,7 @@ enum
 
 	// Tags >= PU_PURGELEVEL are purgable whenever needed
 	PU_PURGELEVEL            = 100, // Note: this is never actually used as a tag
-	PU_CACHE_UNLOCKED        = 101, // Note: unused
+	PU_CACHE_UNLOCKED        = 101, // lumps prefetched by W_PrefetchLumps, until used
 	PU_HWRCACHE_UNLOCKED     = 102, // 'unlocked' PU_HWRCACHE memory:
 									// 'second-level' cache for graphics
                                     // stored in hardware format and downloaded as needed
@@ -81,12 +81,13 @@ void Z_Init(void);
 //
 // Zone memory allocation
 //
-// enable ZDEBUG to get the file + line the functions were called from
+// enable ZDEBUG to log the file + line the functions were called from
 // for ZZ_Alloc, see doomdef.h
 //
 
 // Z_Free and alloc with alignment
-#ifdef ZDEBUG
+// These always get the file + line they were called from,
+// for ZDEBUG and for the "memprofile" command
 #define Z_Free(p)                 Z_Free2(p, __FILE__, __LINE__)
 #define Z_MallocAlign(s,t,u,a)    Z_Malloc2(s, t, u, a, __FILE__, __LINE__)
 #define Z_CallocAlign(s,t,u,a)    Z_Calloc2(s, t, u, a, __FILE__, __LINE__)
@@ -95,18 +96,26 @@ void Z_Free2(void *ptr, const char *file, INT32 line);
 void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits, const char *file, INT32 line) FUNCALLOC(1);
 void *Z_Calloc2(size_t size, INT32 tag, void *user, INT32 alignbits, const char *file, INT32 line) FUNCALLOC(1);
 void *Z_Realloc2(void *ptr, size_t size, INT32 tag, void *user, INT32 alignbits, const char *file, INT32 line) FUNCALLOC(2);
-#else
-void Z_Free(void *ptr);
-void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits) FUNCALLOC(1);
-void *Z_CallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits) FUNCALLOC(1);
-void *Z_ReallocAlign(void *ptr, size_t size, INT32 tag, void *user, INT32 alignbits) FUNCALLOC(2);
-#endif
 
 // Alloc with standard alignment
 #define Z_Malloc(s,t,u)    Z_MallocAlign(s, t, u, sizeof(void *))
 #define Z_Calloc(s,t,u)    Z_CallocAlign(s, t, u, sizeof(void *))
 #define Z_Realloc(p,s,t,u) Z_ReallocAlign(p, s, t, u, sizeof(void *))
 
+//
+// Fixed-size object pools
+//
+// Memory from a pool is freed with Z_Free and purged by tag
+// like any other block, but its slot is kept for reuse.
+//
+typedef struct mempool_s mempool_t;
+mempool_t *Z_CreatePool(const char *name, size_t size);
+
+#define Z_PoolMalloc(p,t,u) Z_PoolMalloc2(p, t, u, __FILE__, __LINE__)
+#define Z_PoolCalloc(p,t,u) Z_PoolCalloc2(p, t, u, __FILE__, __LINE__)
+void *Z_PoolMalloc2(mempool_t *pool, INT32 tag, void *user, const char *file, INT32 line);
+void *Z_PoolCalloc2(mempool_t *pool, INT32 tag, void *user, const char *file, INT32 line);
+
 // Free all memory by tag
 // these don't give line numbers for ZDEBUG currently though
 // (perhaps this should be changed in future?)
@@ -137,6 +146,8 @@ void Z_SetUser2(void *ptr, void **newuser, const char *file, INT32 line);
 void Z_ChangeTag(void *ptr, INT32 tag);
 void Z_SetUser(void *ptr, void **newuser);
 #endif
+INT32 Z_GetTag(void *ptr);
+void Z_MarkUserdata(void *ptr);
 
 //
 // Zone memory usage